@@ -73,11 +73,13 @@ typedef uint32_t RgBool32;
 RG_DEFINE_NON_DISPATCHABLE_HANDLE(RgInstance)
 typedef uint32_t RgMaterial;
 typedef uint32_t RgCubemap;
+typedef uint32_t RgMesh;
 typedef uint32_t RgFlags;
 
 #define RG_NULL_HANDLE      0
 #define RG_NO_MATERIAL      0
 #define RG_EMPTY_CUBEMAP    0
+#define RG_NO_MESH          0
 #define RG_FALSE            0
 #define RG_TRUE             1
 
@@ -100,6 +102,7 @@ typedef enum RgResult
     RG_WRONG_FUNCTION_CALL,
     RG_ERROR_CANT_FIND_BLUE_NOISE,
     RG_ERROR_CANT_FIND_WATER_TEXTURES,
+    RG_CANT_UPDATE_VERTICES,
 } RgResult;
 
 typedef void (*PFN_rgPrint)(const char *pMessage, void *pUserData);
@@ -180,6 +183,9 @@ typedef struct RgInstanceCreateInfo
     // "FPSMonitor"         - show FPS at the window name
     // Default: "RayTracedGL1.txt"
     const char                  *pConfigPath;
+    // If not null, every successful rg* call of this instance is recorded into this file (.rgcap),
+    // including geometry, texture and frame parameters data. The file can be replayed with RtglReplay.
+    const char                  *pCaptureFilePath;
     
     // Optional function to print messages from the library.
     // Requires "VulkanValidation" in the configuration file.
@@ -208,6 +214,31 @@ typedef struct RgInstanceCreateInfo
     // Allow RG_GEOMETRY_VISIBILITY_TYPE_SKY.
     // If true, RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 must not be used.
     RgBool32                    allowGeometryWithSkyFlag;
+    // Compact BLAS of static non-movable geometry and meshes after they're built.
+    // Reduces the memory they occupy, the compaction is done when the static geometry becomes visible.
+    RgBool32                    compactStaticAccelerationStructures;
+    // Store normals and texture coordinates of ray traced geometry with less precision:
+    // octahedral normals and half-float texture coordinates. Positions are not changed.
+    // Halves the memory of vertex buffers, but texture coordinates must be in a range of float16.
+    RgBool32                    compactVertexFormat;
+    // Initial sizes of vertex and index buffers of ray traced geometry, in elements.
+    // These are only hints: buffers grow, if more geometry is uploaded. 0 means a default value.
+    uint32_t                    initialStaticVertexCount;
+    uint32_t                    initialDynamicVertexCount;
+    uint32_t                    initialIndexCount;
+    // Sizes of the regions for static chunks in vertex and index buffers, in elements.
+    // Unlike the hints above, the regions don't grow: rgUploadStaticChunk fails, if a chunk
+    // doesn't fit in the remaining space. 0 means a default value.
+    uint32_t                    staticChunkVertexCount;
+    uint32_t                    staticChunkIndexCount;
+    // Optimize static geometry on rgSubmitStaticGeometries, before it's built: equal vertices are welded,
+    // degenerate triangles are removed, vertices are reordered for fetch locality, and tiny
+    // non-movable geometries with the same material are merged. The processing is done on worker threads.
+    // Vertex order is not preserved, so rgUpdateGeometryTexCoords can't be used for static geometry.
+    // Merged geometries share one geometry, so their unique IDs stay reserved, but they can't be
+    // updated by the ID, e.g. rgUpdateGeometryTransform fails for them.
+    // The results can be queried with rgGetStaticGeometryOptimizationStats.
+    RgBool32                    optimizeStaticGeometry;
 
     // Memory that must be allocated for vertex and index buffers of rasterized geometry.
     // It can't be changed after rgCreateInstance.
@@ -388,8 +419,12 @@ typedef struct RgGeometryUploadInfo
     
     // Can be null, if indices are not used.
     // pIndices is an array of uint32_t of size indexCount.
+    // If pIndices16 is not null, then indices are taken from it
+    // as an array of uint16_t of size indexCount, and pIndices must be null.
+    // 16-bit indices take half the memory in index buffer.
     uint32_t                        indexCount;
     const uint32_t                  *pIndices;
+    const uint16_t                  *pIndices16;
 
     // Look RgPortalUploadInfo.
     // Must be null if not RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL.
@@ -416,6 +451,19 @@ typedef struct RgUpdateTransformInfo
     RgTransform     transform;
 } RgUpdateTransformInfo;
 
+typedef struct RgUpdateVerticesInfo
+{
+    uint64_t        movableStaticUniqueID;
+    // Range in the vertices of the uploaded geometry,
+    // vertex and index count of the geometry can't be changed.
+    uint32_t        vertexOffset;
+    uint32_t        vertexCount;
+    // Must not be null, if vertexCount is not 0.
+    const RgFloat3D *pPositions;
+    // If null, normals won't be updated.
+    const RgFloat3D *pNormals;
+} RgUpdateVerticesInfo;
+
 typedef struct RgUpdateTexCoordsInfo
 {
     // movable or non-movable static unique geom ID
@@ -434,10 +482,37 @@ typedef struct RgUpdateTexCoordsInfo
 // Dynamic geometry can be uploaded only between rgStartFrame - rgDrawFrame.
 // Static geometry can be uploaded only between rgBeginStaticGeometries - rgSubmitStaticGeometries.
 // Uploading dynamic geometries and then calling rgBeginStaticGeometries will erase them.
+// If a limit of geometry count or of buffer size is reached, RG_WRONG_ARGUMENT is returned.
 RGAPI RgResult RGCONV rgUploadGeometry(
     RgInstance                              rgInstance,
     const RgGeometryUploadInfo              *pUploadInfo);
 
+// Same as calling rgUploadGeometry for each element of pUploadInfos, but the whole array
+// is validated at once, and staging space is reserved for all geometries together.
+// Should be preferred, if there are a lot of small geometries.
+// If any element is invalid, none of them are uploaded. If a limit is reached,
+// geometries that don't fit are skipped, and RG_WRONG_ARGUMENT is returned.
+// Geometries must be either all dynamic or all static (static and static movable can be mixed).
+RGAPI RgResult RGCONV rgUploadGeometries(
+    RgInstance                              rgInstance,
+    uint32_t                                uploadInfoCount,
+    const RgGeometryUploadInfo              *pUploadInfos);
+
+// Get memory for vertexCount vertices and indexCount indices of dynamic geometry,
+// so it can be written in place, without an additional copy in rgUploadGeometry.
+// To commit the data, call rgUploadGeometry (or rgUploadGeometries) with a dynamic geometry,
+// which pVertices and pIndices are the acquired pointers; vertexCount and indexCount
+// must not exceed the acquired ones.
+// The memory is write-only (it may be uncached), and it's valid only until rgDrawFrame.
+// Can be called only between rgStartFrame - rgDrawFrame.
+// If indexCount is 0, ppOutIndices can be null.
+RGAPI RgResult RGCONV rgAcquireGeometryMemory(
+    RgInstance                              rgInstance,
+    uint32_t                                vertexCount,
+    uint32_t                                indexCount,
+    RgVertex                                **ppOutVertices,
+    uint32_t                                **ppOutIndices);
+
 // Updating transform is available only for movable static geometry.
 // Other geometry types don't need it because they are either fully static
 // or uploaded every frame, so transforms are always as they are intended.
@@ -445,6 +520,26 @@ RGAPI RgResult RGCONV rgUpdateGeometryTransform(
     RgInstance                              rgInstance,
     const RgUpdateTransformInfo             *pUpdateInfo);
 
+// Same as calling rgUpdateGeometryTransform for each element of pUpdateInfos.
+// Should be preferred, if a lot of movable geometries are moved in one frame.
+// Only the changed transforms are copied to the GPU, and only acceleration structures
+// that contain the moved geometries are updated.
+// All elements are validated before applying, so if some element is invalid, none of them are applied.
+RGAPI RgResult RGCONV rgUpdateGeometryTransforms(
+    RgInstance                              rgInstance,
+    uint32_t                                updateInfoCount,
+    const RgUpdateTransformInfo             *pUpdateInfos);
+
+// Update vertex positions and normals of movable static geometry in place, e.g. for
+// water surfaces or flags, instead of uploading it as dynamic geometry every frame.
+// Only the updated range is copied to the GPU, and the acceleration structure is refitted.
+// Not available, if static geometry optimization is enabled.
+// Normals are not generated for the updated vertices, and motion vectors
+// don't account for the deformation.
+RGAPI RgResult RGCONV rgUpdateGeometryVertices(
+    RgInstance                              rgInstance,
+    const RgUpdateVerticesInfo              *pUpdateInfo);
+
 RGAPI RgResult RGCONV rgUpdateGeometryTexCoords(
     RgInstance                              rgInstance,
     const RgUpdateTexCoordsInfo             *pUpdateInfo);
@@ -463,11 +558,64 @@ RGAPI RgResult RGCONV rgBeginStaticGeometries(
 // To clear static scene, call rgBeginStaticGeometries and then rgSubmitStaticGeometries
 // without uploading any geometry.
 // rgBeginStaticGeometries and rgSubmitStaticGeometries can be called outside of rgStartFrame-rgDrawFrame.
+// Static geometry is built asynchronously, the function doesn't wait for it. Until the build
+// is finished, the frames are drawn without static geometry and mesh instances.
 RGAPI RgResult RGCONV rgSubmitStaticGeometries(
     RgInstance                          rgInstance);
 
 
 
+typedef struct RgMeshInstanceUploadInfo
+{
+    // Must be unique among the mesh instances of the current frame.
+    // Used for matching instances between frames, e.g. for motion vectors.
+    uint64_t            uniqueID;
+    RgMesh              mesh;
+    RgTransform         transform;
+} RgMeshInstanceUploadInfo;
+
+// Upload geometry that is not drawn by itself, but can be drawn many times
+// with different transforms using rgUploadMeshInstances.
+// Mesh is a part of the static scene: it must be uploaded between
+// rgBeginStaticGeometries - rgSubmitStaticGeometries, and its handle is valid
+// from rgSubmitStaticGeometries until the next rgBeginStaticGeometries.
+// Geometry type must be RG_GEOMETRY_TYPE_STATIC, uniqueID and transform are ignored.
+// Normals can't be generated for meshes.
+RGAPI RgResult RGCONV rgUploadMesh(
+    RgInstance                              rgInstance,
+    const RgGeometryUploadInfo              *pUploadInfo,
+    RgMesh                                  *pResult);
+
+// Draw meshes with the specified transforms. Like dynamic geometry,
+// mesh instances are visible only in the current frame, so they must be uploaded each frame.
+// Can be called only between rgStartFrame - rgDrawFrame.
+RGAPI RgResult RGCONV rgUploadMeshInstances(
+    RgInstance                              rgInstance,
+    uint32_t                                instanceCount,
+    const RgMeshInstanceUploadInfo          *pInstances);
+
+
+// Upload static geometries as a chunk that can be added or removed independently
+// of the static scene and of the other chunks, e.g. to stream world sectors.
+// Each chunk has its own space in static buffers and its own BLAS-es, so adding
+// or removing it doesn't require rebuilding the rest of the static geometry.
+// Chunk is visible starting from the current frame (or the next one, if it's uploaded
+// outside of rgStartFrame - rgDrawFrame), until rgRemoveStaticChunk.
+// Chunks are not affected by rgBeginStaticGeometries.
+// Geometry types must be RG_GEOMETRY_TYPE_STATIC, and normals can't be generated for them.
+// Geometry unique IDs must not be the same as the ones of the mesh instances.
+RGAPI RgResult RGCONV rgUploadStaticChunk(
+    RgInstance                              rgInstance,
+    uint64_t                                chunkID,
+    uint32_t                                geometryCount,
+    const RgGeometryUploadInfo              *pGeometries);
+
+RGAPI RgResult RGCONV rgRemoveStaticChunk(
+    RgInstance                              rgInstance,
+    uint64_t                                chunkID);
+
+
+
 typedef enum RgBlendFactor
 {
     RG_BLEND_FACTOR_ONE,
@@ -1207,6 +1355,117 @@ RGAPI RgResult RGCONV rgDrawFrame(
 
 
 
+// GPU passes of a frame, which execution time is measured.
+typedef enum RgFramePass
+{
+    // Geometry and acceleration structures submission
+    RG_FRAME_PASS_SCENE,
+    RG_FRAME_PASS_RASTERIZED_SKY,
+    RG_FRAME_PASS_LIGHT_GRID,
+    RG_FRAME_PASS_PRIMARY_RAYS,
+    RG_FRAME_PASS_DECALS,
+    RG_FRAME_PASS_REFLECTIONS_REFRACTIONS,
+    RG_FRAME_PASS_DIRECT_ILLUMINATION,
+    RG_FRAME_PASS_INDIRECT_ILLUMINATION,
+    RG_FRAME_PASS_VOLUMETRIC,
+    RG_FRAME_PASS_DENOISE,
+    RG_FRAME_PASS_TONEMAPPING,
+    RG_FRAME_PASS_RASTERIZATION,
+    RG_FRAME_PASS_COMPOSITION,
+    RG_FRAME_PASS_BLOOM,
+    RG_FRAME_PASS_UPSCALE,
+    RG_FRAME_PASS_POST_EFFECTS,
+    // Rasterization into swapchain, its post-effects and presentation blit
+    RG_FRAME_PASS_SWAPCHAIN,
+    RG_FRAME_PASS_COUNT
+} RgFramePass;
+
+typedef struct RgFrameTimings
+{
+    // Timings are available only after the GPU completed the frame,
+    // so they're late by a few frames. This is the number of rgDrawFrame
+    // call that timings belong to, or 0 if there are no timings yet.
+    uint32_t                frameId;
+    // Time in milliseconds of each pass, indexed by RgFramePass.
+    // 0, if the pass wasn't executed in that frame.
+    float                   passTimesMs[RG_FRAME_PASS_COUNT];
+    // Time between the start of the first executed pass and the end of the last one.
+    float                   frameTimeMs;
+} RgFrameTimings;
+
+// Get GPU timings of the latest completed frame. It doesn't wait for the GPU.
+RGAPI RgResult RGCONV rgGetFrameTimings(
+    RgInstance                          rgInstance,
+    RgFrameTimings                      *pResult);
+
+typedef struct RgScratchBufferStats
+{
+    // Size in bytes of the ring that scratch memory is allocated from.
+    uint64_t                capacity;
+    // Scratch memory in bytes that was requested in the current frame.
+    uint64_t                currentFrameUsage;
+    // Max scratch memory in bytes that was requested during one frame,
+    // the ring is grown to it, if it doesn't fit.
+    uint64_t                highWaterMark;
+    // Count of allocations that didn't fit into the ring,
+    // a temporary buffer was created for each of them.
+    uint32_t                overflowCount;
+    // Count of times the ring was grown.
+    uint32_t                growCount;
+} RgScratchBufferStats;
+
+typedef struct RgScratchStats
+{
+    // Scratch memory of the acceleration structures that are built in each frame:
+    // dynamic geometry, static chunks and movable static geometry.
+    RgScratchBufferStats    frame;
+    // Scratch memory of the static geometry build on the compute queue.
+    RgScratchBufferStats    staticGeometry;
+} RgScratchStats;
+
+// Get statistics of the scratch memory for acceleration structure builds,
+// e.g. to find out if the buffers grow or overflow. It doesn't wait for the GPU.
+RGAPI RgResult RGCONV rgGetScratchStats(
+    RgInstance                          rgInstance,
+    RgScratchStats                      *pResult);
+
+typedef struct RgStaticGeometryOptimizationStats
+{
+    // RG_FALSE, if static geometry wasn't optimized on the last rgSubmitStaticGeometries,
+    // e.g. if optimizeStaticGeometry is disabled. Other members are zero in that case.
+    RgBool32                wasOptimized;
+    uint32_t                inputGeometryCount;
+    uint32_t                outputGeometryCount;
+    // Count of geometries that were merged into the others.
+    uint32_t                mergedGeometryCount;
+    uint32_t                inputVertexCount;
+    uint32_t                outputVertexCount;
+    uint32_t                weldedVertexCount;
+    uint32_t                inputTriangleCount;
+    uint32_t                outputTriangleCount;
+    uint32_t                degenerateTriangleCount;
+    // Count of worker threads that processed the geometries.
+    uint32_t                workerCount;
+    // CPU time of the optimization.
+    float                   durationMs;
+} RgStaticGeometryOptimizationStats;
+
+// Get statistics of the static geometry optimization that was done
+// on the last rgSubmitStaticGeometries, see optimizeStaticGeometry in RgInstanceCreateInfo.
+RGAPI RgResult RGCONV rgGetStaticGeometryOptimizationStats(
+    RgInstance                          rgInstance,
+    RgStaticGeometryOptimizationStats   *pResult);
+
+
+
+// Write CPU events of the recent frames (rgStartFrame, rgDrawFrame and their phases)
+// as a Chrome trace JSON file, it can be opened in chrome://tracing or Perfetto UI.
+// The library must be compiled with RG_WITH_CPU_TRACING option,
+// and "cputracing" entry must be in the library config file.
+RGAPI RgResult RGCONV rgWriteCpuTrace(
+    RgInstance                          rgInstance,
+    const char                          *pFilePath);
+
 RGAPI RgBool32 RGCONV rgIsRenderUpscaleTechniqueAvailable(
     RgInstance                          rgInstance,
     RgRenderUpscaleTechnique            technique);
@@ -38,7 +38,8 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
     uint32_t geometryCount, 
     const VkAccelerationStructureGeometryKHR *pGeometries,
     const uint32_t *pMaxPrimitiveCount, 
-    bool fastTrace) const
+    bool fastTrace,
+    bool isUpdateable) const
 {
     assert(geometryCount > 0);
 
@@ -51,6 +52,11 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
     buildInfo.flags = fastTrace ?
         VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR :
         VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+    if (isUpdateable)
+    {
+        // sizes depend on it
+        buildInfo.flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    }
     buildInfo.geometryCount = geometryCount;
     buildInfo.pGeometries = pGeometries;
     buildInfo.ppGeometries = nullptr;
@@ -67,11 +73,11 @@ VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBuildSizes(
 
 VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetBottomBuildSizes(
     uint32_t geometryCount,
-    const VkAccelerationStructureGeometryKHR *pGeometries, const uint32_t *pMaxPrimitiveCount, bool fastTrace) const
+    const VkAccelerationStructureGeometryKHR *pGeometries, const uint32_t *pMaxPrimitiveCount, bool fastTrace, bool isUpdateable) const
 {
     return GetBuildSizes(
         VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR, geometryCount,
-        pGeometries, pMaxPrimitiveCount, fastTrace);
+        pGeometries, pMaxPrimitiveCount, fastTrace, isUpdateable);
 }
 
 VkAccelerationStructureBuildSizesInfoKHR ASBuilder::GetTopBuildSizes(
@@ -87,7 +93,7 @@ void ASBuilder::AddBLAS(
     const VkAccelerationStructureGeometryKHR* pGeometries,
     const VkAccelerationStructureBuildRangeInfoKHR *pRangeInfos,
     const VkAccelerationStructureBuildSizesInfoKHR &buildSizes,
-    bool fastTrace, bool update, bool isBLASUpdateable)
+    bool fastTrace, bool update, bool isBLASUpdateable, bool allowCompaction)
 {
     // while building bottom level, top level must be not
     assert(topLBuildInfo.geomInfos.empty() && topLBuildInfo.rangeInfos.empty());
@@ -105,6 +111,11 @@ void ASBuilder::AddBLAS(
         flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
     }
 
+    if (allowCompaction)
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+
     VkAccelerationStructureBuildGeometryInfoKHR buildInfo = {};
     buildInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
     buildInfo.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
@@ -48,7 +48,7 @@ public:
         const VkAccelerationStructureGeometryKHR *pGeometries,
         const VkAccelerationStructureBuildRangeInfoKHR *pRangeInfos,
         const VkAccelerationStructureBuildSizesInfoKHR &buildSizes,
-        bool fastTrace, bool update, bool isBLASUpdateable);
+        bool fastTrace, bool update, bool isBLASUpdateable, bool allowCompaction);
 
     void BuildBottomLevel(VkCommandBuffer cmd);
 
@@ -69,13 +69,13 @@ public:
     VkAccelerationStructureBuildSizesInfoKHR GetBuildSizes(
         VkAccelerationStructureTypeKHR type, uint32_t geometryCount,
         const VkAccelerationStructureGeometryKHR *pGeometries,
-        const uint32_t *pMaxPrimitiveCount, bool fastTrace) const;
+        const uint32_t *pMaxPrimitiveCount, bool fastTrace, bool isUpdateable = false) const;
 
     // GetBuildSizes(..) for BLAS
     VkAccelerationStructureBuildSizesInfoKHR GetBottomBuildSizes(
         uint32_t geometryCount,
         const VkAccelerationStructureGeometryKHR *pGeometries,
-        const uint32_t *pMaxPrimitiveCount, bool fastTrace) const;
+        const uint32_t *pMaxPrimitiveCount, bool fastTrace, bool isUpdateable = false) const;
     // GetBuildSizes(..) for TLAS
     VkAccelerationStructureBuildSizesInfoKHR GetTopBuildSizes(
         const VkAccelerationStructureGeometryKHR *pGeometry,
@@ -31,7 +31,10 @@ RTGL1::BLASComponent::BLASComponent(VkDevice _device, VertexCollectorFilterTypeF
 :
     ASComponent(_device, VertexCollectorFilterTypeFlags_GetNameForBLAS(_filter)),
     filter(_filter),
-    geomCount(0)
+    geomCount(0),
+    builtContentHash(std::nullopt),
+    builtTopologyHash(std::nullopt),
+    updateCount(0)
 {}
 
 RTGL1::TLASComponent::TLASComponent(VkDevice _device, const char *_debugName)
@@ -130,6 +133,11 @@ VkDeviceAddress RTGL1::ASComponent::GetASAddress() const
     return GetASAddress(as);
 }
 
+VkBuffer RTGL1::ASComponent::GetBuffer() const
+{
+    return buffer.GetBuffer();
+}
+
 VkDeviceAddress RTGL1::ASComponent::GetASAddress(VkAccelerationStructureKHR as) const
 {
     assert(device != VK_NULL_HANDLE);
@@ -170,4 +178,35 @@ bool RTGL1::BLASComponent::IsEmpty() const
 uint32_t RTGL1::BLASComponent::GetGeomCount() const
 {
     return geomCount;
+}
+
+void RTGL1::BLASComponent::SetBuiltContentHash(std::optional<uint64_t> hash)
+{
+    builtContentHash = hash;
+}
+
+bool RTGL1::BLASComponent::IsBuiltWith(std::optional<uint64_t> hash) const
+{
+    return hash && builtContentHash && *hash == *builtContentHash;
+}
+
+void RTGL1::BLASComponent::SetBuiltTopologyHash(std::optional<uint64_t> hash)
+{
+    builtTopologyHash = hash;
+    updateCount = 0;
+}
+
+bool RTGL1::BLASComponent::CanBeUpdatedWith(std::optional<uint64_t> topologyHash) const
+{
+    return as != VK_NULL_HANDLE && topologyHash && builtTopologyHash && *topologyHash == *builtTopologyHash;
+}
+
+void RTGL1::BLASComponent::MarkUpdated()
+{
+    updateCount++;
+}
+
+uint32_t RTGL1::BLASComponent::GetUpdateCount() const
+{
+    return updateCount;
 }
\ No newline at end of file
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "Common.h"
@@ -48,6 +49,8 @@ public:
 
     VkAccelerationStructureKHR GetAS() const;
     VkDeviceAddress GetASAddress() const;
+    // Buffer that stores AS, null if not created
+    VkBuffer GetBuffer() const;
 
     bool IsValid(const VkAccelerationStructureBuildSizesInfoKHR &buildSizes) const;
 
@@ -83,6 +86,18 @@ public:
     bool IsEmpty() const;
     uint32_t GetGeomCount() const;
 
+    // Hash of geometry data that BLAS was built with. Null if unknown.
+    void SetBuiltContentHash(std::optional<uint64_t> hash);
+    bool IsBuiltWith(std::optional<uint64_t> hash) const;
+
+    // Hash of geometry topology that BLAS was fully built with, resets update count.
+    // Null if BLAS can't be updated.
+    void SetBuiltTopologyHash(std::optional<uint64_t> hash);
+    bool CanBeUpdatedWith(std::optional<uint64_t> topologyHash) const;
+    // Amount of updates since the last full build
+    void MarkUpdated();
+    uint32_t GetUpdateCount() const;
+
 protected:
     void CreateAS(VkDeviceSize size) override;
     const char *GetBufferDebugName() const override;
@@ -90,6 +105,9 @@ protected:
 private:
     VertexCollectorFilterTypeFlags filter;
     uint32_t geomCount;
+    std::optional<uint64_t> builtContentHash;
+    std::optional<uint64_t> builtTopologyHash;
+    uint32_t updateCount;
 };
 
 
@@ -20,12 +20,15 @@
 
 #include "ASManager.h"
 
+#include <algorithm>
 #include <array>
 #include <cstring>
 
 #include "Utils.h"
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+#include "Const.h"
+#include "RgException.h"
 
 using namespace RTGL1;
 
@@ -35,16 +38,33 @@ ASManager::ASManager(
     std::shared_ptr<MemoryAllocator> _allocator,
     std::shared_ptr<CommandBufferManager> _cmdManager,
     std::shared_ptr<TextureManager> _textureManager,
-    std::shared_ptr<GeomInfoManager> _geomInfoManager)
+    std::shared_ptr<GeomInfoManager> _geomInfoManager,
+    bool _compactStaticBlas,
+    VertexBufferFormat _vertexFormat,
+    uint32_t _initialStaticVertexCount,
+    uint32_t _initialDynamicVertexCount,
+    uint32_t _initialIndexCount,
+    uint32_t _staticChunkVertexCount,
+    uint32_t _staticChunkIndexCount)
 :
     device(_device),
     allocator(std::move(_allocator)),
     staticCopyFence(VK_NULL_HANDLE),
+    isStaticBuildPending(false),
+    isStaticBuildDiscarded(false),
+    isStaticRecording(false),
+    isStaticSubmitDeferred(false),
+    compactStaticBlas(_compactStaticBlas),
+    compactedSizeQueryPool(VK_NULL_HANDLE),
+    compactedSizeQueryCount(0),
+    vertexFormat(_vertexFormat),
     cmdManager(std::move(_cmdManager)),
     textureMgr(std::move(_textureManager)),
     geomInfoMgr(std::move(_geomInfoManager)),
+    submittedMeshCount(0),
     descPool(VK_NULL_HANDLE),
     buffersDescSetLayout(VK_NULL_HANDLE),
+    buffersDescSetsOutdated{},
     asDescSetLayout(VK_NULL_HANDLE)
 {
     typedef VertexCollectorFilterTypeFlags FL;
@@ -75,15 +95,35 @@ ASManager::ASManager(
     const uint32_t scratchOffsetAligment = physDevice->GetASProperties().minAccelerationStructureScratchOffsetAlignment;
     scratchBuffer = std::make_shared<ScratchBuffer>(allocator, scratchOffsetAligment);
     asBuilder = std::make_shared<ASBuilder>(device, scratchBuffer);
+    staticScratchBuffer = std::make_shared<ScratchBuffer>(allocator, scratchOffsetAligment);
+    staticAsBuilder = std::make_shared<ASBuilder>(device, staticScratchBuffer);
+
+
+    // vertex and index buffers are accessed as storage buffers in shaders, so it's the limit of their growth
+    const VkDeviceSize maxGeometryBufferSize = physDevice->GetLimits().maxStorageBufferRange;
+    const uint32_t initialIndexCount = _initialIndexCount > 0 ? _initialIndexCount : DEFAULT_INDEX_COUNT;
+
+    // only static collector has regions for chunks
+    const uint32_t staticChunkVertexCount = std::min<uint32_t>(
+        _staticChunkVertexCount > 0 ? _staticChunkVertexCount : DEFAULT_STATIC_CHUNK_VERTEX_COUNT,
+        MAX_STATIC_CHUNK_VERTEX_COUNT);
+    const uint32_t staticChunkIndexCount = std::min<uint32_t>(
+        _staticChunkIndexCount > 0 ? _staticChunkIndexCount : DEFAULT_STATIC_CHUNK_INDEX_COUNT,
+        MAX_STATIC_CHUNK_INDEXED_PRIMITIVE_COUNT * 3);
 
 
     // static and movable static vertices share the same buffer as their data won't be changing
     collectorStatic = std::make_shared<VertexCollector>(
         device, allocator, geomInfoMgr,
-        MAX_STATIC_VERTEX_COUNT * sizeof(ShVertex),
+        _initialStaticVertexCount > 0 ? _initialStaticVertexCount : DEFAULT_STATIC_VERTEX_COUNT,
+        initialIndexCount,
+        staticChunkVertexCount,
+        staticChunkIndexCount,
+        maxGeometryBufferSize,
         FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE | 
         FT::MASK_PASS_THROUGH_GROUP | 
-        FT::MASK_PRIMARY_VISIBILITY_GROUP);
+        FT::MASK_PRIMARY_VISIBILITY_GROUP,
+        vertexFormat);
 
     // subscribe to texture manager only static collector,
     // as static geometries aren't updating its material info (in ShGeometryInstance)
@@ -94,10 +134,15 @@ ASManager::ASManager(
     // dynamic vertices
     collectorDynamic[0] = std::make_shared<VertexCollector>(
         device, allocator, geomInfoMgr,
-        MAX_DYNAMIC_VERTEX_COUNT * sizeof(ShVertex),
+        _initialDynamicVertexCount > 0 ? _initialDynamicVertexCount : DEFAULT_DYNAMIC_VERTEX_COUNT,
+        initialIndexCount,
+        0,
+        0,
+        maxGeometryBufferSize,
         FT::CF_DYNAMIC | 
         FT::MASK_PASS_THROUGH_GROUP | 
-        FT::MASK_PRIMARY_VISIBILITY_GROUP);
+        FT::MASK_PRIMARY_VISIBILITY_GROUP,
+        vertexFormat);
 
     // other dynamic vertex collectors should share the same device local buffers as the first one
     for (uint32_t i = 1; i < MAX_FRAMES_IN_FLIGHT; i++)
@@ -105,13 +150,16 @@ ASManager::ASManager(
         collectorDynamic[i] = std::make_shared<VertexCollector>(collectorDynamic[0], allocator);
     }
 
-    previousDynamicPositions.Init(
-        allocator, MAX_DYNAMIC_VERTEX_COUNT * sizeof(ShVertex),
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+    // same layouts as dynamic vertex and index buffers, they're grown together
+    previousDynamicPositions = std::make_shared<Buffer>();
+    previousDynamicPositions->Init(
+        allocator, collectorDynamic[0]->GetVertexBufferSize(),
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's vertex data");
-    previousDynamicIndices.Init(
-        allocator, MAX_DYNAMIC_VERTEX_COUNT * sizeof(uint32_t),
-        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+    previousDynamicIndices = std::make_shared<Buffer>();
+    previousDynamicIndices->Init(
+        allocator, collectorDynamic[0]->GetIndexBufferSize(),
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, "Previous frame's index data");
 
 
@@ -121,12 +169,11 @@ ASManager::ASManager(
     VkDeviceSize instanceBufferSize = MAX_TOP_LEVEL_INSTANCE_COUNT * sizeof(VkAccelerationStructureInstanceKHR);
     instanceBuffer->Create(instanceBufferSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, "TLAS instance buffer");
 
-    static_assert(std::size(TLASPrepareResult{}.instances) == MAX_TOP_LEVEL_INSTANCE_COUNT);
 
 
     CreateDescriptors();
 
-    // buffers won't be changing, update once
+    // buffers are changed only on growth
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         UpdateBufferDescriptors(i);
@@ -270,7 +317,8 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
 
     // buffer infos
     VkDescriptorBufferInfo &stVertsBufInfo = bufferInfos[BINDING_VERTEX_BUFFER_STATIC];
-    stVertsBufInfo.buffer = collectorStatic->GetVertexBuffer();
+    // while static geometry is being built, the previous static buffers are in use
+    stVertsBufInfo.buffer = boundStaticVertices ? boundStaticVertices->GetBuffer() : collectorStatic->GetVertexBuffer();
     stVertsBufInfo.offset = 0;
     stVertsBufInfo.range = VK_WHOLE_SIZE;
 
@@ -280,7 +328,7 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
     dnVertsBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &stIndexBufInfo = bufferInfos[BINDING_INDEX_BUFFER_STATIC];
-    stIndexBufInfo.buffer = collectorStatic->GetIndexBuffer();
+    stIndexBufInfo.buffer = boundStaticIndices ? boundStaticIndices->GetBuffer() : collectorStatic->GetIndexBuffer();
     stIndexBufInfo.offset = 0;
     stIndexBufInfo.range = VK_WHOLE_SIZE;
 
@@ -300,12 +348,12 @@ void ASManager::UpdateBufferDescriptors(uint32_t frameIndex)
     gpBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &ppBufInfo = bufferInfos[BINDING_PREV_POSITIONS_BUFFER_DYNAMIC];
-    ppBufInfo.buffer = previousDynamicPositions.GetBuffer();
+    ppBufInfo.buffer = previousDynamicPositions->GetBuffer();
     ppBufInfo.offset = 0;
     ppBufInfo.range = VK_WHOLE_SIZE;
 
     VkDescriptorBufferInfo &piBufInfo = bufferInfos[BINDING_PREV_INDEX_BUFFER_DYNAMIC];
-    piBufInfo.buffer = previousDynamicIndices.GetBuffer();
+    piBufInfo.buffer = previousDynamicIndices->GetBuffer();
     piBufInfo.offset = 0;
     piBufInfo.range = VK_WHOLE_SIZE;
 
@@ -417,6 +465,42 @@ ASManager::~ASManager()
         as->Destroy();
     }
 
+    for (auto &as : allMeshBlas)
+    {
+        as->Destroy();
+    }
+
+    for (auto &as : retiredMeshBlas)
+    {
+        as->Destroy();
+    }
+
+    for (auto &as : pendingStaticBlas)
+    {
+        as->Destroy();
+    }
+
+    for (auto &as : pendingMeshBlas)
+    {
+        as->Destroy();
+    }
+
+    for (auto &[chunkID, blasArr] : chunkBlas)
+    {
+        for (auto &as : blasArr)
+        {
+            as->Destroy();
+        }
+    }
+
+    for (auto &blasArr : retiredChunkBlas)
+    {
+        for (auto &as : blasArr)
+        {
+            as->Destroy();
+        }
+    }
+
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         for (auto &as : allDynamicBlas[i])
@@ -431,9 +515,14 @@ ASManager::~ASManager()
     vkDestroyDescriptorSetLayout(device, buffersDescSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(device, asDescSetLayout, nullptr);
     vkDestroyFence(device, staticCopyFence, nullptr);
+
+    if (compactedSizeQueryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device, compactedSizeQueryPool, nullptr);
+    }
 }
 
-bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector)
+bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector, ASBuilder &builder)
 {
     auto filter = blas.GetFilter();
     const std::vector<VkAccelerationStructureGeometryKHR> &geoms = vertCollector->GetASGeometries(filter);
@@ -450,9 +539,13 @@ bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexColle
 
     const bool fastTrace = !IsFastBuild(filter);
     const bool update = false;
+    // movable and dynamic can be updated later
+    const bool isUpdateable = filter & (VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE | VertexCollectorFilterTypeFlagBits::CF_DYNAMIC);
+    // movable are updated in place, so they must keep the full size
+    const bool allowCompaction = compactStaticBlas && (filter & VertexCollectorFilterTypeFlagBits::CF_STATIC_NON_MOVABLE);
 
     // get AS size and create buffer for AS
-    const auto buildSizes = asBuilder->GetBottomBuildSizes(geoms.size(), geoms.data(), primCounts.data(), fastTrace);
+    const auto buildSizes = builder.GetBottomBuildSizes(geoms.size(), geoms.data(), primCounts.data(), fastTrace, isUpdateable);
 
     // if no buffer, or it was created, but its size is too small for current AS
     blas.RecreateIfNotValid(buildSizes, allocator);
@@ -460,15 +553,65 @@ bool ASManager::SetupBLAS(BLASComponent &blas, const std::shared_ptr<VertexColle
     assert(blas.GetAS() != VK_NULL_HANDLE);
 
     // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
-    asBuilder->AddBLAS(blas.GetAS(), geoms.size(),
-                       geoms.data(), ranges.data(),
-                       buildSizes,
-                       fastTrace, update, blas.GetFilter() & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE);
+    builder.AddBLAS(blas.GetAS(), geoms.size(),
+                    geoms.data(), ranges.data(),
+                    buildSizes,
+                    fastTrace, update, isUpdateable, allowCompaction);
 
     return true;
 }
 
-void ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector)
+void ASManager::SetupMeshBLAS(BLASComponent &blas, uint32_t meshIndex, ASBuilder &builder)
+{
+    const VkAccelerationStructureGeometryKHR &geom = collectorStatic->GetMeshASGeometry(meshIndex);
+    const VkAccelerationStructureBuildRangeInfoKHR &range = collectorStatic->GetMeshASBuildRangeInfo(meshIndex);
+    const uint32_t &primCount = collectorStatic->GetMeshPrimitiveCount(meshIndex);
+
+    // mesh has only one geometry
+    blas.SetGeometryCount(1);
+
+    // meshes are not changing, so fast trace
+    const bool fastTrace = true;
+    const bool update = false;
+
+    const auto buildSizes = builder.GetBottomBuildSizes(1, &geom, &primCount, fastTrace);
+
+    blas.RecreateIfNotValid(buildSizes, allocator);
+
+    assert(blas.GetAS() != VK_NULL_HANDLE);
+
+    // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
+    builder.AddBLAS(blas.GetAS(), 1,
+                    &geom, &range,
+                    buildSizes,
+                    fastTrace, update, false, compactStaticBlas);
+}
+
+void ASManager::SetupChunkBLAS(BLASComponent &blas, const VertexCollector::ChunkGroup &group)
+{
+    const uint32_t geomCount = (uint32_t)group.asGeometries.size();
+    assert(geomCount > 0);
+
+    blas.SetGeometryCount(geomCount);
+
+    // chunks are not changing, so fast trace
+    const bool fastTrace = true;
+    const bool update = false;
+
+    const auto buildSizes = asBuilder->GetBottomBuildSizes(geomCount, group.asGeometries.data(), group.primitiveCounts.data(), fastTrace);
+
+    blas.RecreateIfNotValid(buildSizes, allocator);
+
+    assert(blas.GetAS() != VK_NULL_HANDLE);
+
+    // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
+    asBuilder->AddBLAS(blas.GetAS(), geomCount,
+                       group.asGeometries.data(), group.asBuildRangeInfos.data(),
+                       buildSizes,
+                       fastTrace, update, false, false);
+}
+
+bool ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexCollector> &vertCollector)
 {
     auto filter = blas.GetFilter();
     const std::vector<VkAccelerationStructureGeometryKHR> &geoms = vertCollector->GetASGeometries(filter);
@@ -477,7 +620,7 @@ void ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexColl
 
     if (blas.IsEmpty())
     {
-        return;
+        return false;
     }
 
     const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &ranges = vertCollector->GetASBuildRangeInfos(filter);
@@ -489,7 +632,7 @@ void ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexColl
     const bool update = true;
 
     const auto buildSizes = asBuilder->GetBottomBuildSizes(
-        geoms.size(), geoms.data(), primCounts.data(), fastTrace);
+        geoms.size(), geoms.data(), primCounts.data(), fastTrace, true);
 
     assert(blas.IsValid(buildSizes));
     assert(blas.GetAS() != VK_NULL_HANDLE);
@@ -498,7 +641,9 @@ void ASManager::UpdateBLAS(BLASComponent &blas, const std::shared_ptr<VertexColl
     asBuilder->AddBLAS(blas.GetAS(), geoms.size(),
                        geoms.data(), ranges.data(),
                        buildSizes,
-                       fastTrace, update, blas.GetFilter() & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE);
+                       fastTrace, update, true, false);
+
+    return true;
 }
 
 // separate functions to make adding between Begin..Geometry() and Submit..Geometry() a bit clearer
@@ -521,7 +666,7 @@ uint32_t ASManager::AddStaticGeometry(uint32_t frameIndex, const RgGeometryUploa
     return UINT32_MAX;
 }
 
-uint32_t ASManager::AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info)
+bool ASManager::AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info)
 {
     if (info.geomType == RG_GEOMETRY_TYPE_DYNAMIC)
     {
@@ -532,91 +677,737 @@ uint32_t ASManager::AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUplo
             textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[2]),
         };
 
-        return collectorDynamic[frameIndex]->AddGeometry(frameIndex, info, materials);
+        return collectorDynamic[frameIndex]->AddGeometryDeferred(frameIndex, info, materials);
     }
 
     assert(0);
-    return UINT32_MAX;
+    return false;
+}
+
+void ASManager::GetMaterialTextures(std::span<const RgGeometryUploadInfo> infos, std::vector<MaterialTextures> &result) const
+{
+    result.resize(infos.size() * 3);
+
+    for (size_t i = 0; i < infos.size(); i++)
+    {
+        for (uint32_t layer = 0; layer < 3; layer++)
+        {
+            result[i * 3 + layer] = textureMgr->GetMaterialTextures(infos[i].geomMaterial.layerMaterials[layer]);
+        }
+    }
+}
+
+void ASManager::AddStaticGeometries(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<uint32_t> outSimpleIndices)
+{
+    assert(std::ranges::all_of(infos, [](const RgGeometryUploadInfo &info)
+    {
+        return info.geomType == RG_GEOMETRY_TYPE_STATIC || info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE;
+    }));
+
+    std::vector<MaterialTextures> materials;
+    GetMaterialTextures(infos, materials);
+
+    collectorStatic->AddGeometries(frameIndex, infos, materials, outSimpleIndices);
+}
+
+void ASManager::AddDynamicGeometries(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<uint32_t> outResults)
+{
+    assert(std::ranges::all_of(infos, [](const RgGeometryUploadInfo &info)
+    {
+        return info.geomType == RG_GEOMETRY_TYPE_DYNAMIC;
+    }));
+
+    std::vector<MaterialTextures> materials;
+    GetMaterialTextures(infos, materials);
+
+    collectorDynamic[frameIndex]->AddGeometriesDeferred(frameIndex, infos, materials, outResults);
+}
+
+bool ASManager::AcquireDynamicGeometryMemory(uint32_t frameIndex, uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices)
+{
+    return collectorDynamic[frameIndex]->AcquireMemory(vertexCount, indexCount, ppOutVertices, ppOutIndices);
+}
+
+RgMesh ASManager::AddMesh(uint32_t frameIndex, const RgGeometryUploadInfo &info)
+{
+    MaterialTextures materials[] =
+    {
+        textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[0]),
+        textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[1]),
+        textureMgr->GetMaterialTextures(info.geomMaterial.layerMaterials[2]),
+    };
+
+    // transform of each instance is applied in TLAS
+    RgGeometryUploadInfo meshInfo = info;
+    meshInfo.transform =
+    {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f
+    };
+
+    // lock, so mesh indices in collectorStatic and in meshMaterials are the same
+    std::lock_guard<std::mutex> lock(meshMutex);
+
+    uint32_t meshIndex = collectorStatic->AddMesh(frameIndex, meshInfo, materials);
+
+    if (meshIndex == UINT32_MAX)
+    {
+        return RG_NO_MESH;
+    }
+
+    assert(meshIndex == meshMaterials.size());
+    meshMaterials.push_back(info.geomMaterial);
+
+    // RG_NO_MESH is 0
+    return meshIndex + 1;
+}
+
+bool ASManager::IsMeshValid(RgMesh mesh) const
+{
+    // meshes can be used only after the submission
+    return mesh != RG_NO_MESH && mesh - 1 < submittedMeshCount.load();
+}
+
+bool ASManager::AddMeshInstances(uint32_t frameIndex, std::span<const RgMeshInstanceUploadInfo> infos)
+{
+    std::lock_guard<std::mutex> lock(meshMutex);
+
+    auto &instances = meshInstances[frameIndex];
+
+    if (instances.size() + infos.size() > MAX_MESH_INSTANCE_COUNT)
+    {
+        return false;
+    }
+
+    // check under the lock, as a new static scene could be started concurrently;
+    // nothing is added, if any of the handles is invalid
+    for (const RgMeshInstanceUploadInfo &info : infos)
+    {
+        if (!IsMeshValid(info.mesh) || info.mesh - 1 >= meshMaterials.size())
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Mesh instance with ID=" + std::to_string(info.uniqueID) + " has invalid mesh handle");
+        }
+    }
+
+    for (const RgMeshInstanceUploadInfo &info : infos)
+    {
+        instances.push_back(MeshInstance
+        {
+            .uniqueID = info.uniqueID,
+            .meshIndex = info.mesh - 1,
+            .transform = info.transform,
+            .globalGeomIndex = UINT32_MAX,
+        });
+    }
+
+    return true;
+}
+
+void ASManager::SubmitMeshInstances(uint32_t frameIndex)
+{
+    auto &instances = meshInstances[frameIndex];
+
+    // mesh BLAS-es are not built yet, so instances are skipped in TLAS
+    if (IsStaticGeometryPending())
+    {
+        return;
+    }
+
+    // instances could be added concurrently, so sort them to make 
+    // geometry infos independent from the order of the calls
+    std::sort(instances.begin(), instances.end(), [] (const MeshInstance &a, const MeshInstance &b)
+    {
+        return a.uniqueID < b.uniqueID;
+    });
+
+    for (MeshInstance &inst : instances)
+    {
+        assert(inst.meshIndex < meshMaterials.size());
+        const RgLayeredMaterial &m = meshMaterials[inst.meshIndex];
+
+        MaterialTextures materials[] =
+        {
+            textureMgr->GetMaterialTextures(m.layerMaterials[0]),
+            textureMgr->GetMaterialTextures(m.layerMaterials[1]),
+            textureMgr->GetMaterialTextures(m.layerMaterials[2]),
+        };
+
+        inst.globalGeomIndex = collectorStatic->WriteMeshInstanceGeomInfo(frameIndex, inst.meshIndex, inst.uniqueID, inst.transform, materials);
+    }
+}
+
+bool ASManager::AddStaticChunk(uint64_t chunkID, uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos)
+{
+    std::vector<MaterialTextures> materials;
+    GetMaterialTextures(infos, materials);
+
+    if (!collectorStatic->AddChunk(chunkID, frameIndex, infos, materials))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    chunksToBuild.push_back(chunkID);
+
+    return true;
+}
+
+void ASManager::RemoveStaticChunk(uint64_t chunkID, uint32_t frameIndex)
+{
+    std::lock_guard<std::mutex> lock(chunkMutex);
+
+    collectorStatic->RemoveChunk(chunkID, frameIndex);
+
+    // if it wasn't built yet
+    std::erase(chunksToBuild, chunkID);
+
+    auto f = chunkBlas.find(chunkID);
+
+    if (f != chunkBlas.end())
+    {
+        for (auto &blas : f->second)
+        {
+            retiredChunkBlas[frameIndex].push_back(std::move(blas));
+        }
+
+        chunkBlas.erase(f);
+    }
+}
+
+void ASManager::SubmitStaticChunks(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    std::lock_guard<std::mutex> lock(chunkMutex);
+
+    CmdLabel label(cmd, "Building static chunk BLAS");
+
+    collectorStatic->CopyChunksFromStaging(cmd);
+
+    assert(asBuilder->IsEmpty());
+
+    // while static geometry is being built, data of the new chunks is copied only
+    // to the new static buffers, so the chunks are built when those buffers are bound
+    if (!chunksToBuild.empty() && !boundStaticVertices)
+    {
+        // only new chunks are built, the other ones are just placed in TLAS
+        for (uint64_t chunkID : chunksToBuild)
+        {
+            const auto *groups = collectorStatic->GetChunkGroups(chunkID);
+            assert(groups != nullptr);
+
+            auto &blasArr = chunkBlas[chunkID];
+            assert(blasArr.empty());
+
+            for (const auto &group : *groups)
+            {
+                blasArr.push_back(std::make_unique<BLASComponent>(device, group.filter));
+                SetupChunkBLAS(*blasArr.back(), group);
+            }
+        }
+
+        chunksToBuild.clear();
+
+        asBuilder->BuildBottomLevel(cmd);
+
+        // sync AS access
+        Utils::ASBuildMemoryBarrier(cmd);
+    }
+
+    // chunk geometry infos are placed in the same region as the mesh instances' ones,
+    // so they're written every frame
+    for (const auto &[chunkID, blasArr] : chunkBlas)
+    {
+        collectorStatic->WriteChunkGeomInfos(frameIndex, chunkID, *textureMgr);
+    }
 }
 
 void ASManager::ResetStaticGeometry()
 {
+    DiscardPendingStaticGeometry();
+
     collectorStatic->Reset();
     geomInfoMgr->ResetWithStatic();
+
+    RetireMeshes();
+
+    isStaticRecording = true;
 }
 
 void ASManager::BeginStaticGeometry()
 {
+    DiscardPendingStaticGeometry();
+
     // the whole static vertex data must be recreated, clear previous data
     collectorStatic->Reset();
     geomInfoMgr->ResetWithStatic();
 
+    RetireMeshes();
+
     collectorStatic->BeginCollecting(true);
+    isStaticRecording = true;
+}
+
+void ASManager::DiscardPendingStaticGeometry()
+{
+    // the static data is being replaced, so the deferred submission is not needed
+    isStaticSubmitDeferred = false;
+
+    if (!isStaticBuildPending)
+    {
+        return;
+    }
+
+    // the build can't be cancelled, but its results won't be used,
+    // as the static data it was recorded with is being replaced;
+    // the previous static BLAS-es stay in use until the next build is finished
+    isStaticBuildDiscarded = true;
+    blasToCompact.clear();
+}
+
+void ASManager::RetireMeshes()
+{
+    std::lock_guard<std::mutex> lock(meshMutex);
+
+    // instances of the previous meshes can't be used anymore
+    for (auto &instances : meshInstances)
+    {
+        instances.clear();
+    }
+
+    meshMaterials.clear();
+
+    // BLAS can be in use by the frames in flight, so they're retired on the next frame
+    for (auto &blas : allMeshBlas)
+    {
+        retiredMeshBlas.push_back(std::move(blas));
+    }
+
+    allMeshBlas.clear();
+    submittedMeshCount = 0;
 }
 
-void ASManager::SubmitStaticGeometry()
+void ASManager::SubmitStaticGeometry(uint32_t frameIndex)
 {
     collectorStatic->EndCollecting();
+    isStaticRecording = false;
 
-    // static geometry submission happens very infrequently, e.g. on level load
-    vkDeviceWaitIdle(device);
+    // meshes can be referenced from now on, but their instances
+    // are skipped in TLAS until the build is finished
+    submittedMeshCount = collectorStatic->GetMeshCount();
+
+    // the frames must not wait for the previous build, so the new one
+    // is recorded when the previous one is finished, and its results are dropped
+    if (isStaticBuildPending)
+    {
+        isStaticBuildDiscarded = true;
+        isStaticSubmitDeferred = true;
+        blasToCompact.clear();
+        return;
+    }
 
+    RecordStaticBuild(frameIndex);
+}
+
+void ASManager::RecordStaticBuild(uint32_t frameIndex)
+{
     typedef VertexCollectorFilterTypeFlagBits FT;
 
-    auto staticFlags = FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE;
+    assert(!isStaticBuildPending);
+    assert(pendingStaticBlas.empty() && pendingMeshBlas.empty());
+    assert(staticAsBuilder->IsEmpty());
+
+    isStaticSubmitDeferred = false;
 
-    // destroy previous static
-    for (auto &staticBlas : allStaticBlas)
+    // staging buffers that were replaced on growth could be read by the chunk copies of the frames in flight
+    collectorStatic->RetireStaging(retiredGeometryBuffers[frameIndex]);
+
+    if (!boundStaticVertices)
+    {
+        // static buffers in use stay bound, until the new ones are filled by the build
+        collectorStatic->ReplaceDeviceBuffers(boundStaticVertices, boundStaticIndices, retiredGeometryBuffers[frameIndex]);
+    }
+    else if (collectorStatic->NeedsDeviceBufferGrowth())
     {
-        assert(!(staticBlas->GetFilter() & FT::CF_DYNAMIC));
+        // buffers of the discarded build were never bound, but the frames in flight could copy chunk data to them
+        collectorStatic->GrowDeviceBuffers(retiredGeometryBuffers[frameIndex]);
+    }
 
-        // if flags have any of static bits
-        if (staticBlas->GetFilter() & staticFlags)
+    // the previous build is finished, so the static scratch buffer is not in use
+    staticScratchBuffer->Reset();
+
+    // record to the compute queue, the frames are not waiting for it
+    VkCommandBuffer cmd = cmdManager->StartAsyncComputeCmd();
+
+    // copy from staging with barrier
+    collectorStatic->CopyFromStaging(cmd);
+
+    // BLAS for each static filter, even if it's empty, as it replaces the one in use
+    VertexCollectorFilterTypeFlags_IterateOverFlags([this] (VertexCollectorFilterTypeFlags filter)
+    {
+        if (!(filter & FT::CF_DYNAMIC))
         {
-            staticBlas->Destroy();
-            staticBlas->SetGeometryCount(0);
+            pendingStaticBlas.push_back(std::make_unique<BLASComponent>(device, filter));
+            SetupBLAS(*pendingStaticBlas.back(), collectorStatic, *staticAsBuilder);
         }
+    });
+
+    // each mesh has its own BLAS
+    for (uint32_t i = 0; i < collectorStatic->GetMeshCount(); i++)
+    {
+        pendingMeshBlas.push_back(std::make_unique<BLASComponent>(device, collectorStatic->GetMeshFilter(i)));
+        SetupMeshBLAS(*pendingMeshBlas.back(), i, *staticAsBuilder);
     }
 
-    assert(asBuilder->IsEmpty());
+    // all static geometries can be empty
+    if (!staticAsBuilder->IsEmpty())
+    {
+        staticAsBuilder->BuildBottomLevel(cmd);
+
+        if (compactStaticBlas)
+        {
+            QueryCompactedSizes(cmd);
+        }
+    }
+
+    TransferStaticOwnership(cmd, true);
+
+    // static geom infos are copied in TryFinishStaticGeometry,
+    // as the frames are reading geom info buffer concurrently
+    cmdManager->Submit(cmd, staticCopyFence);
+    isStaticBuildPending = true;
+}
+
+bool ASManager::TryFinishStaticGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (!isStaticBuildPending)
+    {
+        return false;
+    }
+
+    // never wait, just check
+    VkResult r = vkGetFenceStatus(device, staticCopyFence);
+
+    if (r == VK_NOT_READY)
+    {
+        return false;
+    }
+
+    VK_CHECKERROR(r);
+
+    r = vkResetFences(device, 1, &staticCopyFence);
+    VK_CHECKERROR(r);
+
+    isStaticBuildPending = false;
+
+    if (isStaticBuildDiscarded)
+    {
+        isStaticBuildDiscarded = false;
+
+        // the build is finished, and its BLAS-es were never in use
+        pendingStaticBlas.clear();
+        pendingMeshBlas.clear();
+
+        if (isStaticSubmitDeferred)
+        {
+            RecordStaticBuild(frameIndex);
+        }
+
+        return false;
+    }
+
+    CmdLabel label(cmd, "Acquiring static BLAS");
+
+    TransferStaticOwnership(cmd, false);
+
+    // compacted sizes are available, as the build is finished
+    CompactStaticBlas(cmd, frameIndex);
+
+    SwapStaticBlas(frameIndex);
+
+    // the new static buffers are filled, the previous ones can be in use by the frames in flight
+    assert(boundStaticVertices && boundStaticIndices);
+    retiredGeometryBuffers[frameIndex].push_back(std::move(boundStaticVertices));
+    retiredGeometryBuffers[frameIndex].push_back(std::move(boundStaticIndices));
+
+    UpdateBufferDescriptors(frameIndex);
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        buffersDescSetsOutdated[i] = i != frameIndex;
+    }
+
+    // static geom infos will be copied with the other ones of this frame
+    geomInfoMgr->MarkStaticGeomInfosToCopy(frameIndex);
+
+    return true;
+}
+
+void ASManager::SwapStaticBlas(uint32_t frameIndex)
+{
+    // previous ones can be in use by the frames in flight
+    for (auto &blas : allStaticBlas)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(blas));
+    }
+
+    for (auto &blas : allMeshBlas)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(blas));
+    }
+
+    allStaticBlas = std::move(pendingStaticBlas);
+    allMeshBlas = std::move(pendingMeshBlas);
+
+    pendingStaticBlas.clear();
+    pendingMeshBlas.clear();
+}
+
+void ASManager::QueryCompactedSizes(VkCommandBuffer cmd)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
 
-    // skip if all static geometries are empty
-    if (collectorStatic->AreGeometriesEmpty(staticFlags))
+    assert(blasToCompact.empty());
+
+    // movable are updated in place, so they're not compacted
+    for (auto &blas : pendingStaticBlas)
+    {
+        if ((blas->GetFilter() & FT::CF_STATIC_NON_MOVABLE) && !blas->IsEmpty())
+        {
+            blasToCompact.push_back(&blas);
+        }
+    }
+
+    for (auto &blas : pendingMeshBlas)
+    {
+        blasToCompact.push_back(&blas);
+    }
+
+    if (blasToCompact.empty())
     {
         return;
     }
 
-    VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+    const uint32_t queryCount = (uint32_t)blasToCompact.size();
 
-    // copy from staging with barrier
-    collectorStatic->CopyFromStaging(cmd);
+    // recreate, if there are more BLAS-es than the pool can hold;
+    // the previous static build is finished, so the pool is not in use
+    if (queryCount > compactedSizeQueryCount)
+    {
+        if (compactedSizeQueryPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, compactedSizeQueryPool, nullptr);
+        }
+
+        compactedSizeQueryCount = std::max(queryCount, compactedSizeQueryCount * 2);
+
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+        poolInfo.queryCount = compactedSizeQueryCount;
 
-    // setup static blas
-    for (auto &staticBlas : allStaticBlas)
+        VkResult r = vkCreateQueryPool(device, &poolInfo, nullptr, &compactedSizeQueryPool);
+        VK_CHECKERROR(r);
+
+        SET_DEBUG_NAME(device, compactedSizeQueryPool, VK_OBJECT_TYPE_QUERY_POOL, "BLAS compacted size query pool");
+    }
+
+    std::vector<VkAccelerationStructureKHR> ases;
+    ases.reserve(queryCount);
+
+    for (const auto *blas : blasToCompact)
+    {
+        ases.push_back((*blas)->GetAS());
+    }
+
+    vkCmdResetQueryPool(cmd, compactedSizeQueryPool, 0, queryCount);
+
+    // wait for the build
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+    barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+        0,
+        1, &barrier,
+        0, nullptr,
+        0, nullptr);
+
+    svkCmdWriteAccelerationStructuresPropertiesKHR(
+        cmd, queryCount, ases.data(),
+        VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, compactedSizeQueryPool, 0);
+}
+
+void ASManager::CompactStaticBlas(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    if (blasToCompact.empty())
+    {
+        return;
+    }
+
+    const uint32_t queryCount = (uint32_t)blasToCompact.size();
+    std::vector<VkDeviceSize> compactedSizes(queryCount);
+
+    VkResult r = vkGetQueryPoolResults(
+        device, compactedSizeQueryPool, 0, queryCount,
+        queryCount * sizeof(VkDeviceSize), compactedSizes.data(), sizeof(VkDeviceSize),
+        VK_QUERY_RESULT_64_BIT);
+
+    // just keep the original ones
+    if (r != VK_SUCCESS)
+    {
+        blasToCompact.clear();
+        return;
+    }
+
+    CmdLabel label(cmd, "Compacting static BLAS");
+
+    bool anyCopied = false;
+
+    for (uint32_t i = 0; i < queryCount; i++)
     {
-        // if flags have any of static bits
-        if (staticBlas->GetFilter() & staticFlags)
+        std::unique_ptr<BLASComponent> &original = *blasToCompact[i];
+
+        if (compactedSizes[i] == 0)
         {
-            SetupBLAS(*staticBlas, collectorStatic);
+            continue;
         }
+
+        auto compacted = std::make_unique<BLASComponent>(device, original->GetFilter());
+        compacted->SetGeometryCount(original->GetGeomCount());
+
+        VkAccelerationStructureBuildSizesInfoKHR sizes = {};
+        sizes.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
+        sizes.accelerationStructureSize = compactedSizes[i];
+
+        compacted->RecreateIfNotValid(sizes, allocator);
+
+        VkCopyAccelerationStructureInfoKHR copyInfo = {};
+        copyInfo.sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR;
+        copyInfo.src = original->GetAS();
+        copyInfo.dst = compacted->GetAS();
+        copyInfo.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+
+        svkCmdCopyAccelerationStructureKHR(cmd, &copyInfo);
+
+        // original can be used by this frame until the copy is done
+        retiredStaticBlas[frameIndex].push_back(std::move(original));
+        original = std::move(compacted);
+
+        anyCopied = true;
     }
-    
-    // build AS
-    asBuilder->BuildBottomLevel(cmd);
 
-    // submit geom info, in case if rgStartNewScene and rgSubmitStaticGeometries 
-    // were out of rgStartFrame - rgDrawFrame, so static geominfo-s won't be
-    // erased on GeomInfoManager::PrepareForFrame
-    geomInfoMgr->CopyFromStaging(cmd, 0, false);
+    blasToCompact.clear();
 
-    // submit and wait
-    cmdManager->Submit(cmd, staticCopyFence);
-    Utils::WaitAndResetFence(device, staticCopyFence);
+    if (anyCopied)
+    {
+        // compacted BLAS-es are used in TLAS building and in ray tracing
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+        barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+            0,
+            1, &barrier,
+            0, nullptr,
+            0, nullptr);
+    }
+}
+
+bool ASManager::IsStaticGeometryPending() const
+{
+    return isStaticRecording || isStaticBuildPending || isStaticSubmitDeferred;
+}
+
+void ASManager::TransferStaticOwnership(VkCommandBuffer cmd, bool isRelease)
+{
+    const uint32_t computeFamily = cmdManager->GetComputeQueueFamily();
+    const uint32_t graphicsFamily = cmdManager->GetGraphicsQueueFamily();
+
+    if (computeFamily == graphicsFamily)
+    {
+        // the fence is signaled, just make the results visible for the frame
+        if (!isRelease)
+        {
+            VkMemoryBarrier b = {};
+            b.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+            b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+
+            vkCmdPipelineBarrier(
+                cmd,
+                VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                0,
+                1, &b,
+                0, nullptr,
+                0, nullptr);
+        }
+
+        return;
+    }
+
+    collectorStatic->TransferOwnership(cmd, computeFamily, graphicsFamily, isRelease);
+
+    std::vector<VkBufferMemoryBarrier> barriers;
+
+    auto addBlas = [&] (const BLASComponent &blas)
+    {
+        if (blas.GetBuffer() == VK_NULL_HANDLE || blas.IsEmpty())
+        {
+            return;
+        }
+
+        VkBufferMemoryBarrier b = {};
+        b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        b.srcQueueFamilyIndex = computeFamily;
+        b.dstQueueFamilyIndex = graphicsFamily;
+        b.srcAccessMask = isRelease ? VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR : 0;
+        b.dstAccessMask = isRelease ? 0 : VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+        b.buffer = blas.GetBuffer();
+        b.offset = 0;
+        b.size = VK_WHOLE_SIZE;
+
+        barriers.push_back(b);
+    };
+
+    // static BLAS-es are transferred before they're swapped with the ones in use
+    for (const auto &blas : pendingStaticBlas)
+    {
+        addBlas(*blas);
+    }
+
+    for (const auto &blas : pendingMeshBlas)
+    {
+        addBlas(*blas);
+    }
+
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    vkCmdPipelineBarrier(
+        cmd,
+        isRelease ? VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+        0,
+        0, nullptr,
+        (uint32_t)barriers.size(), barriers.data(),
+        0, nullptr);
 }
 
 void ASManager::BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
 {
-    scratchBuffer->Reset();
+    // scratch memory of the frame with the same index is not used anymore
+    scratchBuffer->BeginFrame(frameIndex);
 
     static_assert(MAX_FRAMES_IN_FLIGHT == 2, "");
     uint32_t prevFrameIndex = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -627,6 +1418,46 @@ void ASManager::BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
     // dynamic AS must be recreated
     collectorDynamic[frameIndex]->Reset();
     collectorDynamic[frameIndex]->BeginCollecting(false);
+
+    // frame with this index is finished, so the buffers that were replaced on growth are not in use
+    collectorDynamic[frameIndex]->DestroyRetiredStaging();
+    retiredGeometryBuffers[frameIndex].clear();
+    retiredInstanceBuffers[frameIndex].clear();
+
+    // buffers were grown in the other frame, while this frame's descriptor set was in use
+    if (buffersDescSetsOutdated[frameIndex])
+    {
+        UpdateBufferDescriptors(frameIndex);
+        buffersDescSetsOutdated[frameIndex] = false;
+    }
+
+    // frame with this index is finished, so the replaced static BLAS-es are not in use
+    retiredStaticBlas[frameIndex].clear();
+
+    // meshes of the previous static scene can be used only by the frames in flight
+    for (auto &blas : retiredMeshBlas)
+    {
+        retiredStaticBlas[frameIndex].push_back(std::move(blas));
+    }
+
+    retiredMeshBlas.clear();
+
+    // frame with this index is finished, so the removed chunks are not in use
+    {
+        std::lock_guard<std::mutex> lock(chunkMutex);
+
+        for (auto &blas : retiredChunkBlas[frameIndex])
+        {
+            blas->Destroy();
+        }
+
+        retiredChunkBlas[frameIndex].clear();
+        collectorStatic->FreeRemovedChunks(frameIndex);
+    }
+
+    // mesh instances are uploaded every frame
+    std::lock_guard<std::mutex> lock(meshMutex);
+    meshInstances[frameIndex].clear();
 }
 
 void ASManager::SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
@@ -637,7 +1468,14 @@ void ASManager::SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
 
     const auto &colDyn = collectorDynamic[frameIndex];
 
+    // register geometries that were added concurrently
     colDyn->EndCollecting();
+
+    if (colDyn->NeedsDeviceBufferGrowth())
+    {
+        GrowDynamicBuffers(cmd, frameIndex);
+    }
+
     colDyn->CopyFromStaging(cmd);
 
     assert(asBuilder->IsEmpty());
@@ -650,7 +1488,32 @@ void ASManager::SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex)
         // must be dynamic
         assert(dynamicBlas->GetFilter() & FT::CF_DYNAMIC);
 
-        toBuild |= SetupBLAS(*dynamicBlas, colDyn);
+        const auto contentHash = colDyn->GetContentHash(dynamicBlas->GetFilter());
+
+        // this BLAS was built for the same frame index, and if all of its geometries
+        // have the same data, then it can be reused
+        if (dynamicBlas->IsBuiltWith(contentHash))
+        {
+            assert(dynamicBlas->GetGeomCount() == colDyn->GetASGeometries(dynamicBlas->GetFilter()).size());
+            continue;
+        }
+
+        const auto topologyHash = colDyn->GetTopologyHash(dynamicBlas->GetFilter());
+
+        // if geometries have the same topology, e.g. animated characters, then
+        // BLAS can be refitted, but it's rebuilt periodically to bound quality decay
+        if (dynamicBlas->CanBeUpdatedWith(topologyHash) && dynamicBlas->GetUpdateCount() < DYNAMIC_BLAS_MAX_UPDATE_COUNT)
+        {
+            toBuild |= UpdateBLAS(*dynamicBlas, colDyn);
+            dynamicBlas->MarkUpdated();
+        }
+        else
+        {
+            toBuild |= SetupBLAS(*dynamicBlas, colDyn, *asBuilder);
+            dynamicBlas->SetBuiltTopologyHash(topologyHash);
+        }
+
+        dynamicBlas->SetBuiltContentHash(contentHash);
     }
     
     if (!toBuild)
@@ -670,6 +1533,11 @@ void ASManager::UpdateStaticMovableTransform(uint32_t simpleIndex, const RgUpdat
     collectorStatic->UpdateTransform(simpleIndex, updateInfo);
 }
 
+bool ASManager::UpdateStaticMovableVertices(uint32_t simpleIndex, const RgUpdateVerticesInfo &updateInfo)
+{
+    return collectorStatic->UpdateVertices(simpleIndex, updateInfo);
+}
+
 void RTGL1::ASManager::UpdateStaticTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo)
 {
     collectorStatic->UpdateTexCoords(simpleIndex, texCoordsInfo, true);
@@ -679,7 +1547,8 @@ void RTGL1::ASManager::ResubmitStaticTexCoords(VkCommandBuffer cmd)
 {
     typedef VertexCollectorFilterTypeFlagBits FT;
 
-    if (collectorStatic->AreGeometriesEmpty(FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE))
+    // tex coords will be copied when the static build is finished
+    if (IsStaticGeometryPending() || collectorStatic->AreGeometriesEmpty(FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE))
     {
         return;
     }
@@ -693,6 +1562,9 @@ void ASManager::ResubmitStaticMovable(VkCommandBuffer cmd)
 {
     typedef VertexCollectorFilterTypeFlagBits FT;
 
+    // must not be called while static BLAS-es are recorded or building
+    assert(!IsStaticGeometryPending());
+
     if (collectorStatic->AreGeometriesEmpty(FT::CF_STATIC_MOVABLE))
     {
         return;
@@ -700,23 +1572,29 @@ void ASManager::ResubmitStaticMovable(VkCommandBuffer cmd)
 
     assert(asBuilder->IsEmpty());
 
-    // update movable blas
+    bool toBuild = false;
+
+    // update only those movable BLAS-es, which geometries were moved or deformed
     for (auto &blas : allStaticBlas)
     {
         assert(!(blas->GetFilter() & FT::CF_DYNAMIC));
 
-        if (blas->GetFilter() & FT::CF_STATIC_MOVABLE)
+        if ((blas->GetFilter() & FT::CF_STATIC_MOVABLE) && collectorStatic->AreGeometriesChanged(blas->GetFilter()))
         {
-            UpdateBLAS(*blas, collectorStatic);
+            toBuild |= UpdateBLAS(*blas, collectorStatic);
         }
     }
 
     CmdLabel label(cmd, "Building static movable BLAS");
 
-    // copy transforms to device-local memory
+    // copy changed transforms and vertices to device-local memory
     collectorStatic->RecopyTransformsFromStaging(cmd);
+    collectorStatic->RecopyVerticesFromStaging(cmd);
 
-    asBuilder->BuildBottomLevel(cmd);
+    if (toBuild)
+    {
+        asBuilder->BuildBottomLevel(cmd);
+    }
 }
 
 bool ASManager::SetupTLASInstanceFromBLAS(const BLASComponent &blas, uint32_t rayCullMaskWorld, bool allowGeometryWithSkyFlag, VkAccelerationStructureInstanceKHR &instance)
@@ -862,6 +1740,16 @@ static void WriteInstanceGeomInfo(int32_t *instanceGeomInfoOffset, int32_t *inst
     instanceGeomCount[index] = geomCount;
 }
 
+ScratchBuffer::Stats ASManager::GetScratchStats() const
+{
+    return scratchBuffer->GetStats();
+}
+
+ScratchBuffer::Stats ASManager::GetStaticScratchStats() const
+{
+    return staticScratchBuffer->GetStats();
+}
+
 std::pair<ASManager::TLASPrepareResult, ShVertPreprocessing> ASManager::PrepareForBuildingTLAS(
     uint32_t frameIndex,
     ShGlobalUniform &uniformData,
@@ -871,9 +1759,6 @@ std::pair<ASManager::TLASPrepareResult, ShVertPreprocessing> ASManager::PrepareF
 {
     typedef VertexCollectorFilterTypeFlagBits FT;
 
-    static_assert(std::size(TLASPrepareResult{}.instances) == MAX_TOP_LEVEL_INSTANCE_COUNT, "Change TLASPrepareResult sizes");
-
-
     TLASPrepareResult r = {};
     ShVertPreprocessing push = {};
 
@@ -892,36 +1777,99 @@ std::pair<ASManager::TLASPrepareResult, ShVertPreprocessing> ASManager::PrepareF
     // write geometry counts of each BLAS for iterating in vertex preprocessing 
     int32_t *instanceGeomCount = uniformData.instanceGeomCount;
 
+    // previous static BLAS-es are in use, until the new ones are built
     const std::vector<std::unique_ptr<BLASComponent>> *blasArrays[] =
     {
         &allStaticBlas,
         &allDynamicBlas[frameIndex],
     };
 
+    r.instances.reserve(MAX_TOP_LEVEL_INSTANCE_COUNT + meshInstances[frameIndex].size());
+
     for (const auto *blasArr : blasArrays)
     {
         for (const auto &blas : *blasArr)
         {
             bool isDynamic = blas->GetFilter() & FT::CF_DYNAMIC;
 
+            VkAccelerationStructureInstanceKHR instance = {};
+
             // add to TLAS instances array
-            bool isAdded = ASManager::SetupTLASInstanceFromBLAS(*blas, uniformData_rayCullMaskWorld, allowGeometryWithSkyFlag, r.instances[r.instanceCount]);
+            bool isAdded = ASManager::SetupTLASInstanceFromBLAS(*blas, uniformData_rayCullMaskWorld, allowGeometryWithSkyFlag, instance);
 
             if (isAdded)
             {
+                const uint32_t instanceIndex = (uint32_t)r.instances.size();
+
                 // mark bit if dynamic
                 if (isDynamic)
                 {
-                    push.tlasInstanceIsDynamicBits[ r.instanceCount / MAX_TOP_LEVEL_INSTANCE_COUNT] |= 1 << (r.instanceCount % MAX_TOP_LEVEL_INSTANCE_COUNT);
+                    push.tlasInstanceIsDynamicBits[ instanceIndex / MAX_TOP_LEVEL_INSTANCE_COUNT] |= 1 << (instanceIndex % MAX_TOP_LEVEL_INSTANCE_COUNT);
                 }
 
-                WriteInstanceGeomInfo(instanceGeomInfoOffset, instanceGeomCount, r.instanceCount, *blas);
-                r.instanceCount++;
+                WriteInstanceGeomInfo(instanceGeomInfoOffset, instanceGeomCount, instanceIndex, *blas);
+                r.instances.push_back(instance);
             }
         }
     }
 
-    push.tlasInstanceCount = r.instanceCount;
+    // only instances of filters' BLAS are preprocessed,
+    // as mesh vertices are static and normals are not generated for them
+    push.tlasInstanceCount = (uint32_t)r.instances.size();
+
+    for (const MeshInstance &inst : meshInstances[frameIndex])
+    {
+        // if there was no space for its geometry info
+        if (inst.globalGeomIndex == UINT32_MAX)
+        {
+            continue;
+        }
+
+        VkAccelerationStructureInstanceKHR instance = {};
+
+        // mask, flags and SBT offset are the same as for the filter of a mesh
+        bool isAdded = ASManager::SetupTLASInstanceFromBLAS(*allMeshBlas[inst.meshIndex], uniformData_rayCullMaskWorld, allowGeometryWithSkyFlag, instance);
+
+        if (isAdded)
+        {
+            static_assert(sizeof(RgTransform) == sizeof(VkTransformMatrixKHR));
+            memcpy(&instance.transform, &inst.transform, sizeof(VkTransformMatrixKHR));
+
+            // instance count is not limited by the uniform arrays,
+            // so the geometry info index is in the custom index
+            instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE | (inst.globalGeomIndex << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET);
+
+            r.instances.push_back(instance);
+        }
+    }
+
+    // each group of a static chunk is an instance with identity transform,
+    // its geometry infos are placed in the same region as the mesh instances' ones
+    for (const auto &[chunkID, blasArr] : chunkBlas)
+    {
+        const auto *groups = collectorStatic->GetChunkGroups(chunkID);
+        assert(groups != nullptr && groups->size() == blasArr.size());
+
+        for (size_t i = 0; i < blasArr.size(); i++)
+        {
+            // if there was no space for the geometry infos of the group
+            if ((*groups)[i].firstGlobalGeomIndex == UINT32_MAX)
+            {
+                continue;
+            }
+
+            VkAccelerationStructureInstanceKHR instance = {};
+
+            bool isAdded = ASManager::SetupTLASInstanceFromBLAS(*blasArr[i], uniformData_rayCullMaskWorld, allowGeometryWithSkyFlag, instance);
+
+            if (isAdded)
+            {
+                instance.instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE | ((*groups)[i].firstGlobalGeomIndex << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET);
+
+                r.instances.push_back(instance);
+            }
+        }
+    }
 
     return std::make_pair(r, push);
 }
@@ -931,14 +1879,23 @@ void ASManager::BuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLASPr
     CmdLabel label(cmd, "Building TLAS");
 
 
-    if (r.instanceCount > 0)
+    const uint32_t instanceCount = (uint32_t)r.instances.size();
+
+    if (instanceCount > 0)
     {
+        const VkDeviceSize size = instanceCount * sizeof(VkAccelerationStructureInstanceKHR);
+
+        if (size > instanceBuffer->GetSize())
+        {
+            GrowInstanceBuffer(frameIndex, instanceCount);
+        }
+
         // fill buffer
         auto *mapped = (VkAccelerationStructureInstanceKHR*)instanceBuffer->GetMapped(frameIndex);
 
-        memcpy(mapped, r.instances, r.instanceCount * sizeof(VkAccelerationStructureInstanceKHR));
+        memcpy(mapped, r.instances.data(), size);
 
-        instanceBuffer->CopyFromStaging(cmd, frameIndex);
+        instanceBuffer->CopyFromStaging(cmd, frameIndex, size);
     }
 
 
@@ -952,16 +1909,16 @@ void ASManager::BuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLASPr
     auto &instData = instGeom.geometry.instances;
     instData.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
     instData.arrayOfPointers = VK_FALSE;
-    instData.data.deviceAddress = r.instanceCount > 0 ? instanceBuffer->GetDeviceAddress() : 0;
+    instData.data.deviceAddress = instanceCount > 0 ? instanceBuffer->GetDeviceAddress() : 0;
 
     // get AS size and create buffer for AS
-    VkAccelerationStructureBuildSizesInfoKHR buildSizes = asBuilder->GetTopBuildSizes(&instGeom, r.instanceCount, false);
+    VkAccelerationStructureBuildSizesInfoKHR buildSizes = asBuilder->GetTopBuildSizes(&instGeom, instanceCount, false);
 
     // if previous buffer's size is not enough
     pCurrentTLAS->RecreateIfNotValid(buildSizes, allocator);
 
     VkAccelerationStructureBuildRangeInfoKHR range = {};
-    range.primitiveCount = r.instanceCount;
+    range.primitiveCount = instanceCount;
 
 
     // build
@@ -981,6 +1938,20 @@ void ASManager::BuildTLAS(VkCommandBuffer cmd, uint32_t frameIndex, const TLASPr
     UpdateASDescriptors(frameIndex);
 }
 
+void ASManager::GrowInstanceBuffer(uint32_t frameIndex, uint32_t instanceCount)
+{
+    // double the size to not recreate the buffer too often
+    const VkDeviceSize size = std::max<VkDeviceSize>(
+        instanceBuffer->GetSize() * 2, 
+        instanceCount * sizeof(VkAccelerationStructureInstanceKHR));
+
+    // instance buffer can be in use by the previous frame, so don't destroy it right away
+    retiredInstanceBuffers[frameIndex].push_back(std::move(instanceBuffer));
+
+    instanceBuffer = std::make_unique<AutoBuffer>(device, allocator);
+    instanceBuffer->Create(size, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, "TLAS instance buffer");
+}
+
 void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frameIndex)
 {
     uint32_t vertCount = collectorDynamic[frameIndex]->GetCurrentVertexCount();
@@ -991,12 +1962,12 @@ void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frame
         VkBufferCopy vertRegion = {};
         vertRegion.srcOffset = 0;
         vertRegion.dstOffset = 0;
-        vertRegion.size = vertCount * sizeof(ShVertex);
+        vertRegion.size = vertCount * GetVertexStride(vertexFormat);
 
         vkCmdCopyBuffer(
             cmd, 
             collectorDynamic[frameIndex]->GetVertexBuffer(), 
-            previousDynamicPositions.GetBuffer(),
+            previousDynamicPositions->GetBuffer(),
             1, &vertRegion);
     }
 
@@ -1010,11 +1981,111 @@ void ASManager::CopyDynamicDataToPrevBuffers(VkCommandBuffer cmd, uint32_t frame
         vkCmdCopyBuffer(
             cmd, 
             collectorDynamic[frameIndex]->GetIndexBuffer(), 
-            previousDynamicIndices.GetBuffer(),
+            previousDynamicIndices->GetBuffer(),
             1, &indexRegion);
     }
 }
 
+void ASManager::GrowDynamicBuffers(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    const auto &colDyn = collectorDynamic[frameIndex];
+
+    // buffers can be in use by the other frame in flight,
+    // so they're destroyed when the frame with this index is finished
+    colDyn->GrowDeviceBuffers(retiredGeometryBuffers[frameIndex]);
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        if (i != frameIndex)
+        {
+            collectorDynamic[i]->ShareDeviceBuffers(*colDyn);
+        }
+    }
+
+    // previous frame's data was already copied in BeginDynamicGeometry, so move it to the new buffers
+    const std::tuple<std::shared_ptr<Buffer> &, VkDeviceSize, const char *> prevBuffers[] =
+    {
+        { previousDynamicPositions, colDyn->GetVertexBufferSize(), "Previous frame's vertex data" },
+        { previousDynamicIndices, colDyn->GetIndexBufferSize(), "Previous frame's index data" },
+    };
+
+    VkBufferMemoryBarrier barriers[std::size(prevBuffers)] = {};
+    uint32_t barrierCount = 0;
+
+    for (const auto &[prev, newSize, debugName] : prevBuffers)
+    {
+        if (prev->GetSize() >= newSize)
+        {
+            continue;
+        }
+
+        auto grown = std::make_shared<Buffer>();
+        grown->Init(
+            allocator, newSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
+            debugName);
+
+        VkBufferMemoryBarrier &b = barriers[barrierCount];
+        barrierCount++;
+
+        b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        b.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        b.buffer = prev->GetBuffer();
+        b.offset = 0;
+        b.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            1, &b,
+            0, nullptr);
+
+        VkBufferCopy region = {};
+        region.srcOffset = 0;
+        region.dstOffset = 0;
+        region.size = prev->GetSize();
+
+        vkCmdCopyBuffer(cmd, prev->GetBuffer(), grown->GetBuffer(), 1, &region);
+
+        // for the reads in shaders
+        b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        b.buffer = grown->GetBuffer();
+
+        retiredGeometryBuffers[frameIndex].push_back(std::move(prev));
+        prev = std::move(grown);
+    }
+
+    if (barrierCount > 0)
+    {
+        vkCmdPipelineBarrier(
+            cmd,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+            0,
+            0, nullptr,
+            barrierCount, barriers,
+            0, nullptr);
+    }
+
+    // descriptor set of this frame is not bound yet, and the others can be in use
+    UpdateBufferDescriptors(frameIndex);
+    buffersDescSetsOutdated[frameIndex] = false;
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        if (i != frameIndex)
+        {
+            buffersDescSetsOutdated[i] = true;
+        }
+    }
+}
+
 void ASManager::OnVertexPreprocessingBegin(VkCommandBuffer cmd, uint32_t frameIndex, bool onlyDynamic)
 {
     if (!onlyDynamic)
@@ -20,6 +20,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <map>
+#include <mutex>
+
 #include "ASBuilder.h"
 #include "CommandBufferManager.h"
 #include "GlobalUniform.h"
@@ -39,8 +43,8 @@ class ASManager
 public:
     struct TLASPrepareResult
     {
-        VkAccelerationStructureInstanceKHR instances[45];
-        uint32_t instanceCount;
+        // instances of filters' BLAS, and then mesh instances
+        std::vector<VkAccelerationStructureInstanceKHR> instances;
     };
 
 public:
@@ -49,7 +53,14 @@ public:
               std::shared_ptr<MemoryAllocator> allocator,
               std::shared_ptr<CommandBufferManager> cmdManager,
               std::shared_ptr<TextureManager> textureManager,
-              std::shared_ptr<GeomInfoManager> geomInfoManager);
+              std::shared_ptr<GeomInfoManager> geomInfoManager,
+              bool compactStaticBlas,
+              VertexBufferFormat vertexFormat,
+              uint32_t initialStaticVertexCount,
+              uint32_t initialDynamicVertexCount,
+              uint32_t initialIndexCount,
+              uint32_t staticChunkVertexCount,
+              uint32_t staticChunkIndexCount);
     ~ASManager();
 
     ASManager(const ASManager& other) = delete;
@@ -60,20 +71,62 @@ public:
 
     void BeginStaticGeometry();
     uint32_t AddStaticGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info);
-    // Submitting static geometry to the building is a heavy operation
-    // with waiting for it to complete.
-    void SubmitStaticGeometry();
+    // Batched AddStaticGeometry. Simple indices are written to outSimpleIndices,
+    // UINT32_MAX if geometry wasn't added.
+    void AddStaticGeometries(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<uint32_t> outSimpleIndices);
+    // Submitting static geometry to the building is a heavy operation,
+    // so it's built asynchronously on the compute queue. The previous static
+    // geometry stays visible until TryFinishStaticGeometry returns true.
+    // If the previous build is still pending, the new one is recorded after it.
+    void SubmitStaticGeometry(uint32_t frameIndex);
+    // Check if the static geometry build is completed without waiting for it.
+    // If it is, the static geometry replaces the previous one from the current frame,
+    // and true is returned. Must be called before the other submissions of the frame.
+    bool TryFinishStaticGeometry(VkCommandBuffer cmd, uint32_t frameIndex);
+    // Static geometry is being recorded or built, so the data in the collector
+    // doesn't match the static BLAS-es in use, and they must not be updated
+    bool IsStaticGeometryPending() const;
     // If all the added geometries must be removed, call this function before submitting
     void ResetStaticGeometry();
 
+    // Add mesh to the static scene, it will have its own BLAS that is built in SubmitStaticGeometry.
+    // Returns RG_NO_MESH, if mesh wasn't added.
+    RgMesh AddMesh(uint32_t frameIndex, const RgGeometryUploadInfo &info);
+    // Is mesh in the submitted static scene
+    bool IsMeshValid(RgMesh mesh) const;
+    // Thread-safe. Mesh instances are visible only in the current frame.
+    // Returns false, if there's not enough space for them. Throws RgException, if a mesh handle is invalid.
+    bool AddMeshInstances(uint32_t frameIndex, std::span<const RgMeshInstanceUploadInfo> infos);
+    // Write geometry infos for the mesh instances of the current frame.
+    void SubmitMeshInstances(uint32_t frameIndex);
+
+    // Thread-safe. Add static geometries with their own BLAS-es that can be
+    // added or removed independently of the static scene, e.g. to stream world sectors.
+    // Chunk is built on the next SubmitStaticChunks. Returns false, if chunk wasn't added.
+    bool AddStaticChunk(uint64_t chunkID, uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos);
+    // Thread-safe. Chunk resources are freed, when the frame with the same index is finished.
+    void RemoveStaticChunk(uint64_t chunkID, uint32_t frameIndex);
+    // Build BLAS-es of the added chunks and write geometry infos of all chunks for the current frame.
+    void SubmitStaticChunks(VkCommandBuffer cmd, uint32_t frameIndex);
+
     void BeginDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex);
-    uint32_t AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info);
+    // Thread-safe. Dynamic geometries are registered in SubmitDynamicGeometry
+    // in the order of their unique IDs.
+    bool AddDynamicGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info);
+    // Batched AddDynamicGeometry. outResults[i] is UINT32_MAX, if geometry wasn't added.
+    void AddDynamicGeometries(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<uint32_t> outResults);
+    // Thread-safe. Get memory in the dynamic staging buffers to write geometry data in place.
+    bool AcquireDynamicGeometryMemory(uint32_t frameIndex, uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices);
     void SubmitDynamicGeometry(VkCommandBuffer cmd, uint32_t frameIndex);
 
 
     // Update transform for static movable geometry
     void UpdateStaticMovableTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo);
-    // After updating transforms, acceleration structures should be rebuilt
+    // Update vertex positions and normals of static movable geometry.
+    // Returns false, if the range is out of the geometry's vertices.
+    bool UpdateStaticMovableVertices(uint32_t simpleIndex, const RgUpdateVerticesInfo &updateInfo);
+    // After updating transforms or vertices, acceleration structures should be rebuilt.
+    // Only BLAS-es with the changed geometries are updated.
     void ResubmitStaticMovable(VkCommandBuffer cmd);
 
     // Update texture coordinates for static geometry, it 
@@ -82,6 +135,10 @@ public:
     void ResubmitStaticTexCoords(VkCommandBuffer cmd);
 
 
+    // Statistics of the scratch memory of the per-frame builds and of the static geometry build
+    ScratchBuffer::Stats GetScratchStats() const;
+    ScratchBuffer::Stats GetStaticScratchStats() const;
+
     // Prepare data for building TLAS.
     // Also fill uniform with current state.
     std::pair<TLASPrepareResult, ShVertPreprocessing> PrepareForBuildingTLAS(
@@ -115,11 +172,24 @@ private:
     void UpdateBufferDescriptors(uint32_t frameIndex);
     void UpdateASDescriptors(uint32_t frameIndex);
 
+    // Get textures of each layer, 3 elements per geometry
+    void GetMaterialTextures(std::span<const RgGeometryUploadInfo> infos, std::vector<MaterialTextures> &result) const;
+
     bool SetupBLAS(
         BLASComponent &as,
-        const std::shared_ptr<VertexCollector> &vertCollector);
+        const std::shared_ptr<VertexCollector> &vertCollector,
+        ASBuilder &builder);
 
-    void UpdateBLAS(
+    void SetupMeshBLAS(
+        BLASComponent &as,
+        uint32_t meshIndex,
+        ASBuilder &builder);
+
+    void SetupChunkBLAS(
+        BLASComponent &as,
+        const VertexCollector::ChunkGroup &group);
+
+    bool UpdateBLAS(
         BLASComponent &as,
         const std::shared_ptr<VertexCollector> &vertCollector);
 
@@ -131,22 +201,89 @@ private:
 
     static bool IsFastBuild(VertexCollectorFilterTypeFlags filter);
 
+    // Write compacted sizes of the static BLAS-es that were just built
+    void QueryCompactedSizes(VkCommandBuffer cmd);
+    // Replace the static BLAS-es with their compacted copies, the original ones
+    // are destroyed when the frame with the same index is finished
+    void CompactStaticBlas(VkCommandBuffer cmd, uint32_t frameIndex);
+
+    // Results of the pending static build must not be used
+    void DiscardPendingStaticGeometry();
+
+    // Record the build of the submitted static geometry to the compute queue,
+    // no static build must be pending
+    void RecordStaticBuild(uint32_t frameIndex);
+    // Replace static BLAS-es in use with the ones of the finished build,
+    // the previous ones are destroyed when the frame with the same index is finished
+    void SwapStaticBlas(uint32_t frameIndex);
+
+    // Meshes of the previous static scene can't be used anymore
+    void RetireMeshes();
+
+    // Static data is written on the compute queue, but used on the graphics one
+    void TransferStaticOwnership(VkCommandBuffer cmd, bool isRelease);
+
+    // Recreate TLAS instance buffer, so it can hold at least instanceCount instances;
+    // the old one is destroyed when the frame with the same index is finished
+    void GrowInstanceBuffer(uint32_t frameIndex, uint32_t instanceCount);
+
+    // Staging buffers of the dynamic collector were grown, so recreate the device local
+    // buffers that are shared by the dynamic collectors and the previous frame's buffers
+    void GrowDynamicBuffers(VkCommandBuffer cmd, uint32_t frameIndex);
+
+private:
+    struct MeshInstance
+    {
+        uint64_t uniqueID;
+        uint32_t meshIndex;
+        RgTransform transform;
+        // set in SubmitMeshInstances
+        uint32_t globalGeomIndex;
+    };
+
 private:
     VkDevice device;
     std::shared_ptr<MemoryAllocator> allocator;
 
+    // signaled when the static geometry is built, it's never waited on
     VkFence staticCopyFence;
+    bool isStaticBuildPending;
+    // if static scene was restarted while its previous build is pending
+    bool isStaticBuildDiscarded;
+    // static scene is being recorded, between BeginStaticGeometry and SubmitStaticGeometry
+    bool isStaticRecording;
+    // static scene was submitted while the previous build is pending, it's recorded when that one is finished
+    bool isStaticSubmitDeferred;
+
+    // static BLAS-es are built with the compaction flag and then copied to smaller buffers
+    bool compactStaticBlas;
+    VkQueryPool compactedSizeQueryPool;
+    uint32_t compactedSizeQueryCount;
+    // BLAS-es that are queried in the pending static build, in the order of the queries
+    std::vector<std::unique_ptr<BLASComponent> *> blasToCompact;
+    // replaced static and mesh BLAS-es, e.g. original ones of the compacted, destroyed when the frame with the same index is finished
+    std::vector<std::unique_ptr<BLASComponent>> retiredStaticBlas[MAX_FRAMES_IN_FLIGHT];
 
     // for filling buffers
+    VertexBufferFormat vertexFormat;
     std::shared_ptr<VertexCollector> collectorStatic;
     std::shared_ptr<VertexCollector> collectorDynamic[MAX_FRAMES_IN_FLIGHT];
     // device-local buffer for storing previous info
-    Buffer previousDynamicPositions;
-    Buffer previousDynamicIndices;
+    std::shared_ptr<Buffer> previousDynamicPositions;
+    std::shared_ptr<Buffer> previousDynamicIndices;
+    // vertex and index buffers that were replaced on growth, destroyed when the frame with the same index is finished
+    std::vector<std::shared_ptr<Buffer>> retiredGeometryBuffers[MAX_FRAMES_IN_FLIGHT];
+    // static buffers that are bound to the descriptor sets, while the new ones of collectorStatic
+    // are filled by the static build; null, if collectorStatic's buffers are bound
+    std::shared_ptr<Buffer> boundStaticVertices;
+    std::shared_ptr<Buffer> boundStaticIndices;
 
     // building
     std::shared_ptr<ScratchBuffer> scratchBuffer;
     std::shared_ptr<ASBuilder> asBuilder;
+    // static BLAS-es are built asynchronously, so they can't share scratch memory with the frames
+    std::shared_ptr<ScratchBuffer> staticScratchBuffer;
+    std::shared_ptr<ASBuilder> staticAsBuilder;
 
     std::shared_ptr<CommandBufferManager> cmdManager;
     std::shared_ptr<TextureManager> textureMgr;
@@ -155,8 +292,33 @@ private:
     std::vector<std::unique_ptr<BLASComponent>> allStaticBlas;
     std::vector<std::unique_ptr<BLASComponent>> allDynamicBlas[MAX_FRAMES_IN_FLIGHT];
 
-    // top level AS
+    // BLAS for each mesh in collectorStatic, created on static geometry submission
+    std::vector<std::unique_ptr<BLASComponent>> allMeshBlas;
+    // mesh count of the submitted static scene, it can be read by uploading threads without the lock
+    std::atomic<uint32_t> submittedMeshCount;
+    // previous static scene's meshes, retired on the next frame
+    std::vector<std::unique_ptr<BLASComponent>> retiredMeshBlas;
+    // BLAS-es of the pending static build, they replace allStaticBlas and allMeshBlas when it's finished
+    std::vector<std::unique_ptr<BLASComponent>> pendingStaticBlas;
+    std::vector<std::unique_ptr<BLASComponent>> pendingMeshBlas;
+    // materials are resolved every frame, as for dynamic geometry
+    std::vector<RgLayeredMaterial> meshMaterials;
+    std::vector<MeshInstance> meshInstances[MAX_FRAMES_IN_FLIGHT];
+    // guards mesh materials and instances, as they can be added concurrently
+    std::mutex meshMutex;
+
+    // BLAS for each group of a static chunk, sorted by chunk ID
+    std::map<uint64_t, std::vector<std::unique_ptr<BLASComponent>>> chunkBlas;
+    // chunks that were added, but not built yet
+    std::vector<uint64_t> chunksToBuild;
+    // BLAS of the removed chunks, destroyed when the frame with the same index is finished
+    std::vector<std::unique_ptr<BLASComponent>> retiredChunkBlas[MAX_FRAMES_IN_FLIGHT];
+    std::mutex chunkMutex;
+
+    // top level AS, instance buffer grows if there are more instances than it can hold
     std::unique_ptr<AutoBuffer> instanceBuffer;
+    // instance buffers that were replaced on growth, destroyed when the frame with the same index is finished
+    std::vector<std::unique_ptr<AutoBuffer>> retiredInstanceBuffers[MAX_FRAMES_IN_FLIGHT];
     std::unique_ptr<TLASComponent> tlas[MAX_FRAMES_IN_FLIGHT];
 
     // TLAS and buffer descriptors
@@ -164,6 +326,8 @@ private:
 
     VkDescriptorSetLayout buffersDescSetLayout;
     VkDescriptorSet buffersDescSets[MAX_FRAMES_IN_FLIGHT];
+    // buffers were recreated, but the descriptor set can be in use by a frame in flight
+    bool buffersDescSetsOutdated[MAX_FRAMES_IN_FLIGHT];
 
     VkDescriptorSetLayout asDescSetLayout;
     VkDescriptorSet asDescSets[MAX_FRAMES_IN_FLIGHT];
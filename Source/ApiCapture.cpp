@@ -0,0 +1,93 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ApiCapture.h"
+
+#include "RgException.h"
+
+using namespace RTGL1;
+
+ApiCapture::ApiCapture(const char *pFilePath) : file(nullptr)
+{
+    file = std::fopen(pFilePath, "wb");
+
+    if (file == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, std::string("Can't create capture file: ") + pFilePath);
+    }
+
+    // calls are small and frequent, let the stream accumulate them
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    const Capture::FileHeader header = Capture::MakeFileHeader();
+    std::fwrite(&header, sizeof(header), 1, file);
+}
+
+ApiCapture::~ApiCapture()
+{
+    if (file != nullptr)
+    {
+        std::fclose(file);
+    }
+}
+
+void ApiCapture::Write(Capture::CallType type, const std::vector<uint8_t> &payload)
+{
+    const Capture::RecordHeader header =
+    {
+        .type = type,
+        .size = static_cast<uint32_t>(payload.size()),
+    };
+
+    std::lock_guard lock(fileMutex);
+
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    if (!payload.empty())
+    {
+        std::fwrite(payload.data(), 1, payload.size(), file);
+    }
+
+    // frame is a natural point to not lose the data, if the application crashes
+    if (type == Capture::CallType::DrawFrame)
+    {
+        std::fflush(file);
+    }
+}
+
+void ApiCapture::AddMaterial(RgMaterial material, const RgExtent2D &size)
+{
+    std::lock_guard lock(materialsMutex);
+    materialSizes[material] = size;
+}
+
+void ApiCapture::RemoveMaterial(RgMaterial material)
+{
+    std::lock_guard lock(materialsMutex);
+    materialSizes.erase(material);
+}
+
+RgExtent2D ApiCapture::GetMaterialSize(RgMaterial material) const
+{
+    std::lock_guard lock(materialsMutex);
+
+    auto it = materialSizes.find(material);
+    return it != materialSizes.end() ? it->second : RgExtent2D{ 0, 0 };
+}
@@ -0,0 +1,78 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "CaptureFormat.h"
+#include "Containers.h"
+
+namespace RTGL1
+{
+
+// Records API calls of an instance into a .rgcap file, see CaptureFormat.h.
+// Records are written in the order their calls have returned.
+class ApiCapture
+{
+public:
+    // Throws RgException, if the file can't be created.
+    explicit ApiCapture(const char *pFilePath);
+    ~ApiCapture();
+
+    ApiCapture(const ApiCapture &other) = delete;
+    ApiCapture(ApiCapture &&other) noexcept = delete;
+    ApiCapture &operator=(const ApiCapture &other) = delete;
+    ApiCapture &operator=(ApiCapture &&other) noexcept = delete;
+
+    // Thread-safe. "serialize" is called with Capture::Writer to fill the payload of the record.
+    template<typename Func>
+    void Record(Capture::CallType type, Func &&serialize)
+    {
+        // reuse the memory, as geometry payloads are large
+        thread_local std::vector<uint8_t> payload;
+        payload.clear();
+
+        Capture::Writer writer(payload);
+        serialize(writer);
+
+        Write(type, payload);
+    }
+
+    // Thread-safe. RgMaterialUpdateInfo doesn't contain texture size,
+    // so it's taken from the material create info.
+    void AddMaterial(RgMaterial material, const RgExtent2D &size);
+    void RemoveMaterial(RgMaterial material);
+    RgExtent2D GetMaterialSize(RgMaterial material) const;
+
+private:
+    void Write(Capture::CallType type, const std::vector<uint8_t> &payload);
+
+private:
+    FILE *file;
+    std::mutex fileMutex;
+
+    rgl::unordered_map<RgMaterial, RgExtent2D> materialSizes;
+    mutable std::mutex materialsMutex;
+};
+
+}
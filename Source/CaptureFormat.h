@@ -0,0 +1,584 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "RTGL1/RTGL1.h"
+
+// Binary format of .rgcap files, that are written by the library if
+// RgInstanceCreateInfo::pCaptureFilePath is set, and read by the RtglReplay tool.
+// This header doesn't depend on the library internals, so it can be used by the tools.
+//
+// File is FileHeader followed by records: RecordHeader and "size" bytes of payload.
+// Payload is a sequence of serialized call arguments, see RTGL1.cpp for the order.
+// API structs are stored as raw bytes, then the data their pointers point to is appended,
+// so the reader can restore the pointers. Structs are not converted between the versions,
+// so a capture must be replayed by the library that was built from the same RTGL1.h.
+namespace RTGL1::Capture
+{
+
+constexpr char     FILE_MAGIC[4] = { 'R', 'G', 'C', 'P' };
+constexpr uint32_t FILE_VERSION = 1;
+
+struct FileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    // to reject captures from a build with a different struct layout
+    uint32_t pointerSize;
+    uint32_t geometryUploadInfoSize;
+    uint32_t drawFrameInfoSize;
+};
+
+inline FileHeader MakeFileHeader()
+{
+    return FileHeader{
+        .magic                  = { FILE_MAGIC[0], FILE_MAGIC[1], FILE_MAGIC[2], FILE_MAGIC[3] },
+        .version                = FILE_VERSION,
+        .pointerSize            = sizeof(void*),
+        .geometryUploadInfoSize = sizeof(RgGeometryUploadInfo),
+        .drawFrameInfoSize      = sizeof(RgDrawFrameInfo),
+    };
+}
+
+inline bool IsCompatible(const FileHeader &header)
+{
+    const FileHeader expected = MakeFileHeader();
+    return std::memcmp(&header, &expected, sizeof(FileHeader)) == 0;
+}
+
+enum class CallType : uint32_t
+{
+    CreateInstance,
+    DestroyInstance,
+    UploadGeometry,
+    UploadGeometries,
+    UpdateGeometryTransform,
+    UpdateGeometryTexCoords,
+    UploadRasterizedGeometry,
+    UploadLensFlare,
+    UploadDecal,
+    UploadPortal,
+    BeginStaticGeometries,
+    SubmitStaticGeometries,
+    UploadMesh,
+    UploadMeshInstances,
+    UploadStaticChunk,
+    RemoveStaticChunk,
+    UploadDirectionalLight,
+    UploadSphericalLight,
+    UploadSpotLight,
+    UploadPolygonalLight,
+    CreateMaterial,
+    CreateAnimatedMaterial,
+    ChangeAnimatedMaterialFrame,
+    UpdateMaterialContents,
+    DestroyMaterial,
+    CreateCubemap,
+    DestroyCubemap,
+    StartFrame,
+    DrawFrame,
+    UpdateGeometryTransforms,
+    UpdateGeometryVertices,
+
+    Count
+};
+
+inline const char *GetCallName(CallType type)
+{
+    constexpr const char *names[] = {
+        "rgCreateInstance",
+        "rgDestroyInstance",
+        "rgUploadGeometry",
+        "rgUploadGeometries",
+        "rgUpdateGeometryTransform",
+        "rgUpdateGeometryTexCoords",
+        "rgUploadRasterizedGeometry",
+        "rgUploadLensFlare",
+        "rgUploadDecal",
+        "rgUploadPortal",
+        "rgBeginStaticGeometries",
+        "rgSubmitStaticGeometries",
+        "rgUploadMesh",
+        "rgUploadMeshInstances",
+        "rgUploadStaticChunk",
+        "rgRemoveStaticChunk",
+        "rgUploadDirectionalLight",
+        "rgUploadSphericalLight",
+        "rgUploadSpotLight",
+        "rgUploadPolygonalLight",
+        "rgCreateMaterial",
+        "rgCreateAnimatedMaterial",
+        "rgChangeAnimatedMaterialFrame",
+        "rgUpdateMaterialContents",
+        "rgDestroyMaterial",
+        "rgCreateCubemap",
+        "rgDestroyCubemap",
+        "rgStartFrame",
+        "rgDrawFrame",
+        "rgUpdateGeometryTransforms",
+        "rgUpdateGeometryVertices",
+    };
+    static_assert(std::size(names) == static_cast<size_t>(CallType::Count));
+
+    const auto i = static_cast<size_t>(type);
+    return i < std::size(names) ? names[i] : "<unknown>";
+}
+
+struct RecordHeader
+{
+    CallType type;
+    uint32_t size;
+};
+
+// RgMaterialUpdateInfo doesn't contain the size of its textures,
+// so it's captured with the size of the target material.
+struct MaterialUpdate
+{
+    RgExtent2D           size;
+    RgMaterialUpdateInfo info;
+};
+
+
+
+// Appends call arguments to a byte array.
+// Writer only reads the values, Serialize functions take them as non-const,
+// so the same functions could be used by the Reader.
+class Writer
+{
+public:
+    explicit Writer(std::vector<uint8_t> &_dst) : dst(_dst) {}
+
+    template<typename T>
+    void Value(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Append(&value, sizeof(T));
+    }
+
+    // Raw array of "count" elements. Null pointer is stored as an absent array.
+    template<typename T>
+    void Array(T *ptr, uint32_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (BeginArray(ptr, count))
+        {
+            Append(ptr, sizeof(T) * count);
+        }
+    }
+
+    void Bytes(const void *ptr, size_t size)
+    {
+        if (BeginArray(ptr, static_cast<uint32_t>(size)))
+        {
+            Append(ptr, size);
+        }
+    }
+
+    // Array of structs that contain pointers, each one is serialized.
+    template<typename T>
+    void Objects(T *ptr, uint32_t count);
+
+    template<typename T>
+    void Object(T *ptr)
+    {
+        Objects(ptr, 1);
+    }
+
+    void String(const char *str)
+    {
+        Bytes(str, str != nullptr ? std::strlen(str) + 1 : 0);
+    }
+
+    // Values that are not valid outside of the captured process: surfaces, callbacks, user data
+    template<typename T>
+    void Drop(const T &)
+    {
+    }
+
+private:
+    bool BeginArray(const void *ptr, uint32_t count)
+    {
+        const uint8_t  isPresent = ptr != nullptr;
+        const uint32_t n         = isPresent ? count : 0;
+
+        Value(isPresent);
+        Value(n);
+
+        return isPresent && n > 0;
+    }
+
+    void Append(const void *src, size_t size)
+    {
+        const auto *bytes = static_cast<const uint8_t*>(src);
+        dst.insert(dst.end(), bytes, bytes + size);
+    }
+
+private:
+    std::vector<uint8_t> &dst;
+};
+
+
+
+// Reads call arguments from a payload of one record. Pointers in the read structs
+// point to the memory that is owned by the reader, so they're valid until its destruction.
+class Reader
+{
+public:
+    Reader(const uint8_t *_data, size_t _size) : cur(_data), end(_data + _size) {}
+
+    template<typename T>
+    void Value(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Read(&value, sizeof(T));
+    }
+
+    // Count is read from the payload, the returned value is the element count.
+    template<typename T>
+    uint32_t Array(T *&ptr, uint32_t)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        uint32_t count;
+        ptr = static_cast<T*>(BeginArray(sizeof(T), count));
+
+        if (ptr != nullptr)
+        {
+            Read(const_cast<std::remove_const_t<T>*>(ptr), sizeof(T) * count);
+        }
+        return count;
+    }
+
+    uint32_t Bytes(const void *&ptr, size_t)
+    {
+        uint32_t count;
+        void *dst = BeginArray(1, count);
+
+        if (dst != nullptr)
+        {
+            Read(dst, count);
+        }
+        ptr = dst;
+        return count;
+    }
+
+    template<typename T>
+    uint32_t Objects(T *&ptr, uint32_t);
+
+    template<typename T>
+    void Object(T *&ptr)
+    {
+        Objects(ptr, 1);
+    }
+
+    void String(const char *&str)
+    {
+        const void *ptr;
+        uint32_t size = Bytes(ptr, 0);
+
+        // guarantee a null-terminated string even for a corrupted capture
+        if (ptr != nullptr && size > 0)
+        {
+            static_cast<char*>(const_cast<void*>(ptr))[size - 1] = '\0';
+        }
+        str = static_cast<const char*>(ptr);
+    }
+
+    template<typename T>
+    void Drop(T &value)
+    {
+        value = {};
+    }
+
+    bool IsAtEnd() const
+    {
+        return cur == end;
+    }
+
+private:
+    // Returns null, if the array is absent
+    void *BeginArray(size_t elementSize, uint32_t &outCount)
+    {
+        uint8_t  isPresent;
+        uint32_t count;
+
+        Value(isPresent);
+        Value(count);
+
+        outCount = count;
+
+        if (!isPresent)
+        {
+            return nullptr;
+        }
+
+        if (elementSize * count > static_cast<size_t>(end - cur))
+        {
+            throw std::runtime_error("Capture record is corrupted: array is out of the payload");
+        }
+
+        // zero-sized arrays still must be non-null
+        storage.push_back(std::make_unique<uint8_t[]>(std::max<size_t>(elementSize * count, 1)));
+        return storage.back().get();
+    }
+
+    void Read(void *dst, size_t size)
+    {
+        if (size > static_cast<size_t>(end - cur))
+        {
+            throw std::runtime_error("Capture record is corrupted: read is out of the payload");
+        }
+
+        std::memcpy(dst, cur, size);
+        cur += size;
+    }
+
+private:
+    const uint8_t *cur;
+    const uint8_t *end;
+
+    std::vector<std::unique_ptr<uint8_t[]>> storage;
+};
+
+
+
+// Serialize functions describe both writing and reading of the API structs.
+// By default, a struct is just its bytes.
+template<typename Archive, typename T>
+void Serialize(Archive &ar, T &value)
+{
+    ar.Value(value);
+}
+
+template<typename Archive>
+void SerializeTextures(Archive &ar, RgTextureSet &textures, const RgExtent2D &size)
+{
+    const size_t textureSize = size_t(size.width) * size.height * 4;
+
+    ar.Bytes(textures.pDataAlbedoAlpha, textureSize);
+    ar.Bytes(textures.pDataRoughnessMetallicEmission, textureSize);
+    ar.Bytes(textures.pDataNormal, textureSize);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgInstanceCreateInfo &info)
+{
+    ar.Value(info);
+
+    ar.String(info.pAppName);
+    ar.String(info.pAppGUID);
+    ar.String(info.pConfigPath);
+    ar.String(info.pCaptureFilePath);
+    ar.String(info.pShaderFolderPath);
+    ar.String(info.pBlueNoiseFilePath);
+    ar.String(info.pOverridenTexturesFolderPath);
+    ar.String(info.pOverridenTexturesFolderPathDeveloper);
+    ar.String(info.pOverridenAlbedoAlphaTexturePostfix);
+    ar.String(info.pOverridenRoughnessMetallicEmissionTexturePostfix);
+    ar.String(info.pOverridenNormalTexturePostfix);
+    ar.String(info.pWaterNormalTexturePath);
+
+    ar.Drop(info.pWin32SurfaceInfo);
+    ar.Drop(info.pMetalSurfaceCreateInfo);
+    ar.Drop(info.pWaylandSurfaceCreateInfo);
+    ar.Drop(info.pXcbSurfaceCreateInfo);
+    ar.Drop(info.pXlibSurfaceCreateInfo);
+    ar.Drop(info.pfnPrint);
+    ar.Drop(info.pUserPrintData);
+    ar.Drop(info.pfnOpenFile);
+    ar.Drop(info.pfnCloseFile);
+    ar.Drop(info.pUserLoadFileData);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgGeometryUploadInfo &info)
+{
+    ar.Value(info);
+
+    ar.Array(info.pVertices, info.vertexCount);
+    ar.Array(info.pIndices, info.indexCount);
+    ar.Array(info.pIndices16, info.indexCount);
+    ar.Array(info.pPortalIndex, 1);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgUpdateVerticesInfo &info)
+{
+    ar.Value(info);
+    ar.Array(info.pPositions, info.vertexCount);
+    ar.Array(info.pNormals, info.vertexCount);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgUpdateTexCoordsInfo &info)
+{
+    ar.Value(info);
+
+    for (auto &layer : info.pTexCoordLayerData)
+    {
+        ar.Bytes(layer, size_t(info.vertexCount) * sizeof(float) * 2);
+    }
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgRasterizedGeometryUploadInfo &info)
+{
+    ar.Value(info);
+
+    ar.Array(info.pVertices, info.vertexCount);
+    ar.Bytes(info.pIndices, size_t(info.indexCount) * sizeof(uint32_t));
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgLensFlareUploadInfo &info)
+{
+    ar.Value(info);
+
+    ar.Array(info.pVertices, info.vertexCount);
+    ar.Array(info.pIndices, info.indexCount);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgMaterialCreateInfo &info)
+{
+    ar.Value(info);
+
+    SerializeTextures(ar, info.textures, info.size);
+    ar.String(info.pRelativePath);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgAnimatedMaterialCreateInfo &info)
+{
+    ar.Value(info);
+
+    ar.Objects(info.pFrames, info.frameCount);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, MaterialUpdate &update)
+{
+    ar.Value(update);
+
+    SerializeTextures(ar, update.info.textures, update.size);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgCubemapCreateInfo &info)
+{
+    ar.Value(info);
+
+    const size_t faceSize = size_t(info.sideSize) * info.sideSize * 4;
+
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        ar.Bytes(info.pData[i], faceSize);
+        ar.String(info.pRelativePaths[i]);
+    }
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgDrawFrameIlluminationParams &params)
+{
+    ar.Value(params);
+
+    ar.Array(params.lightUniqueIdIgnoreFirstPersonViewerShadows, 1);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgDrawFrameRenderResolutionParams &params)
+{
+    ar.Value(params);
+
+    ar.Array(params.pPixelizedRenderSize, 1);
+}
+
+template<typename Archive>
+void Serialize(Archive &ar, RgDrawFrameInfo &info)
+{
+    ar.Value(info);
+
+    ar.Object(info.pRenderResolutionParams);
+    ar.Object(info.pIlluminationParams);
+    ar.Array(info.pVolumetricParams, 1);
+    ar.Array(info.pTonemappingParams, 1);
+    ar.Array(info.pBloomParams, 1);
+    ar.Array(info.pReflectRefractParams, 1);
+    ar.Array(info.pSkyParams, 1);
+    ar.Array(info.pTexturesParams, 1);
+    ar.Array(info.pLensFlareParams, 1);
+    ar.Array(info.pLightmapParams, 1);
+    ar.Array(info.pDebugParams, 1);
+
+    auto &effects = info.postEffectParams;
+    ar.Array(effects.pWipe, 1);
+    ar.Array(effects.pRadialBlur, 1);
+    ar.Array(effects.pChromaticAberration, 1);
+    ar.Array(effects.pInverseBlackAndWhite, 1);
+    ar.Array(effects.pHueShift, 1);
+    ar.Array(effects.pDistortedSides, 1);
+    ar.Array(effects.pWaves, 1);
+    ar.Array(effects.pColorTint, 1);
+    ar.Array(effects.pCRT, 1);
+}
+
+
+
+template<typename T>
+void Writer::Objects(T *ptr, uint32_t count)
+{
+    if (BeginArray(ptr, count))
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Serialize(*this, const_cast<std::remove_const_t<T>&>(ptr[i]));
+        }
+    }
+}
+
+template<typename T>
+uint32_t Reader::Objects(T *&ptr, uint32_t)
+{
+    using Mutable = std::remove_const_t<T>;
+
+    uint32_t count;
+    auto *dst = static_cast<Mutable*>(BeginArray(sizeof(T), count));
+
+    if (dst != nullptr)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Serialize(*this, dst[i]);
+        }
+    }
+    ptr = dst;
+    return count;
+}
+
+}
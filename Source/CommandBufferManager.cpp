@@ -49,6 +49,10 @@ CommandBufferManager::CommandBufferManager(VkDevice device, std::shared_ptr<Queu
         r = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &transferCmds[i].pool);
         VK_CHECKERROR(r);
     }
+
+    cmdPoolInfo.queueFamilyIndex = queues->GetIndexCompute();
+    VkResult r = vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &asyncComputeCmds.pool);
+    VK_CHECKERROR(r);
 }
 
 CommandBufferManager::~CommandBufferManager()
@@ -61,6 +65,8 @@ CommandBufferManager::~CommandBufferManager()
         vkDestroyCommandPool(device, computeCmds[i].pool, nullptr);
         vkDestroyCommandPool(device, transferCmds[i].pool, nullptr);
     }
+
+    vkDestroyCommandPool(device, asyncComputeCmds.pool, nullptr);
 }
 
 void CommandBufferManager::PrepareForFrame(uint32_t frameIndex)
@@ -144,6 +150,32 @@ VkCommandBuffer CommandBufferManager::StartTransferCmd()
     return StartCmd(currentFrameIndex, transferCmds[currentFrameIndex], queues.lock()->GetTransfer());
 }
 
+VkCommandBuffer CommandBufferManager::StartAsyncComputeCmd()
+{
+    if (queues.expired())
+    {
+        return VK_NULL_HANDLE;
+    }
+
+    // previous async cmd must be completed, so the pool can be reset
+    vkResetCommandPool(device, asyncComputeCmds.pool, 0);
+    asyncComputeCmds.curCount = 0;
+
+    return StartCmd(currentFrameIndex, asyncComputeCmds, queues.lock()->GetCompute());
+}
+
+uint32_t CommandBufferManager::GetGraphicsQueueFamily() const
+{
+    assert(!queues.expired());
+    return queues.lock()->GetIndexGraphics();
+}
+
+uint32_t CommandBufferManager::GetComputeQueueFamily() const
+{
+    assert(!queues.expired());
+    return queues.lock()->GetIndexCompute();
+}
+
 void CommandBufferManager::Submit(VkCommandBuffer cmd, VkFence fence)
 {
     VkResult r = vkEndCommandBuffer(cmd);
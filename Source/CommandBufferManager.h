@@ -48,6 +48,12 @@ public:
     VkCommandBuffer StartComputeCmd();
     // Start transfer command buffer for current frame index
     VkCommandBuffer StartTransferCmd();
+    // Start compute command buffer that is not bound to frames, so it can
+    // be executing for several frames. Previous one must be completed.
+    VkCommandBuffer StartAsyncComputeCmd();
+
+    uint32_t GetGraphicsQueueFamily() const;
+    uint32_t GetComputeQueueFamily() const;
 
     void Submit(VkCommandBuffer cmd, VkFence fence = VK_NULL_HANDLE);
     void Submit(VkCommandBuffer cmd, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStages, VkSemaphore signalSemaphore, VkFence fence);
@@ -80,6 +86,8 @@ private:
     AllocatedCmds graphicsCmds[MAX_FRAMES_IN_FLIGHT];
     AllocatedCmds computeCmds[MAX_FRAMES_IN_FLIGHT];
     AllocatedCmds transferCmds[MAX_FRAMES_IN_FLIGHT];
+    // not reset on frame start
+    AllocatedCmds asyncComputeCmds;
 
     std::weak_ptr<Queues> queues;
     rgl::unordered_map<VkCommandBuffer, VkQueue> cmdQueues[MAX_FRAMES_IN_FLIGHT];
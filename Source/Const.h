@@ -43,6 +43,10 @@ constexpr const char    *DEFAULT_TEXTURE_POSTFIX_NORMAL                     = "_
 
 constexpr uint32_t      MAX_PREGENERATED_MIPMAP_LEVELS          = 20;
 
+// Dynamic BLAS with the same topology is refitted instead of rebuilding,
+// but it's fully rebuilt after this amount of refits, as its quality decays
+constexpr uint32_t      DYNAMIC_BLAS_MAX_UPDATE_COUNT           = 16;
+
 // Use WORLD2 mask bit as SKY
 #define RAYCULLMASK_SKY_IS_WORLD2 1
 
@@ -0,0 +1,197 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CpuTrace.h"
+
+#ifdef RG_USE_CPU_TRACING
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace RTGL1;
+
+std::atomic<bool> CpuTrace::detail::enabled = false;
+
+namespace
+{
+    constexpr uint64_t RING_SIZE = 1 << 16;
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "Ring size must be a power of 2");
+
+    // Fields are atomic, so a slot can be read while it's being overwritten;
+    // "sequence" is odd while writing, a reader discards the slot if it has changed.
+    struct Event
+    {
+        std::atomic<uint64_t> sequence{ 0 };
+        std::atomic<const char *> pName{ nullptr };
+        std::atomic<uint32_t> threadId{ 0 };
+        std::atomic<uint64_t> beginNs{ 0 };
+        std::atomic<uint64_t> endNs{ 0 };
+    };
+
+    struct EventCopy
+    {
+        const char *pName;
+        uint32_t threadId;
+        uint64_t beginNs;
+        uint64_t endNs;
+    };
+
+    Event g_ring[RING_SIZE];
+    std::atomic<uint64_t> g_head = 0;
+    std::atomic<uint32_t> g_threadCounter = 0;
+
+    uint32_t GetThreadId()
+    {
+        // small sequential ids are more readable than the hashes of std::thread::id
+        thread_local const uint32_t id = g_threadCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+        return id;
+    }
+
+    std::vector<EventCopy> CopyEvents()
+    {
+        const uint64_t head = g_head.load(std::memory_order_acquire);
+        const uint64_t first = head > RING_SIZE ? head - RING_SIZE : 0;
+
+        std::vector<EventCopy> result;
+        result.reserve(head - first);
+
+        for (uint64_t i = first; i < head; i++)
+        {
+            const Event &e = g_ring[i & (RING_SIZE - 1)];
+
+            const uint64_t seq = e.sequence.load(std::memory_order_acquire);
+
+            // not finished or already overwritten
+            if (seq != i * 2 + 2)
+            {
+                continue;
+            }
+
+            EventCopy c = 
+            {
+                .pName = e.pName.load(std::memory_order_relaxed),
+                .threadId = e.threadId.load(std::memory_order_relaxed),
+                .beginNs = e.beginNs.load(std::memory_order_relaxed),
+                .endNs = e.endNs.load(std::memory_order_relaxed),
+            };
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (e.sequence.load(std::memory_order_relaxed) != seq)
+            {
+                continue;
+            }
+
+            result.push_back(c);
+        }
+
+        return result;
+    }
+
+    void WriteEscaped(FILE *f, const char *pStr)
+    {
+        for (const char *c = pStr; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                std::fputc('\\', f);
+            }
+            std::fputc(*c, f);
+        }
+    }
+}
+
+void CpuTrace::SetEnabled(bool enable)
+{
+    detail::enabled.store(enable, std::memory_order_relaxed);
+}
+
+uint64_t CpuTrace::Now()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CpuTrace::Record(const char *pName, uint64_t beginNs, uint64_t endNs)
+{
+    const uint64_t index = g_head.fetch_add(1, std::memory_order_relaxed);
+    Event &e = g_ring[index & (RING_SIZE - 1)];
+
+    e.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    e.pName.store(pName, std::memory_order_relaxed);
+    e.threadId.store(GetThreadId(), std::memory_order_relaxed);
+    e.beginNs.store(beginNs, std::memory_order_relaxed);
+    e.endNs.store(endNs, std::memory_order_relaxed);
+
+    e.sequence.store(index * 2 + 2, std::memory_order_release);
+}
+
+bool CpuTrace::WriteChromeTrace(const char *pFilePath)
+{
+    if (pFilePath == nullptr)
+    {
+        return false;
+    }
+
+    std::vector<EventCopy> events = CopyEvents();
+
+    std::ranges::sort(events, [](const EventCopy &a, const EventCopy &b)
+    {
+        return a.beginNs < b.beginNs;
+    });
+
+    FILE *f = std::fopen(pFilePath, "w");
+
+    if (f == nullptr)
+    {
+        return false;
+    }
+
+    const uint64_t origin = events.empty() ? 0 : events.front().beginNs;
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const EventCopy &e = events[i];
+
+        // complete events, time is in microseconds
+        std::fprintf(f, "{\"name\":\"");
+        WriteEscaped(f, e.pName != nullptr ? e.pName : "");
+        std::fprintf(f, "\",\"cat\":\"RTGL1\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                e.threadId,
+                static_cast<double>(e.beginNs - origin) / 1000.0,
+                static_cast<double>(e.endNs - e.beginNs) / 1000.0,
+                i + 1 < events.size() ? "," : "");
+    }
+
+    std::fprintf(f, "]}\n");
+
+    const bool success = std::ferror(f) == 0;
+    std::fclose(f);
+
+    return success;
+}
+
+#endif // RG_USE_CPU_TRACING
@@ -0,0 +1,88 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Scoped CPU events for profiling, compiled in only with RG_USE_CPU_TRACING
+// and recorded only if "cputracing" entry is in the library config.
+// Use RG_TRACE_SCOPE("name") with string literals, as only pointers are stored.
+
+#ifdef RG_USE_CPU_TRACING
+
+namespace RTGL1::CpuTrace
+{
+    namespace detail
+    {
+        extern std::atomic<bool> enabled;
+    }
+
+    void SetEnabled(bool enable);
+
+    inline bool IsEnabled()
+    {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+
+    // Nanoseconds
+    uint64_t Now();
+
+    // Thread-safe, lock-free. The oldest events are overwritten, if the ring is full.
+    void Record(const char *pName, uint64_t beginNs, uint64_t endNs);
+
+    // Write recorded events in Chrome trace event format, it can be opened
+    // in chrome://tracing or Perfetto UI. Returns false, if the file couldn't be written.
+    bool WriteChromeTrace(const char *pFilePath);
+
+    class Scope
+    {
+    public:
+        explicit Scope(const char *_pName) : pName(_pName), beginNs(IsEnabled() ? Now() : UINT64_MAX) {}
+
+        ~Scope()
+        {
+            if (beginNs != UINT64_MAX)
+            {
+                Record(pName, beginNs, Now());
+            }
+        }
+
+        Scope(const Scope &other) = delete;
+        Scope(Scope &&other) noexcept = delete;
+        Scope &operator=(const Scope &other) = delete;
+        Scope &operator=(Scope &&other) noexcept = delete;
+
+    private:
+        const char *pName;
+        uint64_t beginNs;
+    };
+}
+
+#define RG_TRACE_CONCAT_IMPL(a, b) a##b
+#define RG_TRACE_CONCAT(a, b) RG_TRACE_CONCAT_IMPL(a, b)
+#define RG_TRACE_SCOPE(pName) ::RTGL1::CpuTrace::Scope RG_TRACE_CONCAT(rgTraceScope_, __LINE__)(pName)
+
+#else
+
+#define RG_TRACE_SCOPE(pName) ((void)0)
+
+#endif // RG_USE_CPU_TRACING
@@ -0,0 +1,118 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DirtyRangeSet.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace RTGL1;
+
+DirtyRangeSet::DirtyRangeSet(uint32_t _mergeGap) : mergeGap(_mergeGap), isCoalesced(true)
+{}
+
+void DirtyRangeSet::Add(uint32_t index)
+{
+    Add(index, 1);
+}
+
+void DirtyRangeSet::Add(uint32_t first, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    const uint32_t begin = first;
+    const uint32_t end = first + count;
+    assert(begin < end);
+
+    // elements are usually marked sequentially,
+    // so try to extend the last range first
+    if (!ranges.empty())
+    {
+        Range &last = ranges.back();
+
+        if (begin <= last.end + mergeGap && last.begin <= end + mergeGap)
+        {
+            // extending to the left might overlap the previous ranges
+            if (begin < last.begin && ranges.size() > 1)
+            {
+                isCoalesced = false;
+            }
+
+            last.begin = std::min(last.begin, begin);
+            last.end = std::max(last.end, end);
+            return;
+        }
+
+        if (begin < last.begin)
+        {
+            isCoalesced = false;
+        }
+    }
+
+    ranges.push_back({ begin, end });
+}
+
+void DirtyRangeSet::Clear()
+{
+    ranges.clear();
+    isCoalesced = true;
+}
+
+bool DirtyRangeSet::IsEmpty() const
+{
+    return ranges.empty();
+}
+
+const std::vector<DirtyRangeSet::Range> &DirtyRangeSet::GetRanges()
+{
+    if (isCoalesced)
+    {
+        return ranges;
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [] (const Range &a, const Range &b)
+    {
+        return a.begin < b.begin;
+    });
+
+    // merge in-place
+    size_t last = 0;
+
+    for (size_t i = 1; i < ranges.size(); i++)
+    {
+        if (ranges[i].begin <= ranges[last].end + mergeGap)
+        {
+            ranges[last].end = std::max(ranges[last].end, ranges[i].end);
+        }
+        else
+        {
+            last++;
+            ranges[last] = ranges[i];
+        }
+    }
+
+    ranges.resize(last + 1);
+    isCoalesced = true;
+
+    return ranges;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Set of dirty element intervals, e.g. to copy only changed parts of a buffer.
+// Ranges that are closer than "mergeGap" elements are coalesced into one,
+// as copying a few clean elements is cheaper than an additional copy region.
+class DirtyRangeSet
+{
+public:
+    struct Range
+    {
+        uint32_t begin;
+        uint32_t end;
+    };
+
+public:
+    explicit DirtyRangeSet(uint32_t mergeGap = 0);
+
+    void Add(uint32_t index);
+    void Add(uint32_t first, uint32_t count);
+    void Clear();
+
+    bool IsEmpty() const;
+    // Sort and coalesce the added ranges. Returned ranges don't overlap
+    // and are in ascending order.
+    const std::vector<Range> &GetRanges();
+
+private:
+    std::vector<Range> ranges;
+    uint32_t mergeGap;
+    bool isCoalesced;
+};
+
+}
@@ -26,6 +26,10 @@
 #include "RenderResolutionHelper.h"
 #include "RgException.h"
 
+
+#ifndef RG_USE_NULL_DEVICE
+
+
 namespace
 {
     void CheckError(FfxErrorCode r)
@@ -215,3 +219,21 @@ RgFloat2D RTGL1::FSR2::GetJitter(const ResolutionState& resolutionState, uint32_
 
     return jitter;
 }
+
+
+#else
+
+
+// FSR2 libraries require a real Vulkan device
+RTGL1::FSR2::FSR2(VkDevice _device, VkPhysicalDevice _physDevice) : device(_device), physDevice(_physDevice), context(std::make_unique<std::optional<FfxFsr2Context>>()) { }
+RTGL1::FSR2::~FSR2() { }
+
+void RTGL1::FSR2::OnFramebuffersSizeChange(const ResolutionState &resolutionState) { }
+
+RTGL1::FramebufferImageIndex RTGL1::FSR2::Apply(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<Framebuffers> &framebuffers, const RenderResolutionHelper &renderResolution, RgFloat2D jitterOffset, float timeDelta, float nearPlane, float farPlane, float fovVerticalRad)
+{ throw RgException(RG_WRONG_ARGUMENT, "RTGL1 was built with RG_WITH_NULL_DEVICE, FSR2 is not available."); }
+
+RgFloat2D RTGL1::FSR2::GetJitter(const ResolutionState &resolutionState, uint32_t frameId) { return {}; }
+
+
+#endif // !RG_USE_NULL_DEVICE
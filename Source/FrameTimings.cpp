@@ -0,0 +1,187 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FrameTimings.h"
+
+#include <algorithm>
+
+using namespace RTGL1;
+
+namespace
+{
+    // begin and end timestamps for each segment
+    constexpr uint32_t MAX_QUERY_COUNT = 128;
+
+    float ToMs(uint64_t ticks, double timestampPeriod)
+    {
+        return static_cast<float>(static_cast<double>(ticks) * timestampPeriod / 1000000.0);
+    }
+}
+
+FrameTimings::FrameTimings(VkDevice _device, const std::shared_ptr<PhysicalDevice> &_physDevice)
+:
+    device(_device),
+    isSupported(false),
+    timestampPeriod(1.0),
+    queryPools{},
+    frameIds{},
+    latest{}
+{
+    const VkPhysicalDeviceLimits &limits = _physDevice->GetLimits();
+
+    // timestamps must be supported by all graphics and compute queues
+    isSupported = limits.timestampComputeAndGraphics && limits.timestampPeriod > 0.0f;
+    timestampPeriod = limits.timestampPeriod;
+
+    if (!isSupported)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = MAX_QUERY_COUNT;
+
+        VkResult r = vkCreateQueryPool(device, &poolInfo, nullptr, &queryPools[i]);
+        VK_CHECKERROR(r);
+
+        SET_DEBUG_NAME(device, queryPools[i], VK_OBJECT_TYPE_QUERY_POOL, "Frame timings query pool");
+
+        segments[i].reserve(MAX_QUERY_COUNT / 2);
+    }
+}
+
+FrameTimings::~FrameTimings()
+{
+    for (VkQueryPool p : queryPools)
+    {
+        if (p != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, p, nullptr);
+        }
+    }
+}
+
+void FrameTimings::PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t frameId)
+{
+    if (!isSupported)
+    {
+        return;
+    }
+
+    ReadResults(frameIndex);
+
+    vkCmdResetQueryPool(cmd, queryPools[frameIndex], 0, MAX_QUERY_COUNT);
+
+    segments[frameIndex].clear();
+    frameIds[frameIndex] = frameId;
+}
+
+void FrameTimings::ReadResults(uint32_t frameIndex)
+{
+    if (segments[frameIndex].empty())
+    {
+        return;
+    }
+
+    const uint32_t queryCount = segments[frameIndex].back().beginQuery + 2;
+
+    // value and availability for each query
+    uint64_t results[MAX_QUERY_COUNT][2] = {};
+
+    // no VK_QUERY_RESULT_WAIT_BIT: the fence of the frame index was already waited for,
+    // but if a query is still not available, it's just ignored
+    VkResult r = vkGetQueryPoolResults(device, queryPools[frameIndex], 0, queryCount,
+                                       queryCount * sizeof(results[0]), results, sizeof(results[0]),
+                                       VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (r != VK_NOT_READY)
+    {
+        VK_CHECKERROR(r);
+    }
+
+    RgFrameTimings timings = {};
+    timings.frameId = frameIds[frameIndex];
+
+    uint64_t first = UINT64_MAX;
+    uint64_t last = 0;
+
+    for (const Segment &s : segments[frameIndex])
+    {
+        const uint64_t *begin = results[s.beginQuery];
+        const uint64_t *end = results[s.beginQuery + 1];
+
+        if (begin[1] == 0 || end[1] == 0 || end[0] < begin[0])
+        {
+            continue;
+        }
+
+        timings.passTimesMs[s.pass] += ToMs(end[0] - begin[0], timestampPeriod);
+
+        first = std::min(first, begin[0]);
+        last = std::max(last, end[0]);
+    }
+
+    if (first < last)
+    {
+        timings.frameTimeMs = ToMs(last - first, timestampPeriod);
+    }
+
+    latest = timings;
+}
+
+uint32_t FrameTimings::BeginSegment(VkCommandBuffer cmd, uint32_t frameIndex, RgFramePass pass)
+{
+    if (!isSupported)
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t beginQuery = static_cast<uint32_t>(segments[frameIndex].size()) * 2;
+
+    if (beginQuery + 2 > MAX_QUERY_COUNT)
+    {
+        assert(0 && "Increase MAX_QUERY_COUNT");
+        return UINT32_MAX;
+    }
+
+    segments[frameIndex].push_back({ pass, beginQuery });
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPools[frameIndex], beginQuery);
+    return beginQuery;
+}
+
+void FrameTimings::EndSegment(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t beginQuery)
+{
+    if (beginQuery == UINT32_MAX)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPools[frameIndex], beginQuery + 1);
+}
+
+const RgFrameTimings &FrameTimings::GetLatest() const
+{
+    return latest;
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+#include "PhysicalDevice.h"
+#include "RTGL1/RTGL1.h"
+
+namespace RTGL1
+{
+
+// Measures GPU time of the frame passes with timestamp queries.
+// Each frame index has its own query pool, which results are read
+// when the same frame index is started again, i.e. when its fence
+// was waited for, so reading them never stalls.
+class FrameTimings
+{
+public:
+    explicit FrameTimings(VkDevice device, const std::shared_ptr<PhysicalDevice> &physDevice);
+    ~FrameTimings();
+
+    FrameTimings(const FrameTimings &other) = delete;
+    FrameTimings(FrameTimings &&other) noexcept = delete;
+    FrameTimings &operator=(const FrameTimings &other) = delete;
+    FrameTimings &operator=(FrameTimings &&other) noexcept = delete;
+
+    // Must be called after waiting for the fence of the frame index.
+    // Reads the results that were written MAX_FRAMES_IN_FLIGHT frames ago
+    // and resets the queries of the frame index.
+    void PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t frameId);
+
+    // A pass can consist of several segments, their times are summed up.
+    // Returns a query index that must be passed to EndSegment.
+    uint32_t BeginSegment(VkCommandBuffer cmd, uint32_t frameIndex, RgFramePass pass);
+    void EndSegment(VkCommandBuffer cmd, uint32_t frameIndex, uint32_t beginQuery);
+
+    const RgFrameTimings &GetLatest() const;
+
+private:
+    void ReadResults(uint32_t frameIndex);
+
+private:
+    struct Segment
+    {
+        RgFramePass pass;
+        // end timestamp is the next query
+        uint32_t beginQuery;
+    };
+
+private:
+    VkDevice device;
+    bool isSupported;
+    // nanoseconds per timestamp tick
+    double timestampPeriod;
+
+    VkQueryPool queryPools[MAX_FRAMES_IN_FLIGHT];
+    // segments that were recorded, and frame ID that they belong to
+    std::vector<Segment> segments[MAX_FRAMES_IN_FLIGHT];
+    uint32_t frameIds[MAX_FRAMES_IN_FLIGHT];
+
+    RgFrameTimings latest;
+};
+
+
+// Measure a segment of the pass for the lifetime of the object
+class FrameTimingScope
+{
+public:
+    explicit FrameTimingScope(FrameTimings &_timings, VkCommandBuffer _cmd, uint32_t _frameIndex, RgFramePass _pass)
+        : timings(_timings), cmd(_cmd), frameIndex(_frameIndex)
+    {
+        beginQuery = timings.BeginSegment(cmd, frameIndex, _pass);
+    }
+
+    ~FrameTimingScope()
+    {
+        timings.EndSegment(cmd, frameIndex, beginQuery);
+    }
+
+    FrameTimingScope(const FrameTimingScope &other) = delete;
+    FrameTimingScope(FrameTimingScope &&other) noexcept = delete;
+    FrameTimingScope &operator=(const FrameTimingScope &other) = delete;
+    FrameTimingScope &operator=(FrameTimingScope &&other) noexcept = delete;
+
+private:
+    FrameTimings &timings;
+    VkCommandBuffer cmd;
+    uint32_t frameIndex;
+    uint32_t beginQuery;
+};
+
+}
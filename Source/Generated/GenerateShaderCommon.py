@@ -223,9 +223,10 @@ GRADIENT_ESTIMATION_ENABLED = True
 FRAMEBUF_IGNORE_ATTACHMENTS_DEFINE = "FRAMEBUF_IGNORE_ATTACHMENTS" # define this, to not specify framebufs that are used as attachments
 
 CONST = {
-    "MAX_STATIC_VERTEX_COUNT"               : 1 << 20,
-    "MAX_DYNAMIC_VERTEX_COUNT"              : 1 << 21,
-    "MAX_INDEXED_PRIMITIVE_COUNT"           : 1 << 20,
+    # static chunks have their own regions before the static vertex and index data,
+    # vertex and index buffers are growable, so they have no other limits
+    "MAX_STATIC_CHUNK_VERTEX_COUNT"         : 1 << 20,
+    "MAX_STATIC_CHUNK_INDEXED_PRIMITIVE_COUNT" : 1 << 20,
    
     "MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT"     : 1 << 12,
     "MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT_POW" : CONST_TO_EVALUATE,
@@ -235,6 +236,8 @@ CONST = {
     "LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT"   : 1 << 8,
     
     "MAX_TOP_LEVEL_INSTANCE_COUNT"          : 45,
+    # geometry infos of mesh instances and static chunks are placed after the ones of the instances above
+    "MAX_MESH_INSTANCE_COUNT"               : 1 << 16,
     
     "BINDING_VERTEX_BUFFER_STATIC"              : 0,
     "BINDING_VERTEX_BUFFER_DYNAMIC"             : 1,
@@ -276,6 +279,9 @@ CONST = {
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON"           : "1 << 1",
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER"    : "1 << 2",
     "INSTANCE_CUSTOM_INDEX_FLAG_SKY"                    : "1 << 3",
+    "INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE"          : "1 << 4",
+    # mesh instances store their global geometry index in the bits after the flags
+    "INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET"       : 5,
 
     "INSTANCE_MASK_WORLD_0"                 : 1 << 0,
     "INSTANCE_MASK_WORLD_1"                 : 1 << 1,
@@ -402,6 +408,9 @@ CONST = {
     "MEDIA_TYPE_COUNT"                      : 4,
 
     "GEOM_INST_NO_TRIANGLE_INFO"            : "UINT32_MAX",
+    # if set in base index index, then indices are 16-bit;
+    # must be checked only if base index index is not UINT32_MAX
+    "GEOM_INST_INDEX_16_BIT_FLAG"           : "1u << 31",
 
     "LIGHT_TYPE_NONE"                       : 0,
     "LIGHT_TYPE_DIRECTIONAL"                : 1,
@@ -486,6 +495,19 @@ VERTEX_STRUCT = [
     (TYPE_UINT32,       1,     "packedColor",           1),
 ]
 
+# Used instead of ShVertex, if RgInstanceCreateInfo::compactVertexFormat is true.
+# Positions are not compressed, as they're read by AS builds.
+VERTEX_COMPACT_STRUCT = [
+    (TYPE_FLOAT32,      1,     "position",              3),
+    # octahedral encoding, 2x snorm16
+    (TYPE_UINT32,       1,     "normal",                1),
+    # 2x float16
+    (TYPE_UINT32,       1,     "texCoord",              1),
+    (TYPE_UINT32,       1,     "texCoordLayer1",        1),
+    (TYPE_UINT32,       1,     "texCoordLayer2",        1),
+    (TYPE_UINT32,       1,     "packedColor",           1),
+]
+
 # Must be careful with std140 offsets! They are set manually.
 # Other structs are using std430 and padding is done automatically.
 GLOBAL_UNIFORM_STRUCT = [
@@ -596,7 +618,7 @@ GLOBAL_UNIFORM_STRUCT = [
     (TYPE_FLOAT32,      4,      "volumeDirToSource",                1),
 
     (TYPE_FLOAT32,      1,      "volumeSourceAsymmetry",            1),
-    (TYPE_FLOAT32,      1,      "_pad1",                            1),
+    (TYPE_UINT32,       1,      "vertexFormatCompact",              1),
     (TYPE_FLOAT32,      1,      "_pad2",                            1),
     (TYPE_FLOAT32,      1,      "_pad3",                            1),
 
@@ -709,6 +731,7 @@ STRUCT_BREAK_TYPE_ONLY_C    = 2
 #                      it'll be represented as an array of primitive types
 STRUCTS = {
     "ShVertex":                 (VERTEX_STRUCT,                 False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShVertexCompact":          (VERTEX_COMPACT_STRUCT,         False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShGlobalUniform":          (GLOBAL_UNIFORM_STRUCT,         False,  STRUCT_ALIGNMENT_STD140,    STRUCT_BREAK_TYPE_ONLY_C),
     "ShGeometryInstance":       (GEOM_INSTANCE_STRUCT,          False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShTonemapping":            (TONEMAPPING_STRUCT,            False,  0,                          0),
@@ -7,15 +7,15 @@ namespace RTGL1
 
 #include <stdint.h>
 
-#define MAX_STATIC_VERTEX_COUNT (1048576)
-#define MAX_DYNAMIC_VERTEX_COUNT (2097152)
-#define MAX_INDEXED_PRIMITIVE_COUNT (1048576)
+#define MAX_STATIC_CHUNK_VERTEX_COUNT (1048576)
+#define MAX_STATIC_CHUNK_INDEXED_PRIMITIVE_COUNT (1048576)
 #define MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT (4096)
 #define MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT_POW (12)
 #define MAX_GEOMETRY_PRIMITIVE_COUNT (1048576)
 #define MAX_GEOMETRY_PRIMITIVE_COUNT_POW (20)
 #define LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT (256)
 #define MAX_TOP_LEVEL_INSTANCE_COUNT (45)
+#define MAX_MESH_INSTANCE_COUNT (65536)
 #define BINDING_VERTEX_BUFFER_STATIC (0)
 #define BINDING_VERTEX_BUFFER_DYNAMIC (1)
 #define BINDING_INDEX_BUFFER_STATIC (2)
@@ -55,6 +55,8 @@ namespace RTGL1
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON (1 << 1)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER (1 << 2)
 #define INSTANCE_CUSTOM_INDEX_FLAG_SKY (1 << 3)
+#define INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE (1 << 4)
+#define INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET (5)
 #define INSTANCE_MASK_WORLD_0 (1)
 #define INSTANCE_MASK_WORLD_1 (2)
 #define INSTANCE_MASK_WORLD_2 (4)
@@ -160,6 +162,7 @@ namespace RTGL1
 #define MEDIA_TYPE_ACID (3)
 #define MEDIA_TYPE_COUNT (4)
 #define GEOM_INST_NO_TRIANGLE_INFO (UINT32_MAX)
+#define GEOM_INST_INDEX_16_BIT_FLAG (1u << 31)
 #define LIGHT_TYPE_NONE (0)
 #define LIGHT_TYPE_DIRECTIONAL (1)
 #define LIGHT_TYPE_SPHERE (2)
@@ -197,6 +200,16 @@ struct ShVertex
     uint32_t __pad0;
 };
 
+struct ShVertexCompact
+{
+    float position[3];
+    uint32_t normal;
+    uint32_t texCoord;
+    uint32_t texCoordLayer1;
+    uint32_t texCoordLayer2;
+    uint32_t packedColor;
+};
+
 struct ShGlobalUniform
 {
     float view[16];
@@ -283,7 +296,7 @@ struct ShGlobalUniform
     float volumeSourceColor[4];
     float volumeDirToSource[4];
     float volumeSourceAsymmetry;
-    float _pad1;
+    uint32_t vertexFormatCompact;
     float _pad2;
     float _pad3;
     int32_t instanceGeomInfoOffset[48];
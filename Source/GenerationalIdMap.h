@@ -0,0 +1,166 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Map from 64-bit ID to a value, for tables that are refilled every frame.
+// Open addressing with linear probing; values are stored densely in insertion order.
+// Clear() is O(1): it increments the generation, so all slots with older
+// generations become empty. Removing separate entries is not supported.
+template <typename T>
+class GenerationalIdMap
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Values are expected to be POD");
+
+public:
+    explicit GenerationalIdMap(uint32_t initialCapacity = 1024)
+        : mask(0), generation(1)
+    {
+        uint32_t capacity = 16;
+
+        while (capacity < initialCapacity)
+        {
+            capacity <<= 1;
+        }
+
+        slots.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    void Clear()
+    {
+        values.clear();
+        generation++;
+
+        // on overflow, slots with old generations could become valid again
+        if (generation == 0)
+        {
+            for (Slot &s : slots)
+            {
+                s.generation = 0;
+            }
+
+            generation = 1;
+        }
+    }
+
+    const T *Find(uint64_t id) const
+    {
+        const Slot &s = slots[FindSlot(id)];
+        return s.generation == generation ? &values[s.valueIndex] : nullptr;
+    }
+
+    T *Find(uint64_t id)
+    {
+        const Slot &s = slots[FindSlot(id)];
+        return s.generation == generation ? &values[s.valueIndex] : nullptr;
+    }
+
+    // Returns nullptr, if ID already exists
+    T *Insert(uint64_t id, const T &value)
+    {
+        // keep load factor below 0.5, so probe sequences are short
+        if ((values.size() + 1) * 2 > slots.size())
+        {
+            Grow();
+        }
+
+        Slot &s = slots[FindSlot(id)];
+
+        if (s.generation == generation)
+        {
+            return nullptr;
+        }
+
+        s.id = id;
+        s.generation = generation;
+        s.valueIndex = (uint32_t)values.size();
+
+        values.push_back(value);
+        return &values.back();
+    }
+
+    uint32_t GetCount() const
+    {
+        return (uint32_t)values.size();
+    }
+
+private:
+    struct Slot
+    {
+        uint64_t id = 0;
+        uint32_t generation = 0;
+        uint32_t valueIndex = 0;
+    };
+
+    static uint32_t Hash(uint64_t id)
+    {
+        // fibonacci hashing, as IDs are usually sequential
+        return (uint32_t)((id * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    // Returns the slot with the ID, or an empty slot where it should be placed
+    uint32_t FindSlot(uint64_t id) const
+    {
+        uint32_t i = Hash(id) & mask;
+
+        while (slots[i].generation == generation && slots[i].id != id)
+        {
+            i = (i + 1) & mask;
+        }
+
+        return i;
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> oldSlots(slots.size() * 2);
+        std::swap(oldSlots, slots);
+
+        mask = (uint32_t)slots.size() - 1;
+
+        for (const Slot &old : oldSlots)
+        {
+            if (old.generation == generation)
+            {
+                slots[FindSlot(old.id)] = old;
+            }
+        }
+
+        // new slots have zero generation, it must not be used as a valid one
+        assert(generation != 0);
+    }
+
+private:
+    std::vector<Slot> slots;
+    std::vector<T> values;
+    uint32_t mask;
+    uint32_t generation;
+};
+
+}
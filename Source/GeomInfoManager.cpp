@@ -26,19 +26,33 @@
 #include "VertexCollectorFilterType.h"
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+#include "RgException.h"
 
 static_assert(sizeof(RTGL1::ShGeometryInstance) % 16 == 0, "Std430 structs must be aligned by 16 bytes");
 
+// if there are not more than this amount of clean geom infos
+// between dirty ones, copy them all in one region
+constexpr uint32_t GEOM_INFO_COPY_MERGE_GAP = 4;
+
 RTGL1::GeomInfoManager::GeomInfoManager(VkDevice _device, std::shared_ptr<MemoryAllocator> &_allocator)
 :
     device(_device),
     staticGeomCount(0),
-    dynamicGeomCount(0)
+    dynamicGeomCount(0),
+    meshInstanceCount(0),
+    isStaticCopyHeld(false)
 {
     buffer = std::make_shared<AutoBuffer>(device, _allocator);
     matchPrev = std::make_shared<AutoBuffer>(device, _allocator);
 
-    const uint32_t allBottomLevelGeomsCount = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
+    // geom infos of mesh instances are after the ones of all filters
+    const uint32_t allBottomLevelGeomsCount = VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount() + MAX_MESH_INSTANCE_COUNT;
+
+    // global geom index of a mesh instance must fit into the instance custom index
+    if ((allBottomLevelGeomsCount << INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET) >= (1 << 24))
+    {
+        throw RgException(RG_GRAPHICS_API_ERROR, "Geometry info count (" + std::to_string(allBottomLevelGeomsCount) + ") doesn't fit into the TLAS instance custom index");
+    }
 
     buffer->Create(allBottomLevelGeomsCount * sizeof(RTGL1::ShGeometryInstance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Geometry info buffer");
     matchPrev->Create(allBottomLevelGeomsCount * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Match previous Geometry infos buffer");
@@ -46,8 +60,7 @@ RTGL1::GeomInfoManager::GeomInfoManager(VkDevice _device, std::shared_ptr<Memory
 
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
-        copyRegionLowerBounds[i].resize(MAX_TOP_LEVEL_INSTANCE_COUNT, UINT32_MAX);
-        copyRegionUpperBounds[i].resize(MAX_TOP_LEVEL_INSTANCE_COUNT, 0);
+        dirtyGeomInfos[i].resize(MAX_TOP_LEVEL_INSTANCE_COUNT, DirtyRangeSet(GEOM_INFO_COPY_MERGE_GAP));
     }
 }
 
@@ -60,8 +73,9 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
     CmdLabel label(cmd, "Copying geom infos");
 
     {
-        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT];
-        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT];
+        // +1 for mesh instances
+        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
+        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT + 1];
 
         uint32_t infoCount = 0;
 
@@ -124,6 +138,42 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
             }
         }
 
+        // previous frame's mesh instances
+        if (matchPrevCopyInfo.maxMeshInstanceCount > 0)
+        {
+            const uint64_t offset = GetMeshInstanceGlobalGeomIndex(0) * sizeof(int32_t);
+            const uint64_t size = matchPrevCopyInfo.maxMeshInstanceCount * sizeof(int32_t);
+
+            {
+                uint8_t *pDst = (uint8_t*)matchPrev->GetMapped(frameIndex);
+                uint8_t *pSrc = (uint8_t*)matchPrevShadow.get();
+
+                memcpy(pDst + offset, pSrc + offset, size);
+            }
+
+            VkBufferCopy &c = copyInfos[infoCount];
+
+            c = {};
+            c.srcOffset = offset;
+            c.dstOffset = offset;
+            c.size = size;
+
+            VkBufferMemoryBarrier &b = barriers[infoCount];
+
+            b = {};
+            b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            b.buffer = matchPrev->GetDeviceLocal();
+            b.offset = offset;
+            b.size = size;
+
+            infoCount++;
+        }
+
         if (infoCount > 0)
         {
             matchPrev->CopyFromStaging(cmd, frameIndex, copyInfos, infoCount);
@@ -143,10 +193,32 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
 
 
     {
-        VkBufferCopy copyInfos[MAX_TOP_LEVEL_INSTANCE_COUNT];
-        VkBufferMemoryBarrier barriers[MAX_TOP_LEVEL_INSTANCE_COUNT];
+        std::vector<VkBufferCopy> &copyInfos = geomInfoCopyRegions;
+        std::vector<VkBufferMemoryBarrier> &barriers = geomInfoBarriers;
 
-        uint32_t infoCount = 0;
+        copyInfos.clear();
+        barriers.clear();
+
+        const auto addRegion = [this, &copyInfos, &barriers] (uint64_t offset, uint64_t size)
+        {
+            VkBufferCopy c = {};
+            c.srcOffset = offset;
+            c.dstOffset = offset;
+            c.size = size;
+
+            VkBufferMemoryBarrier b = {};
+            b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            b.buffer = buffer->GetDeviceLocal();
+            b.offset = offset;
+            b.size = size;
+
+            copyInfos.push_back(c);
+            barriers.push_back(b);
+        };
 
         for (auto cf : VertexCollectorFilterGroup_ChangeFrequency)
         {
@@ -156,52 +228,41 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
                 {
                     uint32_t flagsId = VertexCollectorFilterTypeFlags_GetID(cf | pt | pm);
 
-                    const uint32_t lower = copyRegionLowerBounds[frameIndex][flagsId];
-                    const uint32_t upper = copyRegionUpperBounds[frameIndex][flagsId];
+                    DirtyRangeSet &dirty = dirtyGeomInfos[frameIndex][flagsId];
 
-                    if (lower < upper)
+                    if (dirty.IsEmpty())
                     {
-                        const uint32_t offsetInArray = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(cf | pt | pm);
-
-                        const uint64_t offset = sizeof(ShGeometryInstance) * (offsetInArray + lower);
-                        const uint64_t size = sizeof(ShGeometryInstance) * (upper - lower);
-
-                        {
-                            VkBufferCopy &c = copyInfos[infoCount];
-
-                            c = {};
-                            c.srcOffset = offset;
-                            c.dstOffset = offset;
-                            c.size = size;
-                        }
-
-                        {
-                            VkBufferMemoryBarrier &b = barriers[infoCount];
+                        continue;
+                    }
 
-                            b = {};
-                            b.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-                            b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                            b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                            b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                            b.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                    const uint32_t offsetInArray = VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(cf | pt | pm);
 
-                            b.buffer = buffer->GetDeviceLocal();
-                            b.offset = offset;
-                            b.size = size;
-                        }
+                    for (const auto &r : dirty.GetRanges())
+                    {
+                        assert(r.end <= VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(cf | pt | pm));
 
-                        infoCount++;
+                        addRegion(
+                            sizeof(ShGeometryInstance) * (offsetInArray + r.begin),
+                            sizeof(ShGeometryInstance) * (r.end - r.begin));
                     }
                 }
             }
         }
 
-        if (infoCount == 0)
+        // mesh instances are always written from the beginning of their region
+        if (meshInstanceCount > 0)
+        {
+            addRegion(
+                sizeof(ShGeometryInstance) * GetMeshInstanceGlobalGeomIndex(0),
+                sizeof(ShGeometryInstance) * meshInstanceCount);
+        }
+
+        if (copyInfos.empty())
         {
             return false;
         }
 
-        buffer->CopyFromStaging(cmd, frameIndex, copyInfos, infoCount);
+        buffer->CopyFromStaging(cmd, frameIndex, copyInfos.data(), (uint32_t)copyInfos.size());
 
         if (insertBarrier)
         {
@@ -210,7 +271,7 @@ bool RTGL1::GeomInfoManager::CopyFromStaging(VkCommandBuffer cmd, uint32_t frame
                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
                 0,
                 0, nullptr,
-                infoCount, barriers,
+                (uint32_t)barriers.size(), barriers.data(),
                 0, nullptr);
         }
     }
@@ -267,16 +328,29 @@ void RTGL1::GeomInfoManager::ResetOnlyDynamic(uint32_t frameIndex)
         dynamicGeomCount = 0;
     }
 
-    for (uint32_t type = 0; type < MAX_TOP_LEVEL_INSTANCE_COUNT; type++)
+    if (meshInstanceCount > 0)
+    {
+        int32_t *toReset = matchPrevShadow.get() + GetMeshInstanceGlobalGeomIndex(0);
+        memset(toReset, 0xFF, meshInstanceCount * sizeof(int32_t));
+
+        meshInstanceCount = 0;
+    }
+
+    for (auto &dirty : dirtyGeomInfos[frameIndex])
     {
-        std::fill(copyRegionLowerBounds[frameIndex].begin(), copyRegionLowerBounds[frameIndex].end(), UINT32_MAX);
-        std::fill(copyRegionUpperBounds[frameIndex].begin(), copyRegionUpperBounds[frameIndex].end(), 0);
+        dirty.Clear();
     }
 }
 
 void RTGL1::GeomInfoManager::ResetWithStatic()
 {
-    movableIDToGeomFrameInfo.clear();
+    movableIDToGeomFrameInfo.Clear();
+
+    // meshes are recreated with the static scene
+    for (auto &m : meshInstanceIDToGeomFrameInfo)
+    {
+        m.Clear();
+    }
 
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
@@ -299,6 +373,9 @@ void RTGL1::GeomInfoManager::ResetWithStatic()
     geomType.clear();
     simpleToLocalIndex.clear();
 
+    // copy ranges are cleared, and the new static geom infos are not copied until they're built
+    isStaticCopyHeld = true;
+
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         ResetOnlyDynamic(i);
@@ -310,6 +387,13 @@ uint32_t RTGL1::GeomInfoManager::GetGlobalGeomIndex(uint32_t localGeomIndex, Ver
     return VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(flags) + localGeomIndex;
 }
 
+uint32_t RTGL1::GeomInfoManager::GetMeshInstanceGlobalGeomIndex(uint32_t instanceIndex)
+{
+    assert(instanceIndex < MAX_MESH_INSTANCE_COUNT);
+
+    return VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount() + instanceIndex;
+}
+
 RTGL1::ShGeometryInstance * RTGL1::GeomInfoManager::GetGeomInfoAddressByGlobalIndex(uint32_t frameIndex, uint32_t globalGeomIndex)
 {
     auto *mapped = (ShGeometryInstance *)buffer->GetMapped(frameIndex);
@@ -334,8 +418,10 @@ void RTGL1::GeomInfoManager::PrepareForFrame(uint32_t frameIndex)
     // save counts before resetting
     matchPrevCopyInfo.maxDynamicGeomCount = dynamicGeomCount;
     matchPrevCopyInfo.maxStaticGeomCount = staticGeomCount;
+    matchPrevCopyInfo.maxMeshInstanceCount = meshInstanceCount;
 
-    dynamicIDToGeomFrameInfo[frameIndex].clear();
+    dynamicIDToGeomFrameInfo[frameIndex].Clear();
+    meshInstanceIDToGeomFrameInfo[frameIndex].Clear();
     ResetOnlyDynamic(frameIndex);
 }
 
@@ -348,7 +434,7 @@ uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
 {
     // must be aligned for per-triangle vertex attributes
     assert(src.baseVertexIndex % 3 == 0);
-    assert(src.baseIndexIndex % 3 == 0);
+    assert(src.baseIndexIndex == UINT32_MAX || (src.baseIndexIndex & ~GEOM_INST_INDEX_16_BIT_FLAG) % 3 == 0);
 
     const uint32_t simpleIndex = GetCount();
 
@@ -397,7 +483,11 @@ uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
         ShGeometryInstance *dst = GetGeomInfoAddressByGlobalIndex(i, globalGeomIndex);
         memcpy(dst, &src, sizeof(ShGeometryInstance));
 
-        MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+        // device-local static geom infos can be in use by the previous static scene
+        if (!isStatic || !isStaticCopyHeld)
+        {
+            MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+        }
     }
 
     WriteInfoForNextUsage(flags, geomUniqueID, globalGeomIndex, src, frameIndex);        
@@ -405,12 +495,64 @@ uint32_t RTGL1::GeomInfoManager::WriteGeomInfo(
     return simpleIndex;
 }
 
+uint32_t RTGL1::GeomInfoManager::WriteMeshInstanceGeomInfo(
+    uint32_t frameIndex,
+    uint64_t instanceUniqueID,
+    ShGeometryInstance &src)
+{
+    // mesh instances and static chunks share the same region
+    if (meshInstanceCount >= MAX_MESH_INSTANCE_COUNT)
+    {
+        return UINT32_MAX;
+    }
+
+    const uint32_t globalGeomIndex = GetMeshInstanceGlobalGeomIndex(meshInstanceCount);
+    meshInstanceCount++;
+
+    static_assert(MAX_FRAMES_IN_FLIGHT == 2, "Assuming MAX_FRAMES_IN_FLIGHT==2");
+    uint32_t prevFrame = (frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
+
+    const GeomFrameInfo *prev = meshInstanceIDToGeomFrameInfo[prevFrame].Find(instanceUniqueID);
+
+    // mesh vertices are static, so if it's the same mesh, only model matrix could be changed
+    if (prev != nullptr && prev->baseVertexIndex == src.baseVertexIndex)
+    {
+        MarkMovableHasPrevInfo(src);
+        memcpy(src.prevModel, prev->model, sizeof(float) * 16);
+
+        // save index to access ShGeometryInfo using previous frame's global geom index
+        matchPrevShadow[prev->prevGlobalGeomIndex] = (int32_t)globalGeomIndex;
+    }
+    else
+    {
+        MarkNoPrevInfo(src);
+    }
+
+    ShGeometryInstance *dst = GetGeomInfoAddressByGlobalIndex(frameIndex, globalGeomIndex);
+    memcpy(dst, &src, sizeof(ShGeometryInstance));
+
+    GeomFrameInfo f = {};
+    memcpy(f.model, src.model, sizeof(float) * 16);
+    f.baseVertexIndex = src.baseVertexIndex;
+    f.baseIndexIndex = src.baseIndexIndex;
+    f.vertexCount = src.vertexCount;
+    f.indexCount = src.indexCount;
+    f.prevGlobalGeomIndex = globalGeomIndex;
+
+    // IDs must be unique
+    if (meshInstanceIDToGeomFrameInfo[frameIndex].Insert(instanceUniqueID, f) == nullptr)
+    {
+        assert(0);
+    }
+
+    return globalGeomIndex;
+}
+
 void RTGL1::GeomInfoManager::MarkGeomInfoIndexToCopy(uint32_t frameIndex, uint32_t localGeomIndex, uint32_t flagsId)
 {
     assert(flagsId < MAX_TOP_LEVEL_INSTANCE_COUNT);
 
-    copyRegionLowerBounds[frameIndex][flagsId] = std::min(localGeomIndex,     copyRegionLowerBounds[frameIndex][flagsId]);
-    copyRegionUpperBounds[frameIndex][flagsId] = std::max(localGeomIndex + 1, copyRegionUpperBounds[frameIndex][flagsId]);
+    dirtyGeomInfos[frameIndex][flagsId].Add(localGeomIndex);
 }
 
 void RTGL1::GeomInfoManager::FillWithPrevFrameData(
@@ -419,7 +561,7 @@ void RTGL1::GeomInfoManager::FillWithPrevFrameData(
 {
     int32_t *prevIndexToCurIndex = matchPrevShadow.get();
 
-    const rgl::unordered_map<uint64_t, GeomFrameInfo> *prevIdToInfo = nullptr;
+    const GenerationalIdMap<GeomFrameInfo> *prevIdToInfo = nullptr;
 
     bool isMovable = flags & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE;
     bool isDynamic = flags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
@@ -448,32 +590,32 @@ void RTGL1::GeomInfoManager::FillWithPrevFrameData(
         }
     }
 
-    const auto prev = prevIdToInfo->find(geomUniqueID);
+    const GeomFrameInfo *prev = prevIdToInfo->Find(geomUniqueID);
 
     // if no previous info
-    if (prev == prevIdToInfo->end())
+    if (prev == nullptr)
     {
         MarkNoPrevInfo(dst);
         return;
     }
 
     // if counts are not the same
-    if (prev->second.vertexCount != dst.vertexCount || 
-        prev->second.indexCount != dst.indexCount)
+    if (prev->vertexCount != dst.vertexCount || 
+        prev->indexCount != dst.indexCount)
     {
         MarkNoPrevInfo(dst);
         return;
     }
 
     // copy data from previous frame to current ShGeometryInstance
-    dst.prevBaseVertexIndex = prev->second.baseVertexIndex;
-    dst.prevBaseIndexIndex = prev->second.baseIndexIndex;
-    memcpy(dst.prevModel, prev->second.model, sizeof(float) * 16);
+    dst.prevBaseVertexIndex = prev->baseVertexIndex;
+    dst.prevBaseIndexIndex = prev->baseIndexIndex;
+    memcpy(dst.prevModel, prev->model, sizeof(float) * 16);
 
     if (isDynamic)
     {
         // save index to access ShGeometryInfo using previous frame's global geom index
-        prevIndexToCurIndex[prev->second.prevGlobalGeomIndex] = currentGlobalGeomIndex;
+        prevIndexToCurIndex[prev->prevGlobalGeomIndex] = currentGlobalGeomIndex;
     }
 }
 
@@ -494,7 +636,7 @@ void RTGL1::GeomInfoManager::WriteInfoForNextUsage(
     bool isMovable = flags & VertexCollectorFilterTypeFlagBits::CF_STATIC_MOVABLE;
     bool isDynamic = flags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
 
-    rgl::unordered_map<uint64_t, GeomFrameInfo> *idToInfo = nullptr;
+    GenerationalIdMap<GeomFrameInfo> *idToInfo = nullptr;
 
     if (isDynamic)
     {
@@ -509,9 +651,6 @@ void RTGL1::GeomInfoManager::WriteInfoForNextUsage(
         return;
     }
 
-    // IDs must be unique
-    assert(idToInfo->find(geomUniqueID) == idToInfo->end());
-
     GeomFrameInfo f = {};
     memcpy(f.model, src.model, sizeof(float) * 16);
     f.baseVertexIndex = src.baseVertexIndex;
@@ -520,7 +659,11 @@ void RTGL1::GeomInfoManager::WriteInfoForNextUsage(
     f.indexCount = src.indexCount;
     f.prevGlobalGeomIndex = currentGlobalGeomIndex;
 
-    (*idToInfo)[geomUniqueID] = f;
+    // IDs must be unique
+    if (idToInfo->Insert(geomUniqueID, f) == nullptr)
+    {
+        assert(0);
+    }
 }
 
 void RTGL1::GeomInfoManager::WriteStaticGeomInfoMaterials(uint32_t simpleIndex, uint32_t layer, const MaterialTextures &src)
@@ -544,8 +687,11 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoMaterials(uint32_t simpleIndex,
 
         memcpy(&pMatArr[layer * TEXTURES_PER_MATERIAL_COUNT], src.indices, TEXTURES_PER_MATERIAL_COUNT * sizeof(uint32_t));
 
-        // mark to be copied
-        MarkGeomInfoIndexToCopy(i, simpleToLocalIndex[simpleIndex], flagsId);
+        // mark to be copied, if static geom infos are not held
+        if (!isStaticCopyHeld)
+        {
+            MarkGeomInfoIndexToCopy(i, simpleToLocalIndex[simpleIndex], flagsId);
+        }
     }
 }
 
@@ -575,16 +721,16 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoTransform(uint32_t simpleIndex,
     float modelMatix[16];
     Matrix::ToMat4Transposed(modelMatix, src);
 
-    auto prev = movableIDToGeomFrameInfo.find(geomUniqueID);
+    GeomFrameInfo *prev = movableIDToGeomFrameInfo.Find(geomUniqueID);
 
     // if movable is updated, then it must be added previously
-    if (prev == movableIDToGeomFrameInfo.end())
+    if (prev == nullptr)
     {
         assert(0);
         return;
     }
 
-    float *prevModelMatrix = prev->second.model;
+    float *prevModelMatrix = prev->model;
 
     const uint32_t localGeomIndex = simpleToLocalIndex[simpleIndex];
     const uint32_t globalIndex = GetGlobalGeomIndex(localGeomIndex, flags);
@@ -600,8 +746,11 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoTransform(uint32_t simpleIndex,
         // mark that movable has a previous info now
         MarkMovableHasPrevInfo(*dst);
 
-        // mark to be copied
-        MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+        // mark to be copied, if static geom infos are not held
+        if (!isStaticCopyHeld)
+        {
+            MarkGeomInfoIndexToCopy(i, localGeomIndex, flagsId);
+        }
     }
 
 
@@ -609,6 +758,22 @@ void RTGL1::GeomInfoManager::WriteStaticGeomInfoTransform(uint32_t simpleIndex,
     memcpy(prevModelMatrix, modelMatix, 16 * sizeof(float));
 }
 
+void RTGL1::GeomInfoManager::MarkStaticGeomInfosToCopy(uint32_t frameIndex)
+{
+    assert(staticGeomCount <= geomType.size());
+    assert(geomType.size() == simpleToLocalIndex.size());
+
+    isStaticCopyHeld = false;
+
+    // static geometries are first in the simple index arrays
+    for (uint32_t simpleIndex = 0; simpleIndex < staticGeomCount; simpleIndex++)
+    {
+        uint32_t flagsId = VertexCollectorFilterTypeFlags_GetID(geomType[simpleIndex]);
+
+        MarkGeomInfoIndexToCopy(frameIndex, simpleToLocalIndex[simpleIndex], flagsId);
+    }
+}
+
 uint32_t RTGL1::GeomInfoManager::GetCount() const
 {
     return staticGeomCount + dynamicGeomCount;
@@ -639,3 +804,8 @@ uint32_t RTGL1::GeomInfoManager::GetStaticGeomBaseVertexIndex(uint32_t simpleInd
     // just use frame 0, as infos have same values in both staging buffers
     return GetGeomInfoAddressByGlobalIndex(0, ConvertSimpleIndexToGlobal(simpleIndex))->baseVertexIndex;
 }
+
+uint32_t RTGL1::GeomInfoManager::GetStaticGeomVertexCount(uint32_t simpleIndex)
+{
+    return GetGeomInfoAddressByGlobalIndex(0, ConvertSimpleIndexToGlobal(simpleIndex))->vertexCount;
+}
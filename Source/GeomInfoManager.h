@@ -24,7 +24,8 @@
 
 #include "AutoBuffer.h"
 #include "Common.h"
-#include "Containers.h"
+#include "DirtyRangeSet.h"
+#include "GenerationalIdMap.h"
 #include "Material.h"
 #include "MemoryAllocator.h"
 #include "VertexCollectorFilterType.h"
@@ -66,9 +67,22 @@ public:
         VertexCollectorFilterTypeFlags flags,
         ShGeometryInstance &src);
 
+    // Write geometry info of a mesh instance, it should be called every frame,
+    // as mesh instances are not retained. Geometry infos of mesh instances are
+    // placed after the ones of all filters. Returns global geometry index,
+    // or UINT32_MAX if there's no space.
+    uint32_t WriteMeshInstanceGeomInfo(
+        uint32_t frameIndex,
+        uint64_t instanceUniqueID,
+        ShGeometryInstance &src);
+
 
     void WriteStaticGeomInfoMaterials(uint32_t simpleIndex, uint32_t layer, const MaterialTextures &src);
     void WriteStaticGeomInfoTransform(uint32_t simpleIndex, uint64_t geomUniqueID, const RgTransform &src);
+    // Static geom infos are written to staging on adding, but should be
+    // copied to device-local only when static geometry is ready to be used.
+    // Until then, after ResetWithStatic, changes of static geom infos are not copied.
+    void MarkStaticGeomInfosToCopy(uint32_t frameIndex);
 
 
     bool CopyFromStaging(VkCommandBuffer cmd, uint32_t frameIndex, bool insertBarrier = true);
@@ -80,6 +94,7 @@ public:
     VkBuffer GetBuffer() const;
     VkBuffer GetMatchPrevBuffer() const;
     uint32_t GetStaticGeomBaseVertexIndex(uint32_t simpleIndex);
+    uint32_t GetStaticGeomVertexCount(uint32_t simpleIndex);
     
 private:
     struct GeomFrameInfo
@@ -96,6 +111,7 @@ private:
     {
         uint32_t maxStaticGeomCount = 0;
         uint32_t maxDynamicGeomCount = 0;
+        uint32_t maxMeshInstanceCount = 0;
     };
 
 private:
@@ -104,6 +120,7 @@ private:
     void ResetOnlyDynamic(uint32_t frameIndex);
 
     static uint32_t GetGlobalGeomIndex(uint32_t localGeomIndex, VertexCollectorFilterTypeFlags flags);
+    static uint32_t GetMeshInstanceGlobalGeomIndex(uint32_t instanceIndex);
     ShGeometryInstance *GetGeomInfoAddressByGlobalIndex(uint32_t frameIndex, uint32_t globalGeomIndex);
     
     uint32_t ConvertSimpleIndexToGlobal(uint32_t simpleIndex) const;
@@ -134,6 +151,11 @@ private:
     // but static ones are added very infrequently, e.g. on level load
     uint32_t staticGeomCount;
     uint32_t dynamicGeomCount;
+    // mesh instances are readded every frame, as dynamic geoms
+    uint32_t meshInstanceCount;
+    // device-local static geom infos are in use by the previous static scene,
+    // while the new one is being built
+    bool isStaticCopyHeld;
 
     // buffer for getting info for geometry in BLAS
     std::shared_ptr<AutoBuffer> buffer;
@@ -142,8 +164,11 @@ private:
     std::unique_ptr<int32_t[]> matchPrevShadow;
     MatchPrevCopyInfo matchPrevCopyInfo;
 
-    std::vector<uint32_t> copyRegionLowerBounds[MAX_FRAMES_IN_FLIGHT];
-    std::vector<uint32_t> copyRegionUpperBounds[MAX_FRAMES_IN_FLIGHT];
+    // per filter, local geom indices to copy from staging
+    std::vector<DirtyRangeSet> dirtyGeomInfos[MAX_FRAMES_IN_FLIGHT];
+    // reused to not allocate each frame
+    std::vector<VkBufferCopy> geomInfoCopyRegions;
+    std::vector<VkBufferMemoryBarrier> geomInfoBarriers;
 
     // each geometry has its type as they're can be in different filters
     std::vector<VertexCollectorFilterTypeFlags> geomType;
@@ -151,9 +176,11 @@ private:
     std::vector<uint32_t> simpleToLocalIndex;
 
     // geometry's uniqueID to geom frame info,
-    // used for getting info from previous frame
-    rgl::unordered_map<uint64_t, GeomFrameInfo> dynamicIDToGeomFrameInfo[MAX_FRAMES_IN_FLIGHT];
-    rgl::unordered_map<uint64_t, GeomFrameInfo> movableIDToGeomFrameInfo;
+    // used for getting info from previous frame;
+    // per-frame tables are cleared in O(1)
+    GenerationalIdMap<GeomFrameInfo> dynamicIDToGeomFrameInfo[MAX_FRAMES_IN_FLIGHT];
+    GenerationalIdMap<GeomFrameInfo> movableIDToGeomFrameInfo;
+    GenerationalIdMap<GeomFrameInfo> meshInstanceIDToGeomFrameInfo[MAX_FRAMES_IN_FLIGHT];
 };
 
 }
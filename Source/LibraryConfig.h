@@ -31,6 +31,8 @@ namespace RTGL1::LibraryConfig
         bool developerMode = false;
         bool dlssValidation = false;
         bool fpsMonitor = false;
+        // has effect only if compiled with RG_WITH_CPU_TRACING
+        bool cpuTracing = false;
     };
 
     namespace detail
@@ -53,6 +55,10 @@ namespace RTGL1::LibraryConfig
             {
                 dst.fpsMonitor = true;
             }
+            else if (entry == "cputracing")
+            {
+                dst.cpuTracing = true;
+            }
         }
     }
 
@@ -0,0 +1,1280 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Null Vulkan implementation, compiled instead of linking the Vulkan loader,
+// if RG_WITH_NULL_DEVICE CMake option is enabled.
+//
+// All objects are plain host allocations, and device memory is host memory,
+// so mapped staging buffers behave as usual. Commands are not executed:
+// the recording is a no-op, and the submission only signals fences.
+// It's enough to run the whole CPU side of the library without a GPU.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Common.h"
+#include "Utils.h"
+
+static_assert(sizeof(void *) == sizeof(uint64_t), "Null device defines non-dispatchable handles as pointers");
+
+#pragma region objects
+
+struct VkPhysicalDevice_T {};
+
+struct VkInstance_T
+{
+    VkPhysicalDevice_T physDevice;
+};
+
+struct VkQueue_T {};
+
+struct VkDevice_T
+{
+    VkQueue_T queue;
+};
+
+struct VkCommandBuffer_T {};
+
+struct VkDeviceMemory_T
+{
+    uint8_t *data;
+    VkDeviceSize size;
+};
+
+struct VkBuffer_T
+{
+    VkDeviceSize size;
+    VkDeviceMemory_T *memory;
+    VkDeviceSize memoryOffset;
+};
+
+struct VkImage_T {};
+
+struct VkFence_T
+{
+    bool signaled;
+};
+
+struct VkQueryPool_T
+{
+    std::vector<uint64_t> results;
+};
+
+struct VkAccelerationStructureKHR_T
+{
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+};
+
+struct VkSwapchainKHR_T
+{
+    std::vector<std::unique_ptr<VkImage_T>> images;
+    std::vector<VkImage> imageHandles;
+    uint32_t nextImage;
+};
+
+struct VkDescriptorSet_T {};
+
+struct VkDescriptorPool_T
+{
+    std::vector<std::unique_ptr<VkDescriptorSet_T>> sets;
+};
+
+struct VkCommandPool_T
+{
+    std::vector<std::unique_ptr<VkCommandBuffer_T>> cmds;
+};
+
+struct VkSurfaceKHR_T {};
+struct VkSemaphore_T {};
+struct VkImageView_T {};
+struct VkSampler_T {};
+struct VkShaderModule_T {};
+struct VkPipelineCache_T {};
+struct VkPipelineLayout_T {};
+struct VkPipeline_T {};
+struct VkDescriptorSetLayout_T {};
+struct VkRenderPass_T {};
+struct VkFramebuffer_T {};
+struct VkDebugUtilsMessengerEXT_T {};
+
+#pragma endregion
+
+namespace
+{
+    // there's no window, so the surface has a fixed size
+    constexpr VkExtent2D NULL_SURFACE_EXTENT = { 1280, 720 };
+    constexpr uint32_t NULL_SWAPCHAIN_IMAGE_COUNT = 3;
+
+    // memory requirements of an image, its contents are never accessed on CPU
+    constexpr VkDeviceSize NULL_IMAGE_MEMORY_SIZE = 256;
+    constexpr VkDeviceSize NULL_MEMORY_ALIGNMENT = 256;
+    constexpr VkDeviceSize NULL_MEMORY_HEAP_SIZE = 64ull * 1024 * 1024 * 1024;
+
+    // approximate amount of acceleration structure memory per primitive
+    constexpr VkDeviceSize NULL_AS_BYTES_PER_PRIMITIVE = 64;
+
+    // device-local and host-visible types must be separate, see PhysicalDevice::GetMemoryTypeIndex
+    constexpr uint32_t NULL_MEMORY_TYPE_BITS = 0b11;
+
+    const VkExtensionProperties NULL_INSTANCE_EXTENSIONS[] =
+    {
+        { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_SURFACE_SPEC_VERSION },
+        { VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_SPEC_VERSION },
+        { VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_SPEC_VERSION },
+        { VK_EXT_DEBUG_UTILS_EXTENSION_NAME, VK_EXT_DEBUG_UTILS_SPEC_VERSION },
+        { VK_EXT_DEBUG_REPORT_EXTENSION_NAME, VK_EXT_DEBUG_REPORT_SPEC_VERSION },
+    };
+
+    const VkExtensionProperties NULL_DEVICE_EXTENSIONS[] =
+    {
+        { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SWAPCHAIN_SPEC_VERSION },
+        { VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, VK_KHR_DEFERRED_HOST_OPERATIONS_SPEC_VERSION },
+        { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_KHR_PIPELINE_LIBRARY_SPEC_VERSION },
+        { VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, VK_KHR_RAY_TRACING_PIPELINE_SPEC_VERSION },
+        { VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME, VK_KHR_ACCELERATION_STRUCTURE_SPEC_VERSION },
+        { VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME, VK_KHR_SYNCHRONIZATION_2_SPEC_VERSION },
+        { VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME, VK_KHR_SHADER_FLOAT16_INT8_SPEC_VERSION },
+    };
+
+    const VkSurfaceFormatKHR NULL_SURFACE_FORMATS[] =
+    {
+        { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+        { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    };
+
+    const VkPresentModeKHR NULL_PRESENT_MODES[] =
+    {
+        VK_PRESENT_MODE_FIFO_KHR,
+        VK_PRESENT_MODE_IMMEDIATE_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+    };
+
+    // Standard Vulkan two-call idiom: if pDst is null, only the count is returned
+    template<typename T>
+    VkResult FillArray(const T *pSrc, uint32_t srcCount, uint32_t *pCount, T *pDst)
+    {
+        if (pDst == nullptr)
+        {
+            *pCount = srcCount;
+            return VK_SUCCESS;
+        }
+
+        const uint32_t count = std::min(*pCount, srcCount);
+        std::copy_n(pSrc, count, pDst);
+        *pCount = count;
+
+        return count < srcCount ? VK_INCOMPLETE : VK_SUCCESS;
+    }
+
+    template<typename T, size_t N>
+    VkResult FillArray(const T(&src)[N], uint32_t *pCount, T *pDst)
+    {
+        return FillArray(src, static_cast<uint32_t>(N), pCount, pDst);
+    }
+
+    template<typename Handle>
+    VkResult CreateObject(Handle *pHandle)
+    {
+        *pHandle = new std::remove_pointer_t<Handle>();
+        return VK_SUCCESS;
+    }
+
+    template<typename Handle>
+    VkResult CreateObjects(uint32_t count, Handle *pHandles)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            CreateObject(&pHandles[i]);
+        }
+        return VK_SUCCESS;
+    }
+
+    VkPhysicalDeviceLimits GetLimits()
+    {
+        VkPhysicalDeviceLimits l = {};
+        l.maxImageDimension1D = 16384;
+        l.maxImageDimension2D = 16384;
+        l.maxImageDimension3D = 2048;
+        l.maxImageDimensionCube = 16384;
+        l.maxImageArrayLayers = 2048;
+        l.maxTexelBufferElements = UINT32_MAX;
+        l.maxUniformBufferRange = 65536;
+        l.maxStorageBufferRange = UINT32_MAX;
+        l.maxPushConstantsSize = 256;
+        l.maxMemoryAllocationCount = UINT32_MAX;
+        l.maxSamplerAllocationCount = 4000;
+        l.bufferImageGranularity = 1;
+        l.maxBoundDescriptorSets = 32;
+        l.maxPerStageDescriptorSamplers = 1048576;
+        l.maxPerStageDescriptorUniformBuffers = 1048576;
+        l.maxPerStageDescriptorStorageBuffers = 1048576;
+        l.maxPerStageDescriptorSampledImages = 1048576;
+        l.maxPerStageDescriptorStorageImages = 1048576;
+        l.maxPerStageResources = UINT32_MAX;
+        l.maxDescriptorSetSamplers = 1048576;
+        l.maxDescriptorSetUniformBuffers = 1048576;
+        l.maxDescriptorSetStorageBuffers = 1048576;
+        l.maxDescriptorSetSampledImages = 1048576;
+        l.maxDescriptorSetStorageImages = 1048576;
+        l.maxComputeSharedMemorySize = 49152;
+        l.maxComputeWorkGroupCount[0] = l.maxComputeWorkGroupCount[1] = l.maxComputeWorkGroupCount[2] = 65535;
+        l.maxComputeWorkGroupInvocations = 1024;
+        l.maxComputeWorkGroupSize[0] = l.maxComputeWorkGroupSize[1] = 1024;
+        l.maxComputeWorkGroupSize[2] = 64;
+        l.maxSamplerLodBias = 15.0f;
+        l.maxSamplerAnisotropy = 16.0f;
+        l.maxViewports = 16;
+        l.maxViewportDimensions[0] = l.maxViewportDimensions[1] = 32768;
+        l.maxFramebufferWidth = l.maxFramebufferHeight = 32768;
+        l.maxFramebufferLayers = 2048;
+        l.framebufferColorSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+        l.framebufferDepthSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+        l.sampledImageColorSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+        l.maxColorAttachments = 8;
+        l.timestampComputeAndGraphics = VK_TRUE;
+        l.timestampPeriod = 1.0f;
+        l.minMemoryMapAlignment = 64;
+        l.minTexelBufferOffsetAlignment = 16;
+        l.minUniformBufferOffsetAlignment = 64;
+        l.minStorageBufferOffsetAlignment = 16;
+        l.optimalBufferCopyOffsetAlignment = 1;
+        l.optimalBufferCopyRowPitchAlignment = 1;
+        l.nonCoherentAtomSize = 64;
+        return l;
+    }
+
+    void GetMemoryRequirements(VkBuffer buffer, VkMemoryRequirements *pRequirements)
+    {
+        pRequirements->size = RTGL1::Utils::Align(buffer->size, NULL_MEMORY_ALIGNMENT);
+        pRequirements->alignment = NULL_MEMORY_ALIGNMENT;
+        pRequirements->memoryTypeBits = NULL_MEMORY_TYPE_BITS;
+    }
+
+    void GetMemoryRequirements(VkImage image, VkMemoryRequirements *pRequirements)
+    {
+        pRequirements->size = NULL_IMAGE_MEMORY_SIZE;
+        pRequirements->alignment = NULL_MEMORY_ALIGNMENT;
+        pRequirements->memoryTypeBits = NULL_MEMORY_TYPE_BITS;
+    }
+
+    void FillDedicatedRequirements(VkMemoryRequirements2 *pRequirements)
+    {
+        for (auto *p = static_cast<VkBaseOutStructure *>(pRequirements->pNext); p != nullptr; p = p->pNext)
+        {
+            if (p->sType == VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS)
+            {
+                auto *dedicated = reinterpret_cast<VkMemoryDedicatedRequirements *>(p);
+                dedicated->prefersDedicatedAllocation = VK_FALSE;
+                dedicated->requiresDedicatedAllocation = VK_FALSE;
+            }
+        }
+    }
+
+    VkDeviceAddress GetAddress(VkBuffer buffer, VkDeviceSize offset)
+    {
+        if (buffer == VK_NULL_HANDLE || buffer->memory == nullptr)
+        {
+            return 0;
+        }
+
+        return reinterpret_cast<VkDeviceAddress>(buffer->memory->data + buffer->memoryOffset + offset);
+    }
+
+    PFN_vkVoidFunction GetProcAddr(const char *pName);
+}
+
+extern "C"
+{
+
+#pragma region instance
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkInstance *pInstance)
+{
+    return CreateObject(pInstance);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks *pAllocator)
+{
+    delete instance;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceExtensionProperties(const char *pLayerName, uint32_t *pPropertyCount, VkExtensionProperties *pProperties)
+{
+    return FillArray(NULL_INSTANCE_EXTENSIONS, pPropertyCount, pProperties);
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char *pName)
+{
+    return GetProcAddr(pName);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance instance, uint32_t *pPhysicalDeviceCount, VkPhysicalDevice *pPhysicalDevices)
+{
+    VkPhysicalDevice physDevice = &instance->physDevice;
+    return FillArray(&physDevice, 1, pPhysicalDeviceCount, pPhysicalDevices);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDebugUtilsMessengerEXT *pMessenger)
+{
+    return CreateObject(pMessenger);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT messenger, const VkAllocationCallbacks *pAllocator)
+{
+    delete messenger;
+}
+
+#pragma endregion
+
+#pragma region physical device
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2 *pFeatures)
+{
+    std::fill_n(reinterpret_cast<VkBool32 *>(&pFeatures->features), sizeof(VkPhysicalDeviceFeatures) / sizeof(VkBool32), VK_TRUE);
+
+    for (auto *p = static_cast<VkBaseOutStructure *>(pFeatures->pNext); p != nullptr; p = p->pNext)
+    {
+        if (p->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR)
+        {
+            reinterpret_cast<VkPhysicalDeviceRayTracingPipelineFeaturesKHR *>(p)->rayTracingPipeline = VK_TRUE;
+        }
+        else if (p->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR)
+        {
+            reinterpret_cast<VkPhysicalDeviceAccelerationStructureFeaturesKHR *>(p)->accelerationStructure = VK_TRUE;
+        }
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties)
+{
+    *pProperties = {};
+    pProperties->apiVersion = VK_API_VERSION_1_2;
+    pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    pProperties->limits = GetLimits();
+    strncpy(pProperties->deviceName, "RTGL1 Null Device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2 *pProperties)
+{
+    vkGetPhysicalDeviceProperties(physicalDevice, &pProperties->properties);
+
+    for (auto *p = static_cast<VkBaseOutStructure *>(pProperties->pNext); p != nullptr; p = p->pNext)
+    {
+        if (p->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR)
+        {
+            auto *rt = reinterpret_cast<VkPhysicalDeviceRayTracingPipelinePropertiesKHR *>(p);
+            rt->shaderGroupHandleSize = 32;
+            rt->maxRayRecursionDepth = 31;
+            rt->maxShaderGroupStride = 4096;
+            rt->shaderGroupBaseAlignment = 64;
+            rt->shaderGroupHandleCaptureReplaySize = 32;
+            rt->maxRayDispatchInvocationCount = 1 << 30;
+            rt->shaderGroupHandleAlignment = 32;
+            rt->maxRayHitAttributeSize = 32;
+        }
+        else if (p->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR)
+        {
+            auto *as = reinterpret_cast<VkPhysicalDeviceAccelerationStructurePropertiesKHR *>(p);
+            as->maxGeometryCount = UINT32_MAX;
+            as->maxInstanceCount = UINT32_MAX;
+            as->maxPrimitiveCount = UINT32_MAX;
+            as->maxPerStageDescriptorAccelerationStructures = 1048576;
+            as->maxPerStageDescriptorUpdateAfterBindAccelerationStructures = 1048576;
+            as->maxDescriptorSetAccelerationStructures = 1048576;
+            as->maxDescriptorSetUpdateAfterBindAccelerationStructures = 1048576;
+            as->minAccelerationStructureScratchOffsetAlignment = 128;
+        }
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties *pMemoryProperties)
+{
+    *pMemoryProperties = {};
+
+    pMemoryProperties->memoryHeapCount = 2;
+    pMemoryProperties->memoryHeaps[0].size = NULL_MEMORY_HEAP_SIZE;
+    pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+    pMemoryProperties->memoryHeaps[1].size = NULL_MEMORY_HEAP_SIZE;
+    pMemoryProperties->memoryHeaps[1].flags = 0;
+
+    pMemoryProperties->memoryTypeCount = 2;
+    pMemoryProperties->memoryTypes[0].heapIndex = 0;
+    pMemoryProperties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    pMemoryProperties->memoryTypes[1].heapIndex = 1;
+    pMemoryProperties->memoryTypes[1].propertyFlags =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+        VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2 *pMemoryProperties)
+{
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &pMemoryProperties->memoryProperties);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties *pFormatProperties)
+{
+    pFormatProperties->linearTilingFeatures = ~0u;
+    pFormatProperties->optimalTilingFeatures = ~0u;
+    pFormatProperties->bufferFeatures = ~0u;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t *pQueueFamilyPropertyCount, VkQueueFamilyProperties *pQueueFamilyProperties)
+{
+    VkQueueFamilyProperties family = {};
+    family.queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+    family.queueCount = 1;
+    family.timestampValidBits = 64;
+    family.minImageTransferGranularity = { 1, 1, 1 };
+
+    FillArray(&family, 1, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice, const char *pLayerName, uint32_t *pPropertyCount, VkExtensionProperties *pProperties)
+{
+    return FillArray(NULL_DEVICE_EXTENSIONS, pPropertyCount, pProperties);
+}
+
+#pragma endregion
+
+#pragma region surface
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateHeadlessSurfaceEXT(VkInstance instance, const VkHeadlessSurfaceCreateInfoEXT *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSurfaceKHR *pSurface)
+{
+    return CreateObject(pSurface);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySurfaceKHR(VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks *pAllocator)
+{
+    delete surface;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR surface, VkBool32 *pSupported)
+{
+    *pSupported = VK_TRUE;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR *pSurfaceCapabilities)
+{
+    *pSurfaceCapabilities = {};
+    pSurfaceCapabilities->minImageCount = 2;
+    pSurfaceCapabilities->maxImageCount = NULL_SWAPCHAIN_IMAGE_COUNT;
+    pSurfaceCapabilities->currentExtent = NULL_SURFACE_EXTENT;
+    pSurfaceCapabilities->minImageExtent = NULL_SURFACE_EXTENT;
+    pSurfaceCapabilities->maxImageExtent = NULL_SURFACE_EXTENT;
+    pSurfaceCapabilities->maxImageArrayLayers = 1;
+    pSurfaceCapabilities->supportedTransforms = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->currentTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    pSurfaceCapabilities->supportedCompositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    pSurfaceCapabilities->supportedUsageFlags =
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pSurfaceFormatCount, VkSurfaceFormatKHR *pSurfaceFormats)
+{
+    return FillArray(NULL_SURFACE_FORMATS, pSurfaceFormatCount, pSurfaceFormats);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t *pPresentModeCount, VkPresentModeKHR *pPresentModes)
+{
+    return FillArray(NULL_PRESENT_MODES, pPresentModeCount, pPresentModes);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSwapchainKHR(VkDevice device, const VkSwapchainCreateInfoKHR *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSwapchainKHR *pSwapchain)
+{
+    auto *swapchain = new VkSwapchainKHR_T();
+    swapchain->nextImage = 0;
+
+    for (uint32_t i = 0; i < std::max(pCreateInfo->minImageCount, 1u); i++)
+    {
+        swapchain->images.push_back(std::make_unique<VkImage_T>());
+        swapchain->imageHandles.push_back(swapchain->images.back().get());
+    }
+
+    *pSwapchain = swapchain;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks *pAllocator)
+{
+    delete swapchain;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t *pSwapchainImageCount, VkImage *pSwapchainImages)
+{
+    return FillArray(swapchain->imageHandles.data(), static_cast<uint32_t>(swapchain->imageHandles.size()), pSwapchainImageCount, pSwapchainImages);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t *pImageIndex)
+{
+    *pImageIndex = swapchain->nextImage;
+    swapchain->nextImage = (swapchain->nextImage + 1) % static_cast<uint32_t>(swapchain->images.size());
+
+    if (fence != VK_NULL_HANDLE)
+    {
+        fence->signaled = true;
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueuePresentKHR(VkQueue queue, const VkPresentInfoKHR *pPresentInfo)
+{
+    if (pPresentInfo->pResults != nullptr)
+    {
+        std::fill_n(pPresentInfo->pResults, pPresentInfo->swapchainCount, VK_SUCCESS);
+    }
+
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+#pragma region device
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDevice *pDevice)
+{
+    return CreateObject(pDevice);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator)
+{
+    delete device;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char *pName)
+{
+    return GetProcAddr(pName);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetDeviceQueue(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue *pQueue)
+{
+    *pQueue = &device->queue;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkDeviceWaitIdle(VkDevice device)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueWaitIdle(VkQueue queue)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits, VkFence fence)
+{
+    // commands are not executed, so the submission is complete immediately
+    if (fence != VK_NULL_HANDLE)
+    {
+        fence->signaled = true;
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkSetDebugUtilsObjectNameEXT(VkDevice device, const VkDebugUtilsObjectNameInfoEXT *pNameInfo)
+{
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+#pragma region memory
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo *pAllocateInfo, const VkAllocationCallbacks *pAllocator, VkDeviceMemory *pMemory)
+{
+    // calloc, so large allocations that are never touched on CPU stay uncommitted
+    auto *data = static_cast<uint8_t *>(std::calloc(static_cast<size_t>(pAllocateInfo->allocationSize), 1));
+
+    if (data == nullptr)
+    {
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    *pMemory = new VkDeviceMemory_T{ data, pAllocateInfo->allocationSize };
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks *pAllocator)
+{
+    if (memory != VK_NULL_HANDLE)
+    {
+        std::free(memory->data);
+        delete memory;
+    }
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void **ppData)
+{
+    *ppData = memory->data + offset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUnmapMemory(VkDevice device, VkDeviceMemory memory)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkFlushMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkInvalidateMappedMemoryRanges(VkDevice device, uint32_t memoryRangeCount, const VkMappedMemoryRange *pMemoryRanges)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(VkDevice device, const VkBufferCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkBuffer *pBuffer)
+{
+    *pBuffer = new VkBuffer_T{ pCreateInfo->size, nullptr, 0 };
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks *pAllocator)
+{
+    delete buffer;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements *pMemoryRequirements)
+{
+    GetMemoryRequirements(buffer, pMemoryRequirements);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(VkDevice device, const VkBufferMemoryRequirementsInfo2 *pInfo, VkMemoryRequirements2 *pMemoryRequirements)
+{
+    GetMemoryRequirements(pInfo->buffer, &pMemoryRequirements->memoryRequirements);
+    FillDedicatedRequirements(pMemoryRequirements);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory(VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    buffer->memory = memory;
+    buffer->memoryOffset = memoryOffset;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindBufferMemory2(VkDevice device, uint32_t bindInfoCount, const VkBindBufferMemoryInfo *pBindInfos)
+{
+    for (uint32_t i = 0; i < bindInfoCount; i++)
+    {
+        vkBindBufferMemory(device, pBindInfos[i].buffer, pBindInfos[i].memory, pBindInfos[i].memoryOffset);
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkDeviceAddress VKAPI_CALL vkGetBufferDeviceAddress(VkDevice device, const VkBufferDeviceAddressInfo *pInfo)
+{
+    return GetAddress(pInfo->buffer, 0);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(VkDevice device, const VkImageCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkImage *pImage)
+{
+    return CreateObject(pImage);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks *pAllocator)
+{
+    delete image;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements *pMemoryRequirements)
+{
+    GetMemoryRequirements(image, pMemoryRequirements);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(VkDevice device, const VkImageMemoryRequirementsInfo2 *pInfo, VkMemoryRequirements2 *pMemoryRequirements)
+{
+    GetMemoryRequirements(pInfo->image, &pMemoryRequirements->memoryRequirements);
+    FillDedicatedRequirements(pMemoryRequirements);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory(VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBindImageMemory2(VkDevice device, uint32_t bindInfoCount, const VkBindImageMemoryInfo *pBindInfos)
+{
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+#pragma region objects
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateImageView(VkDevice device, const VkImageViewCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkImageView *pView)
+{
+    return CreateObject(pView);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyImageView(VkDevice device, VkImageView imageView, const VkAllocationCallbacks *pAllocator)
+{
+    delete imageView;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSampler(VkDevice device, const VkSamplerCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSampler *pSampler)
+{
+    return CreateObject(pSampler);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySampler(VkDevice device, VkSampler sampler, const VkAllocationCallbacks *pAllocator)
+{
+    delete sampler;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkShaderModule *pShaderModule)
+{
+    return CreateObject(pShaderModule);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks *pAllocator)
+{
+    delete shaderModule;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineCache(VkDevice device, const VkPipelineCacheCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineCache *pPipelineCache)
+{
+    return CreateObject(pPipelineCache);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator)
+{
+    delete pipelineCache;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineLayout *pPipelineLayout)
+{
+    return CreateObject(pPipelineLayout);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks *pAllocator)
+{
+    delete pipelineLayout;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    return CreateObjects(createInfoCount, pPipelines);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    return CreateObjects(createInfoCount, pPipelines);
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateRayTracingPipelinesKHR(VkDevice device, VkDeferredOperationKHR deferredOperation, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkRayTracingPipelineCreateInfoKHR *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines)
+{
+    return CreateObjects(createInfoCount, pPipelines);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator)
+{
+    delete pipeline;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetRayTracingShaderGroupHandlesKHR(VkDevice device, VkPipeline pipeline, uint32_t firstGroup, uint32_t groupCount, size_t dataSize, void *pData)
+{
+    memset(pData, 0, dataSize);
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorSetLayout(VkDevice device, const VkDescriptorSetLayoutCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorSetLayout *pSetLayout)
+{
+    return CreateObject(pSetLayout);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorSetLayout(VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks *pAllocator)
+{
+    delete descriptorSetLayout;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateDescriptorPool(VkDevice device, const VkDescriptorPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDescriptorPool *pDescriptorPool)
+{
+    return CreateObject(pDescriptorPool);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks *pAllocator)
+{
+    delete descriptorPool;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo *pAllocateInfo, VkDescriptorSet *pDescriptorSets)
+{
+    auto &sets = pAllocateInfo->descriptorPool->sets;
+
+    for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++)
+    {
+        sets.push_back(std::make_unique<VkDescriptorSet_T>());
+        pDescriptorSets[i] = sets.back().get();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkUpdateDescriptorSets(VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet *pDescriptorWrites, uint32_t descriptorCopyCount, const VkCopyDescriptorSet *pDescriptorCopies)
+{}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateRenderPass(VkDevice device, const VkRenderPassCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkRenderPass *pRenderPass)
+{
+    return CreateObject(pRenderPass);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyRenderPass(VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks *pAllocator)
+{
+    delete renderPass;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFramebuffer(VkDevice device, const VkFramebufferCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkFramebuffer *pFramebuffer)
+{
+    return CreateObject(pFramebuffer);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFramebuffer(VkDevice device, VkFramebuffer framebuffer, const VkAllocationCallbacks *pAllocator)
+{
+    delete framebuffer;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateAccelerationStructureKHR(VkDevice device, const VkAccelerationStructureCreateInfoKHR *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkAccelerationStructureKHR *pAccelerationStructure)
+{
+    *pAccelerationStructure = new VkAccelerationStructureKHR_T{ pCreateInfo->buffer, pCreateInfo->offset, pCreateInfo->size };
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyAccelerationStructureKHR(VkDevice device, VkAccelerationStructureKHR accelerationStructure, const VkAllocationCallbacks *pAllocator)
+{
+    delete accelerationStructure;
+}
+
+VKAPI_ATTR VkDeviceAddress VKAPI_CALL vkGetAccelerationStructureDeviceAddressKHR(VkDevice device, const VkAccelerationStructureDeviceAddressInfoKHR *pInfo)
+{
+    return GetAddress(pInfo->accelerationStructure->buffer, pInfo->accelerationStructure->offset);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkGetAccelerationStructureBuildSizesKHR(VkDevice device, VkAccelerationStructureBuildTypeKHR buildType, const VkAccelerationStructureBuildGeometryInfoKHR *pBuildInfo, const uint32_t *pMaxPrimitiveCounts, VkAccelerationStructureBuildSizesInfoKHR *pSizeInfo)
+{
+    VkDeviceSize primitiveCount = 0;
+
+    for (uint32_t i = 0; i < pBuildInfo->geometryCount; i++)
+    {
+        primitiveCount += pMaxPrimitiveCounts[i];
+    }
+
+    const VkDeviceSize size = NULL_MEMORY_ALIGNMENT + primitiveCount * NULL_AS_BYTES_PER_PRIMITIVE;
+
+    pSizeInfo->accelerationStructureSize = size;
+    pSizeInfo->buildScratchSize = size;
+    pSizeInfo->updateScratchSize = size;
+}
+
+#pragma endregion
+
+#pragma region synchronization
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateFence(VkDevice device, const VkFenceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkFence *pFence)
+{
+    *pFence = new VkFence_T{ (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0 };
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks *pAllocator)
+{
+    delete fence;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences)
+{
+    for (uint32_t i = 0; i < fenceCount; i++)
+    {
+        pFences[i]->signaled = false;
+    }
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence *pFences, VkBool32 waitAll, uint64_t timeout)
+{
+    // submissions are complete immediately, nothing to wait for
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetFenceStatus(VkDevice device, VkFence fence)
+{
+    return fence->signaled ? VK_SUCCESS : VK_NOT_READY;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateSemaphore(VkDevice device, const VkSemaphoreCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkSemaphore *pSemaphore)
+{
+    return CreateObject(pSemaphore);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroySemaphore(VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks *pAllocator)
+{
+    delete semaphore;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateQueryPool(VkDevice device, const VkQueryPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkQueryPool *pQueryPool)
+{
+    auto *pool = new VkQueryPool_T();
+    pool->results.resize(pCreateInfo->queryCount, 0);
+
+    *pQueryPool = pool;
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyQueryPool(VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks *pAllocator)
+{
+    delete queryPool;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void *pData, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+    const bool is64 = flags & VK_QUERY_RESULT_64_BIT;
+    const bool withAvailability = flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+
+    for (uint32_t i = 0; i < queryCount; i++)
+    {
+        uint8_t *dst = static_cast<uint8_t *>(pData) + i * stride;
+        const uint64_t value = queryPool->results[firstQuery + i];
+
+        if (is64)
+        {
+            const uint64_t values[] = { value, 1 };
+            memcpy(dst, values, sizeof(uint64_t) * (withAvailability ? 2 : 1));
+        }
+        else
+        {
+            const uint32_t values[] = { static_cast<uint32_t>(value), 1 };
+            memcpy(dst, values, sizeof(uint32_t) * (withAvailability ? 2 : 1));
+        }
+    }
+
+    return VK_SUCCESS;
+}
+
+#pragma endregion
+
+#pragma region command buffers
+
+VKAPI_ATTR VkResult VKAPI_CALL vkCreateCommandPool(VkDevice device, const VkCommandPoolCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkCommandPool *pCommandPool)
+{
+    return CreateObject(pCommandPool);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkDestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks *pAllocator)
+{
+    delete commandPool;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkResetCommandPool(VkDevice device, VkCommandPool commandPool, VkCommandPoolResetFlags flags)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo *pAllocateInfo, VkCommandBuffer *pCommandBuffers)
+{
+    auto &cmds = pAllocateInfo->commandPool->cmds;
+
+    for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++)
+    {
+        cmds.push_back(std::make_unique<VkCommandBuffer_T>());
+        pCommandBuffers[i] = cmds.back().get();
+    }
+
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkBeginCommandBuffer(VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo *pBeginInfo)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL vkEndCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    return VK_SUCCESS;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo *pRenderPassBegin, VkSubpassContents contents)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndRenderPass(VkCommandBuffer commandBuffer)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindPipeline(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, uint32_t descriptorSetCount, const VkDescriptorSet *pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t *pDynamicOffsets)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBindVertexBuffers(VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer *pBuffers, const VkDeviceSize *pOffsets)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void *pValues)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetViewport(VkCommandBuffer commandBuffer, uint32_t firstViewport, uint32_t viewportCount, const VkViewport *pViewports)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdSetScissor(VkCommandBuffer commandBuffer, uint32_t firstScissor, uint32_t scissorCount, const VkRect2D *pScissors)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDraw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDrawIndexedIndirectCount(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countBufferOffset, uint32_t maxDrawCount, uint32_t stride)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdDispatch(VkCommandBuffer commandBuffer, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdTraceRaysKHR(VkCommandBuffer commandBuffer, const VkStridedDeviceAddressRegionKHR *pRaygenShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pMissShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pHitShaderBindingTable, const VkStridedDeviceAddressRegionKHR *pCallableShaderBindingTable, uint32_t width, uint32_t height, uint32_t depth)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *pRegions)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkBufferImageCopy *pRegions)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBlitImage(VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount, const VkImageBlit *pRegions, VkFilter filter)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdClearAttachments(VkCommandBuffer commandBuffer, uint32_t attachmentCount, const VkClearAttachment *pAttachments, uint32_t rectCount, const VkClearRect *pRects)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, uint32_t memoryBarrierCount, const VkMemoryBarrier *pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier *pBufferMemoryBarriers, uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdPipelineBarrier2KHR(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR *pDependencyInfo)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdResetQueryPool(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+{
+    std::fill_n(queryPool->results.begin() + firstQuery, queryCount, 0);
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+{
+    // nothing is executed, so every pass takes 0 time
+    queryPool->results[query] = 0;
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBuildAccelerationStructuresKHR(VkCommandBuffer commandBuffer, uint32_t infoCount, const VkAccelerationStructureBuildGeometryInfoKHR *pInfos, const VkAccelerationStructureBuildRangeInfoKHR *const *ppBuildRangeInfos)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdCopyAccelerationStructureKHR(VkCommandBuffer commandBuffer, const VkCopyAccelerationStructureInfoKHR *pInfo)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdWriteAccelerationStructuresPropertiesKHR(VkCommandBuffer commandBuffer, uint32_t accelerationStructureCount, const VkAccelerationStructureKHR *pAccelerationStructures, VkQueryType queryType, VkQueryPool queryPool, uint32_t firstQuery)
+{
+    // written on recording, as there's no execution;
+    // compacted size is the same as the original one
+    for (uint32_t i = 0; i < accelerationStructureCount; i++)
+    {
+        queryPool->results[firstQuery + i] = pAccelerationStructures[i]->size;
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdBeginDebugUtilsLabelEXT(VkCommandBuffer commandBuffer, const VkDebugUtilsLabelEXT *pLabelInfo)
+{}
+
+VKAPI_ATTR void VKAPI_CALL vkCmdEndDebugUtilsLabelEXT(VkCommandBuffer commandBuffer)
+{}
+
+#pragma endregion
+
+} // extern "C"
+
+#define NULL_DEVICE_CORE_FUNCTION_LIST \
+    VK_EXTENSION_FUNCTION(vkCreateInstance) \
+    VK_EXTENSION_FUNCTION(vkDestroyInstance) \
+    VK_EXTENSION_FUNCTION(vkEnumerateInstanceExtensionProperties) \
+    VK_EXTENSION_FUNCTION(vkGetInstanceProcAddr) \
+    VK_EXTENSION_FUNCTION(vkEnumeratePhysicalDevices) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceFeatures2) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceProperties) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceProperties2) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceMemoryProperties) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceMemoryProperties2) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceFormatProperties) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties) \
+    VK_EXTENSION_FUNCTION(vkEnumerateDeviceExtensionProperties) \
+    VK_EXTENSION_FUNCTION(vkCreateHeadlessSurfaceEXT) \
+    VK_EXTENSION_FUNCTION(vkDestroySurfaceKHR) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceSurfaceSupportKHR) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    VK_EXTENSION_FUNCTION(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    VK_EXTENSION_FUNCTION(vkCreateSwapchainKHR) \
+    VK_EXTENSION_FUNCTION(vkDestroySwapchainKHR) \
+    VK_EXTENSION_FUNCTION(vkGetSwapchainImagesKHR) \
+    VK_EXTENSION_FUNCTION(vkAcquireNextImageKHR) \
+    VK_EXTENSION_FUNCTION(vkQueuePresentKHR) \
+    VK_EXTENSION_FUNCTION(vkCreateDevice) \
+    VK_EXTENSION_FUNCTION(vkDestroyDevice) \
+    VK_EXTENSION_FUNCTION(vkGetDeviceProcAddr) \
+    VK_EXTENSION_FUNCTION(vkGetDeviceQueue) \
+    VK_EXTENSION_FUNCTION(vkDeviceWaitIdle) \
+    VK_EXTENSION_FUNCTION(vkQueueWaitIdle) \
+    VK_EXTENSION_FUNCTION(vkQueueSubmit) \
+    VK_EXTENSION_FUNCTION(vkAllocateMemory) \
+    VK_EXTENSION_FUNCTION(vkFreeMemory) \
+    VK_EXTENSION_FUNCTION(vkMapMemory) \
+    VK_EXTENSION_FUNCTION(vkUnmapMemory) \
+    VK_EXTENSION_FUNCTION(vkFlushMappedMemoryRanges) \
+    VK_EXTENSION_FUNCTION(vkInvalidateMappedMemoryRanges) \
+    VK_EXTENSION_FUNCTION(vkCreateBuffer) \
+    VK_EXTENSION_FUNCTION(vkDestroyBuffer) \
+    VK_EXTENSION_FUNCTION(vkGetBufferMemoryRequirements) \
+    VK_EXTENSION_FUNCTION(vkGetBufferMemoryRequirements2) \
+    VK_EXTENSION_FUNCTION(vkBindBufferMemory) \
+    VK_EXTENSION_FUNCTION(vkBindBufferMemory2) \
+    VK_EXTENSION_FUNCTION(vkGetBufferDeviceAddress) \
+    VK_EXTENSION_FUNCTION(vkCreateImage) \
+    VK_EXTENSION_FUNCTION(vkDestroyImage) \
+    VK_EXTENSION_FUNCTION(vkGetImageMemoryRequirements) \
+    VK_EXTENSION_FUNCTION(vkGetImageMemoryRequirements2) \
+    VK_EXTENSION_FUNCTION(vkBindImageMemory) \
+    VK_EXTENSION_FUNCTION(vkBindImageMemory2) \
+    VK_EXTENSION_FUNCTION(vkCreateImageView) \
+    VK_EXTENSION_FUNCTION(vkDestroyImageView) \
+    VK_EXTENSION_FUNCTION(vkCreateSampler) \
+    VK_EXTENSION_FUNCTION(vkDestroySampler) \
+    VK_EXTENSION_FUNCTION(vkCreateShaderModule) \
+    VK_EXTENSION_FUNCTION(vkDestroyShaderModule) \
+    VK_EXTENSION_FUNCTION(vkCreatePipelineCache) \
+    VK_EXTENSION_FUNCTION(vkDestroyPipelineCache) \
+    VK_EXTENSION_FUNCTION(vkCreatePipelineLayout) \
+    VK_EXTENSION_FUNCTION(vkDestroyPipelineLayout) \
+    VK_EXTENSION_FUNCTION(vkCreateGraphicsPipelines) \
+    VK_EXTENSION_FUNCTION(vkCreateComputePipelines) \
+    VK_EXTENSION_FUNCTION(vkDestroyPipeline) \
+    VK_EXTENSION_FUNCTION(vkCreateDescriptorSetLayout) \
+    VK_EXTENSION_FUNCTION(vkDestroyDescriptorSetLayout) \
+    VK_EXTENSION_FUNCTION(vkCreateDescriptorPool) \
+    VK_EXTENSION_FUNCTION(vkDestroyDescriptorPool) \
+    VK_EXTENSION_FUNCTION(vkAllocateDescriptorSets) \
+    VK_EXTENSION_FUNCTION(vkUpdateDescriptorSets) \
+    VK_EXTENSION_FUNCTION(vkCreateRenderPass) \
+    VK_EXTENSION_FUNCTION(vkDestroyRenderPass) \
+    VK_EXTENSION_FUNCTION(vkCreateFramebuffer) \
+    VK_EXTENSION_FUNCTION(vkDestroyFramebuffer) \
+    VK_EXTENSION_FUNCTION(vkCreateFence) \
+    VK_EXTENSION_FUNCTION(vkDestroyFence) \
+    VK_EXTENSION_FUNCTION(vkResetFences) \
+    VK_EXTENSION_FUNCTION(vkWaitForFences) \
+    VK_EXTENSION_FUNCTION(vkGetFenceStatus) \
+    VK_EXTENSION_FUNCTION(vkCreateSemaphore) \
+    VK_EXTENSION_FUNCTION(vkDestroySemaphore) \
+    VK_EXTENSION_FUNCTION(vkCreateQueryPool) \
+    VK_EXTENSION_FUNCTION(vkDestroyQueryPool) \
+    VK_EXTENSION_FUNCTION(vkGetQueryPoolResults) \
+    VK_EXTENSION_FUNCTION(vkCreateCommandPool) \
+    VK_EXTENSION_FUNCTION(vkDestroyCommandPool) \
+    VK_EXTENSION_FUNCTION(vkResetCommandPool) \
+    VK_EXTENSION_FUNCTION(vkAllocateCommandBuffers) \
+    VK_EXTENSION_FUNCTION(vkBeginCommandBuffer) \
+    VK_EXTENSION_FUNCTION(vkEndCommandBuffer) \
+    VK_EXTENSION_FUNCTION(vkCmdBeginRenderPass) \
+    VK_EXTENSION_FUNCTION(vkCmdEndRenderPass) \
+    VK_EXTENSION_FUNCTION(vkCmdBindPipeline) \
+    VK_EXTENSION_FUNCTION(vkCmdBindDescriptorSets) \
+    VK_EXTENSION_FUNCTION(vkCmdBindIndexBuffer) \
+    VK_EXTENSION_FUNCTION(vkCmdBindVertexBuffers) \
+    VK_EXTENSION_FUNCTION(vkCmdPushConstants) \
+    VK_EXTENSION_FUNCTION(vkCmdSetViewport) \
+    VK_EXTENSION_FUNCTION(vkCmdSetScissor) \
+    VK_EXTENSION_FUNCTION(vkCmdDraw) \
+    VK_EXTENSION_FUNCTION(vkCmdDrawIndexed) \
+    VK_EXTENSION_FUNCTION(vkCmdDrawIndexedIndirectCount) \
+    VK_EXTENSION_FUNCTION(vkCmdDispatch) \
+    VK_EXTENSION_FUNCTION(vkCmdCopyBuffer) \
+    VK_EXTENSION_FUNCTION(vkCmdCopyBufferToImage) \
+    VK_EXTENSION_FUNCTION(vkCmdBlitImage) \
+    VK_EXTENSION_FUNCTION(vkCmdClearAttachments) \
+    VK_EXTENSION_FUNCTION(vkCmdPipelineBarrier) \
+    VK_EXTENSION_FUNCTION(vkCmdResetQueryPool) \
+    VK_EXTENSION_FUNCTION(vkCmdWriteTimestamp)
+
+namespace
+{
+    PFN_vkVoidFunction GetProcAddr(const char *pName)
+    {
+        struct Entry
+        {
+            std::string_view name;
+            PFN_vkVoidFunction func;
+        };
+
+    #define VK_EXTENSION_FUNCTION(fname) { #fname, reinterpret_cast<PFN_vkVoidFunction>(&fname) },
+    #define VK_FUNCTION_ALIAS(alias, fname) { #alias, reinterpret_cast<PFN_vkVoidFunction>(&fname) },
+
+        static const Entry entries[] =
+        {
+            NULL_DEVICE_CORE_FUNCTION_LIST
+            VK_INSTANCE_DEBUG_UTILS_FUNCTION_LIST
+            VK_DEVICE_FUNCTION_LIST
+            VK_DEVICE_DEBUG_UTILS_FUNCTION_LIST
+
+            // promoted to core, but can be requested by the extension names, e.g. by VMA
+            VK_FUNCTION_ALIAS(vkGetPhysicalDeviceFeatures2KHR, vkGetPhysicalDeviceFeatures2)
+            VK_FUNCTION_ALIAS(vkGetPhysicalDeviceProperties2KHR, vkGetPhysicalDeviceProperties2)
+            VK_FUNCTION_ALIAS(vkGetPhysicalDeviceMemoryProperties2KHR, vkGetPhysicalDeviceMemoryProperties2)
+            VK_FUNCTION_ALIAS(vkGetBufferMemoryRequirements2KHR, vkGetBufferMemoryRequirements2)
+            VK_FUNCTION_ALIAS(vkGetImageMemoryRequirements2KHR, vkGetImageMemoryRequirements2)
+            VK_FUNCTION_ALIAS(vkBindBufferMemory2KHR, vkBindBufferMemory2)
+            VK_FUNCTION_ALIAS(vkBindImageMemory2KHR, vkBindImageMemory2)
+            VK_FUNCTION_ALIAS(vkGetBufferDeviceAddressKHR, vkGetBufferDeviceAddress)
+        };
+
+    #undef VK_FUNCTION_ALIAS
+    #undef VK_EXTENSION_FUNCTION
+
+        if (pName == nullptr)
+        {
+            return nullptr;
+        }
+
+        for (const Entry &e : entries)
+        {
+            if (e.name == pName)
+            {
+                return e.func;
+            }
+        }
+
+        return nullptr;
+    }
+}
@@ -28,7 +28,7 @@
 using namespace RTGL1;
 
 PhysicalDevice::PhysicalDevice(VkInstance instance)
-    : physDevice(VK_NULL_HANDLE), memoryProperties{}, rtPipelineProperties{}, asProperties{}
+    : physDevice(VK_NULL_HANDLE), memoryProperties{}, rtPipelineProperties{}, asProperties{}, limits{}
 {
     VkResult r;
 
@@ -68,6 +68,7 @@ PhysicalDevice::PhysicalDevice(VkInstance instance)
 
             vkGetPhysicalDeviceProperties2(physDevice, &deviceProp2);
             vkGetPhysicalDeviceMemoryProperties(physDevice, &memoryProperties);
+            limits = deviceProp2.properties.limits;
 
             break;
         }
@@ -138,3 +139,8 @@ const VkPhysicalDeviceAccelerationStructurePropertiesKHR& PhysicalDevice::GetASP
 {
     return asProperties;
 }
+
+const VkPhysicalDeviceLimits &PhysicalDevice::GetLimits() const
+{
+    return limits;
+}
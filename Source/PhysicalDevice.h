@@ -41,6 +41,7 @@ public:
     const VkPhysicalDeviceMemoryProperties &GetMemoryProperties() const;
     const VkPhysicalDeviceRayTracingPipelinePropertiesKHR &GetRTPipelineProperties() const;
     const VkPhysicalDeviceAccelerationStructurePropertiesKHR& GetASProperties() const;
+    const VkPhysicalDeviceLimits &GetLimits() const;
 
 private:
     // selected physical device
@@ -48,6 +49,7 @@ private:
     VkPhysicalDeviceMemoryProperties memoryProperties;
     VkPhysicalDeviceRayTracingPipelinePropertiesKHR rtPipelineProperties;
     VkPhysicalDeviceAccelerationStructurePropertiesKHR asProperties;
+    VkPhysicalDeviceLimits limits;
 };
 
 }
\ No newline at end of file
@@ -19,12 +19,16 @@
 // SOFTWARE.
 
 #include "VulkanDevice.h"
+#include "ApiCapture.h"
 #include "RgException.h"
 
 using namespace RTGL1;
+using Capture::CallType;
 
 constexpr uint32_t MAX_DEVICE_COUNT = 8;
 static rgl::unordered_map<RgInstance, std::unique_ptr<VulkanDevice>> G_DEVICES;
+// Instances that record their calls
+static rgl::unordered_map<RgInstance, std::unique_ptr<ApiCapture>> G_CAPTURES;
 
 static RgInstance GetNextID()
 {
@@ -53,6 +57,33 @@ static void TryPrintError(RgInstance rgInstance, const char *pMessage)
     }
 }
 
+static ApiCapture *GetCapture(RgInstance rgInstance)
+{
+    if (G_CAPTURES.empty())
+    {
+        return nullptr;
+    }
+
+    auto it = G_CAPTURES.find(rgInstance);
+    return it != G_CAPTURES.end() ? it->second.get() : nullptr;
+}
+
+// Record the call, if it was successful and the instance is captured.
+// "serialize" writes the arguments, the replay reads them in the same order.
+template<typename Func>
+static RgResult Record(RgInstance rgInstance, RgResult r, CallType type, Func &&serialize)
+{
+    if (r == RG_SUCCESS)
+    {
+        if (ApiCapture *capture = GetCapture(rgInstance))
+        {
+            capture->Record(type, std::forward<Func>(serialize));
+        }
+    }
+
+    return r;
+}
+
 
 
 RgResult rgCreateInstance(const RgInstanceCreateInfo *pInfo, RgInstance *pResult)
@@ -85,6 +116,23 @@ RgResult rgCreateInstance(const RgInstanceCreateInfo *pInfo, RgInstance *pResult
 
         return e.GetErrorCode(); 
     } 
+
+    if (pInfo->pCaptureFilePath != nullptr && pInfo->pCaptureFilePath[0] != '\0')
+    {
+        // capture is optional, so the instance is still valid, if it failed
+        try
+        {
+            auto capture = std::make_unique<ApiCapture>(pInfo->pCaptureFilePath);
+            capture->Record(CallType::CreateInstance, [pInfo] (Capture::Writer &w) { w.Object(pInfo); });
+
+            G_CAPTURES[rgInstance] = std::move(capture);
+        }
+        catch (RTGL1::RgException &e)
+        {
+            TryPrintError(rgInstance, e.what());
+        }
+    }
+
     return RG_SUCCESS;
 }
 
@@ -98,6 +146,12 @@ RgResult rgDestroyInstance(RgInstance rgInstance)
     try
     {
         G_DEVICES.erase(rgInstance);
+
+        if (ApiCapture *capture = GetCapture(rgInstance))
+        {
+            capture->Record(CallType::DestroyInstance, [] (Capture::Writer &) {});
+            G_CAPTURES.erase(rgInstance);
+        }
     }
     catch (RTGL1::RgException &e) 
     { 
@@ -157,116 +211,338 @@ static auto Call(RgInstance rgInstance, Func f, Args&&... args)
 
 RgResult rgUploadGeometry(RgInstance rgInstance, const RgGeometryUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadGeometry, pUploadInfo );
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadGeometry, pUploadInfo),
+                  CallType::UploadGeometry, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
+}
+
+RgResult rgUploadGeometries(RgInstance rgInstance, uint32_t uploadInfoCount, const RgGeometryUploadInfo *pUploadInfos)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadGeometries, uploadInfoCount, pUploadInfos),
+                  CallType::UploadGeometries, [&] (Capture::Writer &w)
+    {
+        w.Objects(pUploadInfos, uploadInfoCount);
+    });
+}
+
+// Not recorded: the data that is written to the acquired memory
+// is captured by the following rgUploadGeometry call.
+RgResult rgAcquireGeometryMemory(RgInstance rgInstance, uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices)
+{
+    if (ppOutVertices != nullptr)
+    {
+        *ppOutVertices = nullptr;
+    }
+
+    if (ppOutIndices != nullptr)
+    {
+        *ppOutIndices = nullptr;
+    }
+
+    return Call(rgInstance, &VulkanDevice::AcquireGeometryMemory, vertexCount, indexCount, ppOutVertices, ppOutIndices);
 }
 
 RgResult rgUpdateGeometryTransform(RgInstance rgInstance, const RgUpdateTransformInfo* pUpdateInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UpdateGeometryTransform, pUpdateInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UpdateGeometryTransform, pUpdateInfo),
+                  CallType::UpdateGeometryTransform, [&] (Capture::Writer &w)
+    {
+        w.Object(pUpdateInfo);
+    });
+}
+
+RgResult rgUpdateGeometryTransforms(RgInstance rgInstance, uint32_t updateInfoCount, const RgUpdateTransformInfo *pUpdateInfos)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UpdateGeometryTransforms, updateInfoCount, pUpdateInfos),
+                  CallType::UpdateGeometryTransforms, [&] (Capture::Writer &w)
+    {
+        w.Objects(pUpdateInfos, updateInfoCount);
+    });
+}
+
+RgResult rgUpdateGeometryVertices(RgInstance rgInstance, const RgUpdateVerticesInfo *pUpdateInfo)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UpdateGeometryVertices, pUpdateInfo),
+                  CallType::UpdateGeometryVertices, [&] (Capture::Writer &w)
+    {
+        w.Object(pUpdateInfo);
+    });
 }
 
 RgResult rgUpdateGeometryTexCoords(RgInstance rgInstance, const RgUpdateTexCoordsInfo *pUpdateInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UpdateGeometryTexCoords, pUpdateInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UpdateGeometryTexCoords, pUpdateInfo),
+                  CallType::UpdateGeometryTexCoords, [&] (Capture::Writer &w)
+    {
+        w.Object(pUpdateInfo);
+    });
 }
 
-RgResult rgUploadRasterizedGeometry(RgInstance rgInstance, const RgRasterizedGeometryUploadInfo *pUploadInfo, 
+RgResult rgUploadRasterizedGeometry(RgInstance rgInstance, const RgRasterizedGeometryUploadInfo *pUploadInfo,
                                     const float *pViewProjection, const RgViewport *pViewport)
 {
-    return Call(rgInstance, &VulkanDevice::UploadRasterizedGeometry, pUploadInfo, pViewProjection, pViewport);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadRasterizedGeometry, pUploadInfo, pViewProjection, pViewport),
+                  CallType::UploadRasterizedGeometry, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+        w.Array(pViewProjection, 16);
+        w.Array(pViewport, 1);
+    });
 }
 
 RgResult rgUploadLensFlare(RgInstance rgInstance, const RgLensFlareUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadLensFlare, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadLensFlare, pUploadInfo),
+                  CallType::UploadLensFlare, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgUploadDecal(RgInstance rgInstance, const RgDecalUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadDecal, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadDecal, pUploadInfo),
+                  CallType::UploadDecal, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgUploadPortal(RgInstance rgInstance, const RgPortalUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadPortal, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadPortal, pUploadInfo),
+                  CallType::UploadPortal, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgBeginStaticGeometries(RgInstance rgInstance)
 {
-    return Call(rgInstance, &VulkanDevice::StartNewStaticScene);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::StartNewStaticScene),
+                  CallType::BeginStaticGeometries, [] (Capture::Writer &) {});
 }
 
 RgResult rgSubmitStaticGeometries(RgInstance rgInstance)
 {
-    return Call(rgInstance, &VulkanDevice::SubmitStaticGeometries);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::SubmitStaticGeometries),
+                  CallType::SubmitStaticGeometries, [] (Capture::Writer &) {});
+}
+
+RgResult rgUploadMesh(RgInstance rgInstance, const RgGeometryUploadInfo *pUploadInfo, RgMesh *pResult)
+{
+    if (pResult != nullptr)
+    {
+        *pResult = RG_NO_MESH;
+    }
+
+    // the result is recorded to match the mesh handles on replay
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadMesh, pUploadInfo, pResult),
+                  CallType::UploadMesh, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+        w.Value(*pResult);
+    });
+}
+
+RgResult rgUploadMeshInstances(RgInstance rgInstance, uint32_t instanceCount, const RgMeshInstanceUploadInfo *pInstances)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadMeshInstances, instanceCount, pInstances),
+                  CallType::UploadMeshInstances, [&] (Capture::Writer &w)
+    {
+        w.Array(pInstances, instanceCount);
+    });
+}
+
+RgResult rgUploadStaticChunk(RgInstance rgInstance, uint64_t chunkID, uint32_t geometryCount, const RgGeometryUploadInfo *pGeometries)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadStaticChunk, chunkID, geometryCount, pGeometries),
+                  CallType::UploadStaticChunk, [&] (Capture::Writer &w)
+    {
+        w.Value(chunkID);
+        w.Objects(pGeometries, geometryCount);
+    });
+}
+
+RgResult rgRemoveStaticChunk(RgInstance rgInstance, uint64_t chunkID)
+{
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::RemoveStaticChunk, chunkID),
+                  CallType::RemoveStaticChunk, [&] (Capture::Writer &w)
+    {
+        w.Value(chunkID);
+    });
 }
 
 RgResult rgUploadDirectionalLight(RgInstance rgInstance, const RgDirectionalLightUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadDirectionalLight, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadDirectionalLight, pUploadInfo),
+                  CallType::UploadDirectionalLight, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgUploadSphericalLight(RgInstance rgInstance, const RgSphericalLightUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadSphericalLight, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadSphericalLight, pUploadInfo),
+                  CallType::UploadSphericalLight, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgUploadSpotLight(RgInstance rgInstance, const RgSpotLightUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadSpotlight, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadSpotlight, pUploadInfo),
+                  CallType::UploadSpotLight, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgUploadPolygonalLight(RgInstance rgInstance, const RgPolygonalLightUploadInfo *pUploadInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UploadPolygonalLight, pUploadInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UploadPolygonalLight, pUploadInfo),
+                  CallType::UploadPolygonalLight, [&] (Capture::Writer &w)
+    {
+        w.Object(pUploadInfo);
+    });
 }
 
 RgResult rgCreateMaterial(RgInstance rgInstance, const RgMaterialCreateInfo *pCreateInfo, RgMaterial *pResult)
 {
     *pResult = RG_NO_MATERIAL;
-    return Call(rgInstance, &VulkanDevice::CreateMaterial, pCreateInfo, pResult);
+
+    RgResult r = Call(rgInstance, &VulkanDevice::CreateMaterial, pCreateInfo, pResult);
+
+    if (ApiCapture *capture = GetCapture(rgInstance); capture != nullptr && r == RG_SUCCESS)
+    {
+        capture->AddMaterial(*pResult, pCreateInfo->size);
+    }
+
+    return Record(rgInstance, r, CallType::CreateMaterial, [&] (Capture::Writer &w)
+    {
+        w.Object(pCreateInfo);
+        w.Value(*pResult);
+    });
 }
 
 RgResult rgCreateAnimatedMaterial(RgInstance rgInstance, const RgAnimatedMaterialCreateInfo *pCreateInfo, RgMaterial *pResult)
 {
     *pResult = RG_NO_MATERIAL;
-    return Call(rgInstance, &VulkanDevice::CreateAnimatedMaterial, pCreateInfo, pResult);
+
+    RgResult r = Call(rgInstance, &VulkanDevice::CreateAnimatedMaterial, pCreateInfo, pResult);
+
+    if (ApiCapture *capture = GetCapture(rgInstance); capture != nullptr && r == RG_SUCCESS && pCreateInfo->frameCount > 0)
+    {
+        capture->AddMaterial(*pResult, pCreateInfo->pFrames[0].size);
+    }
+
+    return Record(rgInstance, r, CallType::CreateAnimatedMaterial, [&] (Capture::Writer &w)
+    {
+        w.Object(pCreateInfo);
+        w.Value(*pResult);
+    });
 }
 
 RgResult rgChangeAnimatedMaterialFrame(RgInstance rgInstance, RgMaterial animatedMaterial, uint32_t frameIndex)
 {
-    return Call(rgInstance, &VulkanDevice::ChangeAnimatedMaterialFrame, animatedMaterial, frameIndex);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::ChangeAnimatedMaterialFrame, animatedMaterial, frameIndex),
+                  CallType::ChangeAnimatedMaterialFrame, [&] (Capture::Writer &w)
+    {
+        w.Value(animatedMaterial);
+        w.Value(frameIndex);
+    });
 }
 
 RgResult rgUpdateMaterialContents(RgInstance rgInstance, const RgMaterialUpdateInfo *pUpdateInfo)
 {
-    return Call(rgInstance, &VulkanDevice::UpdateMaterial, pUpdateInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::UpdateMaterial, pUpdateInfo),
+                  CallType::UpdateMaterialContents, [&] (Capture::Writer &w)
+    {
+        const Capture::MaterialUpdate update =
+        {
+            .size = GetCapture(rgInstance)->GetMaterialSize(pUpdateInfo->target),
+            .info = *pUpdateInfo,
+        };
+
+        w.Object(&update);
+    });
 }
 
 RgResult rgDestroyMaterial(RgInstance rgInstance, RgMaterial material)
 {
-    return Call(rgInstance, &VulkanDevice::DestroyMaterial, material);
+    if (ApiCapture *capture = GetCapture(rgInstance))
+    {
+        capture->RemoveMaterial(material);
+    }
+
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::DestroyMaterial, material),
+                  CallType::DestroyMaterial, [&] (Capture::Writer &w)
+    {
+        w.Value(material);
+    });
 }
 
 RgResult rgCreateCubemap(RgInstance rgInstance, const RgCubemapCreateInfo *pCreateInfo, RgCubemap *pResult)
 {
     *pResult = RG_EMPTY_CUBEMAP;
-    return Call(rgInstance, &VulkanDevice::CreateSkyboxCubemap, pCreateInfo, pResult);
+
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::CreateSkyboxCubemap, pCreateInfo, pResult),
+                  CallType::CreateCubemap, [&] (Capture::Writer &w)
+    {
+        w.Object(pCreateInfo);
+        w.Value(*pResult);
+    });
 }
 
 RgResult rgDestroyCubemap(RgInstance rgInstance, RgCubemap cubemap)
 {
-    return Call(rgInstance, &VulkanDevice::DestroyCubemap, cubemap);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::DestroyCubemap, cubemap),
+                  CallType::DestroyCubemap, [&] (Capture::Writer &w)
+    {
+        w.Value(cubemap);
+    });
 }
 
 RgResult rgStartFrame(RgInstance rgInstance, const RgStartFrameInfo *pStartInfo)
 {
-    return Call(rgInstance, &VulkanDevice::StartFrame, pStartInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::StartFrame, pStartInfo),
+                  CallType::StartFrame, [&] (Capture::Writer &w)
+    {
+        w.Object(pStartInfo);
+    });
 }
 
 RgResult rgDrawFrame(RgInstance rgInstance, const RgDrawFrameInfo *pDrawInfo)
 {
-    return Call(rgInstance, &VulkanDevice::DrawFrame, pDrawInfo);
+    return Record(rgInstance, Call(rgInstance, &VulkanDevice::DrawFrame, pDrawInfo),
+                  CallType::DrawFrame, [&] (Capture::Writer &w)
+    {
+        w.Object(pDrawInfo);
+    });
+}
+
+RgResult rgGetFrameTimings(RgInstance rgInstance, RgFrameTimings *pResult)
+{
+    return Call(rgInstance, &VulkanDevice::GetFrameTimings, pResult);
+}
+
+RgResult rgGetScratchStats(RgInstance rgInstance, RgScratchStats *pResult)
+{
+    return Call(rgInstance, &VulkanDevice::GetScratchStats, pResult);
+}
+
+RgResult rgGetStaticGeometryOptimizationStats(RgInstance rgInstance, RgStaticGeometryOptimizationStats *pResult)
+{
+    return Call(rgInstance, &VulkanDevice::GetStaticGeometryOptimizationStats, pResult);
+}
+
+RgResult rgWriteCpuTrace(RgInstance rgInstance, const char *pFilePath)
+{
+    return Call(rgInstance, &VulkanDevice::WriteCpuTrace, pFilePath);
 }
 
 RgBool32 rgIsRenderUpscaleTechniqueAvailable(RgInstance rgInstance, RgRenderUpscaleTechnique technique)
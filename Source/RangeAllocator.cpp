@@ -0,0 +1,110 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RangeAllocator.h"
+
+#include <cassert>
+#include <iterator>
+
+using namespace RTGL1;
+
+RangeAllocator::RangeAllocator(uint32_t begin, uint32_t size) : freeCount(size)
+{
+    if (size > 0)
+    {
+        freeRanges[begin] = size;
+    }
+}
+
+std::optional<RangeAllocator::Range> RangeAllocator::Allocate(uint32_t count)
+{
+    if (count == 0)
+    {
+        return Range{ 0, 0 };
+    }
+
+    for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+    {
+        const auto [offset, freeRangeCount] = *it;
+
+        if (freeRangeCount < count)
+        {
+            continue;
+        }
+
+        freeRanges.erase(it);
+
+        // the rest of the range is still free
+        if (freeRangeCount > count)
+        {
+            freeRanges[offset + count] = freeRangeCount - count;
+        }
+
+        freeCount -= count;
+        return Range{ offset, count };
+    }
+
+    return std::nullopt;
+}
+
+void RangeAllocator::Free(const Range &range)
+{
+    if (range.count == 0)
+    {
+        return;
+    }
+
+    uint32_t offset = range.offset;
+    uint32_t count = range.count;
+
+    auto next = freeRanges.lower_bound(offset);
+
+    // range must not intersect with free ones
+    assert(next == freeRanges.end() || offset + count <= next->first);
+
+    // merge with the next one
+    if (next != freeRanges.end() && offset + count == next->first)
+    {
+        count += next->second;
+        next = freeRanges.erase(next);
+    }
+
+    // merge with the previous one
+    if (next != freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            count += prev->second;
+            freeRanges.erase(prev);
+        }
+    }
+
+    freeRanges[offset] = count;
+    freeCount += range.count;
+}
+
+uint32_t RangeAllocator::GetFreeCount() const
+{
+    return freeCount;
+}
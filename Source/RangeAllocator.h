@@ -0,0 +1,58 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace RTGL1
+{
+
+// First-fit allocator of ranges in [begin, begin + size).
+// Doesn't own any memory, only manages offsets, e.g. element indices in a buffer.
+// Adjacent free ranges are merged on freeing.
+class RangeAllocator
+{
+public:
+    struct Range
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+public:
+    explicit RangeAllocator(uint32_t begin = 0, uint32_t size = 0);
+
+    // Returns null, if there's no free range with at least "count" elements.
+    // Allocating 0 elements always succeeds.
+    std::optional<Range> Allocate(uint32_t count);
+    void Free(const Range &range);
+
+    uint32_t GetFreeCount() const;
+
+private:
+    // offset to count
+    std::map<uint32_t, uint32_t> freeRanges;
+    uint32_t freeCount;
+};
+
+}
@@ -24,6 +24,7 @@
 #include "Matrix.h"
 #include "Utils.h"
 #include "CmdLabel.h"
+#include "CpuTrace.h"
 #include "RenderResolutionHelper.h"
 
 
@@ -154,6 +155,7 @@ void Rasterizer::UploadLensFlare( uint32_t frameIndex, const RgLensFlareUploadIn
 
 void Rasterizer::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex )
 {
+    RG_TRACE_SCOPE( "Rasterizer::SubmitForFrame" );
     CmdLabel label( cmd, "Copying rasterizer data" );
 
     collector->CopyFromStaging( cmd, frameIndex );
@@ -43,6 +43,7 @@ const char* RTGL1::RgException::GetRgResultName(RgResult r)
         case RG_WRONG_FUNCTION_CALL: return "RG_WRONG_FUNCTION_CALL";
         case RG_ERROR_CANT_FIND_BLUE_NOISE: return "RG_ERROR_CANT_FIND_BLUE_NOISE";
         case RG_ERROR_CANT_FIND_WATER_TEXTURES: return "RG_ERROR_CANT_FIND_WATER_TEXTURES";
+        case RG_CANT_UPDATE_VERTICES: return "RG_CANT_UPDATE_VERTICES";
         default: assert(0); return "Unknown RgResult";
     }
 }
@@ -22,6 +22,7 @@
 #include "Generated/ShaderCommonC.h"
 #include "RgException.h"
 #include "CmdLabel.h"
+#include "CpuTrace.h"
 
 using namespace RTGL1;
 
@@ -32,20 +33,33 @@ Scene::Scene(
     std::shared_ptr<CommandBufferManager> &_cmdManager,
     std::shared_ptr<TextureManager> &_textureManager,
     const std::shared_ptr<const GlobalUniform> &_uniform,
-    const std::shared_ptr<const ShaderManager> &_shaderManager)
+    const std::shared_ptr<const ShaderManager> &_shaderManager,
+    bool _compactStaticBlas,
+    VertexBufferFormat _vertexFormat,
+    uint32_t _initialStaticVertexCount,
+    uint32_t _initialDynamicVertexCount,
+    uint32_t _initialIndexCount,
+    uint32_t _staticChunkVertexCount,
+    uint32_t _staticChunkIndexCount,
+    bool _optimizeStaticGeometry)
 :
     toResubmitMovable(false),
     isRecordingStatic(false),
-    submittedStaticInCurrentFrame(false)
+    wasStaticOptimized(false)
 {
-    VertexCollectorFilterTypeFlags_Init();
-
     lightManager = std::make_shared<LightManager>(_device, _allocator);
     geomInfoMgr = std::make_shared<GeomInfoManager>(_device, _allocator);
 
-    asManager = std::make_shared<ASManager>(_device, _physDevice, _allocator, _cmdManager, _textureManager, geomInfoMgr);
+    asManager = std::make_shared<ASManager>(_device, _physDevice, _allocator, _cmdManager, _textureManager, geomInfoMgr, _compactStaticBlas, _vertexFormat,
+                                             _initialStaticVertexCount, _initialDynamicVertexCount, _initialIndexCount,
+                                             _staticChunkVertexCount, _staticChunkIndexCount);
   
     vertPreproc = std::make_shared<VertexPreprocessing>(_device, _uniform, asManager, _shaderManager);
+
+    if (_optimizeStaticGeometry)
+    {
+        staticOptimizer = std::make_unique<StaticGeometryOptimizer>();
+    }
 }
 
 Scene::~Scene()
@@ -53,7 +67,8 @@ Scene::~Scene()
 
 void Scene::PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex)
 {
-    dynamicUniqueIDToSimpleIndex.clear();
+    dynamicUniqueIDs.clear();
+    meshInstanceUniqueIDs.clear();
 
     geomInfoMgr->PrepareForFrame(frameIndex);
     lightManager->PrepareForFrame(cmd, frameIndex);
@@ -65,10 +80,17 @@ void Scene::PrepareForFrame(VkCommandBuffer cmd, uint32_t frameIndex)
 void Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform, 
                            uint32_t uniformData_rayCullMaskWorld, bool allowGeometryWithSkyFlag, bool disableRTGeometry)
 {
-    uint32_t preprocMode = submittedStaticInCurrentFrame ? VERT_PREPROC_MODE_ALL : 
-                           toResubmitMovable             ? VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE : 
-                                                           VERT_PREPROC_MODE_ONLY_DYNAMIC;
-    submittedStaticInCurrentFrame = false;
+    RG_TRACE_SCOPE("Scene::SubmitForFrame");
+
+    // static geometry is built asynchronously, swap to it as soon as it's ready
+    const bool staticFinished = asManager->TryFinishStaticGeometry(cmd, frameIndex);
+
+    // static buffers must not be touched, until their build is finished
+    const bool resubmitMovable = toResubmitMovable && !asManager->IsStaticGeometryPending();
+
+    uint32_t preprocMode = staticFinished  ? VERT_PREPROC_MODE_ALL : 
+                           resubmitMovable ? VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE : 
+                                             VERT_PREPROC_MODE_ONLY_DYNAMIC;
 
 
     lightManager->CopyFromStaging(cmd, frameIndex);
@@ -77,7 +99,7 @@ void Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::
     // copy to device-local, if there were any tex coords change for static geometry
     asManager->ResubmitStaticTexCoords(cmd);
 
-    if (toResubmitMovable)
+    if (resubmitMovable)
     {
         // at least one transform of static movable geometry was changed
         asManager->ResubmitStaticMovable(cmd);
@@ -85,8 +107,12 @@ void Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::
     }
 
     // always submit dynamic geomtetry on the frame ending
+    asManager->SubmitStaticChunks(cmd, frameIndex);
     asManager->SubmitDynamicGeometry(cmd, frameIndex);
 
+    // write geom infos of mesh instances, they're placed after all others
+    asManager->SubmitMeshInstances(frameIndex);
+
 
     // copy geom and tri infos to device-local
     geomInfoMgr->CopyFromStaging(cmd, frameIndex);
@@ -108,8 +134,6 @@ void Scene::SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::
 
 bool Scene::Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
 {
-    assert(!DoesUniqueIDExist(uploadInfo.uniqueID));
-
     if (uploadInfo.geomType == RG_GEOMETRY_TYPE_DYNAMIC)
     {
         if (isRecordingStatic)
@@ -117,13 +141,23 @@ bool Scene::Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
             throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
         }
 
-        uint32_t simpleIndex = asManager->AddDynamicGeometry(frameIndex, uploadInfo);
+        // reserve ID, other threads could upload the same one
+        {
+            std::lock_guard<std::mutex> lock(uniqueIDsMutex);
 
-        if (simpleIndex != UINT32_MAX)
+            if (IsUniqueIDReserved(uploadInfo.uniqueID) || !dynamicUniqueIDs.insert(uploadInfo.uniqueID).second)
+            {
+                throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID=" + std::to_string(uploadInfo.uniqueID) + " already exists");
+            }
+        }
+
+        if (asManager->AddDynamicGeometry(frameIndex, uploadInfo))
         {
-            dynamicUniqueIDToSimpleIndex[uploadInfo.uniqueID] = simpleIndex;
             return true;
         }
+
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+        dynamicUniqueIDs.erase(uploadInfo.uniqueID);
     }
     else
     {
@@ -133,36 +167,358 @@ bool Scene::Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
             throw RgException(RG_WRONG_FUNCTION_CALL, "Submitting static geometry is only allowed between rgStartNewScene and rgSubmitStaticGeometries calls");
         }
 
+        // reserve ID with an invalid simple index, other threads could upload the same one;
+        // if the geometry is queued for the optimization, simple index is assigned in SubmitStatic
+        {
+            std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+            if (IsUniqueIDReserved(uploadInfo.uniqueID) ||
+                !staticUniqueIDToSimpleIndex.emplace(uploadInfo.uniqueID, UINT32_MAX).second)
+            {
+                throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID=" + std::to_string(uploadInfo.uniqueID) + " already exists");
+            }
+        }
+
+        if (staticOptimizer)
+        {
+            staticOptimizer->Add(uploadInfo);
+            return true;
+        }
+
         uint32_t simpleIndex = asManager->AddStaticGeometry(frameIndex, uploadInfo);
 
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
         if (simpleIndex != UINT32_MAX)
         {
             staticUniqueIDToSimpleIndex[uploadInfo.uniqueID] = simpleIndex;
 
             if (uploadInfo.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
             {
-                movableGeomIndices.push_back(simpleIndex);
+                movableGeomIndices.insert(simpleIndex);
             }
 
             return true;
         }
+
+        staticUniqueIDToSimpleIndex.erase(uploadInfo.uniqueID);
     }
 
     return false;
 }
 
-bool Scene::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
+bool Scene::Upload(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> uploadInfos)
 {
-    uint32_t simpleIndex;
-    if (!TryGetStaticSimpleIndex(updateInfo.movableStaticUniqueID, &simpleIndex))
+    if (uploadInfos.empty())
+    {
+        return true;
+    }
+
+    const bool isDynamic = uploadInfos[0].geomType == RG_GEOMETRY_TYPE_DYNAMIC;
+
+    for (const RgGeometryUploadInfo &info : uploadInfos)
+    {
+        if ((info.geomType == RG_GEOMETRY_TYPE_DYNAMIC) != isDynamic)
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Dynamic and static geometries must be uploaded in separate batches");
+        }
+    }
+
+    if (isDynamic && isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (!isDynamic && !isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Submitting static geometry is only allowed between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    // reserve all IDs at once; static IDs are reserved with an invalid simple index,
+    // so duplicates inside of the batch are also found
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        if (isDynamic)
+        {
+            dynamicUniqueIDs.reserve(dynamicUniqueIDs.size() + uploadInfos.size());
+        }
+        else
+        {
+            staticUniqueIDToSimpleIndex.reserve(staticUniqueIDToSimpleIndex.size() + uploadInfos.size());
+        }
+
+        for (size_t i = 0; i < uploadInfos.size(); i++)
+        {
+            const uint64_t id = uploadInfos[i].uniqueID;
+
+            bool reserved = !IsUniqueIDReserved(id) && (isDynamic ?
+                dynamicUniqueIDs.insert(id).second :
+                staticUniqueIDToSimpleIndex.emplace(id, UINT32_MAX).second);
+
+            if (!reserved)
+            {
+                ReleaseUniqueIDs(uploadInfos.first(i), isDynamic);
+                throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID=" + std::to_string(id) + " already exists");
+            }
+        }
+    }
+
+    if (!isDynamic && staticOptimizer)
+    {
+        for (const RgGeometryUploadInfo &info : uploadInfos)
+        {
+            staticOptimizer->Add(info);
+        }
+
+        return true;
+    }
+
+    std::vector<uint32_t> results(uploadInfos.size());
+
+    if (isDynamic)
+    {
+        asManager->AddDynamicGeometries(frameIndex, uploadInfos, results);
+    }
+    else
+    {
+        asManager->AddStaticGeometries(frameIndex, uploadInfos, results);
+    }
+
+    std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+    bool allAdded = true;
+
+    for (size_t i = 0; i < uploadInfos.size(); i++)
     {
-        throw RgException(RG_CANT_UPDATE_TRANSFORM, "Can't find static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID));
+        const RgGeometryUploadInfo &info = uploadInfos[i];
+
+        if (results[i] == UINT32_MAX)
+        {
+            ReleaseUniqueIDs({ &info, 1 }, isDynamic);
+            allAdded = false;
+            continue;
+        }
+
+        if (!isDynamic)
+        {
+            staticUniqueIDToSimpleIndex[info.uniqueID] = results[i];
+
+            if (info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
+            {
+                movableGeomIndices.insert(results[i]);
+            }
+        }
+    }
+
+    return allAdded;
+}
+
+void Scene::AcquireDynamicGeometryMemory(uint32_t frameIndex, uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices)
+{
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Dynamic geometry must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    if (!asManager->AcquireDynamicGeometryMemory(frameIndex, vertexCount, indexCount, ppOutVertices, ppOutIndices))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Not enough space in dynamic geometry buffers for " + std::to_string(vertexCount) + " vertices and " + std::to_string(indexCount) + " indices");
+    }
+}
+
+RgMesh Scene::UploadMesh(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo)
+{
+    if (!isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Meshes must be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    RgMesh mesh = asManager->AddMesh(frameIndex, uploadInfo);
+
+    if (mesh == RG_NO_MESH)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Not enough space in static geometry buffers for the mesh");
+    }
+
+    return mesh;
+}
+
+void Scene::UploadMeshInstances(uint32_t frameIndex, std::span<const RgMeshInstanceUploadInfo> instanceInfos)
+{
+    if (instanceInfos.empty())
+    {
+        return;
+    }
+
+    if (isRecordingStatic)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "Mesh instances must not be uploaded between rgStartNewScene and rgSubmitStaticGeometries calls");
+    }
+
+    for (const RgMeshInstanceUploadInfo &info : instanceInfos)
+    {
+        if (!asManager->IsMeshValid(info.mesh))
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Mesh instance with ID=" + std::to_string(info.uniqueID) + " has invalid mesh handle");
+        }
+    }
+
+    auto releaseIDs = [this] (std::span<const RgMeshInstanceUploadInfo> infos)
+    {
+        for (const RgMeshInstanceUploadInfo &info : infos)
+        {
+            meshInstanceUniqueIDs.erase(info.uniqueID);
+        }
+    };
+
+    // reserve IDs, as they're used for matching instances between frames
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        for (size_t i = 0; i < instanceInfos.size(); i++)
+        {
+            const uint64_t id = instanceInfos[i].uniqueID;
+
+            if (IsUniqueIDReserved(id) || !meshInstanceUniqueIDs.insert(id).second)
+            {
+                releaseIDs(instanceInfos.first(i));
+                throw RgException(RG_WRONG_ARGUMENT, "Mesh instance with ID=" + std::to_string(id) + " already exists");
+            }
+        }
+    }
+
+    if (!asManager->AddMeshInstances(frameIndex, instanceInfos))
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+        releaseIDs(instanceInfos);
+
+        throw RgException(RG_WRONG_ARGUMENT, "Too many mesh instances, max count is " + std::to_string(MAX_MESH_INSTANCE_COUNT));
+    }
+}
+
+void Scene::UploadStaticChunk(uint32_t frameIndex, uint64_t chunkID, std::span<const RgGeometryUploadInfo> uploadInfos)
+{
+    auto releaseIDs = [this] (std::span<const RgGeometryUploadInfo> infos)
+    {
+        for (const RgGeometryUploadInfo &info : infos)
+        {
+            staticChunkGeomUniqueIDs.erase(info.uniqueID);
+        }
+    };
+
+    // reserve chunk and geometry IDs
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        if (staticChunkToGeomUniqueIDs.contains(chunkID))
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Static chunk with ID=" + std::to_string(chunkID) + " already exists");
+        }
+
+        for (size_t i = 0; i < uploadInfos.size(); i++)
+        {
+            const uint64_t id = uploadInfos[i].uniqueID;
+
+            if (IsUniqueIDReserved(id) || !staticChunkGeomUniqueIDs.insert(id).second)
+            {
+                releaseIDs(uploadInfos.first(i));
+                throw RgException(RG_WRONG_ARGUMENT, "Static chunk geometry with ID=" + std::to_string(id) + " already exists");
+            }
+        }
+
+        auto &geomIDs = staticChunkToGeomUniqueIDs[chunkID];
+
+        for (const RgGeometryUploadInfo &info : uploadInfos)
+        {
+            geomIDs.push_back(info.uniqueID);
+        }
+    }
+
+    if (!asManager->AddStaticChunk(chunkID, frameIndex, uploadInfos))
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        releaseIDs(uploadInfos);
+        staticChunkToGeomUniqueIDs.erase(chunkID);
+
+        throw RgException(RG_WRONG_ARGUMENT, "Not enough space in static chunk buffers for the chunk with ID=" + std::to_string(chunkID));
+    }
+}
+
+void Scene::RemoveStaticChunk(uint32_t frameIndex, uint64_t chunkID)
+{
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        auto f = staticChunkToGeomUniqueIDs.find(chunkID);
+
+        if (f == staticChunkToGeomUniqueIDs.end())
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Static chunk with ID=" + std::to_string(chunkID) + " doesn't exist");
+        }
+
+        for (uint64_t id : f->second)
+        {
+            staticChunkGeomUniqueIDs.erase(id);
+        }
+
+        staticChunkToGeomUniqueIDs.erase(f);
+    }
+
+    asManager->RemoveStaticChunk(chunkID, frameIndex);
+}
+
+void Scene::ReleaseUniqueIDs(std::span<const RgGeometryUploadInfo> uploadInfos, bool isDynamic)
+{
+    for (const RgGeometryUploadInfo &info : uploadInfos)
+    {
+        if (isDynamic)
+        {
+            dynamicUniqueIDs.erase(info.uniqueID);
+        }
+        else
+        {
+            staticUniqueIDToSimpleIndex.erase(info.uniqueID);
+        }
+    }
+}
+
+bool Scene::GetMovableSimpleIndex(uint64_t uniqueID, uint32_t *pSimpleIndex)
+{
+    // geometry is not added yet, if it's queued for the optimization
+    if (isRecordingStatic && staticOptimizer && staticOptimizer->IsMovableQueued(uniqueID))
+    {
+        return false;
+    }
+
+    bool isMovable, isMerged;
+    if (!TryGetStaticSimpleIndex(uniqueID, pSimpleIndex, &isMovable, &isMerged))
+    {
+        throw RgException(RG_CANT_UPDATE_TRANSFORM, "Can't find static geometry with unique ID=" + std::to_string(uniqueID));
+    }
+
+    // the transform would be applied to all of the merged geometries
+    if (isMerged)
+    {
+        throw RgException(RG_CANT_UPDATE_TRANSFORM, "Static geometry with unique ID=" + std::to_string(uniqueID) + " was merged with other geometries by the optimization");
     }
 
     // check if it's actually movable
-    if (std::find(movableGeomIndices.begin(), movableGeomIndices.end(), simpleIndex) == movableGeomIndices.end())
+    if (!isMovable)
     {
-        throw RgException(RG_CANT_UPDATE_TRANSFORM, "Static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID) + " isn't movable");
+        throw RgException(RG_CANT_UPDATE_TRANSFORM, "Static geometry with unique ID=" + std::to_string(uniqueID) + " isn't movable");
+    }
+
+    return true;
+}
+
+bool Scene::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
+{
+    uint32_t simpleIndex;
+    if (!GetMovableSimpleIndex(updateInfo.movableStaticUniqueID, &simpleIndex))
+    {
+        staticOptimizer->UpdateTransform(updateInfo);
+        return true;
     }
 
     asManager->UpdateStaticMovableTransform(simpleIndex, updateInfo);
@@ -177,8 +533,47 @@ bool Scene::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
     return true;
 }
 
+void Scene::UpdateTransforms(std::span<const RgUpdateTransformInfo> updateInfos)
+{
+    // validate all, so nothing is applied if one of them fails;
+    // UINT32_MAX, if the geometry is queued for the optimization
+    std::vector<uint32_t> simpleIndices(updateInfos.size());
+
+    for (size_t i = 0; i < updateInfos.size(); i++)
+    {
+        if (!GetMovableSimpleIndex(updateInfos[i].movableStaticUniqueID, &simpleIndices[i]))
+        {
+            simpleIndices[i] = UINT32_MAX;
+        }
+    }
+
+    for (size_t i = 0; i < updateInfos.size(); i++)
+    {
+        if (simpleIndices[i] == UINT32_MAX)
+        {
+            staticOptimizer->UpdateTransform(updateInfos[i]);
+        }
+        else
+        {
+            asManager->UpdateStaticMovableTransform(simpleIndices[i], updateInfos[i]);
+        }
+    }
+
+    // if not recording, then static geometries were already submitted,
+    // as some movable transform was changed AS must be rebuilt
+    if (!isRecordingStatic && !updateInfos.empty())
+    {
+        toResubmitMovable = true;
+    }
+}
+
 bool RTGL1::Scene::UpdateTexCoords(const RgUpdateTexCoordsInfo &texCoordsInfo)
 {
+    if (staticOptimizer)
+    {
+        throw RgException(RG_CANT_UPDATE_TEXCOORDS, "Texture coordinates of static geometry can't be updated, if static geometry optimization is enabled");
+    }
+
     uint32_t simpleIndex;
     if (!TryGetStaticSimpleIndex(texCoordsInfo.staticUniqueID, &simpleIndex))
     {
@@ -189,19 +584,66 @@ bool RTGL1::Scene::UpdateTexCoords(const RgUpdateTexCoordsInfo &texCoordsInfo)
     return true;
 }
 
-void Scene::SubmitStatic()
+bool Scene::UpdateVertices(const RgUpdateVerticesInfo &updateInfo)
+{
+    // vertices are welded and reordered by the optimization
+    if (staticOptimizer)
+    {
+        throw RgException(RG_CANT_UPDATE_VERTICES, "Vertices of static geometry can't be updated, if static geometry optimization is enabled");
+    }
+
+    uint32_t simpleIndex;
+    bool isMovable;
+    if (!TryGetStaticSimpleIndex(updateInfo.movableStaticUniqueID, &simpleIndex, &isMovable))
+    {
+        throw RgException(RG_CANT_UPDATE_VERTICES, "Can't find static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID));
+    }
+
+    if (!isMovable)
+    {
+        throw RgException(RG_CANT_UPDATE_VERTICES, "Static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID) + " isn't movable");
+    }
+
+    if (!asManager->UpdateStaticMovableVertices(simpleIndex, updateInfo))
+    {
+        throw RgException(RG_CANT_UPDATE_VERTICES, "Vertex range is out of bounds of static geometry with unique ID=" + std::to_string(updateInfo.movableStaticUniqueID));
+    }
+
+    // same as for transforms, AS must be updated
+    if (!isRecordingStatic)
+    {
+        toResubmitMovable = true;
+    }
+
+    return true;
+}
+
+void Scene::SubmitStatic(uint32_t frameIndex)
 {
+    wasStaticOptimized = false;
+    bool allAdded = true;
+
     // submit even if nothing was recorded, 
     // so the static scene will be empty
     if (!isRecordingStatic)
     {
         asManager->BeginStaticGeometry();
     }
+    else if (staticOptimizer)
+    {
+        allAdded = AddOptimizedStatic(frameIndex);
+    }
 
-    asManager->SubmitStaticGeometry();
+    // static geometry will be used in the frame when its build is finished
+    asManager->SubmitStaticGeometry(frameIndex);
     isRecordingStatic = false;
 
-    submittedStaticInCurrentFrame = true;
+    // the rest of the scene is submitted, so only report the geometries that didn't fit
+    if (!allAdded)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Some of the static geometries weren't added after the optimization: "
+                          "a limit of geometry count or buffer size is reached");
+    }
 }
 
 void Scene::StartNewStatic()
@@ -215,8 +657,15 @@ void Scene::StartNewStatic()
     asManager->BeginStaticGeometry();
     lightManager->Reset();
 
+    if (staticOptimizer)
+    {
+        staticOptimizer->Clear();
+    }
+
+    std::lock_guard<std::mutex> lock(uniqueIDsMutex);
     staticUniqueIDToSimpleIndex.clear();
     movableGeomIndices.clear();
+    mergedGeomIndices.clear();
 }
 
 const std::shared_ptr<ASManager> &Scene::GetASManager()
@@ -234,24 +683,105 @@ const std::shared_ptr<VertexPreprocessing> &RTGL1::Scene::GetVertexPreprocessing
     return vertPreproc;
 }
 
-bool Scene::DoesUniqueIDExist(uint64_t uniqueID) const
+bool Scene::AddOptimizedStatic(uint32_t frameIndex)
 {
+    assert(isRecordingStatic && staticOptimizer);
+
+    const std::vector<StaticGeometryOptimizer::Result> optimized = staticOptimizer->Optimize();
+    wasStaticOptimized = true;
+
+    std::vector<RgGeometryUploadInfo> uploadInfos;
+    uploadInfos.reserve(optimized.size());
+
+    for (const auto &r : optimized)
+    {
+        uploadInfos.push_back(r.info);
+    }
+
+    std::vector<uint32_t> results(uploadInfos.size());
+    asManager->AddStaticGeometries(frameIndex, uploadInfos, results);
+
+    bool allAdded = true;
+
+    {
+        std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
+        for (size_t i = 0; i < optimized.size(); i++)
+        {
+            // merged geometries share the same simple index
+            for (uint64_t id : optimized[i].uniqueIDs)
+            {
+                if (results[i] != UINT32_MAX)
+                {
+                    staticUniqueIDToSimpleIndex[id] = results[i];
+                }
+                else
+                {
+                    staticUniqueIDToSimpleIndex.erase(id);
+                }
+            }
+
+            if (results[i] != UINT32_MAX && optimized[i].info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
+            {
+                movableGeomIndices.insert(results[i]);
+            }
+
+            if (results[i] != UINT32_MAX && optimized[i].uniqueIDs.size() > 1)
+            {
+                mergedGeomIndices.insert(results[i]);
+            }
+
+            allAdded &= results[i] != UINT32_MAX;
+        }
+    }
+
+    // the data was copied to staging
+    staticOptimizer->Clear();
+
+    return allAdded;
+}
+
+const StaticGeometryOptimizer::Stats *Scene::GetStaticOptimizationStats() const
+{
+    return wasStaticOptimized ? &staticOptimizer->GetStats() : nullptr;
+}
+
+bool Scene::IsUniqueIDReserved(uint64_t uniqueID) const
+{
+    // dynamic, static, static chunk geometries and mesh instances share the same namespace,
+    // as their geometry infos are matched by the IDs between frames
     return
-        staticUniqueIDToSimpleIndex.find(uniqueID) != staticUniqueIDToSimpleIndex.end() ||
-        dynamicUniqueIDToSimpleIndex.find(uniqueID) != dynamicUniqueIDToSimpleIndex.end();
+        dynamicUniqueIDs.contains(uniqueID) ||
+        staticUniqueIDToSimpleIndex.contains(uniqueID) ||
+        staticChunkGeomUniqueIDs.contains(uniqueID) ||
+        meshInstanceUniqueIDs.contains(uniqueID);
 }
 
-bool Scene::TryGetStaticSimpleIndex(uint64_t uniqueID, uint32_t *result) const
+bool Scene::TryGetStaticSimpleIndex(uint64_t uniqueID, uint32_t *result, bool *pIsMovable, bool *pIsMerged) const
 {
+    std::lock_guard<std::mutex> lock(uniqueIDsMutex);
+
     auto f = staticUniqueIDToSimpleIndex.find(uniqueID);
 
-    if (f != staticUniqueIDToSimpleIndex.end())
+    // invalid simple index, if the ID is only reserved
+    if (f == staticUniqueIDToSimpleIndex.end() || f->second == UINT32_MAX)
     {
-        *result = f->second;
-        return true;
+        return false;
     }
 
-    return false;
+    *result = f->second;
+
+    if (pIsMovable != nullptr)
+    {
+        *pIsMovable = movableGeomIndices.contains(f->second);
+    }
+
+    if (pIsMerged != nullptr)
+    {
+        *pIsMerged = mergedGeomIndices.contains(f->second);
+    }
+
+    return true;
 }
 
 void Scene::UploadLight(uint32_t frameIndex, const RgDirectionalLightUploadInfo &lightInfo)
@@ -20,8 +20,12 @@
 
 #pragma once
 
+#include <mutex>
+#include <span>
+
 #include "ASManager.h"
 #include "LightManager.h"
+#include "StaticGeometryOptimizer.h"
 #include "VertexPreprocessing.h"
 
 namespace RTGL1
@@ -37,7 +41,15 @@ public:
         std::shared_ptr<CommandBufferManager> &cmdManager,
         std::shared_ptr<TextureManager> &textureManager,
         const std::shared_ptr<const GlobalUniform> &uniform,
-        const std::shared_ptr<const ShaderManager> &shaderManager);
+        const std::shared_ptr<const ShaderManager> &shaderManager,
+        bool compactStaticBlas,
+        VertexBufferFormat vertexFormat,
+        uint32_t initialStaticVertexCount,
+        uint32_t initialDynamicVertexCount,
+        uint32_t initialIndexCount,
+        uint32_t staticChunkVertexCount,
+        uint32_t staticChunkIndexCount,
+        bool optimizeStaticGeometry);
 
     ~Scene();
 
@@ -50,26 +62,55 @@ public:
     void SubmitForFrame(VkCommandBuffer cmd, uint32_t frameIndex, const std::shared_ptr<GlobalUniform> &uniform,
                         uint32_t uniformData_rayCullMaskWorld, bool allowGeometryWithSkyFlag, bool disableRTGeometry);
 
+    // Thread-safe. Returns false, if geometry was rejected because of a limit.
     bool Upload(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo);
+    // Thread-safe. Geometries must be either all dynamic or all static.
+    // Returns true, if all geometries were added.
+    bool Upload(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> uploadInfos);
+    // Thread-safe. Get staging memory for dynamic geometry, so its data can be written in place.
+    void AcquireDynamicGeometryMemory(uint32_t frameIndex, uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices);
+    // Thread-safe. Mesh can be uploaded only while recording static geometry.
+    RgMesh UploadMesh(uint32_t frameIndex, const RgGeometryUploadInfo &uploadInfo);
+    // Thread-safe. Mesh instances are visible only in the current frame.
+    void UploadMeshInstances(uint32_t frameIndex, std::span<const RgMeshInstanceUploadInfo> instanceInfos);
+    // Thread-safe. Chunk is not a part of the static scene, so it can be uploaded at any time.
+    void UploadStaticChunk(uint32_t frameIndex, uint64_t chunkID, std::span<const RgGeometryUploadInfo> uploadInfos);
+    void RemoveStaticChunk(uint32_t frameIndex, uint64_t chunkID);
     bool UpdateTransform(const RgUpdateTransformInfo &updateInfo);
+    // All IDs are checked before applying, so if one of them fails, nothing is applied.
+    void UpdateTransforms(std::span<const RgUpdateTransformInfo> updateInfos);
     bool UpdateTexCoords(const RgUpdateTexCoordsInfo &texCoordsInfo);
+    bool UpdateVertices(const RgUpdateVerticesInfo &updateInfo);
 
     void UploadLight(uint32_t frameIndex, const RgSphericalLightUploadInfo &lightInfo);
     void UploadLight(uint32_t frameIndex, const RgPolygonalLightUploadInfo &lightInfo);
     void UploadLight(uint32_t frameIndex, const RgDirectionalLightUploadInfo &lightInfo);
     void UploadLight(uint32_t frameIndex, const RgSpotLightUploadInfo &lightInfo);
 
-    void SubmitStatic();
+    void SubmitStatic(uint32_t frameIndex);
     void StartNewStatic();
 
     const std::shared_ptr<ASManager> &GetASManager();
     const std::shared_ptr<LightManager> &GetLightManager();
     const std::shared_ptr<VertexPreprocessing> &GetVertexPreprocessing();
 
-    bool DoesUniqueIDExist(uint64_t uniqueID) const;
+    // Null, if static geometry optimization wasn't done on the last SubmitStatic
+    const StaticGeometryOptimizer::Stats *GetStaticOptimizationStats() const;
 
 private:
-    bool TryGetStaticSimpleIndex(uint64_t uniqueID, uint32_t *result) const;
+    // Must be called under uniqueIDsMutex
+    bool IsUniqueIDReserved(uint64_t uniqueID) const;
+    // Thread-safe. Returns false, if there's no static geometry with the ID,
+    // or if its ID is only reserved. "pIsMovable" and "pIsMerged" are set, if not null.
+    bool TryGetStaticSimpleIndex(uint64_t uniqueID, uint32_t *result, bool *pIsMovable = nullptr, bool *pIsMerged = nullptr) const;
+    // Throws, if the transform of the geometry can't be updated. Returns false, if the geometry
+    // is queued for the optimization, i.e. it's not added yet; otherwise, sets its simple index.
+    bool GetMovableSimpleIndex(uint64_t uniqueID, uint32_t *pSimpleIndex);
+    // Must be called under uniqueIDsMutex
+    void ReleaseUniqueIDs(std::span<const RgGeometryUploadInfo> uploadInfos, bool isDynamic);
+    // Add geometries that were queued for the optimization, must be called while recording static.
+    // Returns true, if all geometries were added.
+    bool AddOptimizedStatic(uint32_t frameIndex);
 
 private:
     std::shared_ptr<ASManager> asManager;
@@ -77,16 +118,31 @@ private:
     std::shared_ptr<GeomInfoManager> geomInfoMgr;
     std::shared_ptr<VertexPreprocessing> vertPreproc;
 
-    // Dynamic indices are cleared every frame
-    rgl::unordered_map<uint64_t, uint32_t> dynamicUniqueIDToSimpleIndex;
+    // Dynamic IDs are cleared every frame. Simple indices of dynamic geometry
+    // are not known on upload, as they're assigned on the submission.
+    rgl::unordered_set<uint64_t> dynamicUniqueIDs;
     rgl::unordered_map<uint64_t, uint32_t> staticUniqueIDToSimpleIndex;
-
-    // Movable geometry IDs
-    std::vector<uint32_t> movableGeomIndices;
+    // Mesh instance IDs are cleared every frame
+    rgl::unordered_set<uint64_t> meshInstanceUniqueIDs;
+    // Geometry IDs of static chunks
+    rgl::unordered_map<uint64_t, std::vector<uint64_t>> staticChunkToGeomUniqueIDs;
+    rgl::unordered_set<uint64_t> staticChunkGeomUniqueIDs;
+    // guards unique ID containers, as geometry can be uploaded concurrently
+    mutable std::mutex uniqueIDsMutex;
+
+    // Simple indices of movable geometries, guarded by uniqueIDsMutex
+    rgl::unordered_set<uint32_t> movableGeomIndices;
+    // Simple indices of geometries that were merged by the optimization, so several IDs
+    // point to them and they can't be updated by one of these IDs; guarded by uniqueIDsMutex
+    rgl::unordered_set<uint32_t> mergedGeomIndices;
     bool toResubmitMovable;
 
     bool isRecordingStatic;
-    bool submittedStaticInCurrentFrame;
+
+    // if not null, static geometries are queued on upload,
+    // and added to the scene after processing in SubmitStatic
+    std::unique_ptr<StaticGeometryOptimizer> staticOptimizer;
+    bool wasStaticOptimized;
 };
 
 }
\ No newline at end of file
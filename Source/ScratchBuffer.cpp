@@ -26,14 +26,15 @@
 
 using namespace RTGL1;
 
-constexpr VkDeviceSize SCRATCH_CHUNK_BUFFER_SIZE = (1 << 24);
+constexpr VkDeviceSize SCRATCH_INITIAL_SIZE = (1 << 24);
+constexpr VkDeviceSize SCRATCH_SIZE_GRANULARITY = (1 << 20);
 
 ScratchBuffer::ScratchBuffer(std::shared_ptr<MemoryAllocator> _allocator, uint32_t _alignment)
 :
     allocator(_allocator),
     alignment(_alignment)
 {
-    AddChunk(SCRATCH_CHUNK_BUFFER_SIZE);
+    ring = CreateBuffer(SCRATCH_INITIAL_SIZE);
 }
 
 VkDeviceAddress ScratchBuffer::GetScratchAddress(VkDeviceSize scratchSize)
@@ -41,42 +42,120 @@ VkDeviceAddress ScratchBuffer::GetScratchAddress(VkDeviceSize scratchSize)
     // the fastest way to always return an aligned address is simply to align all allocation sizes
     const VkDeviceSize alignedSize = Utils::Align(scratchSize, (VkDeviceSize)alignment);
 
-    // find chunk with appropriate size
-    for (auto &c : chunks)
+    curFrameUsage += alignedSize;
+    highWaterMark = std::max(highWaterMark, curFrameUsage);
+    maxAllocationSize = std::max(maxAllocationSize, alignedSize);
+
+    if (ring && ring->IsInitted())
     {
-        if (alignedSize < c.buffer.GetSize() - c.currentOffset)
+        const VkDeviceSize capacity = ring->GetSize();
+        const VkDeviceSize offset = head % capacity;
+
+        // allocation can't be split, so skip the end of the ring
+        const VkDeviceSize toSkip = offset + alignedSize > capacity ? capacity - offset : 0;
+
+        if (head + toSkip + alignedSize - tail <= capacity)
         {
-            VkDeviceAddress address = c.buffer.GetAddress() + c.currentOffset;
+            head += toSkip;
+
+            VkDeviceAddress address = ring->GetAddress() + head % capacity;
+            head += alignedSize;
 
-            c.currentOffset += alignedSize;
             return address;
         }
     }
 
-    // couldn't find chunk, create new one
-    AddChunk(std::max(SCRATCH_CHUNK_BUFFER_SIZE, alignedSize));
-    return chunks.back().buffer.GetAddress();
+    // ring is full, allocate a temporary buffer;
+    // the ring will be grown on the next frame start
+    overflowCount++;
+
+    auto &overflow = toDestroy[curFrameIndex];
+    overflow.push_back(CreateBuffer(std::max(SCRATCH_SIZE_GRANULARITY, alignedSize)));
+
+    return overflow.back()->GetAddress();
+}
+
+void ScratchBuffer::BeginFrame(uint32_t frameIndex)
+{
+    static_assert(MAX_FRAMES_IN_FLIGHT == 2, "Scratch ring tail must be the start of the oldest frame in flight");
+    assert(frameIndex < MAX_FRAMES_IN_FLIGHT);
+
+    // the previous frame with the same index was finished
+    toDestroy[frameIndex].clear();
+
+    curFrameIndex = frameIndex;
+    curFrameUsage = 0;
+
+    // the oldest frame that can be still in flight
+    tail = frameStart[(frameIndex + 1) % MAX_FRAMES_IN_FLIGHT];
+    frameStart[frameIndex] = head;
+
+    GrowIfNeeded();
 }
 
 void ScratchBuffer::Reset()
 {
-    for (auto &c : chunks)
+    for (auto &d : toDestroy)
     {
-        c.currentOffset = 0;
+        d.clear();
     }
+
+    head = tail = 0;
+    std::fill(std::begin(frameStart), std::end(frameStart), 0);
+    curFrameUsage = 0;
+
+    GrowIfNeeded();
 }
 
-void ScratchBuffer::AddChunk(VkDeviceSize size)
+void ScratchBuffer::GrowIfNeeded()
 {
-    if (const auto allc = allocator.lock())
+    // every frame in flight should fit, and one more allocation
+    // for the space skipped at the end of the ring
+    const VkDeviceSize required = highWaterMark * MAX_FRAMES_IN_FLIGHT + maxAllocationSize;
+
+    if (ring && ring->IsInitted() && ring->GetSize() >= required)
     {
-        chunks.emplace_back();
-        auto &c = chunks.back();
+        return;
+    }
+
+    // old ring can be still in use by the frames in flight,
+    // they will be finished when the current frame index begins again
+    if (ring)
+    {
+        toDestroy[curFrameIndex].push_back(std::move(ring));
+    }
+
+    ring = CreateBuffer(Utils::Align(std::max(required, SCRATCH_INITIAL_SIZE), SCRATCH_SIZE_GRANULARITY));
+    growCount++;
+
+    head = tail = 0;
+    std::fill(std::begin(frameStart), std::end(frameStart), 0);
+}
+
+ScratchBuffer::Stats ScratchBuffer::GetStats() const
+{
+    return Stats
+    {
+        .capacity = ring ? ring->GetSize() : 0,
+        .currentFrameUsage = curFrameUsage,
+        .highWaterMark = highWaterMark,
+        .overflowCount = overflowCount,
+        .growCount = growCount,
+    };
+}
+
+std::unique_ptr<Buffer> ScratchBuffer::CreateBuffer(VkDeviceSize size) const
+{
+    auto b = std::make_unique<Buffer>();
 
-        c.buffer.Init(
+    if (const auto allc = allocator.lock())
+    {
+        b->Init(
             allc, size,
             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             "Scratch buffer");
     }
+
+    return b;
 }
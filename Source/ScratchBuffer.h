@@ -20,15 +20,33 @@
 
 #pragma once
 
-#include <list>
+#include <memory>
+#include <vector>
 
 #include "Buffer.h"
 
 namespace RTGL1
 {
 
+// Ring allocator for acceleration structure build scratch memory.
+// Each frame allocates right after the previous one, and the memory
+// of a frame is recycled when the same frame index begins again.
+// If the ring is full, a temporary buffer is allocated, and the ring
+// is grown to fit the observed high-water mark on the next frame start.
 class ScratchBuffer
 {
+public:
+    struct Stats
+    {
+        VkDeviceSize    capacity;
+        VkDeviceSize    currentFrameUsage;
+        // max scratch memory that was requested during one frame
+        VkDeviceSize    highWaterMark;
+        // count of allocations that didn't fit into the ring
+        uint32_t        overflowCount;
+        uint32_t        growCount;
+    };
+
 public:
     explicit ScratchBuffer(std::shared_ptr<MemoryAllocator> allocator, uint32_t alignment = 1);
 
@@ -39,21 +57,37 @@ public:
 
     // get scratch buffer address
     VkDeviceAddress GetScratchAddress(VkDeviceSize scratchSize);
+    // Frame with the same index must be finished on GPU,
+    // its scratch memory is recycled.
+    void BeginFrame(uint32_t frameIndex);
+    // All scratch memory must not be in use on GPU.
     void Reset();
 
-private:
-    void AddChunk(VkDeviceSize size);
+    Stats GetStats() const;
 
 private:
-    struct ChunkBuffer
-    {
-        Buffer buffer;
-        uint32_t currentOffset = 0;
-    };
+    std::unique_ptr<Buffer> CreateBuffer(VkDeviceSize size) const;
+    void GrowIfNeeded();
 
+private:
     std::weak_ptr<MemoryAllocator> allocator;
-    std::list<ChunkBuffer> chunks;
     uint32_t alignment = 1;
+
+    std::unique_ptr<Buffer> ring;
+    // monotonically increasing offsets, the actual offset is (offset % capacity)
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+    VkDeviceSize frameStart[MAX_FRAMES_IN_FLIGHT] = {};
+    uint32_t curFrameIndex = 0;
+
+    // overflow buffers and previous rings, that can be still used by a frame
+    std::vector<std::unique_ptr<Buffer>> toDestroy[MAX_FRAMES_IN_FLIGHT];
+
+    VkDeviceSize curFrameUsage = 0;
+    VkDeviceSize maxAllocationSize = 0;
+    VkDeviceSize highWaterMark = 0;
+    uint32_t overflowCount = 0;
+    uint32_t growCount = 0;
 };
 
-}
\ No newline at end of file
+}
@@ -93,10 +93,11 @@ vec4 getTextureSampleGrad(uint textureIndex, const vec2 texCoord, const vec2 dPd
 
 
 // instanceID is assumed to be < 256 (i.e. 8 bits ) and 
-// instanceCustomIndexEXT is 24 bits by Vulkan spec
+// instanceCustomIndexEXT is 24 bits by Vulkan spec;
+// instanceID of mesh instances can be larger, but it's not used for them
 uint packInstanceIdAndCustomIndex(int instanceID, int instanceCustomIndexEXT)
 {
-    return (instanceID << 24) | instanceCustomIndexEXT;
+    return ((instanceID & 0xFF) << 24) | instanceCustomIndexEXT;
 }
 
 ivec2 unpackInstanceIdAndCustomIndex(uint instanceIdAndIndex)
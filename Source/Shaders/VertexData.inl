@@ -31,6 +31,18 @@ layout(
     ShVertex g_staticVertices[];
 };
 
+// same buffer, but with ShVertexCompact layout, see globalUniform.vertexFormatCompact
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_VERTEX_BUFFER_STATIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer VertexBufferStaticCompact_BT
+{
+    ShVertexCompact g_staticVerticesCompact[];
+};
+
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_VERTEX_BUFFER_DYNAMIC)
@@ -42,6 +54,17 @@ layout(
     ShVertex g_dynamicVertices[];
 };
 
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_VERTEX_BUFFER_DYNAMIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer VertexBufferDynamicCompact_BT
+{
+    ShVertexCompact g_dynamicVerticesCompact[];
+};
+
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_INDEX_BUFFER_STATIC)
@@ -89,6 +112,17 @@ layout(
     ShVertex g_dynamicVertices_Prev[];
 };
 
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_PREV_POSITIONS_BUFFER_DYNAMIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer PrevPositionsBufferDynamicCompact_BT
+{
+    ShVertexCompact g_dynamicVerticesCompact_Prev[];
+};
+
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_PREV_INDEX_BUFFER_DYNAMIC)
@@ -100,38 +134,185 @@ layout(
     uint prevDynamicIndices[];
 };
 
+bool isVertexFormatCompact()
+{
+    return globalUniform.vertexFormatCompact != 0;
+}
+
+// Octahedral mapping of a unit vector, 2x snorm16
+uint encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+
+    vec2 e = n.xy;
+
+    if (n.z < 0.0)
+    {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return packSnorm2x16(e);
+}
+
+vec3 decodeOctahedral(uint encoded)
+{
+    const vec2 e = unpackSnorm2x16(encoded);
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(n);
+}
+
+ShVertex decodeVertexCompact(const ShVertexCompact c)
+{
+    ShVertex v;
+
+    v.position          = vec4(c.position[0], c.position[1], c.position[2], 0.0);
+    v.normal            = vec4(decodeOctahedral(c.normal), 0.0);
+    v.texCoord          = unpackHalf2x16(c.texCoord);
+    v.texCoordLayer1    = unpackHalf2x16(c.texCoordLayer1);
+    v.texCoordLayer2    = unpackHalf2x16(c.texCoordLayer2);
+    v.packedColor       = c.packedColor;
+    v.__pad0            = 0;
+
+    return v;
+}
+
+ShVertex getStaticVertex(uint index)
+{
+    if (isVertexFormatCompact())
+    {
+        return decodeVertexCompact(g_staticVerticesCompact[index]);
+    }
+
+    return g_staticVertices[index];
+}
+
+ShVertex getDynamicVertex(uint index)
+{
+    if (isVertexFormatCompact())
+    {
+        return decodeVertexCompact(g_dynamicVerticesCompact[index]);
+    }
+
+    return g_dynamicVertices[index];
+}
+
 vec3 getStaticVerticesPositions(uint index)
 {
+    if (isVertexFormatCompact())
+    {
+        const ShVertexCompact c = g_staticVerticesCompact[index];
+        return vec3(c.position[0], c.position[1], c.position[2]);
+    }
+
     return g_staticVertices[index].position.xyz;
 }
 
 vec3 getStaticVerticesNormals(uint index)
 {
+    if (isVertexFormatCompact())
+    {
+        return decodeOctahedral(g_staticVerticesCompact[index].normal);
+    }
+
     return g_staticVertices[index].normal.xyz;
 }
 
 vec3 getDynamicVerticesPositions(uint index)
 {
+    if (isVertexFormatCompact())
+    {
+        const ShVertexCompact c = g_dynamicVerticesCompact[index];
+        return vec3(c.position[0], c.position[1], c.position[2]);
+    }
+
     return g_dynamicVertices[index].position.xyz;
 }
 
 vec3 getDynamicVerticesNormals(uint index)
 {
+    if (isVertexFormatCompact())
+    {
+        return decodeOctahedral(g_dynamicVerticesCompact[index].normal);
+    }
+
     return g_dynamicVertices[index].normal.xyz;
 }
 
 #ifdef VERTEX_BUFFER_WRITEABLE
 void setStaticVerticesNormals(uint index, vec3 value)
 {
+    if (isVertexFormatCompact())
+    {
+        g_staticVerticesCompact[index].normal = encodeOctahedral(value);
+        return;
+    }
+
     g_staticVertices[index].normal = vec4(value, 0.0);
 }
 
 void setDynamicVerticesNormals(uint index, vec3 value)
 {
+    if (isVertexFormatCompact())
+    {
+        g_dynamicVerticesCompact[index].normal = encodeOctahedral(value);
+        return;
+    }
+
     g_dynamicVertices[index].normal = vec4(value, 0.0);
 }
 #endif // VERTEX_BUFFER_WRITEABLE
 
+// 16-bit indices are packed in pairs, and their base index
+// is in 16-bit units from the start of the index buffer
+bool isIndex16Bit(uint baseIndexIndex)
+{
+    return (baseIndexIndex & GEOM_INST_INDEX_16_BIT_FLAG) != 0;
+}
+
+uint unpackIndex16(uint packedPair, uint index16)
+{
+    return (packedPair >> ((index16 & 1) * 16)) & 0xFFFF;
+}
+
+uint getStaticIndex(uint baseIndexIndex, uint i)
+{
+    if (isIndex16Bit(baseIndexIndex))
+    {
+        const uint index16 = (baseIndexIndex & ~GEOM_INST_INDEX_16_BIT_FLAG) + i;
+        return unpackIndex16(staticIndices[index16 >> 1], index16);
+    }
+
+    return staticIndices[baseIndexIndex + i];
+}
+
+uint getDynamicIndex(uint baseIndexIndex, uint i)
+{
+    if (isIndex16Bit(baseIndexIndex))
+    {
+        const uint index16 = (baseIndexIndex & ~GEOM_INST_INDEX_16_BIT_FLAG) + i;
+        return unpackIndex16(dynamicIndices[index16 >> 1], index16);
+    }
+
+    return dynamicIndices[baseIndexIndex + i];
+}
+
+uint getPrevDynamicIndex(uint prevBaseIndexIndex, uint i)
+{
+    if (isIndex16Bit(prevBaseIndexIndex))
+    {
+        const uint index16 = (prevBaseIndexIndex & ~GEOM_INST_INDEX_16_BIT_FLAG) + i;
+        return unpackIndex16(prevDynamicIndices[index16 >> 1], index16);
+    }
+
+    return prevDynamicIndices[prevBaseIndexIndex + i];
+}
+
 // Get indices in vertex buffer. If geom uses index buffer then it flattens them to vertex buffer indices.
 uvec3 getVertIndicesStatic(uint baseVertexIndex, uint baseIndexIndex, uint primitiveId)
 {
@@ -139,9 +320,9 @@ uvec3 getVertIndicesStatic(uint baseVertexIndex, uint baseIndexIndex, uint primi
     if (baseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 0],
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 1],
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 2]);
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 0),
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 1),
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 2));
     }
     else
     {
@@ -158,9 +339,9 @@ uvec3 getVertIndicesDynamic(uint baseVertexIndex, uint baseIndexIndex, uint prim
     if (baseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 0],
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 1],
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 2]);
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 0),
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 1),
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 2));
     }
     else
     {
@@ -178,9 +359,9 @@ uvec3 getPrevVertIndicesDynamic(uint prevBaseVertexIndex, uint prevBaseIndexInde
     if (prevBaseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 0],
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 1],
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 2]);
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 0),
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 1),
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 2));
     }
     else
     {
@@ -193,6 +374,12 @@ uvec3 getPrevVertIndicesDynamic(uint prevBaseVertexIndex, uint prevBaseIndexInde
 
 vec3 getPrevDynamicVerticesPositions(uint index)
 {
+    if (isVertexFormatCompact())
+    {
+        const ShVertexCompact c = g_dynamicVerticesCompact_Prev[index];
+        return vec3(c.position[0], c.position[1], c.position[2]);
+    }
+
     return g_dynamicVertices_Prev[index].position.xyz;
 }
 
@@ -256,15 +443,23 @@ ShTriangle makeTriangle(const ShVertex a, const ShVertex b, const ShVertex c)
 }
 
 // Get geometry index in "geometryInstances" array by instanceID, localGeometryIndex.
-int getGeometryIndex(int instanceID, int localGeometryIndex)
+// Mesh instances have their own geometry index in the custom index, as their count is not limited.
+int getGeometryIndex(int instanceID, int instanceCustomIndex, int localGeometryIndex)
 {
+    if ((instanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE) != 0)
+    {
+        return (instanceCustomIndex >> INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET) + localGeometryIndex;
+    }
+
     return globalUniform.instanceGeomInfoOffset[instanceID / 4][instanceID % 4] + localGeometryIndex;
 }
 
-bool getCurrentGeometryIndexByPrev(int prevInstanceID, int prevLocalGeometryIndex, out int curFrameGlobalGeomIndex)
+bool getCurrentGeometryIndexByPrev(int prevInstanceID, int prevInstanceCustomIndex, int prevLocalGeometryIndex, out int curFrameGlobalGeomIndex)
 {
     // get previous frame's global geom index
-    const int prevFrameGeomIndex = globalUniform.instanceGeomInfoOffsetPrev[prevInstanceID / 4][prevInstanceID % 4] + prevLocalGeometryIndex;
+    const int prevFrameGeomIndex = (prevInstanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_MESH_INSTANCE) != 0 ?
+        (prevInstanceCustomIndex >> INSTANCE_CUSTOM_INDEX_GEOM_INDEX_BIT_OFFSET) + prevLocalGeometryIndex :
+        globalUniform.instanceGeomInfoOffsetPrev[prevInstanceID / 4][prevInstanceID % 4] + prevLocalGeometryIndex;
     
     // try to find global geom index in current frame by it
     curFrameGlobalGeomIndex = geomIndexPrevToCur[prevFrameGeomIndex];
@@ -291,7 +486,7 @@ ShTriangle getTriangle(int instanceID, int instanceCustomIndex, int localGeometr
     ShTriangle tr;
 
     // get info about geometry by the index in pGeometries in BLAS with index "instanceID"
-    const int globalGeometryIndex = getGeometryIndex(instanceID, localGeometryIndex);
+    const int globalGeometryIndex = getGeometryIndex(instanceID, instanceCustomIndex, localGeometryIndex);
     const ShGeometryInstance inst = geometryInstances[globalGeometryIndex];
 
     const bool isDynamic = (instanceCustomIndex & INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC) == INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC;
@@ -302,9 +497,9 @@ ShTriangle getTriangle(int instanceID, int instanceCustomIndex, int localGeometr
             const uvec3 vertIndices = getVertIndicesDynamic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
 
             tr = makeTriangle(
-                g_dynamicVertices[vertIndices[0]],
-                g_dynamicVertices[vertIndices[1]],
-                g_dynamicVertices[vertIndices[2]]);
+                getDynamicVertex(vertIndices[0]),
+                getDynamicVertex(vertIndices[1]),
+                getDynamicVertex(vertIndices[2]));
         }
 
         // to world space
@@ -343,9 +538,9 @@ ShTriangle getTriangle(int instanceID, int instanceCustomIndex, int localGeometr
             const uvec3 vertIndices = getVertIndicesStatic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
         
             tr = makeTriangle(
-                g_staticVertices[vertIndices[0]],
-                g_staticVertices[vertIndices[1]],
-                g_staticVertices[vertIndices[2]]);
+                getStaticVertex(vertIndices[0]),
+                getStaticVertex(vertIndices[1]),
+                getStaticVertex(vertIndices[2]));
         }
 
         const vec4 prevLocalPos[] =
@@ -556,7 +751,7 @@ bool unpackPrevVisibilityBuffer(const vec4 v, out vec3 prevPos)
     unpackGeometryAndPrimitiveIndex(floatBitsToUint(v[1]), prevLocalGeomIndex, primIndex);
 
     int curFrameGlobalGeomIndex;
-    const bool matched = getCurrentGeometryIndexByPrev(prevInstanceID, prevLocalGeomIndex, curFrameGlobalGeomIndex);
+    const bool matched = getCurrentGeometryIndexByPrev(prevInstanceID, instCustomIndex, prevLocalGeomIndex, curFrameGlobalGeomIndex);
 
     if (!matched)
     {
@@ -571,9 +766,9 @@ bool unpackPrevVisibilityBuffer(const vec4 v, out vec3 prevPos)
     return true;
 }
 
-mat4 getModelMatrix(int instanceID, int localGeometryIndex)
+mat4 getModelMatrix(int instanceID, int instanceCustomIndex, int localGeometryIndex)
 {
-    int globalGeometryIndex = getGeometryIndex(instanceID, localGeometryIndex);
+    int globalGeometryIndex = getGeometryIndex(instanceID, instanceCustomIndex, localGeometryIndex);
     return geometryInstances[globalGeometryIndex].model;
 }
 #endif // DESC_SET_VERTEX_DATA
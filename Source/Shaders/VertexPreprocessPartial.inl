@@ -24,14 +24,14 @@
     #define GET_POSITIONS getDynamicVerticesPositions
     #define GET_NORMALS getDynamicVerticesNormals
     #define SET_NORMALS setDynamicVerticesNormals
-    #define INDICES dynamicIndices
+    #define GET_INDEX getDynamicIndex
 
 #elif defined(VERTEX_PREPROCESS_PARTIAL_STATIC_ALL) || defined(VERTEX_PREPROCESS_PARTIAL_STATIC_MOVABLE)
 
     #define GET_POSITIONS getStaticVerticesPositions
     #define GET_NORMALS getStaticVerticesNormals
     #define SET_NORMALS setStaticVerticesNormals
-    #define INDICES staticIndices
+    #define GET_INDEX getStaticIndex
 
 #else
     #error
@@ -71,12 +71,12 @@ for (uint localGeomIndex = gl_LocalInvocationID.x; localGeomIndex < geomCount; l
     {
         for (uint tri = 0; tri < inst.indexCount / 3; tri++)
         {
-            const uint i = inst.baseIndexIndex + tri * 3;
+            const uint i = tri * 3;
 
             const uvec3 vertexIndices = uvec3(
-                inst.baseVertexIndex + INDICES[i + 0],
-                inst.baseVertexIndex + INDICES[i + 1],
-                inst.baseVertexIndex + INDICES[i + 2]);
+                inst.baseVertexIndex + GET_INDEX(inst.baseIndexIndex, i + 0),
+                inst.baseVertexIndex + GET_INDEX(inst.baseIndexIndex, i + 1),
+                inst.baseVertexIndex + GET_INDEX(inst.baseIndexIndex, i + 2));
 
             const vec3 localPos[] = 
             {
@@ -133,7 +133,7 @@ for (uint localGeomIndex = gl_LocalInvocationID.x; localGeomIndex < geomCount; l
 #undef GET_POSITIONS
 #undef GET_NORMALS
 #undef SET_NORMALS
-#undef INDICES
+#undef GET_INDEX
 
 #undef VERTEX_PREPROCESS_PARTIAL_STATIC_ALL
 #undef VERTEX_PREPROCESS_PARTIAL_STATIC_MOVABLE
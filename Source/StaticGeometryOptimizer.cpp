@@ -0,0 +1,637 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "StaticGeometryOptimizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+using namespace RTGL1;
+
+namespace
+{
+
+// geometries with less or equal amount of triangles can be merged
+constexpr uint32_t MERGE_MAX_TRIANGLE_COUNT = 64;
+// if geometry has less vertices, 16-bit indices are used for it
+constexpr uint32_t MAX_INDEX16_VERTEX_COUNT = UINT16_MAX + 1;
+
+// padding of RgVertex can contain garbage, so only attributes are compared
+bool AreVerticesEqual(const RgVertex &a, const RgVertex &b)
+{
+    return
+        memcmp(a.position, b.position, sizeof(a.position)) == 0 &&
+        memcmp(a.normal, b.normal, sizeof(a.normal)) == 0 &&
+        memcmp(a.texCoord, b.texCoord, sizeof(a.texCoord)) == 0 &&
+        memcmp(a.texCoordLayer1, b.texCoordLayer1, sizeof(a.texCoordLayer1)) == 0 &&
+        memcmp(a.texCoordLayer2, b.texCoordLayer2, sizeof(a.texCoordLayer2)) == 0 &&
+        a.packedColor == b.packedColor;
+}
+
+struct VertexHash
+{
+    size_t operator()(const RgVertex *v) const
+    {
+        // FNV-1a
+        uint64_t h = 14695981039346656037ull;
+
+        auto add = [&h] (const void *data, size_t size)
+        {
+            auto bytes = static_cast<const uint8_t *>(data);
+
+            for (size_t i = 0; i < size; i++)
+            {
+                h = (h ^ bytes[i]) * 1099511628211ull;
+            }
+        };
+
+        add(v->position, sizeof(v->position));
+        add(v->normal, sizeof(v->normal));
+        add(v->texCoord, sizeof(v->texCoord));
+        add(v->texCoordLayer1, sizeof(v->texCoordLayer1));
+        add(v->texCoordLayer2, sizeof(v->texCoordLayer2));
+        add(&v->packedColor, sizeof(v->packedColor));
+
+        return static_cast<size_t>(h);
+    }
+};
+
+struct VertexEqual
+{
+    bool operator()(const RgVertex *a, const RgVertex *b) const
+    {
+        return AreVerticesEqual(*a, *b);
+    }
+};
+
+bool IsDegenerate(const RgVertex &a, const RgVertex &b, const RgVertex &c)
+{
+    float e1[3], e2[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        e1[i] = b.position[i] - a.position[i];
+        e2[i] = c.position[i] - a.position[i];
+    }
+
+    return
+        e1[1] * e2[2] - e1[2] * e2[1] == 0.0f &&
+        e1[2] * e2[0] - e1[0] * e2[2] == 0.0f &&
+        e1[0] * e2[1] - e1[1] * e2[0] == 0.0f;
+}
+
+// All the values that define a material of geometry, the geometries with
+// equal keys can be merged. All members are 4 bytes, so there's no padding.
+struct MergeKey
+{
+    RgGeometryUploadFlags           flags;
+    RgGeometryPassThroughType       passThroughType;
+    RgGeometryPrimaryVisibilityType visibilityType;
+    RgFloat4D                       layerColors[3];
+    RgGeometryMaterialBlendType     layerBlendingTypes[3];
+    float                           defaultRoughness;
+    float                           defaultMetallicity;
+    float                           defaultEmission;
+    RgLayeredMaterial               geomMaterial;
+
+    explicit MergeKey(const RgGeometryUploadInfo &info)
+    {
+        memset(this, 0, sizeof(MergeKey));
+
+        flags = info.flags;
+        passThroughType = info.passThroughType;
+        visibilityType = info.visibilityType;
+        memcpy(layerColors, info.layerColors, sizeof(layerColors));
+        memcpy(layerBlendingTypes, info.layerBlendingTypes, sizeof(layerBlendingTypes));
+        defaultRoughness = info.defaultRoughness;
+        defaultMetallicity = info.defaultMetallicity;
+        defaultEmission = info.defaultEmission;
+        geomMaterial = info.geomMaterial;
+    }
+
+    bool operator<(const MergeKey &other) const
+    {
+        return memcmp(this, &other, sizeof(MergeKey)) < 0;
+    }
+
+    bool operator==(const MergeKey &other) const
+    {
+        return memcmp(this, &other, sizeof(MergeKey)) == 0;
+    }
+};
+
+float GetDeterminant(const RgTransform &t)
+{
+    const auto &m = t.matrix;
+
+    return
+        m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+        m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+        m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+void BakeTransform(const RgTransform &t, std::span<RgVertex> vertices)
+{
+    const auto &m = t.matrix;
+
+    // cofactor matrix, it's the inverse transpose multiplied by the determinant,
+    // which is positive for the merged geometries, so normalization is enough
+    const float n[3][3] =
+    {
+        { m[1][1] * m[2][2] - m[1][2] * m[2][1], m[1][2] * m[2][0] - m[1][0] * m[2][2], m[1][0] * m[2][1] - m[1][1] * m[2][0] },
+        { m[0][2] * m[2][1] - m[0][1] * m[2][2], m[0][0] * m[2][2] - m[0][2] * m[2][0], m[0][1] * m[2][0] - m[0][0] * m[2][1] },
+        { m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] },
+    };
+
+    for (RgVertex &v : vertices)
+    {
+        float p[3], nrm[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            p[i] = m[i][0] * v.position[0] + m[i][1] * v.position[1] + m[i][2] * v.position[2] + m[i][3];
+            nrm[i] = n[i][0] * v.normal[0] + n[i][1] * v.normal[1] + n[i][2] * v.normal[2];
+        }
+
+        const float len = std::sqrt(nrm[0] * nrm[0] + nrm[1] * nrm[1] + nrm[2] * nrm[2]);
+
+        for (int i = 0; i < 3; i++)
+        {
+            v.position[i] = p[i];
+            v.normal[i] = len > 0.0f ? nrm[i] / len : 0.0f;
+        }
+    }
+}
+
+void AddStats(StaticGeometryOptimizer::Stats &dst, const StaticGeometryOptimizer::Stats &src)
+{
+    dst.inputVertexCount += src.inputVertexCount;
+    dst.outputVertexCount += src.outputVertexCount;
+    dst.inputTriangleCount += src.inputTriangleCount;
+    dst.outputTriangleCount += src.outputTriangleCount;
+    dst.weldedVertexCount += src.weldedVertexCount;
+    dst.degenerateTriangleCount += src.degenerateTriangleCount;
+}
+
+}
+
+struct StaticGeometryOptimizer::Geometry
+{
+    // pointers of "info" point to the members below
+    RgGeometryUploadInfo    info;
+    std::vector<RgVertex>   vertices;
+    std::vector<uint32_t>   indices;
+    std::vector<uint16_t>   indices16;
+    uint8_t                 portalIndex;
+
+    std::vector<uint64_t>   uniqueIDs;
+    // true, if the geometry was merged into another one
+    bool                    isMergedInto;
+
+    uint32_t GetIndexCount() const
+    {
+        return !indices.empty() ? static_cast<uint32_t>(indices.size()) :
+               !indices16.empty() ? static_cast<uint32_t>(indices16.size()) :
+                                    static_cast<uint32_t>(vertices.size());
+    }
+
+    uint32_t GetIndex(uint32_t i) const
+    {
+        return !indices.empty() ? indices[i] :
+               !indices16.empty() ? indices16[i] :
+                                    i;
+    }
+
+    void SetData(std::vector<RgVertex> &&newVertices, std::vector<uint32_t> &&newIndices)
+    {
+        vertices = std::move(newVertices);
+        indices.clear();
+        indices16.clear();
+
+        if (vertices.size() <= MAX_INDEX16_VERTEX_COUNT)
+        {
+            indices16.assign(newIndices.begin(), newIndices.end());
+        }
+        else
+        {
+            indices = std::move(newIndices);
+        }
+
+        UpdatePointers();
+    }
+
+    void UpdatePointers()
+    {
+        info.vertexCount = static_cast<uint32_t>(vertices.size());
+        info.pVertices = vertices.data();
+        info.indexCount = static_cast<uint32_t>(std::max(indices.size(), indices16.size()));
+        info.pIndices = !indices.empty() ? indices.data() : nullptr;
+        info.pIndices16 = !indices16.empty() ? indices16.data() : nullptr;
+        info.pPortalIndex = info.pPortalIndex != nullptr ? &portalIndex : nullptr;
+    }
+};
+
+StaticGeometryOptimizer::StaticGeometryOptimizer(uint32_t _maxWorkerCount)
+:
+    maxWorkerCount(_maxWorkerCount > 0 ? _maxWorkerCount : std::max(1u, std::thread::hardware_concurrency())),
+    jobId(0),
+    busyWorkerCount(0),
+    stopWorkers(false),
+    stats{}
+{
+    // the current thread is one of the workers
+    workers.reserve(maxWorkerCount - 1);
+
+    for (uint32_t i = 1; i < maxWorkerCount; i++)
+    {
+        workers.emplace_back(&StaticGeometryOptimizer::WorkerLoop, this);
+    }
+}
+
+StaticGeometryOptimizer::~StaticGeometryOptimizer()
+{
+    {
+        std::lock_guard<std::mutex> lock(workersMutex);
+        stopWorkers = true;
+    }
+
+    workStarted.notify_all();
+
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+}
+
+void StaticGeometryOptimizer::WorkerLoop()
+{
+    uint64_t lastJobId = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(workersMutex);
+        workStarted.wait(lock, [this, lastJobId] { return stopWorkers || jobId != lastJobId; });
+
+        if (stopWorkers)
+        {
+            return;
+        }
+
+        lastJobId = jobId;
+
+        lock.unlock();
+        job();
+        lock.lock();
+
+        busyWorkerCount--;
+
+        if (busyWorkerCount == 0)
+        {
+            workFinished.notify_one();
+        }
+    }
+}
+
+void StaticGeometryOptimizer::RunOnWorkers(const std::function<void()> &f)
+{
+    {
+        std::lock_guard<std::mutex> lock(workersMutex);
+
+        job = f;
+        busyWorkerCount = static_cast<uint32_t>(workers.size());
+        jobId++;
+    }
+
+    workStarted.notify_all();
+
+    f();
+
+    std::unique_lock<std::mutex> lock(workersMutex);
+    workFinished.wait(lock, [this] { return busyWorkerCount == 0; });
+
+    job = nullptr;
+}
+
+void StaticGeometryOptimizer::Add(const RgGeometryUploadInfo &info)
+{
+    auto geom = std::make_unique<Geometry>();
+
+    geom->info = info;
+    geom->vertices.assign(info.pVertices, info.pVertices + info.vertexCount);
+
+    if (info.indexCount > 0 && info.pIndices != nullptr)
+    {
+        geom->indices.assign(info.pIndices, info.pIndices + info.indexCount);
+    }
+    else if (info.indexCount > 0 && info.pIndices16 != nullptr)
+    {
+        geom->indices16.assign(info.pIndices16, info.pIndices16 + info.indexCount);
+    }
+
+    geom->portalIndex = info.pPortalIndex != nullptr ? *info.pPortalIndex : 0;
+    geom->uniqueIDs.push_back(info.uniqueID);
+    geom->isMergedInto = false;
+    geom->UpdatePointers();
+
+    std::lock_guard<std::mutex> lock(geometriesMutex);
+
+    if (info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE)
+    {
+        movableGeometries[info.uniqueID] = geom.get();
+    }
+
+    geometries.push_back(std::move(geom));
+}
+
+bool StaticGeometryOptimizer::UpdateTransform(const RgUpdateTransformInfo &updateInfo)
+{
+    std::lock_guard<std::mutex> lock(geometriesMutex);
+
+    auto f = movableGeometries.find(updateInfo.movableStaticUniqueID);
+
+    if (f == movableGeometries.end())
+    {
+        return false;
+    }
+
+    f->second->info.transform = updateInfo.transform;
+    return true;
+}
+
+bool StaticGeometryOptimizer::IsMovableQueued(uint64_t uniqueID)
+{
+    std::lock_guard<std::mutex> lock(geometriesMutex);
+
+    return movableGeometries.find(uniqueID) != movableGeometries.end();
+}
+
+std::vector<StaticGeometryOptimizer::Result> StaticGeometryOptimizer::Optimize()
+{
+    std::lock_guard<std::mutex> lock(geometriesMutex);
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    stats = {};
+
+    // the result must not depend on the order of concurrent uploads
+    std::sort(geometries.begin(), geometries.end(), [] (const auto &a, const auto &b)
+    {
+        return a->info.uniqueID < b->info.uniqueID;
+    });
+
+    std::atomic<size_t> nextGeometry = 0;
+    std::mutex statsMutex;
+
+    // workers that have nothing to process return immediately
+    RunOnWorkers([this, &nextGeometry, &statsMutex] ()
+    {
+        Stats local = {};
+
+        for (size_t i = nextGeometry++; i < geometries.size(); i = nextGeometry++)
+        {
+            OptimizeGeometry(*geometries[i], local);
+        }
+
+        std::lock_guard<std::mutex> statsLock(statsMutex);
+        AddStats(stats, local);
+    });
+
+    MergeGeometries(stats);
+
+    std::vector<Result> results;
+    results.reserve(geometries.size());
+
+    for (const auto &geom : geometries)
+    {
+        if (!geom->isMergedInto)
+        {
+            results.push_back({ geom->info, geom->uniqueIDs });
+        }
+    }
+
+    stats.inputGeometryCount = static_cast<uint32_t>(geometries.size());
+    stats.outputGeometryCount = static_cast<uint32_t>(results.size());
+    stats.workerCount = std::clamp(static_cast<uint32_t>(geometries.size()), 1u, maxWorkerCount);
+    stats.durationMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+
+    return results;
+}
+
+bool StaticGeometryOptimizer::OptimizeGeometry(Geometry &geom, Stats &stats)
+{
+    const uint32_t vertexCount = static_cast<uint32_t>(geom.vertices.size());
+    const uint32_t indexCount = geom.GetIndexCount();
+
+    stats.inputVertexCount += vertexCount;
+    stats.inputTriangleCount += indexCount / 3;
+
+    auto leaveAsIs = [&stats, vertexCount, indexCount] ()
+    {
+        stats.outputVertexCount += vertexCount;
+        stats.outputTriangleCount += indexCount / 3;
+        return false;
+    };
+
+    // generated normals are written to the vertices of each triangle,
+    // so sharing vertices between triangles would change them
+    const bool weld = !(geom.info.flags & (RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT | RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT));
+
+    // index of the first equal vertex
+    std::vector<uint32_t> remap(vertexCount);
+    uint32_t weldedCount = 0;
+
+    if (weld)
+    {
+        std::unordered_map<const RgVertex *, uint32_t, VertexHash, VertexEqual> uniqueVertices;
+        uniqueVertices.reserve(vertexCount);
+
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            const auto [it, isNew] = uniqueVertices.emplace(&geom.vertices[i], i);
+
+            remap[i] = it->second;
+            weldedCount += isNew ? 0 : 1;
+        }
+    }
+    else
+    {
+        std::iota(remap.begin(), remap.end(), 0);
+    }
+
+    std::vector<uint32_t> newIndices;
+    newIndices.reserve(indexCount);
+    uint32_t degenerateCount = 0;
+
+    for (uint32_t t = 0; t + 2 < indexCount; t += 3)
+    {
+        const uint32_t i0 = geom.GetIndex(t), i1 = geom.GetIndex(t + 1), i2 = geom.GetIndex(t + 2);
+
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount)
+        {
+            return leaveAsIs();
+        }
+
+        const uint32_t a = remap[i0], b = remap[i1], c = remap[i2];
+
+        if (a == b || b == c || a == c || IsDegenerate(geom.vertices[a], geom.vertices[b], geom.vertices[c]))
+        {
+            degenerateCount++;
+            continue;
+        }
+
+        newIndices.push_back(a);
+        newIndices.push_back(b);
+        newIndices.push_back(c);
+    }
+
+    // keep the geometry, even if it's invisible, as its ID can be referenced
+    if (newIndices.empty())
+    {
+        return leaveAsIs();
+    }
+
+    // place vertices in the order of their first use, unused ones are removed
+    std::vector<uint32_t> newLocation(vertexCount, UINT32_MAX);
+    std::vector<RgVertex> newVertices;
+    newVertices.reserve(vertexCount - weldedCount);
+
+    for (uint32_t &i : newIndices)
+    {
+        if (newLocation[i] == UINT32_MAX)
+        {
+            newLocation[i] = static_cast<uint32_t>(newVertices.size());
+            newVertices.push_back(geom.vertices[i]);
+        }
+
+        i = newLocation[i];
+    }
+
+    stats.weldedVertexCount += weldedCount;
+    stats.degenerateTriangleCount += degenerateCount;
+    stats.outputVertexCount += static_cast<uint32_t>(newVertices.size());
+    stats.outputTriangleCount += static_cast<uint32_t>(newIndices.size() / 3);
+
+    geom.SetData(std::move(newVertices), std::move(newIndices));
+    return true;
+}
+
+void StaticGeometryOptimizer::MergeGeometries(Stats &stats)
+{
+    std::vector<std::pair<MergeKey, Geometry *>> candidates;
+
+    for (const auto &geom : geometries)
+    {
+        // movable geometries have their own transforms; mirroring transforms
+        // are not baked, as it would change the facing of triangles
+        if (geom->info.geomType == RG_GEOMETRY_TYPE_STATIC &&
+            geom->info.pPortalIndex == nullptr &&
+            geom->GetIndexCount() / 3 <= MERGE_MAX_TRIANGLE_COUNT &&
+            GetDeterminant(geom->info.transform) > 0.0f)
+        {
+            candidates.emplace_back(MergeKey(geom->info), geom.get());
+        }
+    }
+
+    // stable, so geometries are merged in the order of their IDs
+    std::stable_sort(candidates.begin(), candidates.end(), [] (const auto &a, const auto &b)
+    {
+        return a.first < b.first;
+    });
+
+    auto merge = [&stats] (std::span<const std::pair<MergeKey, Geometry *>> group)
+    {
+        if (group.size() < 2)
+        {
+            return;
+        }
+
+        Geometry &target = *group[0].second;
+
+        std::vector<RgVertex> vertices;
+        std::vector<uint32_t> indices;
+
+        for (const auto &[key, geom] : group)
+        {
+            const uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+
+            vertices.insert(vertices.end(), geom->vertices.begin(), geom->vertices.end());
+            BakeTransform(geom->info.transform, { vertices.begin() + baseVertex, vertices.end() });
+
+            for (uint32_t i = 0; i < geom->GetIndexCount(); i++)
+            {
+                indices.push_back(baseVertex + geom->GetIndex(i));
+            }
+
+            if (geom != &target)
+            {
+                target.uniqueIDs.push_back(geom->info.uniqueID);
+                geom->isMergedInto = true;
+            }
+        }
+
+        target.SetData(std::move(vertices), std::move(indices));
+        target.info.transform = { {
+            { 1, 0, 0, 0 },
+            { 0, 1, 0, 0 },
+            { 0, 0, 1, 0 },
+        } };
+
+        stats.mergedGeometryCount += static_cast<uint32_t>(group.size() - 1);
+    };
+
+    size_t groupStart = 0;
+    uint32_t groupVertexCount = 0;
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        const uint32_t vertexCount = static_cast<uint32_t>(candidates[i].second->vertices.size());
+
+        // start a new group, if the material is different or merged geometry wouldn't fit 16-bit indices
+        if (!(candidates[i].first == candidates[groupStart].first) || groupVertexCount + vertexCount > MAX_INDEX16_VERTEX_COUNT)
+        {
+            merge(std::span(candidates).subspan(groupStart, i - groupStart));
+
+            groupStart = i;
+            groupVertexCount = 0;
+        }
+
+        groupVertexCount += vertexCount;
+    }
+
+    merge(std::span(candidates).subspan(groupStart));
+}
+
+void StaticGeometryOptimizer::Clear()
+{
+    std::lock_guard<std::mutex> lock(geometriesMutex);
+
+    geometries.clear();
+    movableGeometries.clear();
+}
+
+const StaticGeometryOptimizer::Stats &StaticGeometryOptimizer::GetStats() const
+{
+    return stats;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2020-2021 Sultim Tsyrendashiev
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "Containers.h"
+#include "RTGL1/RTGL1.h"
+
+namespace RTGL1
+{
+
+// Optional CPU pass over static geometry, it's done on rgSubmitStaticGeometries
+// before the geometry is added to the static vertex collector.
+// Each geometry is processed on a worker thread of a persistent pool: equal vertices are welded,
+// degenerate triangles are removed, and vertices are reordered by their first use in indices.
+// Then tiny non-movable geometries with the same material are merged into one,
+// with their transforms baked into the vertices.
+class StaticGeometryOptimizer
+{
+public:
+    struct Stats
+    {
+        uint32_t    inputGeometryCount;
+        uint32_t    outputGeometryCount;
+        uint32_t    inputVertexCount;
+        uint32_t    outputVertexCount;
+        uint32_t    inputTriangleCount;
+        uint32_t    outputTriangleCount;
+        uint32_t    weldedVertexCount;
+        uint32_t    degenerateTriangleCount;
+        uint32_t    mergedGeometryCount;
+        uint32_t    workerCount;
+        double      durationMs;
+    };
+
+    struct Result
+    {
+        RgGeometryUploadInfo    info;
+        // IDs of the queued geometries that are represented by "info",
+        // more than one, if they were merged; the first one is info.uniqueID
+        std::span<const uint64_t> uniqueIDs;
+    };
+
+public:
+    // If "maxWorkerCount" is 0, it's defined by the hardware concurrency
+    explicit StaticGeometryOptimizer(uint32_t maxWorkerCount = 0);
+    ~StaticGeometryOptimizer();
+
+    StaticGeometryOptimizer(const StaticGeometryOptimizer &other) = delete;
+    StaticGeometryOptimizer(StaticGeometryOptimizer &&other) noexcept = delete;
+    StaticGeometryOptimizer &operator=(const StaticGeometryOptimizer &other) = delete;
+    StaticGeometryOptimizer &operator=(StaticGeometryOptimizer &&other) noexcept = delete;
+
+    // Copy geometry data, so it can be processed later. Thread-safe.
+    void Add(const RgGeometryUploadInfo &info);
+    // Set transform of the queued movable geometry. Thread-safe.
+    // Returns false, if there's no such geometry.
+    bool UpdateTransform(const RgUpdateTransformInfo &updateInfo);
+    // Thread-safe. Returns true, if movable geometry with the ID is queued.
+    bool IsMovableQueued(uint64_t uniqueID);
+
+    // Process all queued geometries. Results are sorted by unique IDs
+    // and they're valid until Clear.
+    std::vector<Result> Optimize();
+    void Clear();
+
+    // Statistics of the last Optimize call
+    const Stats &GetStats() const;
+
+private:
+    struct Geometry;
+
+    // Returns false, if geometry was left as is
+    static bool OptimizeGeometry(Geometry &geom, Stats &stats);
+    // Merge tiny geometries that have the same material, merged ones are marked as "isMergedInto"
+    void MergeGeometries(Stats &stats);
+
+    // Call "f" on each worker and on the current thread, and wait until all of them return
+    void RunOnWorkers(const std::function<void()> &f);
+    void WorkerLoop();
+
+private:
+    uint32_t maxWorkerCount;
+
+    // created once, the thread that calls Optimize is one more worker
+    std::vector<std::thread> workers;
+    std::mutex workersMutex;
+    std::condition_variable workStarted;
+    std::condition_variable workFinished;
+    // job for the workers, it's started when jobId is incremented
+    std::function<void()> job;
+    uint64_t jobId;
+    uint32_t busyWorkerCount;
+    bool stopWorkers;
+
+    std::vector<std::unique_ptr<Geometry>> geometries;
+    // queued movable geometries by unique ID, as their transforms can be changed before the pass
+    rgl::unordered_map<uint64_t, Geometry *> movableGeometries;
+    std::mutex geometriesMutex;
+
+    Stats stats;
+};
+
+}
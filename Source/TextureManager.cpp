@@ -23,6 +23,7 @@
 #include <numeric>
 
 #include "Const.h"
+#include "CpuTrace.h"
 #include "Utils.h"
 #include "TextureOverrides.h"
 #include "Generated/ShaderCommonC.h"
@@ -229,6 +230,8 @@ void TextureManager::SubmitDescriptors(uint32_t frameIndex,
                                        const RgDrawFrameTexturesParams *pTexturesParams,
                                        bool forceUpdateAllDescriptors)
 {
+    RG_TRACE_SCOPE("TextureManager::SubmitDescriptors");
+
     // check if dynamic sampler filter was changed
     RgSamplerFilter newDynamicSamplerFilter = pTexturesParams != nullptr ?
         pTexturesParams->dynamicSamplerFilter : DefaultDynamicSamplerFilter;
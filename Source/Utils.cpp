@@ -20,7 +20,9 @@
 
 #include "Utils.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace RTGL1;
 
@@ -311,6 +313,118 @@ uint32_t RTGL1::Utils::GetPreviousByModulo(uint32_t value, uint32_t count)
     return (value + (count - 1)) % count;
 }
 
+uint64_t RTGL1::Utils::HashBytes(const void *data, size_t size, uint64_t seed)
+{
+    constexpr uint64_t mul = 0x9E3779B97F4A7C15ull;
+
+    const auto *p = static_cast<const uint8_t *>(data);
+
+    // 4 independent lanes, so multiplications are not serialized
+    uint64_t lanes[4] = { seed ^ size, seed + mul, seed ^ (mul >> 1), seed - mul };
+
+    for (; size >= sizeof(lanes); size -= sizeof(lanes), p += sizeof(lanes))
+    {
+        uint64_t w[4];
+        memcpy(w, p, sizeof(w));
+
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            lanes[i] = (lanes[i] ^ w[i]) * mul;
+            lanes[i] ^= lanes[i] >> 29;
+        }
+    }
+
+    uint64_t tail[4] = {};
+    memcpy(tail, p, size);
+
+    uint64_t h = 0;
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        h = HashCombine(h, (lanes[i] ^ tail[i]) * mul);
+    }
+
+    return h;
+}
+
+uint64_t RTGL1::Utils::HashCombine(uint64_t seed, uint64_t value)
+{
+    seed ^= value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+static uint32_t FloatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    const uint32_t sign = (x >> 16) & 0x8000;
+    const uint32_t mant = x & 0x7FFFFF;
+    const int32_t exp = int32_t((x >> 23) & 0xFF) - 127 + 15;
+
+    // infinity, NaN or too large
+    if (exp >= 31)
+    {
+        const bool isNaN = ((x >> 23) & 0xFF) == 0xFF && mant != 0;
+        return sign | 0x7C00 | (isNaN ? 0x200 : 0);
+    }
+
+    // too small, flush to zero
+    if (exp < -10)
+    {
+        return sign;
+    }
+
+    // denormalized
+    if (exp <= 0)
+    {
+        const uint32_t m = mant | 0x800000;
+        const uint32_t shift = uint32_t(14 - exp);
+
+        // round to nearest
+        return sign | ((m >> shift) + ((m >> (shift - 1)) & 1));
+    }
+
+    // round to nearest, carry can go to the exponent
+    return (sign | (uint32_t(exp) << 10) | (mant >> 13)) + ((mant >> 12) & 1);
+}
+
+uint32_t RTGL1::Utils::PackHalf2x16(float x, float y)
+{
+    return FloatToHalf(x) | (FloatToHalf(y) << 16);
+}
+
+uint32_t RTGL1::Utils::EncodeOctahedral(const float v[3])
+{
+    const float l1 = std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+
+    if (l1 <= 0.0f)
+    {
+        return 0;
+    }
+
+    float x = v[0] / l1;
+    float y = v[1] / l1;
+
+    // fold the lower hemisphere
+    if (v[2] < 0.0f)
+    {
+        const float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+        x = fx;
+        y = fy;
+    }
+
+    const auto toSnorm16 = [] (float f)
+    {
+        const float c = std::round(std::clamp(f, -1.0f, 1.0f) * 32767.0f);
+        return uint32_t(uint16_t(int16_t(c)));
+    };
+
+    return toSnorm16(x) | (toSnorm16(y) << 16);
+}
+
 uint32_t RTGL1::Utils::GetWorkGroupCount(float size, uint32_t groupSize)
 {
     return GetWorkGroupCount((uint32_t)std::ceil(size), groupSize);
@@ -121,6 +121,15 @@ namespace Utils
     void SetMatrix3ToGLSLMat4(float dst[16], const RgMatrix3D &src);
 
     uint32_t GetPreviousByModulo(uint32_t value, uint32_t count);
+
+    // Fast non-cryptographic hash, e.g. to detect that geometry data wasn't changed
+    uint64_t HashBytes(const void *data, size_t size, uint64_t seed = 0);
+    uint64_t HashCombine(uint64_t seed, uint64_t value);
+
+    // Same as GLSL's packHalf2x16
+    uint32_t PackHalf2x16(float x, float y);
+    // Octahedral mapping of a vector to 2x snorm16, zero vector is mapped to zero
+    uint32_t EncodeOctahedral(const float v[3]);
     
     uint32_t GetWorkGroupCount(float size, uint32_t groupSize);
     uint32_t GetWorkGroupCount(uint32_t size, uint32_t groupSize);
@@ -19,3 +19,37 @@
 // SOFTWARE.
 
 #pragma once
+
+#include "Common.h"
+#include "Generated/ShaderCommonC.h"
+
+namespace RTGL1
+{
+
+// Layout of the vertices in the buffers of ray traced geometry
+enum class VertexBufferFormat
+{
+    // ShVertex, same as RgVertex
+    Full,
+    // ShVertexCompact: octahedral normals and half-float texture coordinates,
+    // positions are in full precision, as they're used in AS builds
+    Compact,
+};
+
+// Initial sizes of the vertex and index buffers, if they're not specified in RgInstanceCreateInfo,
+// the buffers grow on demand
+constexpr uint32_t DEFAULT_STATIC_VERTEX_COUNT = 1 << 18;
+constexpr uint32_t DEFAULT_DYNAMIC_VERTEX_COUNT = 1 << 16;
+constexpr uint32_t DEFAULT_INDEX_COUNT = 1 << 18;
+// Sizes of the static chunk regions, if they're not specified in RgInstanceCreateInfo
+constexpr uint32_t DEFAULT_STATIC_CHUNK_VERTEX_COUNT = 1 << 16;
+constexpr uint32_t DEFAULT_STATIC_CHUNK_INDEX_COUNT = 3 << 16;
+// Initial size of the transforms buffer, it grows up to the limit of geometries
+constexpr uint32_t INITIAL_TRANSFORM_COUNT = 256;
+
+inline VkDeviceSize GetVertexStride(VertexBufferFormat format)
+{
+    return format == VertexBufferFormat::Compact ? sizeof(ShVertexCompact) : sizeof(ShVertex);
+}
+
+}
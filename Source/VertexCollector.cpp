@@ -23,23 +23,149 @@
 #include <algorithm>
 #include <array>
 #include <cstring>
+#include <thread>
 
 #include "Generated/ShaderCommonC.h"
 #include "Matrix.h"
+#include "RgException.h"
+#include "TextureManager.h"
+#include "Utils.h"
 
 using namespace RTGL1;
 
-constexpr uint32_t INDEX_BUFFER_SIZE     = MAX_INDEXED_PRIMITIVE_COUNT * 3 * sizeof( uint32_t );
-constexpr uint32_t TRANSFORM_BUFFER_SIZE =  MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT * sizeof( VkTransformMatrixKHR );
+struct VertexCollector::PendingGeometry
+{
+    uint64_t                                 uniqueID;
+    uint32_t                                 frameIndex;
+    VertexCollectorFilterTypeFlags           flags;
+    uint32_t                                 transformIndex;
+    uint32_t                                 primitiveCount;
+    VkAccelerationStructureGeometryKHR       asGeometry;
+    VkAccelerationStructureBuildRangeInfoKHR asBuildRangeInfo;
+    ShGeometryInstance                       geomInfo;
+    // hash of vertex and index data; null, if data wasn't hashed
+    std::optional< uint64_t >                dataHash;
+    // hash of everything that affects BLAS
+    std::optional< uint64_t >                blasHash;
+    // hash of everything that must be the same to update BLAS
+    std::optional< uint64_t >                topologyHash;
+};
+
+struct VertexCollector::Chunk
+{
+    struct Geometry
+    {
+        uint64_t           uniqueID;
+        uint32_t           groupIndex;
+        ShGeometryInstance geomInfo;
+        RgLayeredMaterial  material;
+    };
+
+    RangeAllocator::Range     vertRange;
+    RangeAllocator::Range     indexRange;
+    RangeAllocator::Range     transformRange;
+    // sorted by group
+    std::vector< Geometry >   geometries;
+    std::vector< ChunkGroup > groups;
+};
+
+struct VertexCollector::PendingBucket
+{
+    std::mutex                     lock;
+    std::vector< PendingGeometry > geometries;
+};
+
+constexpr uint32_t PENDING_BUCKET_COUNT = 16;
+
+static uint32_t AlignUpBy3( uint32_t x )
+{
+    return ( ( x + 2 ) / 3 ) * 3;
+}
+
+// Reserve "count" elements after "base", only if the range ends before "limit",
+// so the counter is not changed by the reservations that failed
+static bool TryReserveRange( std::atomic< uint32_t >& counter,
+                             uint32_t                 base,
+                             uint32_t                 count,
+                             uint32_t                 limit,
+                             uint32_t*                pOutIndex )
+{
+    uint32_t cur = counter.load();
+
+    do
+    {
+        if( uint64_t( base ) + cur + count > limit )
+        {
+            return false;
+        }
+    } while( !counter.compare_exchange_weak( cur, cur + count ) );
+
+    *pOutIndex = base + cur;
+    return true;
+}
+
+// Index of "index" in the acquired block that contains it and has place for "count" elements,
+// UINT32_MAX, if there's no such block. Must be called under acquiredMutex.
+static uint32_t FindInAcquiredRange( const std::map< uint32_t, uint32_t >& ranges,
+                                     uint32_t                              index,
+                                     uint32_t                              count )
+{
+    // find the block that starts before the index
+    auto f = ranges.upper_bound( index );
+
+    if( f == ranges.begin() )
+    {
+        return UINT32_MAX;
+    }
+    --f;
+
+    if( uint64_t( index ) + count > uint64_t( f->first ) + f->second )
+    {
+        return UINT32_MAX;
+    }
+
+    return index;
+}
+
+static uint32_t GetPendingBucketIndex()
+{
+    return std::hash< std::thread::id >{}( std::this_thread::get_id() ) % PENDING_BUCKET_COUNT;
+}
+
+static const char* GetBufferDebugName( bool isDynamic, bool isIndex, bool isStaging )
+{
+    if( isIndex )
+    {
+        return isDynamic ? ( isStaging ? "Dynamic Index data staging buffer" : "Dynamic Index data buffer" )
+                         : ( isStaging ? "Static Index data staging buffer" : "Static Index data buffer" );
+    }
 
+    return isDynamic
+               ? ( isStaging ? "Dynamic Vertices data staging buffer" : "Dynamic Vertices data buffer" )
+               : ( isStaging ? "Static Vertices data staging buffer" : "Static Vertices data buffer" );
+}
 
 VertexCollector::VertexCollector( VkDevice                                  _device,
                                   const std::shared_ptr< MemoryAllocator >& _allocator,
                                   std::shared_ptr< GeomInfoManager >        _geomInfoManager,
-                                  VkDeviceSize                              _bufferSize,
-                                  VertexCollectorFilterTypeFlags            _filters )
+                                  uint32_t                                  _initialVertexCount,
+                                  uint32_t                                  _initialIndexCount,
+                                  uint32_t                                  _chunkVertexCount,
+                                  uint32_t                                  _chunkIndexCount,
+                                  VkDeviceSize                              _maxBufferSize,
+                                  VertexCollectorFilterTypeFlags            _filters,
+                                  VertexBufferFormat                        _vertexFormat )
     : device( _device )
     , filtersFlags( _filters )
+    , vertexFormat( _vertexFormat )
+    , vertexStride( GetVertexStride( _vertexFormat ) )
+    , allocator( _allocator )
+    , vertexBase( 0 )
+    , indexBase( 0 )
+    , transformBase( 0 )
+    , maxVertexCount( 0 )
+    , maxIndexCount( 0 )
+    , maxTransformCount( 0 )
     , geomInfoMgr( std::move( _geomInfoManager ) )
     , curVertexCount( 0 )
     , curIndexCount( 0 )
@@ -47,44 +173,63 @@ VertexCollector::VertexCollector( VkDevice                                  _dev
     , curTransformCount( 0 )
     , mappedVertexData( nullptr )
     , mappedIndexData( nullptr )
+    , stagingVertexCapacity( 0 )
+    , stagingIndexCapacity( 0 )
     , mappedTransformData( nullptr )
+    , stagingTransformCapacity( 0 )
+    , pendingBuckets( std::make_unique< PendingBucket[] >( PENDING_BUCKET_COUNT ) )
 {
     assert( filtersFlags != 0 );
 
     bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
 
-    vertBuffer       = std::make_shared< Buffer >();
-    indexBuffer      = std::make_shared< Buffer >();
-    transformsBuffer = std::make_shared< Buffer >();
+    // only static collector has regions for chunks, they have fixed sizes,
+    // so they're placed before the usual ranges, as the latter can grow
+    assert( !isDynamic || ( _chunkVertexCount == 0 && _chunkIndexCount == 0 ) );
+    const uint32_t chunkVertexCount = _chunkVertexCount;
+    const uint32_t chunkIndexCount  = _chunkIndexCount;
+    // each chunk geometry takes at least 3 vertices, so there can't be more transforms
+    const uint32_t chunkTransformCount = chunkVertexCount / 3;
+
+    // usual ranges must start at an index that is divisible by 3
+    vertexBase    = AlignUpBy3( chunkVertexCount );
+    indexBase     = AlignUpBy3( chunkIndexCount );
+    transformBase = chunkTransformCount;
+
+    // transform index of a usual geometry is its geometry index in this collector
+    maxTransformCount = transformBase + MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT;
+
+    // the highest bit of a base index is a flag of 16-bit indices,
+    // and their base is in uint16_t units
+    maxVertexCount = uint32_t( std::min< VkDeviceSize >( _maxBufferSize / vertexStride, UINT32_MAX ) );
+    maxIndexCount  = uint32_t( std::min< VkDeviceSize >( _maxBufferSize / sizeof( uint32_t ),
+                                                        GEOM_INST_INDEX_16_BIT_FLAG / 2 ) );
+
+    if( vertexBase >= maxVertexCount || indexBase >= maxIndexCount )
+    {
+        throw RgException( RG_GRAPHICS_API_ERROR,
+                           "Static chunk regions don't fit in the vertex and index buffers" );
+    }
+
+    chunkVertAllocator  = RangeAllocator( 0, chunkVertexCount );
+    chunkIndexAllocator = RangeAllocator( 0, chunkIndexCount );
+    chunkTransformAllocator = RangeAllocator( 0, chunkTransformCount );
 
-    // dynamic vertices need also be copied to previous frame buffer
-    VkBufferUsageFlags transferUsage =
-        isDynamic ? VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-                  : VK_BUFFER_USAGE_TRANSFER_DST_BIT;
-
-    // vertex buffers
-    vertBuffer->Init(
-        _allocator, _bufferSize,
-        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic Vertices data buffer" : "Static Vertices data buffer");
-
-    // index buffers
-    indexBuffer->Init(
-        _allocator, INDEX_BUFFER_SIZE,
-        transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic Index data buffer" : "Static Index data buffer");
-
-    // transforms buffer
-    transformsBuffer->Init(
-        _allocator, TRANSFORM_BUFFER_SIZE,
-        transferUsage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        isDynamic ? "Dynamic BLAS transforms buffer" : "Static BLAS transforms buffer");
+    // usual ranges are sized from the hints, and grown when needed
+    const uint32_t vertexCapacity =
+        std::min( vertexBase + AlignUpBy3( std::max( _initialVertexCount, 3u ) ), maxVertexCount );
+    const uint32_t indexCapacity =
+        std::min( indexBase + AlignUpBy3( std::max( _initialIndexCount, 3u ) ), maxIndexCount );
+
+    vertBuffer  = CreateDeviceBuffer( vertexCapacity * vertexStride,
+                                      GetBufferDebugName( isDynamic, false, false ) );
+    indexBuffer = CreateDeviceBuffer( indexCapacity * sizeof( uint32_t ),
+                                      GetBufferDebugName( isDynamic, true, false ) );
+    transformsBuffer = CreateTransformsBuffer( ( transformBase + INITIAL_TRANSFORM_COUNT ) *
+                                               sizeof( VkTransformMatrixKHR ) );
 
     // device local buffers are
-    InitStagingBuffers( _allocator );
+    InitStagingBuffers();
     InitFilters( filtersFlags );
 }
 
@@ -92,6 +237,15 @@ VertexCollector::VertexCollector( const std::shared_ptr< const VertexCollector >
                                   const std::shared_ptr< MemoryAllocator >&       _allocator )
     : device( _src->device )
     , filtersFlags( _src->filtersFlags )
+    , vertexFormat( _src->vertexFormat )
+    , vertexStride( _src->vertexStride )
+    , allocator( _allocator )
+    , vertexBase( _src->vertexBase )
+    , indexBase( _src->indexBase )
+    , transformBase( _src->transformBase )
+    , maxVertexCount( _src->maxVertexCount )
+    , maxIndexCount( _src->maxIndexCount )
+    , maxTransformCount( _src->maxTransformCount )
     , vertBuffer( _src->vertBuffer )
     , indexBuffer( _src->indexBuffer )
     , transformsBuffer( _src->transformsBuffer )
@@ -102,14 +256,70 @@ VertexCollector::VertexCollector( const std::shared_ptr< const VertexCollector >
     , curTransformCount( 0 )
     , mappedVertexData( nullptr )
     , mappedIndexData( nullptr )
+    , stagingVertexCapacity( 0 )
+    , stagingIndexCapacity( 0 )
     , mappedTransformData( nullptr )
+    , stagingTransformCapacity( 0 )
+    , pendingBuckets( std::make_unique< PendingBucket[] >( PENDING_BUCKET_COUNT ) )
 {
     // device local buffers are shared with the "src" vertex collector
-    InitStagingBuffers( _allocator );
+    InitStagingBuffers();
     InitFilters( filtersFlags );
 }
 
-void VertexCollector::InitStagingBuffers( const std::shared_ptr< MemoryAllocator >& allocator )
+std::unique_ptr< Buffer > VertexCollector::CreateStagingBuffer( VkDeviceSize size,
+                                                                const char*  debugName ) const
+{
+    auto b = std::make_unique< Buffer >();
+    b->Init( allocator,
+             size,
+             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+             debugName );
+
+    return b;
+}
+
+std::shared_ptr< Buffer > VertexCollector::CreateDeviceBuffer( VkDeviceSize size,
+                                                               const char*  debugName ) const
+{
+    // dynamic vertices need also be copied to previous frame buffer
+    VkBufferUsageFlags transferUsage = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC
+                                           ? VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                           : VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    auto b = std::make_shared< Buffer >();
+    b->Init( allocator,
+             size,
+             transferUsage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                 VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+             debugName );
+
+    return b;
+}
+
+std::shared_ptr< Buffer > VertexCollector::CreateTransformsBuffer( VkDeviceSize size ) const
+{
+    bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
+
+    auto b = std::make_shared< Buffer >();
+    b->Init( allocator,
+             size,
+             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                 VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+             isDynamic ? "Dynamic BLAS transforms buffer" : "Static BLAS transforms buffer" );
+
+    return b;
+}
+
+static const char* GetTransformsStagingDebugName( bool isDynamic )
+{
+    return isDynamic ? "Dynamic BLAS transforms staging buffer" : "Static BLAS transforms staging buffer";
+}
+
+void VertexCollector::InitStagingBuffers()
 {
     // device local buffers must not be empty
     assert( vertBuffer && vertBuffer->GetSize() > 0 );
@@ -117,315 +327,1297 @@ void VertexCollector::InitStagingBuffers( const std::shared_ptr< MemoryAllocator
     assert( transformsBuffer && transformsBuffer->GetSize() > 0 );
     assert( geomInfoMgr );
 
-    // vertex buffers
-    stagingVertBuffer.Init( allocator,
-                            vertBuffer->GetSize(),
-                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                            filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC
-                                ? "Dynamic Vertices data staging buffer"
-                                : "Static Vertices data staging buffer" );
-
-    // index buffers
-    stagingIndexBuffer.Init( allocator,
-                             indexBuffer->GetSize(),
-                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                             filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC
-                                 ? "Dynamic Index data staging buffer"
-                                 : "Static Index data staging buffer" );
-
-    // transforms buffer
-    stagingTransformsBuffer.Init( allocator,
-                                  transformsBuffer->GetSize(),
-                                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                  filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC
-                                      ? "Dynamic BLAS transforms staging buffer"
-                                      : "Static BLAS transforms staging buffer" );
-
-    mappedVertexData    = static_cast< ShVertex* >( stagingVertBuffer.Map() );
-    mappedIndexData     = static_cast< uint32_t* >( stagingIndexBuffer.Map() );
-    mappedTransformData = static_cast< VkTransformMatrixKHR* >( stagingTransformsBuffer.Map() );
+    bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
+
+    // vertex and index buffers, staging ones are grown separately from the device local
+    stagingVertBuffer = CreateStagingBuffer( vertBuffer->GetSize(), GetBufferDebugName( isDynamic, false, true ) );
+    stagingIndexBuffer = CreateStagingBuffer( indexBuffer->GetSize(), GetBufferDebugName( isDynamic, true, true ) );
+    stagingTransformsBuffer = CreateStagingBuffer( transformsBuffer->GetSize(), GetTransformsStagingDebugName( isDynamic ) );
+
+    stagingVertexCapacity    = uint32_t( vertBuffer->GetSize() / vertexStride );
+    stagingIndexCapacity     = uint32_t( indexBuffer->GetSize() / sizeof( uint32_t ) );
+    stagingTransformCapacity = uint32_t( transformsBuffer->GetSize() / sizeof( VkTransformMatrixKHR ) );
+
+    mappedVertexData    = static_cast< uint8_t* >( stagingVertBuffer->Map() );
+    mappedIndexData     = static_cast< uint32_t* >( stagingIndexBuffer->Map() );
+    mappedTransformData = static_cast< VkTransformMatrixKHR* >( stagingTransformsBuffer->Map() );
 }
 
 VertexCollector::~VertexCollector()
 {
     // unmap buffers to destroy them
-    stagingVertBuffer.TryUnmap();
-    stagingIndexBuffer.TryUnmap();
-    stagingTransformsBuffer.TryUnmap();
+    stagingVertBuffer->TryUnmap();
+    stagingIndexBuffer->TryUnmap();
+    stagingTransformsBuffer->TryUnmap();
+
+    for( RetiredStaging& r : retiredStaging )
+    {
+        r.buffer->TryUnmap();
+    }
 }
 
-static uint32_t GetMaterialsBlendFlags( const RgGeometryMaterialBlendType blendingTypes[],
-                                        uint32_t                          count )
+bool VertexCollector::EnsureStagingCapacity( uint32_t vertexEnd, uint32_t indexEnd, uint32_t transformEnd )
 {
-    uint32_t r = 0;
-
-    for( uint32_t i = 0; i < count; i++ )
     {
-        RgGeometryMaterialBlendType b = blendingTypes[ i ];
-
-        uint32_t bitOffset = MATERIAL_BLENDING_FLAG_BIT_COUNT * i;
+        std::shared_lock< std::shared_mutex > lock( stagingMutex );
 
-        switch (b)
+        if( vertexEnd <= stagingVertexCapacity && indexEnd <= stagingIndexCapacity &&
+            transformEnd <= stagingTransformCapacity )
         {
-            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE:    r |= MATERIAL_BLENDING_FLAG_OPAQUE  << bitOffset; break;
-            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_ALPHA:     r |= MATERIAL_BLENDING_FLAG_ALPHA   << bitOffset; break;
-            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_ADD:       r |= MATERIAL_BLENDING_FLAG_ADD     << bitOffset; break;
-            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_SHADE:     r |= MATERIAL_BLENDING_FLAG_SHADE   << bitOffset; break;
-            default: assert(0); break;
+            return true;
         }
     }
 
-    return r;
-}
-
-void VertexCollector::BeginCollecting( bool isStatic )
-{
-    assert( curVertexCount == 0 && curIndexCount == 0 && curPrimitiveCount == 0 );
-    assert( ( isStatic && geomInfoMgr->GetStaticCount() == 0 ) ||
-            ( !isStatic && geomInfoMgr->GetDynamicCount() == 0 ) );
-    assert( GetAllGeometryCount() == 0 );
-}
+    if( vertexEnd > maxVertexCount || indexEnd > maxIndexCount || transformEnd > maxTransformCount )
+    {
+        return false;
+    }
 
-static uint32_t AlignUpBy3( uint32_t x )
-{
-    return ( ( x + 2 ) / 3 ) * 3;
-}
+    bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
 
-uint32_t VertexCollector::AddGeometry( uint32_t                         frameIndex,
-                                       const RgGeometryUploadInfo&      info,
-                                       std::span< MaterialTextures, 3 > materials )
-{
-    typedef VertexCollectorFilterTypeFlagBits FT;
-    const VertexCollectorFilterTypeFlags      geomFlags =
-        VertexCollectorFilterTypeFlags_GetForGeometry( info );
+    // writers hold a shared lock, so nothing is written to the staging buffers while growing
+    std::unique_lock< std::shared_mutex > lock( stagingMutex );
 
+    // grow geometrically, so the amount of reallocations is logarithmic
+    const auto getNewCapacity = []( uint32_t capacity, uint32_t needed, uint32_t limit ) {
+        return uint32_t( std::min< uint64_t >( std::max< uint64_t >( needed, uint64_t( capacity ) * 2 ), limit ) );
+    };
 
-    // if exceeds a limit of geometries in a group with specified geomFlags
-    if( GetGeometryCount( geomFlags ) + 1 >=
-        VertexCollectorFilterTypeFlags_GetAmountInGlobalArray( geomFlags ) )
+    // the old buffers are retired, not destroyed: they can be in use by the device,
+    // and the memory returned by AcquireMemory can still be written by a caller
+    if( vertexEnd > stagingVertexCapacity )
     {
-        assert( false && "Too many geometries in a group" );
-        return UINT32_MAX;
-    }
-
+        uint32_t newCapacity = getNewCapacity( stagingVertexCapacity, vertexEnd, maxVertexCount );
 
-    const bool collectStatic = geomFlags & ( FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE );
+        auto newBuffer = CreateStagingBuffer( newCapacity * vertexStride, GetBufferDebugName( isDynamic, false, true ) );
+        auto newMapped = static_cast< uint8_t* >( newBuffer->Map() );
 
-    const uint32_t maxVertexCount =
-        collectStatic ? MAX_STATIC_VERTEX_COUNT : MAX_DYNAMIC_VERTEX_COUNT;
+        memcpy( newMapped, mappedVertexData, stagingVertexCapacity * vertexStride );
 
+        retiredStaging.push_back( RetiredStaging{
+            .buffer  = std::move( stagingVertBuffer ),
+            .mapped  = mappedVertexData,
+            .size    = stagingVertexCapacity * vertexStride,
+            .type    = StagingType::Vertices,
+        } );
 
-    const uint32_t vertIndex      = AlignUpBy3( curVertexCount );
-    const uint32_t indIndex       = AlignUpBy3( curIndexCount );
-    const uint32_t transformIndex = curTransformCount;
+        stagingVertBuffer     = std::move( newBuffer );
+        mappedVertexData      = newMapped;
+        stagingVertexCapacity = newCapacity;
+    }
 
-    const bool     useIndices     = info.indexCount != 0 && info.pIndices != nullptr;
-    const uint32_t primitiveCount = useIndices ? info.indexCount / 3 : info.vertexCount / 3;
+    if( indexEnd > stagingIndexCapacity )
+    {
+        uint32_t newCapacity = getNewCapacity( stagingIndexCapacity, indexEnd, maxIndexCount );
 
+        auto newBuffer = CreateStagingBuffer( newCapacity * sizeof( uint32_t ), GetBufferDebugName( isDynamic, true, true ) );
+        auto newMapped = static_cast< uint32_t* >( newBuffer->Map() );
 
-    curVertexCount = vertIndex + info.vertexCount;
-    curIndexCount  = indIndex + ( useIndices ? info.indexCount : 0 );
-    curPrimitiveCount += primitiveCount;
-    curTransformCount += 1;
+        memcpy( newMapped, mappedIndexData, stagingIndexCapacity * sizeof( uint32_t ) );
 
+        retiredStaging.push_back( RetiredStaging{
+            .buffer  = std::move( stagingIndexBuffer ),
+            .mapped  = reinterpret_cast< const uint8_t* >( mappedIndexData ),
+            .size    = stagingIndexCapacity * sizeof( uint32_t ),
+            .type    = StagingType::Indices,
+        } );
 
-    // check bounds
-    if( curVertexCount >= maxVertexCount )
-    {
-        assert( 0 );
-        return UINT32_MAX;
+        stagingIndexBuffer   = std::move( newBuffer );
+        mappedIndexData      = newMapped;
+        stagingIndexCapacity = newCapacity;
     }
 
-    if( curIndexCount >= MAX_INDEXED_PRIMITIVE_COUNT * 3 )
+    // chunk transforms are at the start of the buffer, so they're copied too
+    if( transformEnd > stagingTransformCapacity )
     {
-        assert( 0 );
-        return UINT32_MAX;
-    }
+        uint32_t newCapacity = getNewCapacity( stagingTransformCapacity, transformEnd, maxTransformCount );
 
-    if( geomInfoMgr->GetCount() + 1 >= MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT )
-    {
-        assert( 0 );
-        return UINT32_MAX;
-    }
+        auto newBuffer = CreateStagingBuffer( newCapacity * sizeof( VkTransformMatrixKHR ),
+                                              GetTransformsStagingDebugName( isDynamic ) );
+        auto newMapped = static_cast< VkTransformMatrixKHR* >( newBuffer->Map() );
 
+        memcpy( newMapped, mappedTransformData, stagingTransformCapacity * sizeof( VkTransformMatrixKHR ) );
 
-    // copy data to buffer
-    assert( stagingVertBuffer.IsMapped() );
-    CopyDataToStaging( info, vertIndex );
+        retiredStaging.push_back( RetiredStaging{
+            .buffer  = std::move( stagingTransformsBuffer ),
+            .mapped  = reinterpret_cast< const uint8_t* >( mappedTransformData ),
+            .size    = stagingTransformCapacity * sizeof( VkTransformMatrixKHR ),
+            .type    = StagingType::Transforms,
+        } );
 
-    if( useIndices )
-    {
-        assert( stagingIndexBuffer.IsMapped() );
-        memcpy( mappedIndexData + indIndex, info.pIndices, info.indexCount * sizeof( uint32_t ) );
+        stagingTransformsBuffer  = std::move( newBuffer );
+        mappedTransformData      = newMapped;
+        stagingTransformCapacity = newCapacity;
     }
 
-    static_assert( sizeof( RgTransform ) == sizeof( VkTransformMatrixKHR ),
-                   "RgTransform and VkTransformMatrixKHR must have the same structure to be used "
-                   "in AS building" );
-    memcpy( mappedTransformData + transformIndex, &info.transform, sizeof( VkTransformMatrixKHR ) );
-
-    // use positions and index data in the device local buffers: AS shouldn't be built using staging
-    // buffers
-    const VkDeviceAddress vertexDataDeviceAddress =
-        vertBuffer->GetAddress() + vertIndex * sizeof( ShVertex ) + offsetof( ShVertex, position );
+    return true;
+}
 
-    // geometry info
-    VkAccelerationStructureGeometryKHR geom = {};
-    geom.sType                              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-    geom.geometryType                       = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+void VertexCollector::DestroyRetiredStaging()
+{
+    std::unique_lock< std::shared_mutex > lock( stagingMutex );
 
-    geom.flags = geomFlags & FT::PT_OPAQUE ? VK_GEOMETRY_OPAQUE_BIT_KHR
-                                           : VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+    for( RetiredStaging& r : retiredStaging )
+    {
+        r.buffer->TryUnmap();
+    }
 
-    VkAccelerationStructureGeometryTrianglesDataKHR& trData = geom.geometry.triangles;
-    trData.sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-    trData.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
-    trData.maxVertex    = info.vertexCount;
-    trData.vertexData.deviceAddress = vertexDataDeviceAddress;
-    trData.vertexStride             = sizeof( ShVertex );
-    trData.transformData.deviceAddress =
-        transformsBuffer->GetAddress() + transformIndex * sizeof( VkTransformMatrixKHR );
+    retiredStaging.clear();
+}
 
-    if( useIndices )
-    {
-        const VkDeviceAddress indexDataDeviceAddress =
-            indexBuffer->GetAddress() + indIndex * sizeof( uint32_t );
+void VertexCollector::RetireStaging( std::vector< std::shared_ptr< Buffer > >& retired )
+{
+    std::unique_lock< std::shared_mutex > lock( stagingMutex );
 
-        trData.indexType               = VK_INDEX_TYPE_UINT32;
-        trData.indexData.deviceAddress = indexDataDeviceAddress;
-    }
-    else
+    for( RetiredStaging& r : retiredStaging )
     {
-        trData.indexType = VK_INDEX_TYPE_NONE_KHR;
-        trData.indexData = {};
+        r.buffer->TryUnmap();
+        retired.push_back( std::move( r.buffer ) );
     }
 
+    retiredStaging.clear();
+}
 
-    uint32_t localIndex = PushGeometry( geomFlags, geom );
+bool VertexCollector::NeedsDeviceBufferGrowth() const
+{
+    std::shared_lock< std::shared_mutex > lock( stagingMutex );
 
+    return stagingVertBuffer->GetSize() > vertBuffer->GetSize() ||
+           stagingIndexBuffer->GetSize() > indexBuffer->GetSize() ||
+           stagingTransformsBuffer->GetSize() > transformsBuffer->GetSize();
+}
 
-    VkAccelerationStructureBuildRangeInfoKHR rangeInfo = {};
-    rangeInfo.primitiveCount                           = primitiveCount;
-    rangeInfo.primitiveOffset                          = 0;
-    rangeInfo.firstVertex                              = 0;
-    rangeInfo.transformOffset                          = 0;
-    PushRangeInfo( geomFlags, rangeInfo );
+void VertexCollector::GrowDeviceBuffers( std::vector< std::shared_ptr< Buffer > >& retired )
+{
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
 
+    const bool growVertices   = stagingVertBuffer->GetSize() > vertBuffer->GetSize();
+    const bool growIndices    = stagingIndexBuffer->GetSize() > indexBuffer->GetSize();
+    const bool growTransforms = stagingTransformsBuffer->GetSize() > transformsBuffer->GetSize();
 
-    PushPrimitiveCount( geomFlags, primitiveCount );
+    if( !growVertices && !growIndices && !growTransforms )
+    {
+        return;
+    }
 
+    RecreateDeviceBuffers( growVertices, growIndices, growTransforms, retired );
+}
 
-    ShGeometryInstance geomInfo = {};
-    geomInfo.baseVertexIndex    = vertIndex;
-    geomInfo.baseIndexIndex     = useIndices ? indIndex : UINT32_MAX;
-    geomInfo.vertexCount        = info.vertexCount;
-    geomInfo.indexCount         = useIndices ? info.indexCount : UINT32_MAX;
-    geomInfo.defaultRoughness   = std::clamp( info.defaultRoughness, 0.0f, 1.0f );
-    geomInfo.defaultMetallicity = std::clamp( info.defaultMetallicity, 0.0f, 1.0f );
-    geomInfo.defaultEmission    = std::clamp( info.defaultEmission, 0.0f, 1.0f );
+void VertexCollector::ReplaceDeviceBuffers( std::shared_ptr< Buffer >&                prevVertices,
+                                            std::shared_ptr< Buffer >&                prevIndices,
+                                            std::vector< std::shared_ptr< Buffer > >& retired )
+{
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
 
-    Matrix::ToMat4Transposed( geomInfo.model, info.transform );
+    // transforms are only read by AS builds, so they're recreated only to grow
+    const bool growTransforms = stagingTransformsBuffer->GetSize() > transformsBuffer->GetSize();
 
-    geomInfo.flags = GetMaterialsBlendFlags( info.layerBlendingTypes, MATERIALS_MAX_LAYER_COUNT );
+    std::vector< std::shared_ptr< Buffer > > prev;
+    RecreateDeviceBuffers( true, true, growTransforms, prev );
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT )
-    {
-        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
-    }
+    assert( prev.size() == ( growTransforms ? 3 : 2 ) );
+    prevVertices = std::move( prev[ 0 ] );
+    prevIndices  = std::move( prev[ 1 ] );
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT )
+    if( growTransforms )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
-        geomInfo.flags |= GEOM_INST_FLAG_INVERTED_NORMALS;
+        retired.push_back( std::move( prev[ 2 ] ) );
     }
+}
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_EXACT_NORMALS_BIT )
-    {
-        geomInfo.flags |= GEOM_INST_FLAG_EXACT_NORMALS;
-    }
+void VertexCollector::RecreateDeviceBuffers( bool                                      vertices,
+                                             bool                                      indices,
+                                             bool                                      transforms,
+                                             std::vector< std::shared_ptr< Buffer > >& retired )
+{
+    bool isDynamic = filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC;
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_NO_MEDIA_CHANGE_ON_REFRACT_BIT )
+    const VkDeviceAddress oldVertexAddress    = vertBuffer->GetAddress();
+    const VkDeviceAddress oldIndexAddress     = indexBuffer->GetAddress();
+    const VkDeviceAddress oldTransformAddress = transformsBuffer->GetAddress();
+
+    if( vertices )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_NO_MEDIA_CHANGE;
+        retired.push_back( std::move( vertBuffer ) );
+        vertBuffer = CreateDeviceBuffer( stagingVertBuffer->GetSize(), GetBufferDebugName( isDynamic, false, false ) );
     }
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_MULTIPLY_BIT )
+    if( indices )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_REFL_REFR_ALBEDO_MULT;
+        retired.push_back( std::move( indexBuffer ) );
+        indexBuffer = CreateDeviceBuffer( stagingIndexBuffer->GetSize(), GetBufferDebugName( isDynamic, true, false ) );
     }
-    else if( info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_ADD_BIT )
+
+    if( transforms )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_REFL_REFR_ALBEDO_ADD;
+        retired.push_back( std::move( transformsBuffer ) );
+        transformsBuffer = CreateTransformsBuffer( stagingTransformsBuffer->GetSize() );
     }
 
-    if( info.flags & RG_GEOMETRY_UPLOAD_IGNORE_REFRACT_AFTER_REFRACT_BIT )
+    const VkDeviceAddress newVertexAddress    = vertBuffer->GetAddress();
+    const VkDeviceAddress newIndexAddress     = indexBuffer->GetAddress();
+    const VkDeviceAddress newTransformAddress = transformsBuffer->GetAddress();
+
+    for( auto& f : filters )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_IGNORE_REFRACT_AFTER;
+        if( f )
+        {
+            f->RebaseASGeometries( oldVertexAddress,
+                                   newVertexAddress,
+                                   oldIndexAddress,
+                                   newIndexAddress,
+                                   oldTransformAddress,
+                                   newTransformAddress );
+        }
     }
 
-    if( geomFlags & FT::CF_STATIC_MOVABLE )
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    for( PendingGeometry& m : meshes )
     {
-        geomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+        VertexCollectorFilter::RebaseASGeometry( m.asGeometry,
+                                                 oldVertexAddress,
+                                                 newVertexAddress,
+                                                 oldIndexAddress,
+                                                 newIndexAddress,
+                                                 oldTransformAddress,
+                                                 newTransformAddress );
     }
 
-    switch( info.passThroughType )
+    for( auto& [ chunkID, chunk ] : chunks )
     {
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR:
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            break;
+        if( chunk == nullptr )
+        {
+            continue;
+        }
 
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL:
-            if( info.pPortalIndex )
+        for( ChunkGroup& g : chunk->groups )
+        {
+            for( auto& geom : g.asGeometries )
             {
-                geomInfo.flags |= GEOM_INST_FLAG_PORTAL;
+                VertexCollectorFilter::RebaseASGeometry( geom,
+                                                         oldVertexAddress,
+                                                         newVertexAddress,
+                                                         oldIndexAddress,
+                                                         newIndexAddress,
+                                                         oldTransformAddress,
+                                                         newTransformAddress );
             }
-            break;
-
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            break;
-
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
-            break;
-
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_GLASS;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
-            break;
-
-        case RG_GEOMETRY_PASS_THROUGH_TYPE_ACID_REFLECT_REFRACT:
-            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_ACID;
-            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
-            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
-            break;
+        }
 
-        default: break;
+        // chunks are copied only once, so their data must be copied to the new buffers again
+        QueueChunkDataCopy( *chunk, vertices, indices, transforms );
     }
+}
 
-    static_assert( sizeof( RgLayeredMaterial ) / sizeof( RgMaterial ) == MATERIALS_MAX_LAYER_COUNT,
-                   "Layer count mismatch with ShGeometryInstance" );
-    {
-        geomInfo.materials0A = materials[ 0 ].indices[ 0 ];
-        geomInfo.materials0B = materials[ 0 ].indices[ 1 ];
-        geomInfo.materials0C = materials[ 0 ].indices[ 2 ];
+void VertexCollector::ShareDeviceBuffers( const VertexCollector& src )
+{
+    const VkDeviceAddress oldVertexAddress    = vertBuffer->GetAddress();
+    const VkDeviceAddress oldIndexAddress     = indexBuffer->GetAddress();
+    const VkDeviceAddress oldTransformAddress = transformsBuffer->GetAddress();
 
-        geomInfo.materials1A = materials[ 1 ].indices[ 0 ];
-        geomInfo.materials1B = materials[ 1 ].indices[ 1 ];
-        // no materials1C member
+    vertBuffer       = src.vertBuffer;
+    indexBuffer      = src.indexBuffer;
+    transformsBuffer = src.transformsBuffer;
 
-        geomInfo.materials2A = materials[ 2 ].indices[ 0 ];
-        geomInfo.materials2B = materials[ 2 ].indices[ 1 ];
-        // no materials2C member
-    }
-    const std::tuple<uint32_t, RgMaterial, std::array<uint32_t, TEXTURES_PER_MATERIAL_COUNT>> layerDependencies[] =
+    for( auto& f : filters )
+    {
+        if( f )
+        {
+            f->RebaseASGeometries( oldVertexAddress,
+                                   vertBuffer->GetAddress(),
+                                   oldIndexAddress,
+                                   indexBuffer->GetAddress(),
+                                   oldTransformAddress,
+                                   transformsBuffer->GetAddress() );
+        }
+    }
+}
+
+static uint32_t GetMaterialsBlendFlags( const RgGeometryMaterialBlendType blendingTypes[],
+                                        uint32_t                          count )
+{
+    uint32_t r = 0;
+
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        RgGeometryMaterialBlendType b = blendingTypes[ i ];
+
+        uint32_t bitOffset = MATERIAL_BLENDING_FLAG_BIT_COUNT * i;
+
+        switch (b)
+        {
+            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE:    r |= MATERIAL_BLENDING_FLAG_OPAQUE  << bitOffset; break;
+            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_ALPHA:     r |= MATERIAL_BLENDING_FLAG_ALPHA   << bitOffset; break;
+            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_ADD:       r |= MATERIAL_BLENDING_FLAG_ADD     << bitOffset; break;
+            case RG_GEOMETRY_MATERIAL_BLEND_TYPE_SHADE:     r |= MATERIAL_BLENDING_FLAG_SHADE   << bitOffset; break;
+            default: assert(0); break;
+        }
+    }
+
+    return r;
+}
+
+void VertexCollector::BeginCollecting( bool isStatic )
+{
+    assert( curVertexCount == 0 && curIndexCount == 0 && curPrimitiveCount == 0 );
+    assert( ( isStatic && geomInfoMgr->GetStaticCount() == 0 ) ||
+            ( !isStatic && geomInfoMgr->GetDynamicCount() == 0 ) );
+    assert( GetAllGeometryCount() == 0 );
+}
+
+static bool UsesIndices( const RgGeometryUploadInfo& info )
+{
+    return info.indexCount != 0 && ( info.pIndices != nullptr || info.pIndices16 != nullptr );
+}
+
+static bool Uses16BitIndices( const RgGeometryUploadInfo& info )
+{
+    return info.indexCount != 0 && info.pIndices16 != nullptr;
+}
+
+static uint32_t GetPrimitiveCount( const RgGeometryUploadInfo& info )
+{
+    return UsesIndices( info ) ? info.indexCount / 3 : info.vertexCount / 3;
+}
+
+struct VertexCollector::StagingRanges
+{
+    // absolute indices in the buffers, i.e. including the chunk regions
+    uint32_t vertIndex;
+    uint32_t indIndex;
+    uint32_t transformIndex;
+    // chunk ranges were allocated with exact sizes, so bounds are not checked;
+    // 16-bit indices of chunks are widened
+    bool     isChunk;
+    // vertex and index data is written by another geometry with the same content
+    bool     isSharedData;
+    // if the data is written by another geometry in the same batch, its index
+    size_t   sharedDataOwner = SIZE_MAX;
+
+    // move to the ranges of the next geometry in a batch
+    void Advance( const VertexCollector& owner, const RgGeometryUploadInfo& info, bool isShared = false )
+    {
+        vertIndex += isShared ? 0 : owner.GetVertexCountToReserve( info );
+        indIndex += isShared ? 0 : owner.GetIndexCountToReserve( info );
+        transformIndex += 1;
+    }
+};
+
+struct VertexCollector::NewSharedData
+{
+    // index of the geometry in the batch that writes the data
+    size_t     owner;
+    uint64_t   hash;
+    SharedData data;
+};
+
+namespace
+{
+struct SharedDataKey
+{
+    bool     isValid;
+    uint64_t hash;
+    uint64_t verificationHash;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+
+    bool Matches( uint64_t otherVerificationHash, uint32_t otherVertexCount, uint32_t otherIndexCount ) const
+    {
+        return verificationHash == otherVerificationHash && vertexCount == otherVertexCount &&
+               indexCount == otherIndexCount;
+    }
+};
+}
+
+static SharedDataKey GetSharedDataKey( const RgGeometryUploadInfo& info )
+{
+    // vertices of movable geometry can be updated in place, so they must not be shared
+    if( info.vertexCount == 0 || info.pVertices == nullptr ||
+        info.geomType == RG_GEOMETRY_TYPE_STATIC_MOVABLE )
+    {
+        return { .isValid = false };
+    }
+
+    // normals are generated in place, so such geometries can share the data only with each other;
+    // the data is written by the first geometry, so if it's rejected because of the limits of its filter,
+    // the ones in the same batch that share its data must be rejected too; and the data is registered
+    // for the next batches only after it's written, see RegisterSharedData
+    const uint64_t layout = Utils::HashCombine(
+        Utils::HashCombine( Uses16BitIndices( info ), VertexCollectorFilterTypeFlags_GetForGeometry( info ) ),
+        info.flags & ( RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT |
+                       RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT ) );
+
+    // the second hash with another seed, so a collision would have to happen in both
+    constexpr uint64_t verificationSeed = 0x5bd1e9955bd1e995ull;
+
+    const void*  indexData = !UsesIndices( info )       ? nullptr
+                             : Uses16BitIndices( info ) ? static_cast< const void* >( info.pIndices16 )
+                                                        : static_cast< const void* >( info.pIndices );
+    const size_t indexDataSize =
+        !UsesIndices( info ) ? 0
+                             : info.indexCount * ( Uses16BitIndices( info ) ? sizeof( uint16_t ) : sizeof( uint32_t ) );
+
+    const uint64_t indexHash = Utils::HashBytes( indexData, indexDataSize, layout );
+    const uint64_t indexHash2 = Utils::HashBytes( indexData, indexDataSize, layout ^ verificationSeed );
+
+    return {
+        .isValid          = true,
+        .hash             = Utils::HashBytes( info.pVertices, info.vertexCount * sizeof( RgVertex ), indexHash ),
+        .verificationHash = Utils::HashBytes(
+            info.pVertices, info.vertexCount * sizeof( RgVertex ), indexHash2 ^ verificationSeed ),
+        .vertexCount = info.vertexCount,
+        .indexCount  = UsesIndices( info ) ? info.indexCount : 0,
+    };
+}
+
+bool VertexCollector::AcquireMemory( uint32_t   vertexCount,
+                                     uint32_t   indexCount,
+                                     RgVertex** ppOutVertices,
+                                     uint32_t** ppOutIndices )
+{
+    *ppOutVertices = nullptr;
+    *ppOutIndices  = nullptr;
+
+    // same alignment as for the ranges that are reserved on adding a geometry
+    const uint32_t vertCountToReserve = AlignUpBy3( vertexCount );
+    const uint32_t indCountToReserve  = indexCount > 0 ? AlignUpBy3( indexCount ) : 0;
+
+    uint32_t vertIndex, indIndex;
+
+    if( !TryReserveRange( curVertexCount, vertexBase, vertCountToReserve, maxVertexCount, &vertIndex ) )
+    {
+        return false;
+    }
+
+    if( !TryReserveRange( curIndexCount, indexBase, indCountToReserve, maxIndexCount, &indIndex ) )
+    {
+        // release the vertex range, if nothing was reserved after it;
+        // otherwise, it stays unused until the collector is reset
+        uint32_t expected = vertIndex - vertexBase + vertCountToReserve;
+        curVertexCount.compare_exchange_strong( expected, vertIndex - vertexBase );
+
+        return false;
+    }
+
+    // the ranges are in the limits, so the staging buffers can be grown
+    if( !EnsureStagingCapacity( vertIndex + vertCountToReserve, indIndex + indCountToReserve, 0 ) )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( acquiredMutex );
+
+        if( vertexFormat == VertexBufferFormat::Compact )
+        {
+            // staging has a different layout, so a caller writes to a temporary memory
+            // and vertices are encoded on adding a geometry
+            auto data = std::make_unique_for_overwrite< RgVertex[] >( vertexCount );
+            *ppOutVertices = data.get();
+
+            acquiredVertices[ reinterpret_cast< uintptr_t >( data.get() ) ] = AcquiredVertices{
+                .data      = std::move( data ),
+                .count     = vertexCount,
+                .vertIndex = vertIndex,
+            };
+        }
+        else
+        {
+            acquiredVertexRanges[ vertIndex ] = vertexCount;
+        }
+
+        if( indexCount > 0 )
+        {
+            acquiredIndexRanges[ indIndex ] = indexCount;
+        }
+    }
+
+    // staging can be grown before the geometry is added, in that case the pointers
+    // are in a retired staging buffer, and the data is copied from there
+    std::shared_lock< std::shared_mutex > lock( stagingMutex );
+
+    if( vertexFormat != VertexBufferFormat::Compact )
+    {
+        // ShVertex and RgVertex have the same layout, see CopyDataToStaging
+        *ppOutVertices = reinterpret_cast< RgVertex* >( mappedVertexData + vertIndex * vertexStride );
+    }
+
+    *ppOutIndices  = indexCount > 0 ? mappedIndexData + indIndex : nullptr;
+
+    return true;
+}
+
+bool VertexCollector::TryGetAcquiredVertexIndex( const RgVertex* pVertices,
+                                                 uint32_t        vertexCount,
+                                                 uint32_t*       pOutIndex,
+                                                 bool*           pOutIsInStaging ) const
+{
+    auto p = reinterpret_cast< uintptr_t >( pVertices );
+
+    if( vertexFormat == VertexBufferFormat::Compact )
+    {
+        std::lock_guard< std::mutex > lock( acquiredMutex );
+
+        // find the block that starts before the pointer
+        auto f = acquiredVertices.upper_bound( p );
+
+        if( f == acquiredVertices.begin() )
+        {
+            return false;
+        }
+        --f;
+
+        if( p >= f->first + f->second.count * sizeof( RgVertex ) )
+        {
+            return false;
+        }
+
+        const uint32_t offset = static_cast< uint32_t >( ( p - f->first ) / sizeof( RgVertex ) );
+
+        // must still be encoded to staging
+        *pOutIndex       = uint64_t( offset ) + vertexCount <= f->second.count
+                               ? f->second.vertIndex + offset
+                               : UINT32_MAX;
+        *pOutIsInStaging = false;
+        return true;
+    }
+
+    auto begin = reinterpret_cast< uintptr_t >( mappedVertexData );
+
+    uint32_t index;
+    bool     isInStaging;
+
+    if( p >= begin + vertexBase * vertexStride &&
+        p < begin + ( vertexBase + GetCurrentVertexCount() ) * vertexStride )
+    {
+        index       = static_cast< uint32_t >( ( p - begin ) / vertexStride );
+        isInStaging = true;
+    }
+    else
+    {
+        auto r = std::ranges::find_if( retiredStaging, [ p ]( const RetiredStaging& rs ) {
+            auto rbegin = reinterpret_cast< uintptr_t >( rs.mapped );
+            return rs.type == StagingType::Vertices && p >= rbegin && p < rbegin + rs.size;
+        } );
+
+        if( r == retiredStaging.end() )
+        {
+            return false;
+        }
+
+        index       = static_cast< uint32_t >( ( p - reinterpret_cast< uintptr_t >( r->mapped ) ) / vertexStride );
+        isInStaging = false;
+    }
+
+    std::lock_guard< std::mutex > lock( acquiredMutex );
+
+    *pOutIndex       = FindInAcquiredRange( acquiredVertexRanges, index, vertexCount );
+    *pOutIsInStaging = isInStaging;
+    return true;
+}
+
+bool VertexCollector::TryGetAcquiredIndexIndex( const uint32_t* pIndices,
+                                                uint32_t        indexCount,
+                                                uint32_t*       pOutIndex,
+                                                bool*           pOutIsInStaging ) const
+{
+    auto p     = reinterpret_cast< uintptr_t >( pIndices );
+    auto begin = reinterpret_cast< uintptr_t >( mappedIndexData );
+
+    uint32_t index;
+    bool     isInStaging;
+
+    if( p >= begin + indexBase * sizeof( uint32_t ) &&
+        p < begin + ( indexBase + GetCurrentIndexCount() ) * sizeof( uint32_t ) )
+    {
+        index       = static_cast< uint32_t >( ( p - begin ) / sizeof( uint32_t ) );
+        isInStaging = true;
+    }
+    else
+    {
+        auto r = std::ranges::find_if( retiredStaging, [ p ]( const RetiredStaging& rs ) {
+            auto rbegin = reinterpret_cast< uintptr_t >( rs.mapped );
+            return rs.type == StagingType::Indices && p >= rbegin && p < rbegin + rs.size;
+        } );
+
+        if( r == retiredStaging.end() )
+        {
+            return false;
+        }
+
+        index       = static_cast< uint32_t >( ( p - reinterpret_cast< uintptr_t >( r->mapped ) ) / sizeof( uint32_t ) );
+        isInStaging = false;
+    }
+
+    std::lock_guard< std::mutex > lock( acquiredMutex );
+
+    *pOutIndex       = FindInAcquiredRange( acquiredIndexRanges, index, indexCount );
+    *pOutIsInStaging = isInStaging;
+    return true;
+}
+
+bool VertexCollector::SharesStaticData() const
+{
+    return !( filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC );
+}
+
+std::span< std::optional< VertexCollector::StagingRanges > > VertexCollector::GetSharedRangesSpan(
+    std::optional< StagingRanges >& sharedRanges ) const
+{
+    if( SharesStaticData() )
+    {
+        return { &sharedRanges, 1 };
+    }
+
+    return {};
+}
+
+uint32_t VertexCollector::GetVertexCountToReserve( const RgGeometryUploadInfo& info ) const
+{
+    uint32_t unusedIndex;
+    bool     unusedIsInStaging;
+    return TryGetAcquiredVertexIndex( info.pVertices, info.vertexCount, &unusedIndex, &unusedIsInStaging )
+               ? 0
+               : AlignUpBy3( info.vertexCount );
+}
+
+// 16-bit indices are packed in pairs into the same range as 32-bit ones
+static uint32_t GetIndex16SlotCount( uint32_t indexCount )
+{
+    return AlignUpBy3( ( indexCount + 1 ) / 2 );
+}
+
+uint32_t VertexCollector::GetIndexCountToReserve( const RgGeometryUploadInfo& info ) const
+{
+    if( !UsesIndices( info ) )
+    {
+        return 0;
+    }
+
+    // 16-bit indices can't be acquired, so they're always copied
+    if( Uses16BitIndices( info ) )
+    {
+        return GetIndex16SlotCount( info.indexCount );
+    }
+
+    uint32_t unusedIndex;
+    bool     unusedIsInStaging;
+    return TryGetAcquiredIndexIndex( info.pIndices, info.indexCount, &unusedIndex, &unusedIsInStaging )
+               ? 0
+               : AlignUpBy3( info.indexCount );
+}
+
+VertexCollector::StagingRanges VertexCollector::ReserveRanges(
+    std::span< const RgGeometryUploadInfo > infos,
+    std::span< std::optional< StagingRanges > > outSharedRanges,
+    std::vector< NewSharedData >*               pOutNewSharedData )
+{
+    const bool shareData = !outSharedRanges.empty();
+    assert( !shareData || outSharedRanges.size() == infos.size() );
+    assert( !shareData || pOutNewSharedData != nullptr );
+
+    // hash outside of the lock
+    std::vector< SharedDataKey > keys;
+    // index of a geometry in the batch with the same data, that is placed before
+    std::vector< size_t > sameAsInBatch;
+
+    if( shareData )
+    {
+        keys.reserve( infos.size() );
+
+        for( const RgGeometryUploadInfo& info : infos )
+        {
+            keys.push_back( GetSharedDataKey( info ) );
+        }
+
+        // only the written data is registered, so the geometries with the same data
+        // that are added concurrently may reserve their own ranges
+        std::lock_guard< std::mutex > sharedDataLock( sharedDataMutex );
+        sameAsInBatch.assign( infos.size(), SIZE_MAX );
+
+        rgl::unordered_map< uint64_t, size_t > firstInBatch;
+
+        for( size_t i = 0; i < infos.size(); i++ )
+        {
+            outSharedRanges[ i ] = std::nullopt;
+
+            if( !keys[ i ].isValid )
+            {
+                continue;
+            }
+
+            auto f = sharedData.find( keys[ i ].hash );
+
+            if( f != sharedData.end() )
+            {
+                const SharedData& d = f->second;
+
+                if( keys[ i ].Matches( d.verificationHash, d.vertexCount, d.indexCount ) )
+                {
+                    outSharedRanges[ i ] = StagingRanges{
+                        .vertIndex    = d.vertIndex,
+                        .indIndex     = d.indIndex,
+                        .isSharedData = true,
+                    };
+                }
+                continue;
+            }
+
+            const auto [ first, isFirst ] = firstInBatch.emplace( keys[ i ].hash, i );
+            const SharedDataKey& firstKey = keys[ first->second ];
+
+            if( !isFirst &&
+                keys[ i ].Matches( firstKey.verificationHash, firstKey.vertexCount, firstKey.indexCount ) )
+            {
+                sameAsInBatch[ i ] = first->second;
+            }
+        }
+    }
+
+    auto isShared = [ & ]( size_t i ) {
+        return shareData && ( outSharedRanges[ i ] || sameAsInBatch[ i ] != SIZE_MAX );
+    };
+
+    uint32_t vertexCount    = 0;
+    uint32_t indexCount     = 0;
+    uint32_t primitiveCount = 0;
+
+    {
+        std::shared_lock< std::shared_mutex > lock( stagingMutex );
+
+        // sizes are aligned, so each range starts at an index that is divisible by 3
+        for( size_t i = 0; i < infos.size(); i++ )
+        {
+            if( !isShared( i ) )
+            {
+                vertexCount += GetVertexCountToReserve( infos[ i ] );
+                indexCount += GetIndexCountToReserve( infos[ i ] );
+            }
+
+            primitiveCount += GetPrimitiveCount( infos[ i ] );
+        }
+    }
+
+    // one atomic operation per counter for the whole batch
+    StagingRanges ranges = {};
+    ranges.vertIndex      = vertexBase + curVertexCount.fetch_add( vertexCount );
+    ranges.indIndex       = indexBase + ( indexCount > 0 ? curIndexCount.fetch_add( indexCount ) : 0 );
+    ranges.transformIndex = transformBase + curTransformCount.fetch_add( static_cast< uint32_t >( infos.size() ) );
+    curPrimitiveCount.fetch_add( primitiveCount );
+
+    // if the limit is reached, geometries that don't fit are rejected on the bounds check
+    EnsureStagingCapacity( ranges.vertIndex + vertexCount,
+                           ranges.indIndex + indexCount,
+                           ranges.transformIndex + static_cast< uint32_t >( infos.size() ) );
+
+    if( shareData )
+    {
+        std::shared_lock< std::shared_mutex > lock( stagingMutex );
+
+        // collect the ranges of the new data, and set transform indices of the shared ones
+        StagingRanges cur = ranges;
+        pOutNewSharedData->clear();
+
+        // index in pOutNewSharedData of the data that is written by a geometry in the batch
+        rgl::unordered_map< size_t, size_t > ownerToNew;
+
+        for( size_t i = 0; i < infos.size(); i++ )
+        {
+            if( sameAsInBatch[ i ] != SIZE_MAX )
+            {
+                const NewSharedData& n = ( *pOutNewSharedData )[ ownerToNew.at( sameAsInBatch[ i ] ) ];
+
+                outSharedRanges[ i ] = StagingRanges{
+                    .vertIndex       = n.data.vertIndex,
+                    .indIndex        = n.data.indIndex,
+                    .isSharedData    = true,
+                    .sharedDataOwner = n.owner,
+                };
+            }
+            else if( !outSharedRanges[ i ] && keys[ i ].isValid )
+            {
+                ownerToNew[ i ] = pOutNewSharedData->size();
+
+                pOutNewSharedData->push_back( NewSharedData{
+                    .owner = i,
+                    .hash  = keys[ i ].hash,
+                    .data =
+                        SharedData{
+                            .verificationHash = keys[ i ].verificationHash,
+                            .vertexCount      = keys[ i ].vertexCount,
+                            .indexCount       = keys[ i ].indexCount,
+                            .vertIndex        = cur.vertIndex,
+                            .indIndex         = cur.indIndex,
+                        },
+                } );
+            }
+
+            if( outSharedRanges[ i ] )
+            {
+                outSharedRanges[ i ]->transformIndex = cur.transformIndex;
+            }
+
+            cur.Advance( *this, infos[ i ], isShared( i ) );
+        }
+    }
+
+    return ranges;
+}
+
+void VertexCollector::RegisterSharedData( std::span< const NewSharedData > newSharedData,
+                                          std::span< const uint32_t >      results )
+{
+    if( newSharedData.empty() )
+    {
+        return;
+    }
+
+    std::lock_guard< std::mutex > lock( sharedDataMutex );
+
+    for( const NewSharedData& n : newSharedData )
+    {
+        // if the same data was registered concurrently, keep the first one
+        if( results[ n.owner ] != UINT32_MAX )
+        {
+            sharedData.try_emplace( n.hash, n.data );
+        }
+    }
+}
+
+static void SetMaterials( ShGeometryInstance& geomInfo, std::span< MaterialTextures, 3 > materials )
+{
+    static_assert( sizeof( RgLayeredMaterial ) / sizeof( RgMaterial ) == MATERIALS_MAX_LAYER_COUNT,
+                   "Layer count mismatch with ShGeometryInstance" );
+
+    geomInfo.materials0A = materials[ 0 ].indices[ 0 ];
+    geomInfo.materials0B = materials[ 0 ].indices[ 1 ];
+    geomInfo.materials0C = materials[ 0 ].indices[ 2 ];
+
+    geomInfo.materials1A = materials[ 1 ].indices[ 0 ];
+    geomInfo.materials1B = materials[ 1 ].indices[ 1 ];
+    // no materials1C member
+
+    geomInfo.materials2A = materials[ 2 ].indices[ 0 ];
+    geomInfo.materials2B = materials[ 2 ].indices[ 1 ];
+    // no materials2C member
+}
+
+bool VertexCollector::PrepareGeometry( uint32_t                         frameIndex,
+                                       const RgGeometryUploadInfo&      info,
+                                       std::span< MaterialTextures, 3 > materials,
+                                       const StagingRanges&             ranges,
+                                       PendingGeometry&                 result )
+{
+    const VertexCollectorFilterTypeFlags geomFlags =
+        VertexCollectorFilterTypeFlags_GetForGeometry( info );
+
+    // if exceeds a limit of geometries in a group with specified geomFlags
+    VertexCollectorFilter& filter = GetFilter( geomFlags );
+
+    if( !filter.TryReserveGeometry() )
+    {
+        assert( false && "Too many geometries in a group" );
+        return false;
+    }
+
+    if( !PrepareGeometryData( frameIndex, info, materials, ranges, result ) )
+    {
+        // the geometry won't be pushed, so the slot can be used by others
+        filter.ReleaseGeometry();
+        return false;
+    }
+
+    return true;
+}
+
+bool VertexCollector::PrepareGeometryData( uint32_t                         frameIndex,
+                                           const RgGeometryUploadInfo&      info,
+                                           std::span< MaterialTextures, 3 > materials,
+                                           const StagingRanges&             ranges,
+                                           PendingGeometry&                 result )
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+    const VertexCollectorFilterTypeFlags      geomFlags =
+        VertexCollectorFilterTypeFlags_GetForGeometry( info );
+
+
+    const bool collectStatic = geomFlags & ( FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE );
+
+    const bool     useIndices     = UsesIndices( info );
+    const uint32_t primitiveCount = GetPrimitiveCount( info );
+
+    // chunk ranges are allocated for 32-bit indices, so they're widened on copying
+    const bool     useIndices16   = Uses16BitIndices( info ) && !ranges.isChunk;
+    const bool     widenIndices16 = Uses16BitIndices( info ) && ranges.isChunk;
+
+    uint32_t       vertIndex      = ranges.vertIndex;
+    uint32_t       indIndex       = ranges.indIndex;
+    const uint32_t transformIndex = ranges.transformIndex;
+
+    // data that was written in place by a caller doesn't need to be copied,
+    // unless the staging buffer was grown after acquiring the memory
+    bool       vertsInStaging = false;
+    bool       indsInStaging  = false;
+    const bool vertsAcquired =
+        TryGetAcquiredVertexIndex( info.pVertices, info.vertexCount, &vertIndex, &vertsInStaging );
+    const bool indsAcquired = useIndices && !Uses16BitIndices( info ) &&
+                              TryGetAcquiredIndexIndex( info.pIndices, info.indexCount, &indIndex, &indsInStaging );
+
+    // data must not exceed the memory that was acquired for it
+    if( ( vertsAcquired && vertIndex == UINT32_MAX ) || ( indsAcquired && indIndex == UINT32_MAX ) )
+    {
+        return false;
+    }
+
+    // index of the first index in the index buffer, with a flag if it's 16-bit;
+    // 16-bit indices are addressed in uint16_t units
+    const uint32_t baseIndexIndex = !useIndices    ? UINT32_MAX
+                                    : useIndices16 ? ( indIndex * 2 ) | GEOM_INST_INDEX_16_BIT_FLAG
+                                                   : indIndex;
+
+    // hash dynamic data to find out if it's the same as in the staging buffers,
+    // in-place data is considered as changed, as reading it back would be slow
+    std::optional< uint64_t > dataHash;
+    std::optional< uint64_t > topologyHash;
+    bool                      isRetained = false;
+
+    // dynamic geometry with the same indices and vertex count can be refitted in BLAS
+    if( ( geomFlags & FT::CF_DYNAMIC ) && !indsAcquired )
+    {
+        uint64_t indexHash =
+            !useIndices ? 0
+            : Uses16BitIndices( info )
+                ? Utils::HashBytes( info.pIndices16, info.indexCount * sizeof( uint16_t ) )
+                : Utils::HashBytes( info.pIndices, info.indexCount * sizeof( uint32_t ) );
+
+        topologyHash = Utils::HashCombine(
+            Utils::HashCombine( Utils::HashCombine( indexHash, info.uniqueID ), info.vertexCount ),
+            primitiveCount );
+
+        if( !vertsAcquired )
+        {
+            dataHash = Utils::HashBytes(
+                info.pVertices, info.vertexCount * sizeof( RgVertex ), indexHash );
+        }
+    }
+
+    if( dataHash )
+    {
+        auto r = retainedGeometries.find( info.uniqueID );
+
+        isRetained = r != retainedGeometries.end() && 
+                     r->second.dataHash == *dataHash &&
+                     r->second.vertIndex == vertIndex && 
+                     r->second.indIndex == baseIndexIndex;
+    }
+
+
+    // check bounds; if a limit is reached, the geometry is rejected and a caller reports it
+    if( !ranges.isChunk )
+    {
+        // staging buffers are grown on reserving, so the ranges exceed them only if the limit is reached
+        if( vertIndex + AlignUpBy3( info.vertexCount ) > stagingVertexCapacity )
+        {
+            return false;
+        }
+
+        const uint32_t indexSlotCount =
+            useIndices16 ? GetIndex16SlotCount( info.indexCount ) : AlignUpBy3( info.indexCount );
+
+        if( useIndices && indIndex + indexSlotCount > stagingIndexCapacity )
+        {
+            return false;
+        }
+
+        if( transformIndex + 1 > stagingTransformCapacity )
+        {
+            return false;
+        }
+
+        // each geometry has its own transform, so transform index is a geometry index in this collector
+        const uint32_t geomCountBefore = collectStatic ? 0 : geomInfoMgr->GetStaticCount();
+
+        if( geomCountBefore + ( transformIndex - transformBase ) + 1 > MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT )
+        {
+            return false;
+        }
+    }
+
+
+    // copy data to buffer; acquired vertices of the compact format are never in staging,
+    // as they must be encoded
+    assert( stagingVertBuffer->IsMapped() );
+    if( !( vertsAcquired && vertsInStaging ) && !isRetained && !ranges.isSharedData )
+    {
+        CopyDataToStaging( info, vertIndex );
+    }
+
+    if( useIndices && !( indsAcquired && indsInStaging ) && !isRetained && !ranges.isSharedData )
+    {
+        assert( stagingIndexBuffer->IsMapped() );
+
+        if( useIndices16 )
+        {
+            memcpy( reinterpret_cast< uint16_t* >( mappedIndexData + indIndex ),
+                    info.pIndices16,
+                    info.indexCount * sizeof( uint16_t ) );
+        }
+        else if( widenIndices16 )
+        {
+            std::copy_n( info.pIndices16, info.indexCount, mappedIndexData + indIndex );
+        }
+        else
+        {
+            memcpy( mappedIndexData + indIndex, info.pIndices, info.indexCount * sizeof( uint32_t ) );
+        }
+    }
+
+    static_assert( sizeof( RgTransform ) == sizeof( VkTransformMatrixKHR ),
+                   "RgTransform and VkTransformMatrixKHR must have the same structure to be used "
+                   "in AS building" );
+    memcpy( mappedTransformData + transformIndex, &info.transform, sizeof( VkTransformMatrixKHR ) );
+
+    // use positions and index data in the device local buffers: AS shouldn't be built using staging
+    // buffers
+    static_assert( offsetof( ShVertex, position ) == 0 && offsetof( ShVertexCompact, position ) == 0 );
+    const VkDeviceAddress vertexDataDeviceAddress = vertBuffer->GetAddress() + vertIndex * vertexStride;
+
+    // geometry info
+    VkAccelerationStructureGeometryKHR& geom = result.asGeometry;
+    geom                                     = {};
+    geom.sType                               = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+    geom.geometryType                        = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+
+    geom.flags = geomFlags & FT::PT_OPAQUE ? VK_GEOMETRY_OPAQUE_BIT_KHR
+                                           : VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+
+    VkAccelerationStructureGeometryTrianglesDataKHR& trData = geom.geometry.triangles;
+    trData.sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+    trData.vertexFormat = VK_FORMAT_R32G32B32_SFLOAT;
+    trData.maxVertex    = info.vertexCount;
+    trData.vertexData.deviceAddress = vertexDataDeviceAddress;
+    trData.vertexStride             = vertexStride;
+    trData.transformData.deviceAddress =
+        transformsBuffer->GetAddress() + transformIndex * sizeof( VkTransformMatrixKHR );
+
+    if( useIndices )
+    {
+        // 16-bit indices also start at a uint32_t slot
+        const VkDeviceAddress indexDataDeviceAddress =
+            indexBuffer->GetAddress() + indIndex * sizeof( uint32_t );
+
+        trData.indexType               = useIndices16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        trData.indexData.deviceAddress = indexDataDeviceAddress;
+    }
+    else
+    {
+        trData.indexType = VK_INDEX_TYPE_NONE_KHR;
+        trData.indexData = {};
+    }
+
+
+    VkAccelerationStructureBuildRangeInfoKHR& rangeInfo = result.asBuildRangeInfo;
+    rangeInfo                                           = {};
+    rangeInfo.primitiveCount                            = primitiveCount;
+    rangeInfo.primitiveOffset                           = 0;
+    rangeInfo.firstVertex                               = 0;
+    rangeInfo.transformOffset                           = 0;
+
+
+    ShGeometryInstance& geomInfo = result.geomInfo;
+    geomInfo                     = {};
+
+    geomInfo.baseVertexIndex    = vertIndex;
+    geomInfo.baseIndexIndex     = baseIndexIndex;
+    geomInfo.vertexCount        = info.vertexCount;
+    geomInfo.indexCount         = useIndices ? info.indexCount : UINT32_MAX;
+    geomInfo.defaultRoughness   = std::clamp( info.defaultRoughness, 0.0f, 1.0f );
+    geomInfo.defaultMetallicity = std::clamp( info.defaultMetallicity, 0.0f, 1.0f );
+    geomInfo.defaultEmission    = std::clamp( info.defaultEmission, 0.0f, 1.0f );
+
+    Matrix::ToMat4Transposed( geomInfo.model, info.transform );
+
+    geomInfo.flags = GetMaterialsBlendFlags( info.layerBlendingTypes, MATERIALS_MAX_LAYER_COUNT );
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
+    }
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_GENERATE_NORMALS;
+        geomInfo.flags |= GEOM_INST_FLAG_INVERTED_NORMALS;
+    }
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_EXACT_NORMALS_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_EXACT_NORMALS;
+    }
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_NO_MEDIA_CHANGE_ON_REFRACT_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_NO_MEDIA_CHANGE;
+    }
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_MULTIPLY_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_REFL_REFR_ALBEDO_MULT;
+    }
+    else if( info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_ADD_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_REFL_REFR_ALBEDO_ADD;
+    }
+
+    if( info.flags & RG_GEOMETRY_UPLOAD_IGNORE_REFRACT_AFTER_REFRACT_BIT )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_IGNORE_REFRACT_AFTER;
+    }
+
+    if( geomFlags & FT::CF_STATIC_MOVABLE )
+    {
+        geomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+    }
+
+    switch( info.passThroughType )
+    {
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR:
+            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
+            break;
+
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL:
+            if( info.pPortalIndex )
+            {
+                geomInfo.flags |= GEOM_INST_FLAG_PORTAL;
+            }
+            break;
+
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT:
+            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
+            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
+            break;
+
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT:
+            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_WATER;
+            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
+            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
+            break;
+
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT:
+            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_GLASS;
+            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
+            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
+            break;
+
+        case RG_GEOMETRY_PASS_THROUGH_TYPE_ACID_REFLECT_REFRACT:
+            geomInfo.flags |= GEOM_INST_FLAG_MEDIA_TYPE_ACID;
+            geomInfo.flags |= GEOM_INST_FLAG_REFLECT;
+            geomInfo.flags |= GEOM_INST_FLAG_REFRACT;
+            break;
+
+        default: break;
+    }
+
+    SetMaterials( geomInfo, materials );
+
+    for( uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++ )
+    {
+        memcpy( geomInfo.materialColors[ layer ],
+                info.layerColors[ layer ].data,
+                sizeof( info.layerColors[ layer ].data ) );
+    }
+
+
+    geomInfo.portalIndex = info.pPortalIndex ? *info.pPortalIndex : PORTAL_INDEX_NONE;
+
+
+    result.uniqueID       = info.uniqueID;
+    result.frameIndex     = frameIndex;
+    result.flags          = geomFlags;
+    result.transformIndex = transformIndex;
+    result.primitiveCount = primitiveCount;
+    result.dataHash       = dataHash;
+
+    if( dataHash )
+    {
+        uint64_t blasHash = Utils::HashBytes( &info.transform, sizeof( info.transform ), *dataHash );
+        result.blasHash   = Utils::HashCombine( blasHash, primitiveCount );
+    }
+    else
+    {
+        result.blasHash = std::nullopt;
+    }
+
+    result.topologyHash = topologyHash;
+
+    return true;
+}
+
+uint32_t VertexCollector::RegisterGeometry( const PendingGeometry& pending )
+{
+    uint32_t localIndex = PushGeometry( pending.flags, pending.asGeometry );
+    PushRangeInfo( pending.flags, pending.asBuildRangeInfo );
+    PushPrimitiveCount( pending.flags, pending.primitiveCount );
+    GetFilter( pending.flags ).PushContentHash( pending.flags, pending.blasHash );
+    GetFilter( pending.flags ).PushTopologyHash( pending.flags, pending.topologyHash );
+
+    ShGeometryInstance geomInfo = pending.geomInfo;
+
+    // simple index -- calculated as (global cur static count + global cur dynamic count)
+    // global geometry index -- for indexing in geom infos buffer
+    // local geometry index -- index of geometry in BLAS
+    return geomInfoMgr->WriteGeomInfo(
+        pending.frameIndex, pending.uniqueID, localIndex, pending.flags, geomInfo );
+}
+
+uint32_t VertexCollector::AddGeometry( uint32_t                         frameIndex,
+                                       const RgGeometryUploadInfo&      info,
+                                       std::span< MaterialTextures, 3 > materials )
+{
+    std::optional< StagingRanges > sharedRanges;
+    std::vector< NewSharedData >   newSharedData;
+    StagingRanges                  ranges =
+        ReserveRanges( { &info, 1 }, GetSharedRangesSpan( sharedRanges ), &newSharedData );
+    PendingGeometry                pending;
+
+    {
+        std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+
+        if( !PrepareGeometry( frameIndex, info, materials, sharedRanges.value_or( ranges ), pending ) )
+        {
+            return UINT32_MAX;
+        }
+    }
+
+    const uint32_t prepared = 0;
+    RegisterSharedData( newSharedData, { &prepared, 1 } );
+
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    uint32_t simpleIndex = RegisterGeometry( pending );
+    AddStaticDependencies( simpleIndex, info, materials, pending );
+
+    return simpleIndex;
+}
+
+void VertexCollector::AddStaticDependencies( uint32_t                         simpleIndex,
+                                             const RgGeometryUploadInfo&      info,
+                                             std::span< MaterialTextures, 3 > materials,
+                                             const PendingGeometry&           pending )
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+    const bool collectStatic = pending.flags & ( FT::CF_STATIC_NON_MOVABLE | FT::CF_STATIC_MOVABLE );
+
+    // add material dependency but only for static geometry,
+    // dynamic is updated each frame, so their materials will be updated anyway
+    if( !collectStatic )
+    {
+        return;
+    }
+
+    const std::tuple<uint32_t, RgMaterial, std::array<uint32_t, TEXTURES_PER_MATERIAL_COUNT>> layerDependencies[] =
     {
         /* layer index - its material - corresponding texture indices */
         { 0, info.geomMaterial.layerMaterials[0], { materials[0].indices[0], materials[0].indices[1], materials[0].indices[2] } },
@@ -433,55 +1625,573 @@ uint32_t VertexCollector::AddGeometry( uint32_t                         frameInd
         { 2, info.geomMaterial.layerMaterials[2], { materials[2].indices[0], materials[2].indices[1], EMPTY_TEXTURE_INDEX     } },
     };
 
+    for( const auto& [ layerIndex, materialIndex, textureIndices ] : layerDependencies )
+    {
+        // if at least one texture is not empty on this layer, add dependency to the material
+        // layer
+        for( uint32_t textureIndex : textureIndices )
+        {
+            if( textureIndex != EMPTY_TEXTURE_INDEX )
+            {
+                AddMaterialDependency( simpleIndex, layerIndex, materialIndex );
+                break;
+            }
+        }
+    }
+
+    // also, save transform index for updating static movable's transforms
+    simpleIndexToTransform[ simpleIndex ] = { pending.transformIndex, pending.flags };
+}
+
+bool VertexCollector::AddGeometryDeferred( uint32_t                         frameIndex,
+                                           const RgGeometryUploadInfo&      info,
+                                           std::span< MaterialTextures, 3 > materials )
+{
+    uint32_t result;
+    AddGeometriesDeferred( frameIndex, { &info, 1 }, materials, { &result, 1 } );
+
+    return result != UINT32_MAX;
+}
+
+void VertexCollector::AddGeometries( uint32_t                                frameIndex,
+                                     std::span< const RgGeometryUploadInfo > infos,
+                                     std::span< MaterialTextures >           materials,
+                                     std::span< uint32_t >                   outResults )
+{
+    assert( materials.size() == infos.size() * 3 );
+    assert( outResults.size() == infos.size() );
+
+    std::vector< std::optional< StagingRanges > > sharedRanges( SharesStaticData() ? infos.size() : 0 );
+    std::vector< NewSharedData >                  newSharedData;
+    StagingRanges                                 ranges = ReserveRanges( infos, sharedRanges, &newSharedData );
+
+    // copy data without registering, and then register everything at once
+    std::vector< PendingGeometry > pending( infos.size() );
 
-    for( uint32_t layer = 0; layer < MATERIALS_MAX_LAYER_COUNT; layer++ )
     {
-        memcpy( geomInfo.materialColors[ layer ],
-                info.layerColors[ layer ].data,
-                sizeof( info.layerColors[ layer ].data ) );
+        std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+
+        for( size_t i = 0; i < infos.size(); i++ )
+        {
+            const bool isShared = !sharedRanges.empty() && sharedRanges[ i ];
+
+            // the data is not written, if the geometry in the batch that owns it was rejected
+            const size_t owner = isShared ? sharedRanges[ i ]->sharedDataOwner : SIZE_MAX;
+
+            bool prepared = ( owner == SIZE_MAX || outResults[ owner ] != UINT32_MAX ) &&
+                            PrepareGeometry( frameIndex,
+                                             infos[ i ],
+                                             materials.subspan( i * 3 ).first< 3 >(),
+                                             isShared ? *sharedRanges[ i ] : ranges,
+                                             pending[ i ] );
+
+            outResults[ i ] = prepared ? 0 : UINT32_MAX;
+            ranges.Advance( *this, infos[ i ], isShared );
+        }
+    }
+
+    RegisterSharedData( newSharedData, outResults );
+
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    for( size_t i = 0; i < infos.size(); i++ )
+    {
+        if( outResults[ i ] == UINT32_MAX )
+        {
+            continue;
+        }
+
+        uint32_t simpleIndex = RegisterGeometry( pending[ i ] );
+        AddStaticDependencies(
+            simpleIndex, infos[ i ], materials.subspan( i * 3 ).first< 3 >(), pending[ i ] );
+
+        outResults[ i ] = simpleIndex;
+    }
+}
+
+void VertexCollector::AddGeometriesDeferred( uint32_t                                frameIndex,
+                                             std::span< const RgGeometryUploadInfo > infos,
+                                             std::span< MaterialTextures >           materials,
+                                             std::span< uint32_t >                   outResults )
+{
+    // material dependencies are not tracked for deferred geometry
+    assert( filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC );
+    assert( materials.size() == infos.size() * 3 );
+    assert( outResults.size() == infos.size() );
+
+    StagingRanges ranges = ReserveRanges( infos );
+
+    // buckets are sharded by thread, so holding the lock while copying is cheap
+    PendingBucket& bucket = pendingBuckets[ GetPendingBucketIndex() ];
+
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+    std::lock_guard< std::mutex >         lock( bucket.lock );
+    bucket.geometries.reserve( bucket.geometries.size() + infos.size() );
+
+    for( size_t i = 0; i < infos.size(); i++ )
+    {
+        PendingGeometry& pending = bucket.geometries.emplace_back();
+
+        if( PrepareGeometry(
+                frameIndex, infos[ i ], materials.subspan( i * 3 ).first< 3 >(), ranges, pending ) )
+        {
+            outResults[ i ] = 0;
+        }
+        else
+        {
+            bucket.geometries.pop_back();
+            outResults[ i ] = UINT32_MAX;
+        }
+
+        ranges.Advance( *this, infos[ i ] );
+    }
+}
+
+uint32_t VertexCollector::AddMesh( uint32_t                         frameIndex,
+                                   const RgGeometryUploadInfo&      info,
+                                   std::span< MaterialTextures, 3 > materials )
+{
+    assert( !( filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC ) );
+
+    std::optional< StagingRanges > sharedRanges;
+    std::vector< NewSharedData >   newSharedData;
+    StagingRanges                  ranges =
+        ReserveRanges( { &info, 1 }, GetSharedRangesSpan( sharedRanges ), &newSharedData );
+    PendingGeometry                pending;
+
+    {
+        std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+
+        // mesh is not a part of any filter, so don't reserve a place there
+        if( !PrepareGeometryData( frameIndex, info, materials, sharedRanges.value_or( ranges ), pending ) )
+        {
+            return UINT32_MAX;
+        }
+    }
+
+    const uint32_t prepared = 0;
+    RegisterSharedData( newSharedData, { &prepared, 1 } );
+
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    meshes.push_back( pending );
+    return static_cast< uint32_t >( meshes.size() - 1 );
+}
+
+uint32_t VertexCollector::GetMeshCount() const
+{
+    return static_cast< uint32_t >( meshes.size() );
+}
+
+VertexCollectorFilterTypeFlags VertexCollector::GetMeshFilter( uint32_t meshIndex ) const
+{
+    return meshes[ meshIndex ].flags;
+}
+
+const VkAccelerationStructureGeometryKHR& VertexCollector::GetMeshASGeometry( uint32_t meshIndex ) const
+{
+    return meshes[ meshIndex ].asGeometry;
+}
+
+const VkAccelerationStructureBuildRangeInfoKHR& VertexCollector::GetMeshASBuildRangeInfo( uint32_t meshIndex ) const
+{
+    return meshes[ meshIndex ].asBuildRangeInfo;
+}
+
+const uint32_t& VertexCollector::GetMeshPrimitiveCount( uint32_t meshIndex ) const
+{
+    return meshes[ meshIndex ].primitiveCount;
+}
+
+uint32_t VertexCollector::WriteMeshInstanceGeomInfo( uint32_t                         frameIndex,
+                                                     uint32_t                         meshIndex,
+                                                     uint64_t                         instanceUniqueID,
+                                                     const RgTransform&               transform,
+                                                     std::span< MaterialTextures, 3 > materials )
+{
+    ShGeometryInstance geomInfo = meshes[ meshIndex ].geomInfo;
+
+    // mesh instances are always moving, so previous model matrix must be used
+    geomInfo.flags |= GEOM_INST_FLAG_IS_MOVABLE;
+
+    Matrix::ToMat4Transposed( geomInfo.model, transform );
+
+    // materials are updated every frame, as for dynamic geometry
+    SetMaterials( geomInfo, materials );
+
+    return geomInfoMgr->WriteMeshInstanceGeomInfo( frameIndex, instanceUniqueID, geomInfo );
+}
+
+bool VertexCollector::AddChunk( uint64_t                                chunkID,
+                                uint32_t                                frameIndex,
+                                std::span< const RgGeometryUploadInfo > infos,
+                                std::span< MaterialTextures >           materials )
+{
+    assert( !( filtersFlags & VertexCollectorFilterTypeFlagBits::CF_DYNAMIC ) );
+    assert( materials.size() == infos.size() * 3 );
+
+    uint32_t vertexCount = 0;
+    uint32_t indexCount  = 0;
+
+    for( const RgGeometryUploadInfo& info : infos )
+    {
+        vertexCount += AlignUpBy3( info.vertexCount );
+        indexCount += UsesIndices( info ) ? AlignUpBy3( info.indexCount ) : 0;
+    }
+
+    auto chunk = std::make_unique< Chunk >();
+
+    {
+        std::lock_guard< std::mutex > lock( registerMutex );
+
+        if( chunks.contains( chunkID ) )
+        {
+            return false;
+        }
+
+        auto vertRange      = chunkVertAllocator.Allocate( vertexCount );
+        auto indexRange     = chunkIndexAllocator.Allocate( indexCount );
+        auto transformRange = chunkTransformAllocator.Allocate( uint32_t( infos.size() ) );
+
+        if( !vertRange || !indexRange || !transformRange )
+        {
+            if( vertRange )
+            {
+                chunkVertAllocator.Free( *vertRange );
+            }
+
+            if( indexRange )
+            {
+                chunkIndexAllocator.Free( *indexRange );
+            }
+
+            if( transformRange )
+            {
+                chunkTransformAllocator.Free( *transformRange );
+            }
+
+            return false;
+        }
+
+        chunk->vertRange      = *vertRange;
+        chunk->indexRange     = *indexRange;
+        chunk->transformRange = *transformRange;
+
+        // reserve the ID, so other threads can't add the same chunk
+        chunks[ chunkID ] = nullptr;
+    }
+
+    StagingRanges ranges = {
+        .vertIndex      = chunk->vertRange.offset,
+        .indIndex       = chunk->indexRange.offset,
+        .transformIndex = chunk->transformRange.offset,
+        .isChunk        = true,
+    };
+
+    // ranges are not shared, so copy without registering
+    std::vector< PendingGeometry > pending( infos.size() );
+    bool                           allPrepared = true;
+
+    {
+        std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+
+        for( size_t i = 0; i < infos.size() && allPrepared; i++ )
+        {
+            allPrepared = PrepareGeometryData(
+                frameIndex, infos[ i ], materials.subspan( i * 3 ).first< 3 >(), ranges, pending[ i ] );
+
+            // no in-place data for chunks, so sizes are always reserved
+            ranges.vertIndex += AlignUpBy3( infos[ i ].vertexCount );
+            ranges.indIndex += UsesIndices( infos[ i ] ) ? AlignUpBy3( infos[ i ].indexCount ) : 0;
+            ranges.transformIndex += 1;
+        }
+    }
+
+    // the chunk is added entirely or not at all, so release its ranges and ID
+    if( !allPrepared )
+    {
+        std::lock_guard< std::mutex > lock( registerMutex );
+
+        chunkVertAllocator.Free( chunk->vertRange );
+        chunkIndexAllocator.Free( chunk->indexRange );
+        chunkTransformAllocator.Free( chunk->transformRange );
+        chunks.erase( chunkID );
+
+        return false;
+    }
+
+    // geometries with the same filter are built into the same BLAS
+    std::vector< uint32_t > order( infos.size() );
+    for( uint32_t i = 0; i < order.size(); i++ )
+    {
+        order[ i ] = i;
+    }
+
+    std::stable_sort( order.begin(), order.end(), [ &pending ]( uint32_t a, uint32_t b ) {
+        return pending[ a ].flags < pending[ b ].flags;
+    } );
+
+    for( uint32_t i : order )
+    {
+        const PendingGeometry& p = pending[ i ];
+
+        if( chunk->groups.empty() || chunk->groups.back().filter != p.flags )
+        {
+            chunk->groups.push_back( ChunkGroup{ .filter = p.flags, .firstGlobalGeomIndex = UINT32_MAX } );
+        }
+
+        ChunkGroup& g = chunk->groups.back();
+        g.asGeometries.push_back( p.asGeometry );
+        g.asBuildRangeInfos.push_back( p.asBuildRangeInfo );
+        g.primitiveCounts.push_back( p.primitiveCount );
+
+        chunk->geometries.push_back( Chunk::Geometry{
+            .uniqueID   = p.uniqueID,
+            .groupIndex = uint32_t( chunk->groups.size() - 1 ),
+            .geomInfo   = p.geomInfo,
+            .material   = infos[ i ].geomMaterial,
+        } );
+    }
+
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    QueueChunkDataCopy( *chunk, true, true, true );
+
+    chunks[ chunkID ] = std::move( chunk );
+    return true;
+}
+
+void VertexCollector::QueueChunkDataCopy( const Chunk& chunk, bool vertices, bool indices, bool transforms )
+{
+    if( vertices && chunk.vertRange.count > 0 )
+    {
+        chunkVertsToCopy.push_back( VkBufferCopy{
+            .srcOffset = chunk.vertRange.offset * vertexStride,
+            .dstOffset = chunk.vertRange.offset * vertexStride,
+            .size      = chunk.vertRange.count * vertexStride,
+        } );
+    }
+
+    if( indices && chunk.indexRange.count > 0 )
+    {
+        chunkIndicesToCopy.push_back( VkBufferCopy{
+            .srcOffset = chunk.indexRange.offset * sizeof( uint32_t ),
+            .dstOffset = chunk.indexRange.offset * sizeof( uint32_t ),
+            .size      = chunk.indexRange.count * sizeof( uint32_t ),
+        } );
+    }
+
+    if( transforms && chunk.transformRange.count > 0 )
+    {
+        chunkTransformsToCopy.push_back( VkBufferCopy{
+            .srcOffset = chunk.transformRange.offset * sizeof( VkTransformMatrixKHR ),
+            .dstOffset = chunk.transformRange.offset * sizeof( VkTransformMatrixKHR ),
+            .size      = chunk.transformRange.count * sizeof( VkTransformMatrixKHR ),
+        } );
+    }
+}
+
+void VertexCollector::RemoveChunk( uint64_t chunkID, uint32_t frameIndex )
+{
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    auto f = chunks.find( chunkID );
+
+    // null, if it's still being added
+    if( f == chunks.end() || f->second == nullptr )
+    {
+        return;
+    }
+
+    removedChunks[ frameIndex ].push_back( std::move( f->second ) );
+    chunks.erase( f );
+}
+
+void VertexCollector::FreeRemovedChunks( uint32_t frameIndex )
+{
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    for( const auto& c : removedChunks[ frameIndex ] )
+    {
+        chunkVertAllocator.Free( c->vertRange );
+        chunkIndexAllocator.Free( c->indexRange );
+        chunkTransformAllocator.Free( c->transformRange );
     }
 
+    removedChunks[ frameIndex ].clear();
+}
+
+const std::vector< VertexCollector::ChunkGroup >* VertexCollector::GetChunkGroups( uint64_t chunkID ) const
+{
+    auto f = chunks.find( chunkID );
+
+    if( f == chunks.end() || f->second == nullptr )
+    {
+        return nullptr;
+    }
+
+    return &f->second->groups;
+}
+
+void VertexCollector::WriteChunkGeomInfos( uint32_t              frameIndex,
+                                           uint64_t              chunkID,
+                                           const TextureManager& textureManager )
+{
+    std::lock_guard< std::mutex > lock( registerMutex );
+
+    auto f = chunks.find( chunkID );
+
+    if( f == chunks.end() || f->second == nullptr )
+    {
+        assert( 0 );
+        return;
+    }
+
+    Chunk& chunk = *f->second;
+
+    for( ChunkGroup& g : chunk.groups )
+    {
+        g.firstGlobalGeomIndex = UINT32_MAX;
+    }
+
+    // if some geometry of a group didn't fit, the whole group must not be in TLAS
+    std::vector< bool > isGroupIncomplete( chunk.groups.size(), false );
+
+    // geometries are sorted by group, so global indices of a group are consecutive
+    for( const Chunk::Geometry& geom : chunk.geometries )
+    {
+        if( isGroupIncomplete[ geom.groupIndex ] )
+        {
+            continue;
+        }
+
+        MaterialTextures materials[] = {
+            textureManager.GetMaterialTextures( geom.material.layerMaterials[ 0 ] ),
+            textureManager.GetMaterialTextures( geom.material.layerMaterials[ 1 ] ),
+            textureManager.GetMaterialTextures( geom.material.layerMaterials[ 2 ] ),
+        };
+
+        ShGeometryInstance geomInfo = geom.geomInfo;
+        SetMaterials( geomInfo, materials );
+
+        uint32_t globalGeomIndex =
+            geomInfoMgr->WriteMeshInstanceGeomInfo( frameIndex, geom.uniqueID, geomInfo );
+
+        ChunkGroup& g = chunk.groups[ geom.groupIndex ];
+
+        // mesh instance region is full
+        if( globalGeomIndex == UINT32_MAX )
+        {
+            g.firstGlobalGeomIndex               = UINT32_MAX;
+            isGroupIncomplete[ geom.groupIndex ] = true;
+            continue;
+        }
+
+        if( g.firstGlobalGeomIndex == UINT32_MAX )
+        {
+            g.firstGlobalGeomIndex = globalGeomIndex;
+        }
 
-    geomInfo.portalIndex = info.pPortalIndex ? *info.pPortalIndex : PORTAL_INDEX_NONE;
+        assert( globalGeomIndex - g.firstGlobalGeomIndex < g.asGeometries.size() );
+    }
+}
 
+bool VertexCollector::CopyChunksFromStaging( VkCommandBuffer cmd )
+{
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+    std::lock_guard< std::mutex >         lock( registerMutex );
 
-    // simple index -- calculated as (global cur static count + global cur dynamic count)
-    // global geometry index -- for indexing in geom infos buffer
-    // local geometry index -- index of geometry in BLAS
-    uint32_t simpleIndex = geomInfoMgr->WriteGeomInfo( frameIndex, info.uniqueID, localIndex, geomFlags, geomInfo );
+    std::array< VkBufferMemoryBarrier, 3 > barriers     = {};
+    uint32_t                               barrierCount = 0;
 
+    const std::tuple< std::vector< VkBufferCopy >&, const Buffer&, const Buffer& > toCopy[] = {
+        { chunkVertsToCopy, *stagingVertBuffer, *vertBuffer },
+        { chunkIndicesToCopy, *stagingIndexBuffer, *indexBuffer },
+        { chunkTransformsToCopy, *stagingTransformsBuffer, *transformsBuffer },
+    };
 
-    // add material dependency but only for static geometry,
-    // dynamic is updated each frame, so their materials will be updated anyway
-    if( collectStatic )
+    for( const auto& [ regions, src, dst ] : toCopy )
     {
-        for( const auto& [ layerIndex, materialIndex, textureIndices ] : layerDependencies )
+        if( regions.empty() )
         {
-            // if at least one texture is not empty on this layer, add dependency to the material
-            // layer
-            for( uint32_t textureIndex : textureIndices )
-            {
-                if( textureIndex != EMPTY_TEXTURE_INDEX )
-                {
-                    AddMaterialDependency( simpleIndex, layerIndex, materialIndex );
-                    break;
-                }
-            }
+            continue;
+        }
+
+        vkCmdCopyBuffer(
+            cmd, src.GetBuffer(), dst.GetBuffer(), uint32_t( regions.size() ), regions.data() );
+
+        VkDeviceSize lowerBound = UINT64_MAX;
+        VkDeviceSize upperBound = 0;
+        for( const auto& c : regions )
+        {
+            lowerBound = std::min( lowerBound, c.dstOffset );
+            upperBound = std::max( upperBound, c.dstOffset + c.size );
         }
 
-        // also, save transform index for updating static movable's transforms
-        simpleIndexToTransformIndex[ simpleIndex ] = transformIndex;
+        VkBufferMemoryBarrier& br = barriers[ barrierCount ];
+        barrierCount++;
+
+        br                     = {};
+        br.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        br.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        br.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        br.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        br.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+        br.buffer        = dst.GetBuffer();
+        br.offset        = lowerBound;
+        br.size          = upperBound - lowerBound;
+
+        regions.clear();
     }
 
+    if( barrierCount == 0 )
+    {
+        return false;
+    }
 
-    return simpleIndex;
+    // chunks are not preprocessed, so they're ready for AS build and shaders
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                              VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                          0,
+                          0,
+                          nullptr,
+                          barrierCount,
+                          barriers.data(),
+                          0,
+                          nullptr );
+
+    return true;
 }
 
 void VertexCollector::CopyDataToStaging(const RgGeometryUploadInfo &info, uint32_t vertIndex)
 {
-    assert( ( vertIndex + info.vertexCount ) * sizeof( ShVertex ) < vertBuffer->GetSize() );
+    assert( ( vertIndex + info.vertexCount ) * vertexStride <= stagingVertBuffer->GetSize() );
+
+    if( vertexFormat == VertexBufferFormat::Compact )
+    {
+        auto* const pDst = reinterpret_cast< ShVertexCompact* >( mappedVertexData ) + vertIndex;
+
+        for( uint32_t i = 0; i < info.vertexCount; i++ )
+        {
+            const RgVertex& src = info.pVertices[ i ];
+
+            pDst[ i ] = ShVertexCompact{
+                .position       = { src.position[ 0 ], src.position[ 1 ], src.position[ 2 ] },
+                .normal         = Utils::EncodeOctahedral( src.normal ),
+                .texCoord       = Utils::PackHalf2x16( src.texCoord[ 0 ], src.texCoord[ 1 ] ),
+                .texCoordLayer1 = Utils::PackHalf2x16( src.texCoordLayer1[ 0 ], src.texCoordLayer1[ 1 ] ),
+                .texCoordLayer2 = Utils::PackHalf2x16( src.texCoordLayer2[ 0 ], src.texCoordLayer2[ 1 ] ),
+                .packedColor    = src.packedColor,
+            };
+        }
 
-    ShVertex* const pDst = &mappedVertexData[ vertIndex ];
+        return;
+    }
+
+    auto* const pDst = reinterpret_cast< ShVertex* >( mappedVertexData ) + vertIndex;
 
     // must be same to copy
     static_assert( std::is_same_v< decltype( info.pVertices ), const RgVertex* > );
@@ -496,7 +2206,48 @@ void VertexCollector::CopyDataToStaging(const RgGeometryUploadInfo &info, uint32
     memcpy( pDst, info.pVertices, info.vertexCount * sizeof( ShVertex ) );
 }
 
-void VertexCollector::EndCollecting() {}
+void VertexCollector::EndCollecting()
+{
+    pendingSorted.clear();
+
+    for( uint32_t i = 0; i < PENDING_BUCKET_COUNT; i++ )
+    {
+        for( const PendingGeometry& p : pendingBuckets[ i ].geometries )
+        {
+            pendingSorted.push_back( &p );
+        }
+    }
+
+    // unique IDs are unique, so the order is strict: it doesn't depend on thread scheduling
+    std::sort( pendingSorted.begin(),
+               pendingSorted.end(),
+               []( const PendingGeometry* a, const PendingGeometry* b ) {
+                   return a->uniqueID < b->uniqueID;
+               } );
+
+    retainedGeometries.clear();
+
+    for( const PendingGeometry* p : pendingSorted )
+    {
+        RegisterGeometry( *p );
+
+        if( p->dataHash )
+        {
+            retainedGeometries[ p->uniqueID ] = RetainedGeometry{
+                .dataHash  = *p->dataHash,
+                .vertIndex = p->geomInfo.baseVertexIndex,
+                .indIndex  = p->geomInfo.baseIndexIndex,
+            };
+        }
+    }
+
+    pendingSorted.clear();
+
+    for( uint32_t i = 0; i < PENDING_BUCKET_COUNT; i++ )
+    {
+        pendingBuckets[ i ].geometries.clear();
+    }
+}
 
 void VertexCollector::Reset()
 {
@@ -505,67 +2256,99 @@ void VertexCollector::Reset()
     curPrimitiveCount = 0;
     curTransformCount = 0;
 
-    simpleIndexToTransformIndex.clear();
+    {
+        std::lock_guard< std::mutex > lock( acquiredMutex );
+        acquiredVertices.clear();
+        acquiredVertexRanges.clear();
+        acquiredIndexRanges.clear();
+    }
+
+    simpleIndexToTransform.clear();
+    transformsToCopy.Clear();
+    filtersWithChangedGeometry.reset();
+    verticesToCopy.clear();
 
     materialDependencies.clear();
 
+    meshes.clear();
+
+    {
+        std::lock_guard< std::mutex > lock( sharedDataMutex );
+        sharedData.clear();
+    }
+
     for( auto& f : filters )
     {
-        f.second->Reset();
+        if( f )
+        {
+            f->Reset();
+        }
+    }
+
+    for( uint32_t i = 0; i < PENDING_BUCKET_COUNT; i++ )
+    {
+        pendingBuckets[ i ].geometries.clear();
     }
 }
 
 bool VertexCollector::CopyVertexDataFromStaging( VkCommandBuffer cmd )
 {
-    if( curVertexCount == 0 )
+    if( GetCurrentVertexCount() == 0 )
     {
         return false;
     }
 
     VkBufferCopy info = {
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size      = curVertexCount * sizeof( ShVertex ),
+        .srcOffset = vertexBase * vertexStride,
+        .dstOffset = vertexBase * vertexStride,
+        .size      = GetCurrentVertexCount() * vertexStride,
     };
 
-    vkCmdCopyBuffer( cmd, stagingVertBuffer.GetBuffer(), vertBuffer->GetBuffer(), 1, &info );
+    vkCmdCopyBuffer( cmd, stagingVertBuffer->GetBuffer(), vertBuffer->GetBuffer(), 1, &info );
+
+    // all vertices are copied
+    verticesToCopy.clear();
 
     return true;
 }
 
 bool VertexCollector::CopyIndexDataFromStaging( VkCommandBuffer cmd )
 {
-    if( curIndexCount == 0 )
+    if( GetCurrentIndexCount() == 0 )
     {
         return false;
     }
 
     VkBufferCopy info = {
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size      = curIndexCount * sizeof( uint32_t ),
+        .srcOffset = indexBase * sizeof( uint32_t ),
+        .dstOffset = indexBase * sizeof( uint32_t ),
+        .size      = GetCurrentIndexCount() * sizeof( uint32_t ),
     };
 
-    vkCmdCopyBuffer( cmd, stagingIndexBuffer.GetBuffer(), indexBuffer->GetBuffer(), 1, &info );
+    vkCmdCopyBuffer( cmd, stagingIndexBuffer->GetBuffer(), indexBuffer->GetBuffer(), 1, &info );
 
     return true;
 }
 
 bool VertexCollector::CopyTransformsFromStaging( VkCommandBuffer cmd, bool insertMemBarrier )
 {
-    if( curTransformCount == 0 )
+    if( GetCurrentTransformCount() == 0 )
     {
         return false;
     }
 
     VkBufferCopy info = {
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size      = curTransformCount * sizeof( VkTransformMatrixKHR ),
+        .srcOffset = transformBase * sizeof( VkTransformMatrixKHR ),
+        .dstOffset = transformBase * sizeof( VkTransformMatrixKHR ),
+        .size      = GetCurrentTransformCount() * sizeof( VkTransformMatrixKHR ),
     };
 
     vkCmdCopyBuffer(
-        cmd, stagingTransformsBuffer.GetBuffer(), transformsBuffer->GetBuffer(), 1, &info );
+        cmd, stagingTransformsBuffer->GetBuffer(), transformsBuffer->GetBuffer(), 1, &info );
+
+    // all transforms are copied
+    transformsToCopy.Clear();
+    filtersWithChangedGeometry.reset();
 
     if( insertMemBarrier )
     {
@@ -576,7 +2359,8 @@ bool VertexCollector::CopyTransformsFromStaging( VkCommandBuffer cmd, bool inser
         trnBr.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
         trnBr.dstAccessMask         = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
         trnBr.buffer                = transformsBuffer->GetBuffer();
-        trnBr.size                  = curTransformCount * sizeof( VkTransformMatrixKHR );
+        trnBr.offset                = transformBase * sizeof( VkTransformMatrixKHR );
+        trnBr.size                  = GetCurrentTransformCount() * sizeof( VkTransformMatrixKHR );
 
         vkCmdPipelineBarrier( cmd,
                               VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -595,7 +2379,112 @@ bool VertexCollector::CopyTransformsFromStaging( VkCommandBuffer cmd, bool inser
 
 bool VertexCollector::RecopyTransformsFromStaging( VkCommandBuffer cmd )
 {
-    return CopyTransformsFromStaging( cmd, true );
+    if( transformsToCopy.IsEmpty() )
+    {
+        return false;
+    }
+    assert( GetCurrentTransformCount() > 0 );
+
+    std::vector< VkBufferCopy > copyInfos;
+    VkDeviceSize                lowerBound = UINT64_MAX;
+    VkDeviceSize                upperBound = 0;
+
+    for( const auto& r : transformsToCopy.GetRanges() )
+    {
+        assert( r.begin >= transformBase && r.end <= transformBase + GetCurrentTransformCount() );
+
+        VkBufferCopy c = {
+            .srcOffset = r.begin * sizeof( VkTransformMatrixKHR ),
+            .dstOffset = r.begin * sizeof( VkTransformMatrixKHR ),
+            .size      = ( r.end - r.begin ) * sizeof( VkTransformMatrixKHR ),
+        };
+        copyInfos.push_back( c );
+
+        lowerBound = std::min( lowerBound, c.dstOffset );
+        upperBound = std::max( upperBound, c.dstOffset + c.size );
+    }
+
+    vkCmdCopyBuffer( cmd,
+                     stagingTransformsBuffer->GetBuffer(),
+                     transformsBuffer->GetBuffer(),
+                     static_cast< uint32_t >( copyInfos.size() ),
+                     copyInfos.data() );
+
+    VkBufferMemoryBarrier trnBr = {};
+    trnBr.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    trnBr.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    trnBr.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    trnBr.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+    trnBr.dstAccessMask         = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+    trnBr.buffer                = transformsBuffer->GetBuffer();
+    trnBr.offset                = lowerBound;
+    trnBr.size                  = upperBound - lowerBound;
+
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                          0,
+                          0,
+                          nullptr,
+                          1,
+                          &trnBr,
+                          0,
+                          nullptr );
+
+    transformsToCopy.Clear();
+    filtersWithChangedGeometry.reset();
+
+    return true;
+}
+
+bool VertexCollector::RecopyVerticesFromStaging( VkCommandBuffer cmd )
+{
+    if( verticesToCopy.empty() )
+    {
+        return false;
+    }
+
+    vkCmdCopyBuffer( cmd,
+                     stagingVertBuffer->GetBuffer(),
+                     vertBuffer->GetBuffer(),
+                     static_cast< uint32_t >( verticesToCopy.size() ),
+                     verticesToCopy.data() );
+
+    VkDeviceSize lowerBound = UINT64_MAX;
+    VkDeviceSize upperBound = 0;
+    for( const auto& c : verticesToCopy )
+    {
+        lowerBound = std::min( lowerBound, c.dstOffset );
+        upperBound = std::max( upperBound, c.dstOffset + c.size );
+    }
+    assert( lowerBound < upperBound );
+
+    VkBufferMemoryBarrier vrtBr = {};
+    vrtBr.sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    vrtBr.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    vrtBr.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+    vrtBr.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vrtBr.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+    vrtBr.buffer                = vertBuffer->GetBuffer();
+    vrtBr.offset                = lowerBound;
+    vrtBr.size                  = upperBound - lowerBound;
+
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                              VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                          0,
+                          0,
+                          nullptr,
+                          1,
+                          &vrtBr,
+                          0,
+                          nullptr );
+
+    verticesToCopy.clear();
+
+    return true;
 }
 
 bool RTGL1::VertexCollector::RecopyTexCoordsFromStaging( VkCommandBuffer cmd )
@@ -604,10 +2493,10 @@ bool RTGL1::VertexCollector::RecopyTexCoordsFromStaging( VkCommandBuffer cmd )
     {
         return false;
     }
-    assert( curTransformCount > 0 );
+    assert( GetCurrentTransformCount() > 0 );
 
     vkCmdCopyBuffer( cmd,
-                     stagingVertBuffer.GetBuffer(),
+                     stagingVertBuffer->GetBuffer(),
                      vertBuffer->GetBuffer(),
                      texCoordsToCopy.size(),
                      texCoordsToCopy.data() );
@@ -653,7 +2542,7 @@ bool VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
     bool indCopied = CopyIndexDataFromStaging( cmd );
     bool trnCopied = CopyTransformsFromStaging( cmd, false );
 
-    std::array< VkBufferMemoryBarrier, 2 > barriers     = {};
+    std::array< VkBufferMemoryBarrier, 3 > barriers     = {};
     uint32_t                               barrierCount = 0;
 
     // just prepare for preprocessing - so no AS for this moment
@@ -669,8 +2558,8 @@ bool VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
         vrtBr.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
         vrtBr.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
         vrtBr.buffer              = vertBuffer->GetBuffer();
-        vrtBr.offset              = 0;
-        vrtBr.size                = curVertexCount * sizeof( ShVertex );
+        vrtBr.offset              = vertexBase * vertexStride;
+        vrtBr.size                = GetCurrentVertexCount() * vertexStride;
     }
 
     // just prepare for preprocessing - so no AS for this moment
@@ -686,8 +2575,8 @@ bool VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
         indBr.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
         indBr.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
         indBr.buffer              = indexBuffer->GetBuffer();
-        indBr.offset              = 0;
-        indBr.size                = curIndexCount * sizeof( uint32_t );
+        indBr.offset              = indexBase * sizeof( uint32_t );
+        indBr.size                = GetCurrentIndexCount() * sizeof( uint32_t );
     }
 
     if( barrierCount > 0 )
@@ -714,7 +2603,8 @@ bool VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
         trnBr.srcAccessMask         = VK_ACCESS_TRANSFER_WRITE_BIT;
         trnBr.dstAccessMask         = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
         trnBr.buffer                = transformsBuffer->GetBuffer();
-        trnBr.size                  = curTransformCount * sizeof( VkTransformMatrixKHR );
+        trnBr.offset                = transformBase * sizeof( VkTransformMatrixKHR );
+        trnBr.size                  = GetCurrentTransformCount() * sizeof( VkTransformMatrixKHR );
 
         vkCmdPipelineBarrier( cmd,
                               VK_PIPELINE_STAGE_TRANSFER_BIT,
@@ -732,6 +2622,72 @@ bool VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
     return vrtCopied || indCopied || trnCopied;
 }
 
+void VertexCollector::TransferOwnership( VkCommandBuffer cmd,
+                                         uint32_t        srcQueueFamily,
+                                         uint32_t        dstQueueFamily,
+                                         bool            isRelease )
+{
+    assert( srcQueueFamily != dstQueueFamily );
+
+    const std::tuple< VkBuffer, VkDeviceSize, VkDeviceSize > regions[] = {
+        { vertBuffer->GetBuffer(), vertexBase * vertexStride, GetCurrentVertexCount() * vertexStride },
+        { indexBuffer->GetBuffer(),
+          indexBase * sizeof( uint32_t ),
+          GetCurrentIndexCount() * sizeof( uint32_t ) },
+        { transformsBuffer->GetBuffer(),
+          transformBase * sizeof( VkTransformMatrixKHR ),
+          GetCurrentTransformCount() * sizeof( VkTransformMatrixKHR ) },
+    };
+
+    std::array< VkBufferMemoryBarrier, std::size( regions ) > barriers     = {};
+    uint32_t                                                  barrierCount = 0;
+
+    for( const auto& [ buffer, offset, size ] : regions )
+    {
+        if( size == 0 )
+        {
+            continue;
+        }
+
+        VkBufferMemoryBarrier& b = barriers[ barrierCount ];
+        barrierCount++;
+
+        // access masks are ignored on the other side of the transfer
+        b                     = {};
+        b.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        b.srcQueueFamilyIndex = srcQueueFamily;
+        b.dstQueueFamilyIndex = dstQueueFamily;
+        b.srcAccessMask       = isRelease ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+        b.dstAccessMask       = isRelease ? 0
+                                          : VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT |
+                                          VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR;
+        b.buffer              = buffer;
+        b.offset              = offset;
+        b.size                = size;
+    }
+
+    if( barrierCount == 0 )
+    {
+        return;
+    }
+
+    vkCmdPipelineBarrier( cmd,
+                          isRelease ? VK_PIPELINE_STAGE_TRANSFER_BIT |
+                                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR
+                                    : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                          isRelease ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+                                    : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                          VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR,
+                          0,
+                          0,
+                          nullptr,
+                          barrierCount,
+                          barriers.data(),
+                          0,
+                          nullptr );
+}
+
 void VertexCollector::UpdateTransform( uint32_t                     simpleIndex,
                                        const RgUpdateTransformInfo& updateInfo )
 {
@@ -743,31 +2699,128 @@ void VertexCollector::UpdateTransform( uint32_t                     simpleIndex,
 
     assert( mappedTransformData != nullptr );
 
+    auto found = simpleIndexToTransform.find( simpleIndex );
+
+    if( found == simpleIndexToTransform.end() )
+    {
+        assert( 0 );
+        return;
+    }
+
+    const TransformRef& ref = found->second;
+
     static_assert( sizeof( RgTransform ) == sizeof( VkTransformMatrixKHR ),
                    "RgTransform and VkTransformMatrixKHR must have the same structure to be used "
                    "in AS building" );
-    memcpy( mappedTransformData + simpleIndexToTransformIndex[ simpleIndex ],
-            &updateInfo.transform,
-            sizeof( VkTransformMatrixKHR ) );
+    {
+        // staging buffer can be replaced on growth
+        std::shared_lock< std::shared_mutex > lock( stagingMutex );
+
+        memcpy( mappedTransformData + ref.transformIndex,
+                &updateInfo.transform,
+                sizeof( VkTransformMatrixKHR ) );
+    }
+
+    transformsToCopy.Add( ref.transformIndex );
+    filtersWithChangedGeometry.set( VertexCollectorFilterTypeFlags_GetID( ref.filter ) );
 
     geomInfoMgr->WriteStaticGeomInfoTransform(
         simpleIndex, updateInfo.movableStaticUniqueID, updateInfo.transform );
 }
 
+bool VertexCollector::UpdateVertices( uint32_t simpleIndex, const RgUpdateVerticesInfo& updateInfo )
+{
+    auto found = simpleIndexToTransform.find( simpleIndex );
+
+    if( found == simpleIndexToTransform.end() )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    const uint32_t geomVertexCount = geomInfoMgr->GetStaticGeomVertexCount( simpleIndex );
+
+    if( uint64_t( updateInfo.vertexOffset ) + updateInfo.vertexCount > geomVertexCount )
+    {
+        return false;
+    }
+
+    if( updateInfo.vertexCount == 0 )
+    {
+        return true;
+    }
+
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+    assert( mappedVertexData != nullptr );
+
+    // base vertex index is saved in geometry instance info
+    const uint32_t dstVertIndex =
+        geomInfoMgr->GetStaticGeomBaseVertexIndex( simpleIndex ) + updateInfo.vertexOffset;
+
+    if( dstVertIndex + updateInfo.vertexCount > stagingVertexCapacity )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    if( vertexFormat == VertexBufferFormat::Compact )
+    {
+        auto* const pDst = reinterpret_cast< ShVertexCompact* >( mappedVertexData ) + dstVertIndex;
+
+        for( uint32_t i = 0; i < updateInfo.vertexCount; i++ )
+        {
+            memcpy( pDst[ i ].position, updateInfo.pPositions[ i ].data, sizeof( float ) * 3 );
+
+            if( updateInfo.pNormals != nullptr )
+            {
+                pDst[ i ].normal = Utils::EncodeOctahedral( updateInfo.pNormals[ i ].data );
+            }
+        }
+    }
+    else
+    {
+        auto* const pDst = reinterpret_cast< ShVertex* >( mappedVertexData ) + dstVertIndex;
+
+        for( uint32_t i = 0; i < updateInfo.vertexCount; i++ )
+        {
+            memcpy( pDst[ i ].position, updateInfo.pPositions[ i ].data, sizeof( float ) * 3 );
+
+            if( updateInfo.pNormals != nullptr )
+            {
+                memcpy( pDst[ i ].normal, updateInfo.pNormals[ i ].data, sizeof( float ) * 3 );
+            }
+        }
+    }
+
+    verticesToCopy.push_back( VkBufferCopy{
+        .srcOffset = dstVertIndex * vertexStride,
+        .dstOffset = dstVertIndex * vertexStride,
+        .size      = updateInfo.vertexCount * vertexStride,
+    } );
+
+    filtersWithChangedGeometry.set( VertexCollectorFilterTypeFlags_GetID( found->second.filter ) );
+    return true;
+}
+
+bool VertexCollector::AreGeometriesChanged( VertexCollectorFilterTypeFlags filter ) const
+{
+    return filtersWithChangedGeometry.test( VertexCollectorFilterTypeFlags_GetID( filter ) );
+}
+
 void RTGL1::VertexCollector::UpdateTexCoords( uint32_t                     simpleIndex,
                                               const RgUpdateTexCoordsInfo& texCoordsInfo,
                                               bool                         isStatic )
 {
     assert( isStatic );
-    assert( mappedVertexData != nullptr );
 
-    const uint32_t maxVertexCount = isStatic ? MAX_STATIC_VERTEX_COUNT : MAX_DYNAMIC_VERTEX_COUNT;
+    std::shared_lock< std::shared_mutex > stagingLock( stagingMutex );
+    assert( mappedVertexData != nullptr );
 
     // base vertex index is saved in geometry instance info
     uint32_t globalVertIndex = geomInfoMgr->GetStaticGeomBaseVertexIndex( simpleIndex );
     uint32_t dstVertIndex    = globalVertIndex + texCoordsInfo.vertexOffset;
 
-    if( dstVertIndex + texCoordsInfo.vertexCount >= maxVertexCount )
+    if( dstVertIndex + texCoordsInfo.vertexCount > stagingVertexCapacity )
     {
         assert( 0 );
         return;
@@ -818,39 +2871,54 @@ VkBuffer VertexCollector::GetIndexBuffer() const
 const std::vector< uint32_t >& VertexCollector::GetPrimitiveCounts(
     VertexCollectorFilterTypeFlags filter ) const
 {
-    auto f = filters.find( filter );
-    assert( f != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filter ) ];
+    assert( f );
 
-    return f->second->GetPrimitiveCounts();
+    return f->GetPrimitiveCounts();
 }
 
 const std::vector< VkAccelerationStructureGeometryKHR >& VertexCollector::GetASGeometries(
     VertexCollectorFilterTypeFlags filter ) const
 {
-    auto f = filters.find( filter );
-    assert( f != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filter ) ];
+    assert( f );
 
-    return f->second->GetASGeometries();
+    return f->GetASGeometries();
 }
 
 const std::vector< VkAccelerationStructureBuildRangeInfoKHR >& VertexCollector::
     GetASBuildRangeInfos( VertexCollectorFilterTypeFlags filter ) const
 {
-    auto f = filters.find( filter );
-    assert( f != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filter ) ];
+    assert( f );
+
+    return f->GetASBuildRangeInfos();
+}
+
+std::optional< uint64_t > VertexCollector::GetContentHash( VertexCollectorFilterTypeFlags filter ) const
+{
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filter ) ];
+    assert( f );
+
+    return f->GetContentHash();
+}
+
+std::optional< uint64_t > VertexCollector::GetTopologyHash(
+    VertexCollectorFilterTypeFlags filter ) const
+{
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filter ) ];
+    assert( f );
 
-    return f->second->GetASBuildRangeInfos();
+    return f->GetTopologyHash();
 }
 
 bool VertexCollector::AreGeometriesEmpty( VertexCollectorFilterTypeFlags flags ) const
 {
-    for( const auto& p : filters )
+    for( const auto& f : filters )
     {
-        const auto& f = p.second;
-
         // if filter includes any type from flags
         // and it's not empty
-        if( ( f->GetFilter() & flags ) && f->GetGeometryCount() > 0 )
+        if( f && ( f->GetFilter() & flags ) && f->GetGeometryCount() > 0 )
         {
             return false;
         }
@@ -871,10 +2939,10 @@ void VertexCollector::InsertVertexPreprocessBeginBarrier( VkCommandBuffer cmd )
 
 void VertexCollector::InsertVertexPreprocessFinishBarrier( VkCommandBuffer cmd )
 {
-    std::array< VkBufferMemoryBarrier, 2 > barriers     = {};
+    std::array< VkBufferMemoryBarrier, 3 > barriers     = {};
     uint32_t                               barrierCount = 0;
 
-    if( curVertexCount > 0 )
+    if( GetCurrentVertexCount() > 0 )
     {
         VkBufferMemoryBarrier& vrtBr = barriers[ barrierCount ];
         barrierCount++;
@@ -887,11 +2955,11 @@ void VertexCollector::InsertVertexPreprocessFinishBarrier( VkCommandBuffer cmd )
         vrtBr.dstAccessMask =
             VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
         vrtBr.buffer = vertBuffer->GetBuffer();
-        vrtBr.offset = 0;
-        vrtBr.size   = curVertexCount * sizeof( ShVertex );
+        vrtBr.offset = vertexBase * vertexStride;
+        vrtBr.size   = GetCurrentVertexCount() * vertexStride;
     }
 
-    if( curIndexCount > 0 )
+    if( GetCurrentIndexCount() > 0 )
     {
         VkBufferMemoryBarrier& indBr = barriers[ barrierCount ];
         barrierCount++;
@@ -904,8 +2972,8 @@ void VertexCollector::InsertVertexPreprocessFinishBarrier( VkCommandBuffer cmd )
         indBr.dstAccessMask =
             VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
         indBr.buffer = indexBuffer->GetBuffer();
-        indBr.offset = 0;
-        indBr.size   = curIndexCount * sizeof( uint32_t );
+        indBr.offset = indexBase * sizeof( uint32_t );
+        indBr.size   = GetCurrentIndexCount() * sizeof( uint32_t );
     }
 
     if( barrierCount == 0 )
@@ -929,31 +2997,35 @@ void VertexCollector::InsertVertexPreprocessFinishBarrier( VkCommandBuffer cmd )
 uint32_t VertexCollector::PushGeometry( VertexCollectorFilterTypeFlags            type,
                                         const VkAccelerationStructureGeometryKHR& geom )
 {
-    assert( filters.find( type ) != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( type ) ];
+    assert( f );
 
-    return filters[ type ]->PushGeometry( type, geom );
+    return f->PushGeometry( type, geom );
 }
 
 void VertexCollector::PushPrimitiveCount( VertexCollectorFilterTypeFlags type, uint32_t primCount )
 {
-    assert( filters.find( type ) != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( type ) ];
+    assert( f );
 
-    filters[ type ]->PushPrimitiveCount( type, primCount );
+    f->PushPrimitiveCount( type, primCount );
 }
 
 void VertexCollector::PushRangeInfo( VertexCollectorFilterTypeFlags                  type,
                                      const VkAccelerationStructureBuildRangeInfoKHR& rangeInfo )
 {
-    assert( filters.find( type ) != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( type ) ];
+    assert( f );
 
-    filters[ type ]->PushRangeInfo( type, rangeInfo );
+    f->PushRangeInfo( type, rangeInfo );
 }
 
-uint32_t RTGL1::VertexCollector::GetGeometryCount( VertexCollectorFilterTypeFlags type )
+VertexCollectorFilter& VertexCollector::GetFilter( VertexCollectorFilterTypeFlags type )
 {
-    assert( filters.find( type ) != filters.end() );
+    const auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( type ) ];
+    assert( f );
 
-    return filters[ type ]->GetGeometryCount();
+    return *f;
 }
 
 uint32_t VertexCollector::GetAllGeometryCount() const
@@ -962,20 +3034,42 @@ uint32_t VertexCollector::GetAllGeometryCount() const
 
     for( const auto& f : filters )
     {
-        count += f.second->GetGeometryCount();
+        if( f )
+        {
+            count += f->GetGeometryCount();
+        }
     }
 
     return count;
 }
 
+// counters can exceed the capacity, if some geometry didn't fit, so clamp them
+
+// chunk regions are copied separately, so don't include them
+
 uint32_t VertexCollector::GetCurrentVertexCount() const
 {
-    return curVertexCount;
+    return std::min( curVertexCount.load(), stagingVertexCapacity - vertexBase );
 }
 
 uint32_t VertexCollector::GetCurrentIndexCount() const
 {
-    return curIndexCount;
+    return std::min( curIndexCount.load(), stagingIndexCapacity - indexBase );
+}
+
+VkDeviceSize VertexCollector::GetVertexBufferSize() const
+{
+    return vertBuffer->GetSize();
+}
+
+VkDeviceSize VertexCollector::GetIndexBufferSize() const
+{
+    return indexBuffer->GetSize();
+}
+
+uint32_t VertexCollector::GetCurrentTransformCount() const
+{
+    return std::min( curTransformCount.load(), stagingTransformCapacity - transformBase );
 }
 
 void VertexCollector::AddFilter( VertexCollectorFilterTypeFlags filterGroup )
@@ -985,9 +3079,10 @@ void VertexCollector::AddFilter( VertexCollectorFilterTypeFlags filterGroup )
         return;
     }
 
-    assert( filters.find( filterGroup ) == filters.end() );
+    auto& f = filters[ VertexCollectorFilterTypeFlags_GetID( filterGroup ) ];
+    assert( !f );
 
-    filters[ filterGroup ] = std::make_shared< VertexCollectorFilter >( filterGroup );
+    f = std::make_unique< VertexCollectorFilter >( filterGroup );
 }
 
 // try create filters for each group (mask)
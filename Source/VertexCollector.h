@@ -20,14 +20,25 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <span>
 #include <vector>
 
 #include "Buffer.h"
 #include "Common.h"
+#include "Containers.h"
+#include "DirtyRangeSet.h"
 #include "GeomInfoManager.h"
 #include "IMaterialDependency.h"
 #include "Material.h"
+#include "RangeAllocator.h"
 #include "VertexBufferProperties.h"
 #include "VertexCollectorFilter.h"
 #include "RTGL1/RTGL1.h"
@@ -36,20 +47,41 @@ namespace RTGL1
 {
 
 struct ShGeometryInstance;
-struct ShVertex;
+class TextureManager;
 
 // The class collects vertex data to buffers with shader struct types.
 // Geometries are passed to the class by chunks and the result of collecting
 // is a vertex buffer with ready data and infos for acceleration structure creation/building.
+// Adding geometries is thread-safe: each call atomically reserves its ranges
+// in the staging buffers, so vertex and index data can be copied concurrently.
 class VertexCollector : public IMaterialDependency
 {
+public:
+    // Geometries of a static chunk that have the same filter, they're built into one BLAS
+    struct ChunkGroup
+    {
+        VertexCollectorFilterTypeFlags                          filter;
+        std::vector<VkAccelerationStructureGeometryKHR>         asGeometries;
+        std::vector<VkAccelerationStructureBuildRangeInfoKHR>   asBuildRangeInfos;
+        std::vector<uint32_t>                                   primitiveCounts;
+        // global geometry index of the first geometry in the group,
+        // the next ones follow it; set in WriteChunkGeomInfos,
+        // UINT32_MAX if geometry infos of the group didn't fit
+        uint32_t                                                firstGlobalGeomIndex;
+    };
+
 public:
     explicit VertexCollector(
         VkDevice device, 
         const std::shared_ptr<MemoryAllocator> &allocator,
         std::shared_ptr<GeomInfoManager> geomInfoManager,
-        VkDeviceSize bufferSize,
-        VertexCollectorFilterTypeFlags filters);
+        uint32_t initialVertexCount,
+        uint32_t initialIndexCount,
+        uint32_t chunkVertexCount,
+        uint32_t chunkIndexCount,
+        VkDeviceSize maxBufferSize,
+        VertexCollectorFilterTypeFlags filters,
+        VertexBufferFormat vertexFormat);
 
     // Create new vertex collector, but with shared device local buffers
     explicit VertexCollector(
@@ -65,8 +97,44 @@ public:
 
 
     void BeginCollecting(bool isStatic);
+    // Add geometry and register it immediately. Returns simple index.
     // materials[3] is a lightmap
     uint32_t AddGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials);
+    // Copy data to staging, but postpone registering AS geometry and geometry info
+    // until EndCollecting, so the result doesn't depend on the order of concurrent calls.
+    // Returns false, if geometry couldn't be added.
+    bool AddGeometryDeferred(uint32_t frameIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials);
+    // Batched versions of AddGeometry / AddGeometryDeferred: staging ranges for all geometries
+    // are reserved at once. "materials" contains 3 elements per geometry.
+    // Results are simple indices (or 0 for deferred geometries), UINT32_MAX if geometry wasn't added.
+    void AddGeometries(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<MaterialTextures> materials, std::span<uint32_t> outResults);
+    void AddGeometriesDeferred(uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<MaterialTextures> materials, std::span<uint32_t> outResults);
+    // Reserve staging memory, so a caller can write vertex and index data in place.
+    // If AddGeometry* receives pointers to that memory, the data is not copied.
+    // Returns false, if there's not enough space.
+    bool AcquireMemory(uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices);
+    // Add geometry that is not a part of any filter, so it can be built into its own BLAS
+    // and then placed many times as mesh instances. Must be called only for static collector.
+    // Returns mesh index, or UINT32_MAX if it wasn't added.
+    uint32_t AddMesh(uint32_t frameIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials);
+    // Add static geometries that have their own ranges in the buffers, so they can be removed
+    // without rebuilding the rest of static geometry. Must be called only for static collector.
+    // Thread-safe. Returns false, if a chunk with such ID exists, there's not enough space,
+    // or any of the geometries was rejected; in that case nothing is added.
+    bool AddChunk(uint64_t chunkID, uint32_t frameIndex, std::span<const RgGeometryUploadInfo> infos, std::span<MaterialTextures> materials);
+    // Ranges of the chunk are freed on FreeRemovedChunks with the same frame index,
+    // as they can be in use by the frames in flight. Thread-safe.
+    void RemoveChunk(uint64_t chunkID, uint32_t frameIndex);
+    void FreeRemovedChunks(uint32_t frameIndex);
+    // Null, if there's no such chunk
+    const std::vector<ChunkGroup> *GetChunkGroups(uint64_t chunkID) const;
+    // Copy data of the added chunks from staging
+    bool CopyChunksFromStaging(VkCommandBuffer cmd);
+    // Write geometry infos for the current frame, materials are resolved every frame, 
+    // as for the mesh instances
+    void WriteChunkGeomInfos(uint32_t frameIndex, uint64_t chunkID, const TextureManager &textureManager);
+    // Register deferred geometries, sorted by their unique IDs.
+    // Must not be called concurrently with AddGeometry*.
     void EndCollecting();
 
 
@@ -76,14 +144,27 @@ public:
     // Copy buffer from staging and set barrier for processing in compute shader
     // "isStaticVertexData" is required to determine what GLSL struct to use for copying
     bool CopyFromStaging(VkCommandBuffer cmd);
+    // Copy only the transforms that were changed by UpdateTransform.
     // Returns false, if wasn't copied
     bool RecopyTransformsFromStaging(VkCommandBuffer cmd);
+    // Copy only the vertices that were changed by UpdateVertices.
+    bool RecopyVerticesFromStaging(VkCommandBuffer cmd);
     bool RecopyTexCoordsFromStaging(VkCommandBuffer cmd);
+    // Queue family ownership transfer of the data that was copied in CopyFromStaging.
+    // Must be recorded with the same families twice: release on the source queue,
+    // and acquire on the destination one.
+    void TransferOwnership(VkCommandBuffer cmd, uint32_t srcQueueFamily, uint32_t dstQueueFamily, bool isRelease);
 
 
     // Update transform, only for movable static geometry as dynamic geometry
     // will be updated every frame and thus their transforms.
     void UpdateTransform(uint32_t simpleIndex, const RgUpdateTransformInfo &updateInfo);
+    // Update positions and normals of movable static geometry in staging.
+    // Returns false, if the range is out of the geometry's vertices.
+    bool UpdateVertices(uint32_t simpleIndex, const RgUpdateVerticesInfo &updateInfo);
+    // Were transforms or vertices of any geometry in this filter
+    // changed since the last copy from staging?
+    bool AreGeometriesChanged(VertexCollectorFilterTypeFlags filter) const;
     // Update texture coordinates 
     void UpdateTexCoords(uint32_t simpleIndex, const RgUpdateTexCoordsInfo &texCoordsInfo, bool isStatic);
 
@@ -96,6 +177,30 @@ public:
     VkBuffer GetIndexBuffer() const;
     uint32_t GetCurrentVertexCount() const;
     uint32_t GetCurrentIndexCount() const;
+    VkDeviceSize GetVertexBufferSize() const;
+    VkDeviceSize GetIndexBufferSize() const;
+
+
+    // Staging buffers grow on adding geometry, device local ones must be grown
+    // before copying from staging, if the data doesn't fit in them.
+    bool NeedsDeviceBufferGrowth() const;
+    // Recreate device local buffers with the size of the staging ones and refresh
+    // device addresses in AS geometries. Previous buffers are moved to "retired",
+    // as they can be in use by the frames in flight. Chunk data will be recopied from staging.
+    // Must not be called concurrently with adding geometry.
+    void GrowDeviceBuffers(std::vector<std::shared_ptr<Buffer>> &retired);
+    // Same as GrowDeviceBuffers, but vertex and index buffers are recreated even if the data fits in them,
+    // so the previous ones can be read by the frames in flight, while the new ones are being filled.
+    // Transforms buffer is recreated only if it must grow, the previous one is moved to "retired".
+    void ReplaceDeviceBuffers(std::shared_ptr<Buffer> &prevVertices, std::shared_ptr<Buffer> &prevIndices,
+                              std::vector<std::shared_ptr<Buffer>> &retired);
+    // Use device local buffers of "src", e.g. after they were grown
+    void ShareDeviceBuffers(const VertexCollector &src);
+    // Staging buffers that were replaced on growth are kept, as they can be in use by the device,
+    // and the memory returned by AcquireMemory can still be in them. Destroy them, when it's safe.
+    void DestroyRetiredStaging();
+    // Same as DestroyRetiredStaging, but buffers are moved to "retired" to be destroyed later.
+    void RetireStaging(std::vector<std::shared_ptr<Buffer>> &retired);
 
 
     // Get primitive counts from filters. Null if corresponding filter wasn't found.
@@ -107,6 +212,22 @@ public:
     // Get AS build range infos from filters. Null if corresponding filter wasn't found.
     const std::vector<VkAccelerationStructureBuildRangeInfoKHR> &GetASBuildRangeInfos(VertexCollectorFilterTypeFlags filter) const;
 
+    uint32_t GetMeshCount() const;
+    VertexCollectorFilterTypeFlags GetMeshFilter(uint32_t meshIndex) const;
+    const VkAccelerationStructureGeometryKHR &GetMeshASGeometry(uint32_t meshIndex) const;
+    const VkAccelerationStructureBuildRangeInfoKHR &GetMeshASBuildRangeInfo(uint32_t meshIndex) const;
+    const uint32_t &GetMeshPrimitiveCount(uint32_t meshIndex) const;
+
+    // Write geometry info for an instance of the mesh. Returns global geometry index.
+    uint32_t WriteMeshInstanceGeomInfo(uint32_t frameIndex, uint32_t meshIndex, uint64_t instanceUniqueID,
+                                       const RgTransform &transform, std::span<MaterialTextures, 3> materials);
+
+    // Get hash of the filter's geometry data that affects BLAS. Null, if it's unknown.
+    // Only dynamic geometry is hashed.
+    std::optional<uint64_t> GetContentHash(VertexCollectorFilterTypeFlags filter) const;
+    // Hash of geometries' topology in the filter, if it's the same, BLAS can be updated. Null if unknown.
+    std::optional<uint64_t> GetTopologyHash(VertexCollectorFilterTypeFlags filter) const;
+
 
     // Are all geometries for each filter type in "flags" empty?
     bool AreGeometriesEmpty(VertexCollectorFilterTypeFlags flags) const;
@@ -120,9 +241,63 @@ public:
     void InsertVertexPreprocessFinishBarrier(VkCommandBuffer cmd);
 
 private:
-    void InitStagingBuffers(const std::shared_ptr<MemoryAllocator> &allocator);
+    struct PendingGeometry;
+    struct PendingBucket;
+    struct StagingRanges;
+    struct NewSharedData;
+    struct Chunk;
+
+    void InitStagingBuffers();
+    std::unique_ptr<Buffer> CreateStagingBuffer(VkDeviceSize size, const char *debugName) const;
+    std::shared_ptr<Buffer> CreateDeviceBuffer(VkDeviceSize size, const char *debugName) const;
+    std::shared_ptr<Buffer> CreateTransformsBuffer(VkDeviceSize size) const;
+    // Recreate device local buffers with the size of the staging ones, rebase AS geometries
+    // and queue chunk data copies. Must be called under shared lock of stagingMutex.
+    void RecreateDeviceBuffers(bool vertices, bool indices, bool transforms, std::vector<std::shared_ptr<Buffer>> &retired);
+
+    // Grow staging buffers, so the ranges that end at vertexEnd, indexEnd and transformEnd could fit in.
+    // Thread-safe, must not be called under stagingMutex. Returns false, if the limit is reached.
+    bool EnsureStagingCapacity(uint32_t vertexEnd, uint32_t indexEnd, uint32_t transformEnd);
+
+    // Reserve ranges in staging buffers for the geometries. Thread-safe.
+    // Returns ranges of the first geometry, the next ones follow it in the same order.
+    // If "outSharedRanges" is not empty, geometries with the same vertex and index data
+    // share one range: it's set for the geometries that must use the data written by another one,
+    // and the next ranges don't include them. New data that can be shared is added to "pOutNewSharedData",
+    // it must be passed to RegisterSharedData after the data is written.
+    StagingRanges ReserveRanges(std::span<const RgGeometryUploadInfo> infos,
+                                std::span<std::optional<StagingRanges>> outSharedRanges = {},
+                                std::vector<NewSharedData> *pOutNewSharedData = nullptr);
+    // Make the new data available for sharing, but only if the geometry that writes it
+    // wasn't rejected, i.e. its value in "results" is not UINT32_MAX. Thread-safe.
+    void RegisterSharedData(std::span<const NewSharedData> newSharedData, std::span<const uint32_t> results);
+    // Data of static geometries is shared, as it's not changed after adding
+    bool SharesStaticData() const;
+    // Span to pass to ReserveRanges for one geometry, empty if data is not shared
+    std::span<std::optional<StagingRanges>> GetSharedRangesSpan(std::optional<StagingRanges> &sharedRanges) const;
+    // Copy data to the reserved ranges and fill AS geometry and geometry info.
+    // Thread-safe, must be called under shared lock of stagingMutex.
+    bool PrepareGeometry(uint32_t frameIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials, const StagingRanges &ranges, PendingGeometry &result);
+    // Same as PrepareGeometry, but without reserving a place in the geometry's filter.
+    bool PrepareGeometryData(uint32_t frameIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials, const StagingRanges &ranges, PendingGeometry &result);
+    // Push AS geometry to its filter and write geometry info. Returns simple index.
+    uint32_t RegisterGeometry(const PendingGeometry &pending);
+    // Must be called under registerMutex
+    void AddStaticDependencies(uint32_t simpleIndex, const RgGeometryUploadInfo &info, std::span<MaterialTextures, 3> materials, const PendingGeometry &pending);
 
     void CopyDataToStaging(const RgGeometryUploadInfo &info, uint32_t vertIndex);
+    // Must be called under registerMutex
+    void QueueChunkDataCopy(const Chunk &chunk, bool vertices, bool indices, bool transforms);
+
+    // If data pointer is in the memory returned by AcquireMemory, get its index in the staging buffer.
+    // "pOutIsInStaging" is false, if the data must still be copied, e.g. if staging was grown
+    // after acquiring. "pOutIndex" is UINT32_MAX, if the count exceeds the acquired memory.
+    // Must be called under stagingMutex.
+    bool TryGetAcquiredVertexIndex(const RgVertex *pVertices, uint32_t vertexCount, uint32_t *pOutIndex, bool *pOutIsInStaging) const;
+    bool TryGetAcquiredIndexIndex(const uint32_t *pIndices, uint32_t indexCount, uint32_t *pOutIndex, bool *pOutIsInStaging) const;
+    // Zero, if the range was already reserved by AcquireMemory. Must be called under stagingMutex.
+    uint32_t GetVertexCountToReserve(const RgGeometryUploadInfo &info) const;
+    uint32_t GetIndexCountToReserve(const RgGeometryUploadInfo &info) const;
     
     bool CopyVertexDataFromStaging(VkCommandBuffer cmd);
     bool CopyIndexDataFromStaging(VkCommandBuffer cmd);
@@ -140,8 +315,9 @@ private:
     void PushPrimitiveCount(VertexCollectorFilterTypeFlags type, uint32_t primCount);
     void PushRangeInfo(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo);
    
-    uint32_t GetGeometryCount(VertexCollectorFilterTypeFlags type);
+    VertexCollectorFilter &GetFilter(VertexCollectorFilterTypeFlags type);
     uint32_t GetAllGeometryCount() const;
+    uint32_t GetCurrentTransformCount() const;
 
 private:
     struct MaterialRef
@@ -150,39 +326,159 @@ private:
         uint32_t layer;
     };
 
+    struct RetainedGeometry
+    {
+        uint64_t dataHash;
+        uint32_t vertIndex;
+        uint32_t indIndex;
+    };
+
+    struct SharedData
+    {
+        // the main hash is a key in the map, these values
+        // must also be the same to share the data
+        uint64_t verificationHash;
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        // ranges in the buffers
+        uint32_t vertIndex;
+        uint32_t indIndex;
+    };
+
+    enum class StagingType
+    {
+        Vertices,
+        Indices,
+        Transforms,
+    };
+
+    struct RetiredStaging
+    {
+        std::unique_ptr<Buffer> buffer;
+        const uint8_t *mapped;
+        VkDeviceSize size;
+        StagingType type;
+    };
+
+    // vertices returned by AcquireMemory for the compact format, they're encoded on adding
+    struct AcquiredVertices
+    {
+        std::unique_ptr<RgVertex[]> data;
+        uint32_t count;
+        // where the vertices will be placed in the staging buffer
+        uint32_t vertIndex;
+    };
+
 private:
     VkDevice device;
     VertexCollectorFilterTypeFlags filtersFlags;
-
-    Buffer stagingVertBuffer;
+    VertexBufferFormat vertexFormat;
+    VkDeviceSize vertexStride;
+    std::shared_ptr<MemoryAllocator> allocator;
+
+    // chunk regions are placed at the start of the buffers, as they have fixed sizes,
+    // and the usual ranges begin after them, so they can grow
+    uint32_t vertexBase;
+    uint32_t indexBase;
+    uint32_t transformBase;
+    // limits of the buffers' growth, including the chunk regions
+    uint32_t maxVertexCount;
+    uint32_t maxIndexCount;
+    uint32_t maxTransformCount;
+
+    std::unique_ptr<Buffer> stagingVertBuffer;
     std::shared_ptr<Buffer> vertBuffer;
 
-    Buffer stagingIndexBuffer;
+    std::unique_ptr<Buffer> stagingIndexBuffer;
     std::shared_ptr<Buffer> indexBuffer;
 
-    Buffer stagingTransformsBuffer;
+    std::unique_ptr<Buffer> stagingTransformsBuffer;
     std::shared_ptr<Buffer> transformsBuffer;
 
     std::shared_ptr<GeomInfoManager> geomInfoMgr;
 
-    uint32_t curVertexCount;
-    uint32_t curIndexCount;
-    uint32_t curPrimitiveCount;
-    uint32_t curTransformCount;
+    // incremented atomically to reserve ranges in staging buffers
+    std::atomic<uint32_t> curVertexCount;
+    std::atomic<uint32_t> curIndexCount;
+    std::atomic<uint32_t> curPrimitiveCount;
+    std::atomic<uint32_t> curTransformCount;
 
-    ShVertex *mappedVertexData;
+    // staging buffers are replaced on growth, so mapped pointers and capacities
+    // must be accessed under stagingMutex: writers take a shared lock, growth takes a unique one
+    uint8_t *mappedVertexData;
     uint32_t *mappedIndexData;
+    uint32_t stagingVertexCapacity;
+    uint32_t stagingIndexCapacity;
     VkTransformMatrixKHR *mappedTransformData;
+    uint32_t stagingTransformCapacity;
+    std::vector<RetiredStaging> retiredStaging;
+    mutable std::shared_mutex stagingMutex;
+
+    // compact vertices can't be written in place by a caller, so AcquireMemory
+    // returns a temporary memory, it's mapped by its address
+    std::map<uintptr_t, AcquiredVertices> acquiredVertices;
+    // blocks returned by AcquireMemory: first index in the staging buffer to the count,
+    // geometries that use them must fit into them
+    std::map<uint32_t, uint32_t> acquiredVertexRanges;
+    std::map<uint32_t, uint32_t> acquiredIndexRanges;
+    mutable std::mutex acquiredMutex;
 
     // material index to a list of () that have that material
     rgl::unordered_map<uint32_t, std::vector<MaterialRef>> materialDependencies;
-    rgl::unordered_map<VertexCollectorFilterTypeFlags, std::shared_ptr<VertexCollectorFilter>> filters;
+    // indexed by VertexCollectorFilterTypeFlags_GetID; null, if the filter wasn't created
+    std::array<std::unique_ptr<VertexCollectorFilter>, VERTEX_COLLECTOR_FILTER_COUNT> filters;
 
     // if some static geometries changed their tex coords, then they should be copied 
     // from staging to device-local; this array holds copy ranges; freed after vkCmdCopy call
     std::vector<VkBufferCopy> texCoordsToCopy;
 
-    rgl::unordered_map<uint32_t, uint32_t> simpleIndexToTransformIndex;
+    struct TransformRef
+    {
+        uint32_t                        transformIndex;
+        VertexCollectorFilterTypeFlags  filter;
+    };
+    rgl::unordered_map<uint32_t, TransformRef> simpleIndexToTransform;
+
+    // transform indices that were changed after the copy from staging,
+    // and filters of these geometries, i.e. BLAS-es that should be updated
+    DirtyRangeSet transformsToCopy;
+    std::bitset<VERTEX_COLLECTOR_FILTER_COUNT> filtersWithChangedGeometry;
+
+    // same as texCoordsToCopy, but for updated positions and normals
+    std::vector<VkBufferCopy> verticesToCopy;
+
+    // guards filters, geometry infos and material dependencies on immediate registration
+    std::mutex registerMutex;
+    // deferred geometries are sharded by thread to reduce contention
+    std::unique_ptr<PendingBucket[]> pendingBuckets;
+    std::vector<const PendingGeometry *> pendingSorted;
+
+    // geometries that have their own BLAS, guarded by registerMutex
+    std::vector<PendingGeometry> meshes;
+
+    // static chunks, sorted by ID, so geometry infos are written in the same order;
+    // guarded by registerMutex
+    std::map<uint64_t, std::unique_ptr<Chunk>> chunks;
+    // allocators of chunk regions, they're placed before the ranges of the usual static geometries
+    RangeAllocator chunkVertAllocator;
+    RangeAllocator chunkIndexAllocator;
+    RangeAllocator chunkTransformAllocator;
+    // ranges of the removed chunks to free, when the frame with the same index is finished
+    std::vector<std::unique_ptr<Chunk>> removedChunks[MAX_FRAMES_IN_FLIGHT];
+    // data of the added chunks to copy from staging
+    std::vector<VkBufferCopy> chunkVertsToCopy;
+    std::vector<VkBufferCopy> chunkIndicesToCopy;
+    std::vector<VkBufferCopy> chunkTransformsToCopy;
+
+    // Ranges of static geometry data by the hash of its content, identical meshes
+    // use the same vertices and indices, only their transforms and geometry infos differ
+    rgl::unordered_map<uint64_t, SharedData> sharedData;
+    std::mutex sharedDataMutex;
+
+    // Dynamic geometry data that was written to the staging buffers on the previous usage
+    // of this collector. If geometry has the same data at the same place, it's not copied again.
+    // Only read while collecting, rewritten in EndCollecting.
+    rgl::unordered_map<uint64_t, RetainedGeometry> retainedGeometries;
 };
 
 }
\ No newline at end of file
@@ -21,10 +21,11 @@
 #include "VertexCollectorFilter.h"
 
 #include "RgException.h"
+#include "Utils.h"
 
 using namespace RTGL1;
 
-VertexCollectorFilter::VertexCollectorFilter(VertexCollectorFilterTypeFlags _filter) : filter(_filter)
+VertexCollectorFilter::VertexCollectorFilter(VertexCollectorFilterTypeFlags _filter) : filter(_filter), reservedGeometryCount(0), contentHash(0), topologyHash(0)
 {}
 
 VertexCollectorFilter::~VertexCollectorFilter()
@@ -50,6 +51,30 @@ void VertexCollectorFilter::Reset()
     asGeometries.clear();
     primitiveCounts.clear();
     asBuildRangeInfos.clear();
+
+    reservedGeometryCount = 0;
+    contentHash = 0;
+    topologyHash = 0;
+}
+
+bool VertexCollectorFilter::TryReserveGeometry()
+{
+    uint32_t index = reservedGeometryCount.fetch_add(1);
+
+    if (index + 1 < VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(filter))
+    {
+        return true;
+    }
+
+    // don't hold a slot that wasn't reserved
+    ReleaseGeometry();
+    return false;
+}
+
+void VertexCollectorFilter::ReleaseGeometry()
+{
+    assert(reservedGeometryCount > 0);
+    reservedGeometryCount.fetch_sub(1);
 }
 
 uint32_t VertexCollectorFilter::PushGeometry(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureGeometryKHR &geom)
@@ -76,6 +101,34 @@ void VertexCollectorFilter::PushRangeInfo(VertexCollectorFilterTypeFlags type, c
     asBuildRangeInfos.push_back(rangeInfo);
 }
 
+void VertexCollectorFilter::PushContentHash(VertexCollectorFilterTypeFlags type, std::optional<uint64_t> geomHash)
+{
+    assert((type & filter) == filter);
+
+    if (contentHash && geomHash)
+    {
+        contentHash = Utils::HashCombine(*contentHash, *geomHash);
+    }
+    else
+    {
+        contentHash = std::nullopt;
+    }
+}
+
+void VertexCollectorFilter::PushTopologyHash(VertexCollectorFilterTypeFlags type, std::optional<uint64_t> geomTopologyHash)
+{
+    assert((type & filter) == filter);
+
+    if (topologyHash && geomTopologyHash)
+    {
+        topologyHash = Utils::HashCombine(*topologyHash, *geomTopologyHash);
+    }
+    else
+    {
+        topologyHash = std::nullopt;
+    }
+}
+
 VertexCollectorFilterTypeFlags VertexCollectorFilter::GetFilter() const
 {
     return filter;
@@ -85,3 +138,44 @@ uint32_t VertexCollectorFilter::GetGeometryCount() const
 {
     return (uint32_t)asGeometries.size();
 }
+
+std::optional<uint64_t> VertexCollectorFilter::GetContentHash() const
+{
+    return contentHash;
+}
+
+std::optional<uint64_t> VertexCollectorFilter::GetTopologyHash() const
+{
+    return topologyHash;
+}
+
+void VertexCollectorFilter::RebaseASGeometries(VkDeviceAddress oldVertexAddress, VkDeviceAddress newVertexAddress,
+                                               VkDeviceAddress oldIndexAddress, VkDeviceAddress newIndexAddress,
+                                               VkDeviceAddress oldTransformAddress, VkDeviceAddress newTransformAddress)
+{
+    for (auto &geom : asGeometries)
+    {
+        RebaseASGeometry(geom, oldVertexAddress, newVertexAddress, oldIndexAddress, newIndexAddress,
+                         oldTransformAddress, newTransformAddress);
+    }
+}
+
+void VertexCollectorFilter::RebaseASGeometry(VkAccelerationStructureGeometryKHR &geom,
+                                             VkDeviceAddress oldVertexAddress, VkDeviceAddress newVertexAddress,
+                                             VkDeviceAddress oldIndexAddress, VkDeviceAddress newIndexAddress,
+                                             VkDeviceAddress oldTransformAddress, VkDeviceAddress newTransformAddress)
+{
+    VkAccelerationStructureGeometryTrianglesDataKHR &trData = geom.geometry.triangles;
+
+    assert(trData.vertexData.deviceAddress >= oldVertexAddress);
+    trData.vertexData.deviceAddress = newVertexAddress + (trData.vertexData.deviceAddress - oldVertexAddress);
+
+    if (trData.indexType != VK_INDEX_TYPE_NONE_KHR)
+    {
+        assert(trData.indexData.deviceAddress >= oldIndexAddress);
+        trData.indexData.deviceAddress = newIndexAddress + (trData.indexData.deviceAddress - oldIndexAddress);
+    }
+
+    assert(trData.transformData.deviceAddress >= oldTransformAddress);
+    trData.transformData.deviceAddress = newTransformAddress + (trData.transformData.deviceAddress - oldTransformAddress);
+}
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <optional>
 #include <vector>
 
 #include "Common.h"
@@ -50,12 +52,35 @@ public:
 
     void Reset();
 
+    // Thread-safe. Reserve a slot for a geometry, returns false if the filter is full.
+    bool TryReserveGeometry();
+    // Thread-safe. Release a slot that was reserved, but wasn't filled with a geometry.
+    void ReleaseGeometry();
+
     uint32_t PushGeometry(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureGeometryKHR& geom);
     void PushPrimitiveCount(VertexCollectorFilterTypeFlags type, uint32_t primCount);
     void PushRangeInfo(VertexCollectorFilterTypeFlags type, const VkAccelerationStructureBuildRangeInfoKHR &rangeInfo);
+    // Accumulate hash of geometry's data that affects BLAS. Null if the hash is unknown.
+    void PushContentHash(VertexCollectorFilterTypeFlags type, std::optional<uint64_t> geomHash);
+    // Accumulate hash of geometry's topology, i.e. of everything that
+    // must be the same to update BLAS instead of rebuilding it.
+    void PushTopologyHash(VertexCollectorFilterTypeFlags type, std::optional<uint64_t> geomTopologyHash);
 
     VertexCollectorFilterTypeFlags GetFilter() const;
     uint32_t GetGeometryCount() const;
+    // Hash of all pushed geometries, null if it's unknown for at least one of them
+    std::optional<uint64_t> GetContentHash() const;
+    // Topology hash of all pushed geometries, null if it's unknown for at least one of them
+    std::optional<uint64_t> GetTopologyHash() const;
+
+    // Vertex, index and transform buffers were recreated, so shift data addresses of the pushed geometries
+    void RebaseASGeometries(VkDeviceAddress oldVertexAddress, VkDeviceAddress newVertexAddress,
+                            VkDeviceAddress oldIndexAddress, VkDeviceAddress newIndexAddress,
+                            VkDeviceAddress oldTransformAddress, VkDeviceAddress newTransformAddress);
+    static void RebaseASGeometry(VkAccelerationStructureGeometryKHR &geom,
+                                 VkDeviceAddress oldVertexAddress, VkDeviceAddress newVertexAddress,
+                                 VkDeviceAddress oldIndexAddress, VkDeviceAddress newIndexAddress,
+                                 VkDeviceAddress oldTransformAddress, VkDeviceAddress newTransformAddress);
 
 private:
     VertexCollectorFilterTypeFlags filter;
@@ -63,6 +88,11 @@ private:
     std::vector<uint32_t> primitiveCounts;
     std::vector<VkAccelerationStructureGeometryKHR> asGeometries;
     std::vector<VkAccelerationStructureBuildRangeInfoKHR> asBuildRangeInfos;
+
+    std::atomic<uint32_t> reservedGeometryCount;
+
+    std::optional<uint64_t> contentHash;
+    std::optional<uint64_t> topologyHash;
 };
 
 }
\ No newline at end of file
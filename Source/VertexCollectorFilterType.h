@@ -21,8 +21,12 @@
 #pragma once
 
 #include "RTGL1/RTGL1.h"
+#include "Generated/ShaderCommonC.h"
 
-#include <functional>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <iterator>
 
 namespace RTGL1
 {
@@ -79,51 +83,150 @@ constexpr VertexCollectorFilterTypeFlagBits VertexCollectorFilterGroup_PrimaryVi
 };
 
 
-inline VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlagBits b)
+constexpr VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlagBits b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(static_cast<FL>(a) | static_cast<FL>(b));
 }
 
-inline VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlags a, VertexCollectorFilterTypeFlagBits b)
+constexpr VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlags a, VertexCollectorFilterTypeFlagBits b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(a | static_cast<FL>(b));
 }
 
-inline VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlags b)
+constexpr VertexCollectorFilterTypeFlags operator|(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlags b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(static_cast<FL>(a) | b);
 }
 
-inline VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlagBits b)
+constexpr VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlagBits b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(static_cast<FL>(a) & static_cast<FL>(b));
 }
 
-inline VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlags a, VertexCollectorFilterTypeFlagBits b)
+constexpr VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlags a, VertexCollectorFilterTypeFlagBits b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(a & static_cast<FL>(b));
 }
 
-inline VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlags b)
+constexpr VertexCollectorFilterTypeFlags operator&(VertexCollectorFilterTypeFlagBits a, VertexCollectorFilterTypeFlags b)
 {
     typedef VertexCollectorFilterTypeFlags FL;
     return static_cast<FL>(static_cast<FL>(a) & b);
 }
 
-void                            VertexCollectorFilterTypeFlags_Init();
-uint32_t                        VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount();
-uint32_t                        VertexCollectorFilterTypeFlags_GetID(VertexCollectorFilterTypeFlags flags);
-// Offset of the beginning of a group (which corresponds to the specified flags) in a global array of bottom level geometries
-uint32_t                        VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(VertexCollectorFilterTypeFlags flags);
+
+
+// All combinations of the groups are known at compile time,
+// so each filter has a constexpr ID in [0, VERTEX_COLLECTOR_FILTER_COUNT)
+constexpr uint32_t VERTEX_COLLECTOR_FILTER_COUNT =
+    uint32_t(std::size(VertexCollectorFilterGroup_ChangeFrequency) *
+             std::size(VertexCollectorFilterGroup_PassThrough) *
+             std::size(VertexCollectorFilterGroup_PrimaryVisibility));
+
+static_assert(VERTEX_COLLECTOR_FILTER_COUNT == MAX_TOP_LEVEL_INSTANCE_COUNT, "It's recommended for MAX_TOP_LEVEL_INSTANCE_COUNT to be such value");
+static_assert(LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT < MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT);
+
+// Flags must contain exactly one bit from each group
+constexpr uint32_t VertexCollectorFilterTypeFlags_GetID(VertexCollectorFilterTypeFlags flags)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    const uint32_t cf = (flags & FT::MASK_CHANGE_FREQUENCY_GROUP  ) >> VERTEX_COLLECTOR_FILTER_TYPE_BIT_OFFSET_CF;
+    const uint32_t pt = (flags & FT::MASK_PASS_THROUGH_GROUP      ) >> VERTEX_COLLECTOR_FILTER_TYPE_BIT_OFFSET_PT;
+    const uint32_t pv = (flags & FT::MASK_PRIMARY_VISIBILITY_GROUP) >> VERTEX_COLLECTOR_FILTER_TYPE_BIT_OFFSET_PV;
+
+    assert(std::has_single_bit(cf) && std::has_single_bit(pt) && std::has_single_bit(pv));
+
+    // group arrays are in the order of their bits
+    return (uint32_t(std::countr_zero(cf)) * uint32_t(std::size(VertexCollectorFilterGroup_PassThrough)) + 
+            uint32_t(std::countr_zero(pt))) * uint32_t(std::size(VertexCollectorFilterGroup_PrimaryVisibility)) + 
+            uint32_t(std::countr_zero(pv));
+}
+
+// Filter flags by their ID
+constexpr std::array<VertexCollectorFilterTypeFlags, VERTEX_COLLECTOR_FILTER_COUNT> VertexCollectorFilterTypeFlags_AllFilters = [] ()
+{
+    std::array<VertexCollectorFilterTypeFlags, VERTEX_COLLECTOR_FILTER_COUNT> all = {};
+    uint32_t index = 0;
+
+    for (auto cf : VertexCollectorFilterGroup_ChangeFrequency)
+    {
+        for (auto pt : VertexCollectorFilterGroup_PassThrough)
+        {
+            for (auto pv : VertexCollectorFilterGroup_PrimaryVisibility)
+            {
+                all[index] = cf | pt | pv;
+                index++;
+            }
+        }
+    }
+
+    return all;
+}();
+
+static_assert([] ()
+{
+    for (uint32_t i = 0; i < VERTEX_COLLECTOR_FILTER_COUNT; i++)
+    {
+        if (VertexCollectorFilterTypeFlags_GetID(VertexCollectorFilterTypeFlags_AllFilters[i]) != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}(), "Filter IDs must be in the order of iteration over the groups");
+
 // Amount of bottom level geometries in a group with specified flags
-uint32_t                        VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(VertexCollectorFilterTypeFlags flags);
+constexpr uint32_t VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(VertexCollectorFilterTypeFlags flags)
+{
+    typedef VertexCollectorFilterTypeFlagBits FT;
+
+    // amount of world objects is significantly larger than first-person ones
+    const bool hasLowerAmount = flags & (FT::PV_FIRST_PERSON | FT::PV_FIRST_PERSON_VIEWER);
+
+    return hasLowerAmount ? LOWER_BOTTOM_LEVEL_GEOMETRIES_COUNT : MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT;
+}
+
+// Offset of each group in a global array of bottom level geometries, by filter ID;
+// the last element is the total count
+constexpr std::array<uint32_t, VERTEX_COLLECTOR_FILTER_COUNT + 1> VertexCollectorFilterTypeFlags_OffsetsInGlobalArray = [] ()
+{
+    std::array<uint32_t, VERTEX_COLLECTOR_FILTER_COUNT + 1> offsets = {};
+
+    for (uint32_t i = 0; i < VERTEX_COLLECTOR_FILTER_COUNT; i++)
+    {
+        offsets[i + 1] = offsets[i] + VertexCollectorFilterTypeFlags_GetAmountInGlobalArray(VertexCollectorFilterTypeFlags_AllFilters[i]);
+    }
+
+    return offsets;
+}();
+
+constexpr uint32_t VertexCollectorFilterTypeFlags_GetAllBottomLevelGeomsCount()
+{
+    return VertexCollectorFilterTypeFlags_OffsetsInGlobalArray[VERTEX_COLLECTOR_FILTER_COUNT];
+}
+
+// Offset of the beginning of a group (which corresponds to the specified flags) in a global array of bottom level geometries
+constexpr uint32_t VertexCollectorFilterTypeFlags_GetOffsetInGlobalArray(VertexCollectorFilterTypeFlags flags)
+{
+    return VertexCollectorFilterTypeFlags_OffsetsInGlobalArray[VertexCollectorFilterTypeFlags_GetID(flags)];
+}
+
+template<typename Func>
+constexpr void VertexCollectorFilterTypeFlags_IterateOverFlags(Func &&f)
+{
+    for (VertexCollectorFilterTypeFlags flags : VertexCollectorFilterTypeFlags_AllFilters)
+    {
+        f(flags);
+    }
+}
+
 const char*                     VertexCollectorFilterTypeFlags_GetNameForBLAS(VertexCollectorFilterTypeFlags flags);
 VertexCollectorFilterTypeFlags  VertexCollectorFilterTypeFlags_GetForGeometry(const RgGeometryUploadInfo &info);
-void                            VertexCollectorFilterTypeFlags_IterateOverFlags(std::function<void(VertexCollectorFilterTypeFlags)> f);
 
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <stdexcept>
 
+#include "CpuTrace.h"
 #include "HaltonSequence.h"
 #include "Matrix.h"
 #include "RenderResolutionHelper.h"
@@ -37,18 +38,26 @@ VkCommandBuffer VulkanDevice::BeginFrame(const RgStartFrameInfo &startInfo)
 {
     uint32_t frameIndex = currentFrameState.IncrementFrameIndexAndGet();
 
-    if (!waitForOutOfFrameFence)
     {
-        // wait for previous cmd with the same frame index
-        Utils::WaitAndResetFence(device, frameFences[frameIndex]);
+        RG_TRACE_SCOPE("Wait for frame fence");
+
+        if (!waitForOutOfFrameFence)
+        {
+            // wait for previous cmd with the same frame index
+            Utils::WaitAndResetFence(device, frameFences[frameIndex]);
+        }
+        else
+        {
+            Utils::WaitAndResetFences(device, frameFences[frameIndex], outOfFrameFences[frameIndex]);
+        }
     }
-    else
+
     {
-        Utils::WaitAndResetFences(device, frameFences[frameIndex], outOfFrameFences[frameIndex]);
-    }
+        RG_TRACE_SCOPE("Acquire swapchain image");
 
-    swapchain->RequestVsync(startInfo.requestVSync);
-    swapchain->AcquireImage(imageAvailableSemaphores[frameIndex]);
+        swapchain->RequestVsync(startInfo.requestVSync);
+        swapchain->AcquireImage(imageAvailableSemaphores[frameIndex]);
+    }
 
     VkSemaphore semaphoreToWaitOnSubmit = imageAvailableSemaphores[frameIndex];
 
@@ -99,6 +108,9 @@ VkCommandBuffer VulkanDevice::BeginFrame(const RgStartFrameInfo &startInfo)
 
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
 
+    // fence of the frame index was waited for, timings can be read without a stall
+    frameTimings->PrepareForFrame(cmd, frameIndex, frameId);
+
     BeginCmdLabel(cmd, "Prepare for frame");
 
     // start dynamic geometry recording to current frame
@@ -479,6 +491,8 @@ void VulkanDevice::FillUniform(ShGlobalUniform *gu, const RgDrawFrameInfo &drawI
 
     gu->waterNormalTextureIndex = textureManager->GetWaterNormalTextureIndex();
 
+    gu->vertexFormatCompact = compactVertexFormat;
+
     gu->cameraRayConeSpreadAngle = atanf( ( 2.0f * tanf( drawInfo.fovYRadians * 0.5f ) ) / ( float )renderResolution.Height() );
 
     if( Utils::IsAlmostZero( drawInfo.worldUpVector ) )
@@ -594,10 +608,14 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
 
     // submit geometry and upload uniform after getting data from a scene
-    scene->SubmitForFrame(cmd, frameIndex, uniform, 
-                          uniform->GetData()->rayCullMaskWorld, 
-                          allowGeometryWithSkyFlag,
-                          drawInfo.disableRayTracedGeometry);
+    {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_SCENE);
+
+        scene->SubmitForFrame(cmd, frameIndex, uniform, 
+                              uniform->GetData()->rayCullMaskWorld, 
+                              allowGeometryWithSkyFlag,
+                              drawInfo.disableRayTracedGeometry);
+    }
 
 
     framebuffers->PrepareForSize(renderResolution.GetResolutionState());
@@ -610,6 +628,8 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
         // draw rasterized sky to albedo before tracing primary rays
         if (uniform->GetData()->skyType == RG_SKY_TYPE_RASTERIZED_GEOMETRY)
         {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_RASTERIZED_SKY);
+
             RgFloat3D skyViewerPosition = drawInfo.pSkyParams ? drawInfo.pSkyParams->skyViewerPosition : RgFloat3D{ 0,0,0 };
 
             rasterizer->DrawSkyToCubemap(cmd, frameIndex, textureManager, uniform);
@@ -619,7 +639,10 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
 
 
     {
-        lightGrid->Build(cmd, frameIndex, uniform, blueNoise, scene->GetLightManager());
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_LIGHT_GRID);
+            lightGrid->Build(cmd, frameIndex, uniform, blueNoise, scene->GetLightManager());
+        }
 
         decalManager->SubmitForFrame(cmd, frameIndex);
         portalList->SubmitForFrame(cmd, frameIndex);
@@ -639,34 +662,65 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
                                               portalList.get(),
                                               volumetric.get() );
 
-        pathTracer->TracePrimaryRays(params);
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_PRIMARY_RAYS);
+            pathTracer->TracePrimaryRays(params);
+        }
 
         // draw decals on top of primary surface
-        decalManager->Draw(cmd, frameIndex, uniform, framebuffers, textureManager);
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_DECALS);
+            decalManager->Draw(cmd, frameIndex, uniform, framebuffers, textureManager);
+        }
 
         if (uniform->GetData()->reflectRefractMaxDepth > 0)
         {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_REFLECTIONS_REFRACTIONS);
             pathTracer->TraceReflectionRefractionRays(params);
         }
 
-        scene->GetLightManager()->BarrierLightGrid(cmd, frameIndex);
-        pathTracer->CalculateInitialReservoirs(params);
-        pathTracer->TraceDirectllumination(params);
-        pathTracer->TraceIndirectllumination(params);
-        pathTracer->TraceVolumetric(params);
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_DIRECT_ILLUMINATION);
+            scene->GetLightManager()->BarrierLightGrid(cmd, frameIndex);
+            pathTracer->CalculateInitialReservoirs(params);
+            pathTracer->TraceDirectllumination(params);
+        }
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_INDIRECT_ILLUMINATION);
+            pathTracer->TraceIndirectllumination(params);
+        }
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_VOLUMETRIC);
+            pathTracer->TraceVolumetric(params);
+        }
 
-        pathTracer->CalculateGradientsSamples(params);
-        denoiser->Denoise(cmd, frameIndex, uniform);
-        volumetric->ProcessScattering( cmd, frameIndex, uniform.get(), blueNoise.get() );
-        tonemapping->CalculateExposure(cmd, frameIndex, uniform);
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_DENOISE);
+            pathTracer->CalculateGradientsSamples(params);
+            denoiser->Denoise(cmd, frameIndex, uniform);
+        }
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_VOLUMETRIC);
+            volumetric->ProcessScattering( cmd, frameIndex, uniform.get(), blueNoise.get() );
+        }
+        {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_TONEMAPPING);
+            tonemapping->CalculateExposure(cmd, frameIndex, uniform);
+        }
     }
 
-    imageComposition->PrepareForRaster( cmd, frameIndex, uniform.get() );
-    volumetric->BarrierToReadScattering( cmd, frameIndex );
-    volumetric->BarrierToReadIllumination( cmd );
+    {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_COMPOSITION);
+
+        imageComposition->PrepareForRaster( cmd, frameIndex, uniform.get() );
+        volumetric->BarrierToReadScattering( cmd, frameIndex );
+        volumetric->BarrierToReadIllumination( cmd );
+    }
 
     if (!drawInfo.disableRasterization)
     {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_RASTERIZATION);
+
         // draw rasterized geometry into the final image
         rasterizer->DrawToFinalImage(
             cmd,
@@ -682,20 +736,27 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
             drawInfo.pLensFlareParams );
     }
 
-    imageComposition->Finalize(
-        cmd, frameIndex, uniform.get(), tonemapping.get(), volumetric.get() );
+    {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_COMPOSITION);
+
+        imageComposition->Finalize(
+            cmd, frameIndex, uniform.get(), tonemapping.get(), volumetric.get() );
+    }
 
 
     bool enableBloom = drawInfo.pBloomParams == nullptr || (drawInfo.pBloomParams != nullptr && drawInfo.pBloomParams->bloomIntensity > 0.0f);
 
     if (enableBloom)
     {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_BLOOM);
         bloom->Prepare(cmd, frameIndex, uniform, tonemapping);
     }
 
 
     FramebufferImageIndex accum = FramebufferImageIndex::FB_IMAGE_INDEX_FINAL;
     {
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_UPSCALE);
+
         // upscale finalized image
         if (renderResolution.IsNvDlssEnabled())
         {
@@ -729,14 +790,20 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
     {
         if (renderResolution.IsDedicatedSharpeningEnabled())
         {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_POST_EFFECTS);
+
             accum = sharpening->Apply(
                 cmd, frameIndex, framebuffers, renderResolution.UpscaledWidth(), renderResolution.UpscaledHeight(), accum,
                 renderResolution.GetSharpeningTechnique(), renderResolution.GetSharpeningIntensity());
         }
         if (enableBloom)
         {
+            FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_BLOOM);
             accum = bloom->Apply(cmd, frameIndex, uniform, renderResolution.UpscaledWidth(), renderResolution.UpscaledHeight(), accum);
         }
+
+        FrameTimingScope timing(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_POST_EFFECTS);
+
         if (effectColorTint->Setup(args, drawInfo.postEffectParams.pColorTint))
         {
             accum = effectColorTint->Apply(args, accum);
@@ -767,6 +834,8 @@ void VulkanDevice::Render(VkCommandBuffer cmd, const RgDrawFrameInfo &drawInfo)
         }
     }
 
+    FrameTimingScope swapchainTiming(*frameTimings, cmd, frameIndex, RG_FRAME_PASS_SWAPCHAIN);
+
     // draw geometry such as HUD into an upscaled framebuf
     if (!drawInfo.disableRasterization)
     {
@@ -805,16 +874,24 @@ void VulkanDevice::EndFrame(VkCommandBuffer cmd)
     uint32_t frameIndex = currentFrameState.GetFrameIndex();
     VkSemaphore semaphoreToWait = currentFrameState.GetSemaphoreForWaitAndRemove();
 
-    // submit command buffer, but wait until presentation engine has completed using image
-    cmdManager->Submit(
-        cmd, 
-        semaphoreToWait,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
-        renderFinishedSemaphores[frameIndex],
-        frameFences[frameIndex]);
+    {
+        RG_TRACE_SCOPE("Queue submit");
 
-    // present on a surface when rendering will be finished
-    swapchain->Present(queues, renderFinishedSemaphores[frameIndex]);
+        // submit command buffer, but wait until presentation engine has completed using image
+        cmdManager->Submit(
+            cmd, 
+            semaphoreToWait,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 
+            renderFinishedSemaphores[frameIndex],
+            frameFences[frameIndex]);
+    }
+
+    {
+        RG_TRACE_SCOPE("Present");
+
+        // present on a surface when rendering will be finished
+        swapchain->Present(queues, renderFinishedSemaphores[frameIndex]);
+    }
 
     frameId++;
 }
@@ -825,6 +902,8 @@ void VulkanDevice::EndFrame(VkCommandBuffer cmd)
 
 void VulkanDevice::StartFrame(const RgStartFrameInfo *startInfo)
 {
+    RG_TRACE_SCOPE("rgStartFrame");
+
     if (currentFrameState.WasFrameStarted())
     {
         throw RgException(RG_FRAME_WASNT_ENDED);
@@ -841,6 +920,8 @@ void VulkanDevice::StartFrame(const RgStartFrameInfo *startInfo)
 
 void VulkanDevice::DrawFrame(const RgDrawFrameInfo *drawInfo)
 {
+    RG_TRACE_SCOPE("rgDrawFrame");
+
     if (!currentFrameState.WasFrameStarted())
     {
         throw RgException(RG_FRAME_WASNT_STARTED);
@@ -871,6 +952,101 @@ void VulkanDevice::DrawFrame(const RgDrawFrameInfo *drawInfo)
     currentFrameState.OnEndFrame();
 }
 
+void VulkanDevice::WriteCpuTrace(const char *pFilePath) const
+{
+#ifdef RG_USE_CPU_TRACING
+    if (!libconfig.cpuTracing)
+    {
+        throw RgException(RG_WRONG_FUNCTION_CALL, "CPU tracing must be enabled with \"cputracing\" entry in the library config");
+    }
+
+    if (pFilePath == nullptr || pFilePath[0] == '\0')
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "File path is empty");
+    }
+
+    if (!CpuTrace::WriteChromeTrace(pFilePath))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, std::string("Can't write CPU trace to ") + pFilePath);
+    }
+#else
+    throw RgException(RG_WRONG_FUNCTION_CALL, "Library was compiled without RG_WITH_CPU_TRACING");
+#endif // RG_USE_CPU_TRACING
+}
+
+void VulkanDevice::GetFrameTimings(RgFrameTimings *pResult) const
+{
+    if (pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    *pResult = frameTimings->GetLatest();
+}
+
+static RgScratchBufferStats ToRgScratchBufferStats(const ScratchBuffer::Stats &s)
+{
+    return RgScratchBufferStats
+    {
+        .capacity = s.capacity,
+        .currentFrameUsage = s.currentFrameUsage,
+        .highWaterMark = s.highWaterMark,
+        .overflowCount = s.overflowCount,
+        .growCount = s.growCount,
+    };
+}
+
+void VulkanDevice::GetScratchStats(RgScratchStats *pResult) const
+{
+    if (pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    const auto &asManager = scene->GetASManager();
+
+    *pResult = RgScratchStats
+    {
+        .frame = ToRgScratchBufferStats(asManager->GetScratchStats()),
+        .staticGeometry = ToRgScratchBufferStats(asManager->GetStaticScratchStats()),
+    };
+}
+
+void VulkanDevice::GetStaticGeometryOptimizationStats(RgStaticGeometryOptimizationStats *pResult) const
+{
+    if (pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    const auto *stats = scene->GetStaticOptimizationStats();
+
+    if (stats == nullptr)
+    {
+        *pResult = RgStaticGeometryOptimizationStats
+        {
+            .wasOptimized = RG_FALSE,
+        };
+        return;
+    }
+
+    *pResult = RgStaticGeometryOptimizationStats
+    {
+        .wasOptimized = RG_TRUE,
+        .inputGeometryCount = stats->inputGeometryCount,
+        .outputGeometryCount = stats->outputGeometryCount,
+        .mergedGeometryCount = stats->mergedGeometryCount,
+        .inputVertexCount = stats->inputVertexCount,
+        .outputVertexCount = stats->outputVertexCount,
+        .weldedVertexCount = stats->weldedVertexCount,
+        .inputTriangleCount = stats->inputTriangleCount,
+        .outputTriangleCount = stats->outputTriangleCount,
+        .degenerateTriangleCount = stats->degenerateTriangleCount,
+        .workerCount = stats->workerCount,
+        .durationMs = static_cast<float>(stats->durationMs),
+    };
+}
+
 bool VulkanDevice::IsSuspended() const
 {
     if (!swapchain)
@@ -887,8 +1063,13 @@ bool RTGL1::VulkanDevice::IsRenderUpscaleTechniqueAvailable(RgRenderUpscaleTechn
     {
         case RG_RENDER_UPSCALE_TECHNIQUE_NEAREST:
         case RG_RENDER_UPSCALE_TECHNIQUE_LINEAR:
+            return true;
         case RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2:
+        #ifdef RG_USE_NULL_DEVICE
+            return false;
+        #else
             return true;
+        #endif // RG_USE_NULL_DEVICE
         case RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS:
             return nvDlss->IsDlssAvailable();
         default:
@@ -911,82 +1092,149 @@ void VulkanDevice::UploadGeometry(const RgGeometryUploadInfo *uploadInfo)
         throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
     }
 
-    if (uploadInfo->pVertices == nullptr || uploadInfo->vertexCount == 0)
+    // unique ID is checked by the scene while reserving it
+    ValidateGeometryUploadInfo(*uploadInfo);
+
+    if (!scene->Upload(currentFrameState.GetFrameIndex(), *uploadInfo))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID="s + std::to_string(uploadInfo->uniqueID) +
+                          " wasn't uploaded: a limit of geometry count or buffer size is reached");
+    }
+}
+
+void VulkanDevice::UploadGeometries(uint32_t uploadInfoCount, const RgGeometryUploadInfo *pUploadInfos)
+{
+    if (uploadInfoCount == 0)
+    {
+        return;
+    }
+
+    if (pUploadInfos == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    const std::span<const RgGeometryUploadInfo> uploadInfos(pUploadInfos, uploadInfoCount);
+
+    // validate everything before uploading, so an invalid batch is not uploaded partially;
+    // unique IDs are checked by the scene while reserving them
+    for (const RgGeometryUploadInfo &info : uploadInfos)
+    {
+        ValidateGeometryUploadInfo(info);
+    }
+
+    if (!scene->Upload(currentFrameState.GetFrameIndex(), uploadInfos))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Some of the geometries weren't uploaded: "
+                          "a limit of geometry count or buffer size is reached, the others were uploaded");
+    }
+}
+
+void VulkanDevice::AcquireGeometryMemory(uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices)
+{
+    if (ppOutVertices == nullptr || (indexCount != 0 && ppOutIndices == nullptr))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (vertexCount == 0)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Vertex count must not be 0");
+    }
+
+    // dynamic staging buffers are cleared on a frame start
+    if (!currentFrameState.WasFrameStarted())
+    {
+        throw RgException(RG_FRAME_WASNT_STARTED);
+    }
+
+    uint32_t *pIndices = nullptr;
+    scene->AcquireDynamicGeometryMemory(currentFrameState.GetFrameIndex(), vertexCount, indexCount, ppOutVertices, &pIndices);
+
+    if (ppOutIndices != nullptr)
+    {
+        *ppOutIndices = pIndices;
+    }
+}
+
+void VulkanDevice::ValidateGeometryUploadInfo(const RgGeometryUploadInfo &info) const
+{
+    if (info.pVertices == nullptr || info.vertexCount == 0)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Incorrect vertex data");
     }
 
-    if ((uploadInfo->pIndices == nullptr && uploadInfo->indexCount != 0) ||
-        (uploadInfo->pIndices != nullptr && uploadInfo->indexCount == 0))
+    if (info.pIndices != nullptr && info.pIndices16 != nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Only one of pIndices and pIndices16 must be specified");
+    }
+
+    const bool hasIndexData = info.pIndices != nullptr || info.pIndices16 != nullptr;
+
+    if ((!hasIndexData && info.indexCount != 0) ||
+        (hasIndexData && info.indexCount == 0))
     {
         throw RgException(RG_WRONG_ARGUMENT, "Incorrect index data");
     }
 
-    if (uploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC &&
-        uploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC_MOVABLE &&
-        uploadInfo->geomType != RG_GEOMETRY_TYPE_DYNAMIC &&
+    if (info.geomType != RG_GEOMETRY_TYPE_STATIC &&
+        info.geomType != RG_GEOMETRY_TYPE_STATIC_MOVABLE &&
+        info.geomType != RG_GEOMETRY_TYPE_DYNAMIC &&
 
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT &&
-        uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ACID_REFLECT_REFRACT &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ALPHA_TESTED &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_MIRROR &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_ONLY_REFLECT &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_WATER_REFLECT_REFRACT &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_GLASS_REFLECT_REFRACT &&
+        info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_ACID_REFLECT_REFRACT &&
 
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_1 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON &&
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON_VIEWER && 
-        uploadInfo->visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_SKY)
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0 &&
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_1 &&
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 &&
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON &&
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_FIRST_PERSON_VIEWER && 
+        info.visibilityType != RG_GEOMETRY_VISIBILITY_TYPE_SKY)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Incorrect type of ray traced geometry");
     }
 
     if (allowGeometryWithSkyFlag)
     {
-        if (uploadInfo->visibilityType == RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2)
+        if (info.visibilityType == RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2)
         {
             throw RgException(RG_WRONG_ARGUMENT, "Geometry with RG_GEOMETRY_VISIBILITY_TYPE_WORLD_2 cannot be used, as RgInstanceCreateInfo::allowGeometryWithSkyFlag was true");
         }
     }
     else
     {
-        if (uploadInfo->visibilityType == RG_GEOMETRY_VISIBILITY_TYPE_SKY)
+        if (info.visibilityType == RG_GEOMETRY_VISIBILITY_TYPE_SKY)
         {
             throw RgException(RG_WRONG_ARGUMENT, "Geometry with RG_GEOMETRY_VISIBILITY_TYPE_SKY cannot be used, as RgInstanceCreateInfo::allowGeometryWithSkyFlag was false");
         }
     }
 
-    if ((uploadInfo->flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_MULTIPLY_BIT) != 0 &&
-        (uploadInfo->flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_ADD_BIT) != 0)
+    if ((info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_MULTIPLY_BIT) != 0 &&
+        (info.flags & RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_ADD_BIT) != 0)
     {
         throw RgException(RG_WRONG_ARGUMENT, "RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_MULTIPLY_BIT and RG_GEOMETRY_UPLOAD_REFL_REFR_ALBEDO_ADD_BIT must be set separately");
     }
 
-    if (scene->DoesUniqueIDExist(uploadInfo->uniqueID))
-    {
-        throw RgException(RG_WRONG_ARGUMENT, "Geometry with ID="s + std::to_string(uploadInfo->uniqueID) + " already exists");
-    }
-
-    if (uploadInfo->pPortalIndex != nullptr && uploadInfo->passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL)
+    if (info.pPortalIndex != nullptr && info.passThroughType != RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Geometry's pPortalIndex is non-null, but geometry is not marked as portal");
     }
 
-    if (uploadInfo->pPortalIndex == nullptr && uploadInfo->passThroughType == RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL)
+    if (info.pPortalIndex == nullptr && info.passThroughType == RG_GEOMETRY_PASS_THROUGH_TYPE_PORTAL)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Geometry is marked as portal, but pPortalIndex is null");
     }
 
-    if (uploadInfo->pPortalIndex && *(uploadInfo->pPortalIndex) >= PORTAL_MAX_COUNT)
+    if (info.pPortalIndex && *(info.pPortalIndex) >= PORTAL_MAX_COUNT)
     {
         throw RgException(RG_WRONG_ARGUMENT, "Geometry's portal index must be in [0, 62]");
     }
-
-    scene->Upload(currentFrameState.GetFrameIndex(), *uploadInfo);
 }
 
 void VulkanDevice::UpdateGeometryTransform(const RgUpdateTransformInfo *updateInfo)
@@ -999,6 +1247,36 @@ void VulkanDevice::UpdateGeometryTransform(const RgUpdateTransformInfo *updateIn
     scene->UpdateTransform(*updateInfo);
 }
 
+void VulkanDevice::UpdateGeometryTransforms(uint32_t updateInfoCount, const RgUpdateTransformInfo *pUpdateInfos)
+{
+    if (updateInfoCount == 0)
+    {
+        return;
+    }
+
+    if (pUpdateInfos == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    scene->UpdateTransforms({ pUpdateInfos, updateInfoCount });
+}
+
+void VulkanDevice::UpdateGeometryVertices(const RgUpdateVerticesInfo *pUpdateInfo)
+{
+    if (pUpdateInfo == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    if (pUpdateInfo->vertexCount > 0 && pUpdateInfo->pPositions == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Positions must not be null");
+    }
+
+    scene->UpdateVertices(*pUpdateInfo);
+}
+
 void RTGL1::VulkanDevice::UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo *updateInfo)
 {
     if (updateInfo == nullptr)
@@ -1080,7 +1358,7 @@ void RTGL1::VulkanDevice::UploadPortal(const RgPortalUploadInfo *pUploadInfo)
 
 void VulkanDevice::SubmitStaticGeometries()
 {
-    scene->SubmitStatic();
+    scene->SubmitStatic(currentFrameState.GetFrameIndex());
 }
 
 void VulkanDevice::StartNewStaticScene()
@@ -1088,6 +1366,88 @@ void VulkanDevice::StartNewStaticScene()
     scene->StartNewStatic();
 }
 
+void VulkanDevice::UploadMesh(const RgGeometryUploadInfo *pUploadInfo, RgMesh *pResult)
+{
+    if (pUploadInfo == nullptr || pResult == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    ValidateGeometryUploadInfo(*pUploadInfo);
+
+    if (pUploadInfo->geomType != RG_GEOMETRY_TYPE_STATIC)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Mesh geometry type must be RG_GEOMETRY_TYPE_STATIC");
+    }
+
+    // vertex preprocessing is not done for mesh instances
+    if (pUploadInfo->flags & (RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT | RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT))
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Normals can't be generated for a mesh");
+    }
+
+    *pResult = scene->UploadMesh(currentFrameState.GetFrameIndex(), *pUploadInfo);
+}
+
+void VulkanDevice::UploadMeshInstances(uint32_t instanceCount, const RgMeshInstanceUploadInfo *pInstances)
+{
+    if (instanceCount == 0)
+    {
+        return;
+    }
+
+    if (pInstances == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    // instances are cleared on a frame start
+    if (!currentFrameState.WasFrameStarted())
+    {
+        throw RgException(RG_FRAME_WASNT_STARTED);
+    }
+
+    scene->UploadMeshInstances(currentFrameState.GetFrameIndex(), { pInstances, instanceCount });
+}
+
+void VulkanDevice::UploadStaticChunk(uint64_t chunkID, uint32_t geometryCount, const RgGeometryUploadInfo *pGeometries)
+{
+    if (geometryCount == 0)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Static chunk must have at least one geometry");
+    }
+
+    if (pGeometries == nullptr)
+    {
+        throw RgException(RG_WRONG_ARGUMENT, "Argument is null");
+    }
+
+    const std::span<const RgGeometryUploadInfo> geometries(pGeometries, geometryCount);
+
+    for (const RgGeometryUploadInfo &info : geometries)
+    {
+        ValidateGeometryUploadInfo(info);
+
+        if (info.geomType != RG_GEOMETRY_TYPE_STATIC)
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Static chunk geometry type must be RG_GEOMETRY_TYPE_STATIC");
+        }
+
+        // vertex preprocessing is not done for static chunks
+        if (info.flags & (RG_GEOMETRY_UPLOAD_GENERATE_NORMALS_BIT | RG_GEOMETRY_UPLOAD_GENERATE_INVERTED_NORMALS_BIT))
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "Normals can't be generated for a static chunk");
+        }
+    }
+
+    scene->UploadStaticChunk(currentFrameState.GetFrameIndex(), chunkID, geometries);
+}
+
+void VulkanDevice::RemoveStaticChunk(uint64_t chunkID)
+{
+    scene->RemoveStaticChunk(currentFrameState.GetFrameIndex(), chunkID);
+}
+
 void VulkanDevice::UploadDirectionalLight(const RgDirectionalLightUploadInfo *pLightInfo)
 {
     if (pLightInfo == nullptr)
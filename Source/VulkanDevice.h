@@ -53,6 +53,7 @@
 #include "LightGrid.h"
 #include "FSR2.h"
 #include "FrameState.h"
+#include "FrameTimings.h"
 #include "LibraryConfig.h"
 #include "PortalList.h"
 #include "RestirBuffers.h"
@@ -75,7 +76,11 @@ public:
 
 
     void UploadGeometry(const RgGeometryUploadInfo *pUploadInfo);
+    void UploadGeometries(uint32_t uploadInfoCount, const RgGeometryUploadInfo *pUploadInfos);
+    void AcquireGeometryMemory(uint32_t vertexCount, uint32_t indexCount, RgVertex **ppOutVertices, uint32_t **ppOutIndices);
     void UpdateGeometryTransform(const RgUpdateTransformInfo *pUpdateInfo);
+    void UpdateGeometryTransforms(uint32_t updateInfoCount, const RgUpdateTransformInfo *pUpdateInfos);
+    void UpdateGeometryVertices(const RgUpdateVerticesInfo *pUpdateInfo);
     void UpdateGeometryTexCoords(const RgUpdateTexCoordsInfo *pUpdateInfo);
 
     void UploadRasterizedGeometry(const RgRasterizedGeometryUploadInfo *pUploadInfo,
@@ -87,6 +92,12 @@ public:
     void SubmitStaticGeometries();
     void StartNewStaticScene();
 
+    void UploadMesh(const RgGeometryUploadInfo *pUploadInfo, RgMesh *pResult);
+    void UploadMeshInstances(uint32_t instanceCount, const RgMeshInstanceUploadInfo *pInstances);
+
+    void UploadStaticChunk(uint64_t chunkID, uint32_t geometryCount, const RgGeometryUploadInfo *pGeometries);
+    void RemoveStaticChunk(uint64_t chunkID);
+
     void UploadDirectionalLight(const RgDirectionalLightUploadInfo *pLightInfo);
     void UploadSphericalLight(const RgSphericalLightUploadInfo *pLightInfo);
     void UploadSpotlight(const RgSpotLightUploadInfo *pLightInfo);
@@ -108,6 +119,10 @@ public:
 
     bool IsSuspended() const;
     bool IsRenderUpscaleTechniqueAvailable(RgRenderUpscaleTechnique technique) const;
+    void GetFrameTimings(RgFrameTimings *pResult) const;
+    void GetScratchStats(RgScratchStats *pResult) const;
+    void GetStaticGeometryOptimizationStats(RgStaticGeometryOptimizationStats *pResult) const;
+    void WriteCpuTrace(const char *pFilePath) const;
 
 
     void Print(const char *pMessage) const;
@@ -118,6 +133,7 @@ private:
     void CreateSyncPrimitives();
     static VkSurfaceKHR GetSurfaceFromUser(VkInstance instance, const RgInstanceCreateInfo &info);
     void ValidateCreateInfo(const RgInstanceCreateInfo *pInfo);
+    void ValidateGeometryUploadInfo(const RgGeometryUploadInfo &info) const;
 
     void DestroyInstance();
     void DestroyDevice();
@@ -154,6 +170,7 @@ private:
     std::shared_ptr<MemoryAllocator>        memAllocator;
 
     std::shared_ptr<CommandBufferManager>   cmdManager;
+    std::shared_ptr<FrameTimings>           frameTimings;
 
     std::shared_ptr<Framebuffers>           framebuffers;
     std::shared_ptr<RestirBuffers>          restirBuffers;
@@ -200,6 +217,7 @@ private:
 
     bool                                    rayCullBackFacingTriangles;
     bool                                    allowGeometryWithSkyFlag;
+    bool                                    compactVertexFormat;
     bool                                    lensFlareVerticesInScreenSpace;
 
     RenderResolutionHelper                  renderResolution;
@@ -24,6 +24,7 @@
 #include <cstring>
 #include <stdexcept>
 
+#include "CpuTrace.h"
 #include "HaltonSequence.h"
 #include "RenderResolutionHelper.h"
 #include "RgException.h"
@@ -46,12 +47,17 @@ VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
           info->pfnOpenFile, info->pfnCloseFile, info->pUserLoadFileData ) }
     , rayCullBackFacingTriangles( info->rayCullBackFacingTriangles )
     , allowGeometryWithSkyFlag( info->allowGeometryWithSkyFlag )
+    , compactVertexFormat( info->compactVertexFormat )
     , lensFlareVerticesInScreenSpace( info->lensFlareVerticesInScreenSpace )
     , previousFrameTime( -1.0 / 60.0 )
     , currentFrameTime( 0 )
 {
     ValidateCreateInfo( info );
 
+#ifdef RG_USE_CPU_TRACING
+    CpuTrace::SetEnabled( libconfig.cpuTracing );
+#endif // RG_USE_CPU_TRACING
+
 
 
     // init vulkan instance
@@ -79,6 +85,8 @@ VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     cmdManager          = std::make_shared<CommandBufferManager>(device, queues);
 
+    frameTimings        = std::make_shared<FrameTimings>(device, physDevice);
+
     uniform             = std::make_shared<GlobalUniform>(device, memAllocator);
 
     swapchain           = std::make_shared<Swapchain>(device, surface, physDevice->Get(), cmdManager);
@@ -134,7 +142,15 @@ VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         cmdManager,
         textureManager,
         uniform,
-        shaderManager);
+        shaderManager,
+        info->compactStaticAccelerationStructures,
+        info->compactVertexFormat ? VertexBufferFormat::Compact : VertexBufferFormat::Full,
+        info->initialStaticVertexCount,
+        info->initialDynamicVertexCount,
+        info->initialIndexCount,
+        info->staticChunkVertexCount,
+        info->staticChunkIndexCount,
+        info->optimizeStaticGeometry);
    
     tonemapping         = std::make_shared<Tonemapping>(
         device,
@@ -300,6 +316,7 @@ VulkanDevice::~VulkanDevice()
     queues.reset();
     swapchain.reset();
     cmdManager.reset();
+    frameTimings.reset();
     framebuffers.reset();
     restirBuffers.reset();
     volumetric.reset();
@@ -441,6 +458,10 @@ void VulkanDevice::CreateInstance(const RgInstanceCreateInfo &info)
     #ifdef RG_USE_SURFACE_XLIB
         VK_KHR_XLIB_SURFACE_EXTENSION_NAME,
     #endif // RG_USE_SURFACE_XLIB
+
+    #ifdef RG_USE_NULL_DEVICE
+        VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME,
+    #endif // RG_USE_NULL_DEVICE
     };
 
     if (libconfig.vulkanValidation)
@@ -704,6 +725,20 @@ VkSurfaceKHR VulkanDevice::GetSurfaceFromUser(VkInstance instance, const RgInsta
     VkResult r;
 
 
+#ifdef RG_USE_NULL_DEVICE
+    // nothing is presented, so user's window is ignored
+    {
+        VkHeadlessSurfaceCreateInfoEXT headlessInfo = {};
+        headlessInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        r = vkCreateHeadlessSurfaceEXT(instance, &headlessInfo, nullptr, &surface);
+        VK_CHECKERROR(r);
+
+        return surface;
+    }
+#endif // RG_USE_NULL_DEVICE
+
+
 #ifdef RG_USE_SURFACE_WIN32
     if (info.pWin32SurfaceInfo != nullptr)
     {
@@ -856,10 +891,18 @@ void RTGL1::VulkanDevice::ValidateCreateInfo(const RgInstanceCreateInfo *pInfo)
             !!pInfo->pXcbSurfaceCreateInfo +
             !!pInfo->pXlibSurfaceCreateInfo;
 
+    #ifdef RG_USE_NULL_DEVICE
+        // headless surface is used, user's one is optional
+        if (count > 1)
+        {
+            throw RgException(RG_WRONG_ARGUMENT, "At most one of the surface infos must be not null");
+        }
+    #else
         if (count != 1)
         {
             throw RgException(RG_WRONG_ARGUMENT, "Exactly one of the surface infos must be not null");
         }
+    #endif // RG_USE_NULL_DEVICE
     }
 
     if (pInfo->rasterizedSkyCubemapSize == 0)
@@ -0,0 +1,702 @@
+// CPU microbenchmarks of the per-frame submission paths. Internal classes are called
+// directly, with synthetic scenes, on the null Vulkan device (RG_WITH_NULL_DEVICE),
+// so only the CPU cost is measured.
+//
+// Usage: RtglBench [--geometries <count>] [--vertices <count per geometry>] [--lights <count>]
+//                  [--raster <count>] [--textures <count>] [--texture-folder <folder>]
+//                  [--matrices <count>] [--iterations <count>] [--warmup <count>]
+//                  [--filter <substring>] [--out <file.json>]
+// Results are written as JSON to stdout, or to the --out file.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "CommandBufferManager.h"
+#include "GeomInfoManager.h"
+#include "ImageLoader.h"
+#include "LightManager.h"
+#include "Matrix.h"
+#include "MemoryAllocator.h"
+#include "PhysicalDevice.h"
+#include "Queues.h"
+#include "RasterizedDataCollector.h"
+#include "RgException.h"
+#include "SamplerManager.h"
+#include "TextureManager.h"
+#include "TextureOverrides.h"
+#include "UserFunction.h"
+#include "VertexCollector.h"
+#include "VertexCollectorFilterType.h"
+#include "Generated/ShaderCommonC.h"
+
+
+using namespace RTGL1;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+using FT    = VertexCollectorFilterTypeFlagBits;
+
+// LightManager holds up to 4096 lights, spherical and polygonal ones share that space
+constexpr uint32_t MAX_LIGHT_COUNT_PER_TYPE = 2000;
+
+struct Options
+{
+    uint32_t    geometries    = 2048;
+    uint32_t    vertices      = 192;
+    uint32_t    lights        = 1024;
+    uint32_t    raster        = 1024;
+    uint32_t    textures      = 256;
+    const char* textureFolder = "ovrd/mat/";
+    uint32_t    matrices      = 65536;
+    uint32_t    iterations    = 100;
+    uint32_t    warmup        = 10;
+    const char* filter        = nullptr;
+    const char* outPath       = nullptr;
+};
+
+struct BenchResult
+{
+    std::string           name;
+    uint32_t              itemCount;
+    std::vector< double > samplesMs;
+};
+
+class Benchmarks
+{
+public:
+    explicit Benchmarks( const Options& _options ) : options( _options ) {}
+
+    // "prepare" is called before each iteration and isn't measured
+    void Run( const char*                               name,
+              uint32_t                                  itemCount,
+              const std::function< void( uint32_t ) >& prepare,
+              const std::function< void( uint32_t ) >& run )
+    {
+        if( options.filter != nullptr && std::strstr( name, options.filter ) == nullptr )
+        {
+            return;
+        }
+
+        BenchResult r = { .name = name, .itemCount = itemCount };
+        r.samplesMs.reserve( options.iterations );
+
+        for( uint32_t i = 0; i < options.warmup + options.iterations; i++ )
+        {
+            const uint32_t frameIndex = i % MAX_FRAMES_IN_FLIGHT;
+
+            prepare( frameIndex );
+
+            const auto begin = Clock::now();
+            run( frameIndex );
+            const auto end = Clock::now();
+
+            if( i >= options.warmup )
+            {
+                r.samplesMs.push_back(
+                    std::chrono::duration< double, std::milli >( end - begin ).count() );
+            }
+        }
+
+        results.push_back( std::move( r ) );
+    }
+
+    void WriteJson( std::ostream& out ) const
+    {
+        out << "{\n";
+        out << "  \"config\": {\n";
+        out << "    \"geometries\": " << options.geometries << ",\n";
+        out << "    \"vertices\": " << options.vertices << ",\n";
+        out << "    \"lights\": " << options.lights << ",\n";
+        out << "    \"raster\": " << options.raster << ",\n";
+        out << "    \"textures\": " << options.textures << ",\n";
+        out << "    \"matrices\": " << options.matrices << ",\n";
+        out << "    \"iterations\": " << options.iterations << ",\n";
+        out << "    \"warmup\": " << options.warmup << "\n";
+        out << "  },\n";
+        out << "  \"benchmarks\": [\n";
+
+        for( size_t i = 0; i < results.size(); i++ )
+        {
+            const BenchResult& r = results[ i ];
+
+            std::vector< double > sorted = r.samplesMs;
+            std::sort( sorted.begin(), sorted.end() );
+
+            const double minMs    = sorted.empty() ? 0.0 : sorted.front();
+            const double maxMs    = sorted.empty() ? 0.0 : sorted.back();
+            const double medianMs = sorted.empty() ? 0.0 : sorted[ sorted.size() / 2 ];
+            const double meanMs =
+                sorted.empty() ? 0.0
+                               : std::accumulate( sorted.begin(), sorted.end(), 0.0 ) /
+                                     double( sorted.size() );
+            const double nsPerItem =
+                r.itemCount > 0 ? medianMs * 1000000.0 / double( r.itemCount ) : 0.0;
+
+            char buf[ 512 ];
+            std::snprintf( buf,
+                           sizeof( buf ),
+                           "    { \"name\": \"%s\", \"items\": %u, \"iterations\": %zu, "
+                           "\"min_ms\": %.6f, \"median_ms\": %.6f, \"mean_ms\": %.6f, "
+                           "\"max_ms\": %.6f, \"ns_per_item\": %.3f }%s\n",
+                           r.name.c_str(),
+                           r.itemCount,
+                           r.samplesMs.size(),
+                           minMs,
+                           medianMs,
+                           meanMs,
+                           maxMs,
+                           nsPerItem,
+                           i + 1 < results.size() ? "," : "" );
+            out << buf;
+        }
+
+        out << "  ]\n";
+        out << "}\n";
+    }
+
+private:
+    const Options&             options;
+    std::vector< BenchResult > results;
+};
+
+// Minimal set of objects that the benchmarked classes depend on
+class NullContext
+{
+public:
+    NullContext()
+    {
+        VkApplicationInfo appInfo = {};
+        appInfo.sType             = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.apiVersion        = VK_API_VERSION_1_2;
+        appInfo.pApplicationName  = "RtglBench";
+
+        const char* instanceExtensions[] = {
+            VK_KHR_SURFACE_EXTENSION_NAME,
+            VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME,
+        };
+
+        VkInstanceCreateInfo instanceInfo    = {};
+        instanceInfo.sType                   = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        instanceInfo.pApplicationInfo        = &appInfo;
+        instanceInfo.enabledExtensionCount   = std::size( instanceExtensions );
+        instanceInfo.ppEnabledExtensionNames = instanceExtensions;
+
+        VK_CHECKERROR( vkCreateInstance( &instanceInfo, nullptr, &instance ) );
+
+        VkHeadlessSurfaceCreateInfoEXT headlessInfo = {};
+        headlessInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+
+        VK_CHECKERROR( vkCreateHeadlessSurfaceEXT( instance, &headlessInfo, nullptr, &surface ) );
+
+        physDevice = std::make_shared< PhysicalDevice >( instance );
+        queues     = std::make_shared< Queues >( physDevice->Get(), surface );
+
+        std::vector< VkDeviceQueueCreateInfo > queueCreateInfos;
+        queues->GetDeviceQueueCreateInfos( queueCreateInfos );
+
+        // the null device doesn't check features and extensions
+        VkDeviceCreateInfo deviceInfo   = {};
+        deviceInfo.sType                = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        deviceInfo.queueCreateInfoCount = static_cast< uint32_t >( queueCreateInfos.size() );
+        deviceInfo.pQueueCreateInfos    = queueCreateInfos.data();
+
+        VK_CHECKERROR( vkCreateDevice( physDevice->Get(), &deviceInfo, nullptr, &device ) );
+        InitDeviceExtensionFunctions( device );
+
+        queues->SetDevice( device );
+
+        allocator  = std::make_shared< MemoryAllocator >( instance, device, physDevice );
+        cmdManager = std::make_shared< CommandBufferManager >( device, queues );
+        samplerMgr = std::make_shared< SamplerManager >( device, 8, false );
+        fileLoad   = std::make_shared< UserFileLoad >( nullptr, nullptr, nullptr );
+
+        RgInstanceCreateInfo info = {};
+        textureMgr                = std::make_shared< TextureManager >(
+            device, allocator, samplerMgr, cmdManager, fileLoad, info, LibraryConfig::Config{} );
+    }
+
+    ~NullContext()
+    {
+        cmdManager->WaitDeviceIdle();
+
+        textureMgr.reset();
+        samplerMgr.reset();
+        cmdManager.reset();
+        allocator.reset();
+        queues.reset();
+
+        vkDestroyDevice( device, nullptr );
+        vkDestroySurfaceKHR( instance, surface, nullptr );
+        vkDestroyInstance( instance, nullptr );
+    }
+
+    NullContext( const NullContext& other )                = delete;
+    NullContext( NullContext&& other ) noexcept            = delete;
+    NullContext& operator=( const NullContext& other )     = delete;
+    NullContext& operator=( NullContext&& other ) noexcept = delete;
+
+    // Start a frame, cmd is only needed to record copies
+    VkCommandBuffer BeginFrame( uint32_t frameIndex )
+    {
+        cmdManager->PrepareForFrame( frameIndex );
+        return cmdManager->StartGraphicsCmd();
+    }
+
+    void EndFrame( VkCommandBuffer cmd )
+    {
+        cmdManager->Submit( cmd );
+        cmdManager->WaitGraphicsIdle();
+    }
+
+public:
+    VkInstance   instance = VK_NULL_HANDLE;
+    VkSurfaceKHR surface  = VK_NULL_HANDLE;
+    VkDevice     device   = VK_NULL_HANDLE;
+
+    std::shared_ptr< PhysicalDevice >       physDevice;
+    std::shared_ptr< Queues >               queues;
+    std::shared_ptr< MemoryAllocator >      allocator;
+    std::shared_ptr< CommandBufferManager > cmdManager;
+    std::shared_ptr< SamplerManager >       samplerMgr;
+    std::shared_ptr< UserFileLoad >         fileLoad;
+    std::shared_ptr< TextureManager >       textureMgr;
+};
+
+// Synthetic scene, all geometries have the same vertex data, but different unique IDs
+struct SyntheticScene
+{
+    explicit SyntheticScene( const Options& options )
+    {
+        const uint32_t vertexCount = options.vertices;
+
+        vertices.resize( vertexCount );
+        indices.resize( vertexCount );
+
+        for( uint32_t i = 0; i < vertexCount; i++ )
+        {
+            const float x = float( i / 3 );
+            const float y = float( i % 3 == 1 );
+            const float z = float( i % 3 == 2 );
+
+            vertices[ i ] = RgVertex{
+                .position       = { x, y, z },
+                .normal         = { 0, 0, 1 },
+                .texCoord       = { x, y },
+                .texCoordLayer1 = { y, x },
+                .texCoordLayer2 = { z, x },
+                .packedColor    = 0xFFFFFFFF,
+            };
+            indices[ i ] = i;
+        }
+
+        geometries.resize( options.geometries );
+
+        for( uint32_t i = 0; i < options.geometries; i++ )
+        {
+            geometries[ i ] = RgGeometryUploadInfo{
+                .uniqueID           = i + 1,
+                .flags              = 0,
+                .geomType           = RG_GEOMETRY_TYPE_DYNAMIC,
+                .passThroughType    = RG_GEOMETRY_PASS_THROUGH_TYPE_OPAQUE,
+                .visibilityType     = RG_GEOMETRY_VISIBILITY_TYPE_WORLD_0,
+                .vertexCount        = vertexCount,
+                .pVertices          = vertices.data(),
+                .indexCount         = vertexCount,
+                .pIndices           = indices.data(),
+                .layerColors        = { { 1, 1, 1, 1 }, { 1, 1, 1, 1 }, { 1, 1, 1, 1 } },
+                .layerBlendingTypes = { RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE,
+                                        RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE,
+                                        RG_GEOMETRY_MATERIAL_BLEND_TYPE_OPAQUE },
+                .defaultRoughness   = 1.0f,
+                .defaultMetallicity = 0.0f,
+                .defaultEmission    = 0.0f,
+                .geomMaterial       = { RG_NO_MATERIAL, RG_NO_MATERIAL, RG_NO_MATERIAL },
+                .transform          = { {
+                    { 1, 0, 0, float( i ) },
+                    { 0, 1, 0, 0 },
+                    { 0, 0, 1, 0 },
+                } },
+            };
+        }
+
+        materials.resize( options.geometries * 3 );
+        for( MaterialTextures& m : materials )
+        {
+            std::fill( std::begin( m.indices ), std::end( m.indices ), EMPTY_TEXTURE_INDEX );
+        }
+    }
+
+    std::vector< RgVertex >             vertices;
+    std::vector< uint32_t >             indices;
+    std::vector< RgGeometryUploadInfo > geometries;
+    std::vector< MaterialTextures >     materials;
+};
+
+void BenchVertexCollector( Benchmarks& bench, NullContext& ctx, const Options& options )
+{
+    SyntheticScene scene( options );
+
+    auto geomInfoMgr = std::make_shared< GeomInfoManager >( ctx.device, ctx.allocator );
+
+    auto collector = std::make_shared< VertexCollector >(
+        ctx.device,
+        ctx.allocator,
+        geomInfoMgr,
+        options.geometries * options.vertices,
+        options.geometries * options.vertices,
+        ctx.physDevice->GetLimits().maxStorageBufferRange,
+        FT::CF_DYNAMIC | FT::MASK_PASS_THROUGH_GROUP | FT::MASK_PRIMARY_VISIBILITY_GROUP,
+        VertexBufferFormat::Full );
+
+    bench.Run(
+        "VertexCollector::AddGeometry",
+        options.geometries,
+        [ & ]( uint32_t frameIndex ) {
+            collector->Reset();
+            geomInfoMgr->PrepareForFrame( frameIndex );
+        },
+        [ & ]( uint32_t frameIndex ) {
+            collector->BeginCollecting( false );
+
+            for( uint32_t i = 0; i < options.geometries; i++ )
+            {
+                std::span< MaterialTextures, 3 > m( &scene.materials[ i * 3 ], 3 );
+                collector->AddGeometry( frameIndex, scene.geometries[ i ], m );
+            }
+
+            collector->EndCollecting();
+        } );
+}
+
+void BenchGeomInfoManager( Benchmarks& bench, NullContext& ctx, const Options& options )
+{
+    auto geomInfoMgr = std::make_shared< GeomInfoManager >( ctx.device, ctx.allocator );
+
+    constexpr VertexCollectorFilterTypeFlags flags =
+        uint32_t( FT::CF_DYNAMIC ) | uint32_t( FT::PT_OPAQUE ) | uint32_t( FT::PV_WORLD_0 );
+
+    // vertex count must be a multiple of 3 for per-triangle attributes
+    const uint32_t vertexCount = options.vertices;
+
+    std::vector< ShGeometryInstance > infos( options.geometries );
+
+    for( uint32_t i = 0; i < options.geometries; i++ )
+    {
+        ShGeometryInstance& dst = infos[ i ];
+
+        dst = {};
+        Matrix::ToMat4Transposed(
+            dst.model, RgTransform{ { { 1, 0, 0, float( i ) }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } } );
+        dst.baseVertexIndex = i * vertexCount;
+        dst.baseIndexIndex  = i * vertexCount;
+        dst.vertexCount     = vertexCount;
+        dst.indexCount      = vertexCount;
+    }
+
+    bench.Run(
+        "GeomInfoManager::WriteGeomInfo",
+        options.geometries,
+        [ & ]( uint32_t frameIndex ) { geomInfoMgr->PrepareForFrame( frameIndex ); },
+        [ & ]( uint32_t frameIndex ) {
+            for( uint32_t i = 0; i < options.geometries; i++ )
+            {
+                geomInfoMgr->WriteGeomInfo( frameIndex, i + 1, i, flags, infos[ i ] );
+            }
+        } );
+}
+
+void BenchLightManager( Benchmarks& bench, NullContext& ctx, const Options& options )
+{
+    auto lightMgr = std::make_shared< LightManager >( ctx.device, ctx.allocator );
+
+    std::vector< RgSphericalLightUploadInfo > spheres( options.lights );
+    std::vector< RgPolygonalLightUploadInfo > polys( options.lights );
+
+    for( uint32_t i = 0; i < options.lights; i++ )
+    {
+        const float x = float( i % 64 );
+        const float z = float( i / 64 );
+
+        spheres[ i ] = RgSphericalLightUploadInfo{
+            .uniqueID = i,
+            .color    = { 1, 1, 1 },
+            .position = { x, 1, z },
+            .radius   = 0.1f,
+        };
+
+        polys[ i ] = RgPolygonalLightUploadInfo{
+            .uniqueID  = options.lights + i,
+            .color     = { 1, 1, 1 },
+            .positions = { { x, 0, z }, { x + 1, 0, z }, { x, 0, z + 1 } },
+        };
+    }
+
+    // match previous frame's lights, as in the real frame
+    auto prepare = [ & ]( uint32_t frameIndex ) {
+        VkCommandBuffer cmd = ctx.BeginFrame( frameIndex );
+        lightMgr->PrepareForFrame( cmd, frameIndex );
+        ctx.EndFrame( cmd );
+    };
+
+    bench.Run( "LightManager::AddSphericalLight", options.lights, prepare, [ & ]( uint32_t frameIndex ) {
+        for( const auto& l : spheres )
+        {
+            lightMgr->AddSphericalLight( frameIndex, l );
+        }
+    } );
+
+    bench.Run( "LightManager::AddPolygonalLight", options.lights, prepare, [ & ]( uint32_t frameIndex ) {
+        for( const auto& l : polys )
+        {
+            lightMgr->AddPolygonalLight( frameIndex, l );
+        }
+    } );
+}
+
+void BenchRasterizedDataCollector( Benchmarks& bench, NullContext& ctx, const Options& options )
+{
+    SyntheticScene scene( options );
+
+    // +1, as the collector requires strictly less than its capacity
+    auto collector =
+        std::make_shared< RasterizedDataCollector >( ctx.device,
+                                                     ctx.allocator,
+                                                     ctx.textureMgr,
+                                                     options.raster * options.vertices + 1,
+                                                     options.raster * options.vertices + 1 );
+
+    const RgRasterizedGeometryUploadInfo info = {
+        .renderType    = RG_RASTERIZED_GEOMETRY_RENDER_TYPE_DEFAULT,
+        .vertexCount   = options.vertices,
+        .pVertices     = scene.vertices.data(),
+        .indexCount    = options.vertices,
+        .pIndices      = scene.indices.data(),
+        .transform     = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } },
+        .color         = { 1, 1, 1, 1 },
+        .material      = RG_NO_MATERIAL,
+        .pipelineState = 0,
+        .blendFuncSrc  = RG_BLEND_FACTOR_ONE,
+        .blendFuncDst  = RG_BLEND_FACTOR_ONE,
+    };
+
+    bench.Run(
+        "RasterizedDataCollector::AddGeometry",
+        options.raster,
+        [ & ]( uint32_t frameIndex ) { collector->Clear( frameIndex ); },
+        [ & ]( uint32_t frameIndex ) {
+            for( uint32_t i = 0; i < options.raster; i++ )
+            {
+                collector->AddGeometry( frameIndex, info, nullptr, nullptr );
+            }
+        } );
+}
+
+void BenchTextureOverrides( Benchmarks& bench, NullContext& ctx, const Options& options )
+{
+    ImageLoader imageLoader( ctx.fileLoad );
+
+    TextureOverrides::OverrideInfo ovrdInfo = {
+        .commonFolderPath = options.textureFolder,
+        .postfixes        = { DEFAULT_TEXTURE_POSTFIX_ALBEDO_ALPHA,
+                              DEFAULT_TEXTURE_POSTFIX_ROUGNESS_METALLIC_EMISSION,
+                              DEFAULT_TEXTURE_POSTFIX_NORMAL },
+        .overridenIsSRGB  = { true, false, false },
+        .originalIsSRGB   = { true, false, false },
+    };
+
+    // typical relative paths of game textures, with extensions that are replaced
+    std::vector< std::string > names( options.textures );
+    for( uint32_t i = 0; i < options.textures; i++ )
+    {
+        names[ i ] = "textures/world/wall_" + std::to_string( i ) + ".tga";
+    }
+
+    constexpr uint32_t   defaultData[] = { 0xFFFFFFFF };
+    constexpr RgExtent2D defaultSize   = { 1, 1 };
+    const RgTextureSet   defaultSet    = {
+             .pDataAlbedoAlpha               = defaultData,
+             .pDataRoughnessMetallicEmission = defaultData,
+             .pDataNormal                    = defaultData,
+    };
+
+    bench.Run(
+        "TextureOverrides",
+        options.textures,
+        []( uint32_t ) {},
+        [ & ]( uint32_t ) {
+            for( const std::string& n : names )
+            {
+                TextureOverrides ovrd( n.c_str(), defaultSet, defaultSize, ovrdInfo, &imageLoader );
+            }
+        } );
+}
+
+void BenchMatrix( Benchmarks& bench, const Options& options )
+{
+    std::vector< float > src( size_t( options.matrices ) * 16 );
+    std::vector< float > dst( size_t( options.matrices ) * 16 );
+
+    for( uint32_t i = 0; i < options.matrices; i++ )
+    {
+        // rotation around Y, with scale and translation, so it's invertible
+        const float a = float( i ) * 0.01f;
+        const float s = 1.0f + float( i % 7 );
+
+        const RgTransform t = { {
+            { s * std::cos( a ), 0, s * std::sin( a ), float( i ) },
+            { 0, s, 0, 1 },
+            { -s * std::sin( a ), 0, s * std::cos( a ), 2 },
+        } };
+
+        Matrix::ToMat4Transposed( &src[ size_t( i ) * 16 ], t );
+    }
+
+    bench.Run(
+        "Matrix::Inverse",
+        options.matrices,
+        []( uint32_t ) {},
+        [ & ]( uint32_t ) {
+            for( uint32_t i = 0; i < options.matrices; i++ )
+            {
+                Matrix::Inverse( &dst[ size_t( i ) * 16 ], &src[ size_t( i ) * 16 ] );
+            }
+        } );
+}
+
+bool ParseOptions( int argc, char* argv[], Options& dst )
+{
+    for( int i = 1; i < argc; i++ )
+    {
+        auto isArg = [ & ]( const char* name ) {
+            return std::strcmp( argv[ i ], name ) == 0 && i + 1 < argc;
+        };
+        auto toCount = [ & ]( uint32_t minValue ) {
+            return std::max( minValue, uint32_t( std::strtoul( argv[ ++i ], nullptr, 10 ) ) );
+        };
+
+        if( isArg( "--geometries" ) )
+        {
+            dst.geometries = toCount( 1 );
+        }
+        else if( isArg( "--vertices" ) )
+        {
+            dst.vertices = toCount( 3 );
+        }
+        else if( isArg( "--lights" ) )
+        {
+            dst.lights = toCount( 1 );
+        }
+        else if( isArg( "--raster" ) )
+        {
+            dst.raster = toCount( 1 );
+        }
+        else if( isArg( "--textures" ) )
+        {
+            dst.textures = toCount( 1 );
+        }
+        else if( isArg( "--texture-folder" ) )
+        {
+            dst.textureFolder = argv[ ++i ];
+        }
+        else if( isArg( "--matrices" ) )
+        {
+            dst.matrices = toCount( 1 );
+        }
+        else if( isArg( "--iterations" ) )
+        {
+            dst.iterations = toCount( 1 );
+        }
+        else if( isArg( "--warmup" ) )
+        {
+            dst.warmup = toCount( 0 );
+        }
+        else if( isArg( "--filter" ) )
+        {
+            dst.filter = argv[ ++i ];
+        }
+        else if( isArg( "--out" ) )
+        {
+            dst.outPath = argv[ ++i ];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    // geometries of one filter are limited, and triangles must be complete
+    dst.geometries = std::min< uint32_t >( dst.geometries, MAX_BOTTOM_LEVEL_GEOMETRIES_COUNT );
+    dst.vertices   = dst.vertices - dst.vertices % 3;
+    dst.lights     = std::min( dst.lights, MAX_LIGHT_COUNT_PER_TYPE );
+
+    return true;
+}
+
+}
+
+int main( int argc, char* argv[] )
+{
+    Options options;
+
+    if( !ParseOptions( argc, argv, options ) )
+    {
+        std::cout << "Usage: RtglBench [--geometries <count>] [--vertices <count>] "
+                     "[--lights <count>] [--raster <count>] [--textures <count>] "
+                     "[--texture-folder <folder>] [--matrices <count>] [--iterations <count>] "
+                     "[--warmup <count>] [--filter <substring>] [--out <file.json>]"
+                  << std::endl;
+        return 1;
+    }
+
+    Benchmarks bench( options );
+
+    try
+    {
+        NullContext ctx;
+
+        BenchVertexCollector( bench, ctx, options );
+        BenchGeomInfoManager( bench, ctx, options );
+        BenchLightManager( bench, ctx, options );
+        BenchRasterizedDataCollector( bench, ctx, options );
+        BenchTextureOverrides( bench, ctx, options );
+        BenchMatrix( bench, options );
+    }
+    catch( RgException& e )
+    {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    if( options.outPath != nullptr )
+    {
+        std::ofstream file( options.outPath );
+
+        if( !file.is_open() )
+        {
+            std::cout << "Can't write " << options.outPath << std::endl;
+            return 1;
+        }
+
+        bench.WriteJson( file );
+    }
+    else
+    {
+        bench.WriteJson( std::cout );
+    }
+
+    return 0;
+}
@@ -0,0 +1,735 @@
+// Replays a capture that was recorded with RgInstanceCreateInfo::pCaptureFilePath,
+// as fast as possible, and prints CPU timings of each API call and of frames.
+//
+// Usage: RtglReplay <capture.rgcap> [--shaders <folder>] [--bluenoise <file>] [--textures <folder>]
+//                                   [--window <width> <height>]
+// Paths in the capture are relative to the working directory of the captured application,
+// use the options to override them.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+
+// with null device, the library uses a headless surface, so a window is not created
+#ifndef RG_USE_NULL_DEVICE
+    #ifdef _WIN32
+        #define RG_USE_SURFACE_WIN32
+    #else
+        #define RG_USE_SURFACE_XLIB
+    #endif
+#endif
+#include <RTGL1/RTGL1.h>
+
+#ifndef RG_USE_NULL_DEVICE
+    #include <GLFW/glfw3.h>
+    #ifdef _WIN32
+        #define GLFW_EXPOSE_NATIVE_WIN32
+    #else
+        #define GLFW_EXPOSE_NATIVE_X11
+    #endif
+    #include <GLFW/glfw3native.h>
+#else
+struct GLFWwindow;
+#endif
+
+#include "CaptureFormat.h"
+
+
+using RTGL1::Capture::CallType;
+using RTGL1::Capture::Reader;
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+double ToMs( Clock::duration d )
+{
+    return std::chrono::duration< double, std::milli >( d ).count();
+}
+
+struct Options
+{
+    const char* capturePath  = nullptr;
+    const char* shaderFolder = nullptr;
+    const char* blueNoise    = nullptr;
+    const char* textures     = nullptr;
+    int         width        = 1600;
+    int         height       = 900;
+};
+
+struct CallStats
+{
+    uint64_t count       = 0;
+    uint64_t failedCount = 0;
+    uint64_t bytes       = 0;
+    double   totalMs     = 0;
+    double   maxMs       = 0;
+};
+
+class Replayer
+{
+public:
+    Replayer( const Options& _options, GLFWwindow* _window ) : options( _options ), window( _window ) {}
+
+    ~Replayer()
+    {
+        if( instance != nullptr )
+        {
+            rgDestroyInstance( instance );
+        }
+    }
+
+    Replayer( const Replayer& other )                = delete;
+    Replayer( Replayer&& other ) noexcept            = delete;
+    Replayer& operator=( const Replayer& other )     = delete;
+    Replayer& operator=( Replayer&& other ) noexcept = delete;
+
+    void Execute( CallType type, Reader& r, uint32_t payloadSize )
+    {
+        auto& stats = callStats[ static_cast< size_t >( type ) ];
+        stats.bytes += payloadSize;
+
+        switch( type )
+        {
+            case CallType::CreateInstance: CreateInstance( r, stats ); break;
+            case CallType::DestroyInstance:
+            {
+                Timed( stats, [ & ] { return rgDestroyInstance( instance ); } );
+                instance = nullptr;
+                break;
+            }
+            case CallType::UploadGeometry:
+            {
+                const RgGeometryUploadInfo* info;
+                r.Object( info );
+                RemapGeometry( info, 1 );
+                Timed( stats, [ & ] { return rgUploadGeometry( instance, info ); } );
+                break;
+            }
+            case CallType::UploadGeometries:
+            {
+                const RgGeometryUploadInfo* infos;
+                uint32_t                    count = r.Objects( infos, 0 );
+                RemapGeometry( infos, count );
+                Timed( stats, [ & ] { return rgUploadGeometries( instance, count, infos ); } );
+                break;
+            }
+            case CallType::UpdateGeometryTransform:
+            {
+                const RgUpdateTransformInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUpdateGeometryTransform( instance, info ); } );
+                break;
+            }
+            case CallType::UpdateGeometryTransforms:
+            {
+                const RgUpdateTransformInfo* infos;
+                uint32_t                     count = r.Objects( infos, 0 );
+                Timed( stats, [ & ] { return rgUpdateGeometryTransforms( instance, count, infos ); } );
+                break;
+            }
+            case CallType::UpdateGeometryVertices:
+            {
+                const RgUpdateVerticesInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUpdateGeometryVertices( instance, info ); } );
+                break;
+            }
+            case CallType::UpdateGeometryTexCoords:
+            {
+                const RgUpdateTexCoordsInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUpdateGeometryTexCoords( instance, info ); } );
+                break;
+            }
+            case CallType::UploadRasterizedGeometry:
+            {
+                const RgRasterizedGeometryUploadInfo* info;
+                const float*                          viewProjection;
+                const RgViewport*                     viewport;
+                r.Object( info );
+                r.Array( viewProjection, 16 );
+                r.Array( viewport, 1 );
+                Mutable( info ).material = Material( info->material );
+                Timed( stats, [ & ] {
+                    return rgUploadRasterizedGeometry( instance, info, viewProjection, viewport );
+                } );
+                break;
+            }
+            case CallType::UploadLensFlare:
+            {
+                const RgLensFlareUploadInfo* info;
+                r.Object( info );
+                Mutable( info ).material = Material( info->material );
+                Timed( stats, [ & ] { return rgUploadLensFlare( instance, info ); } );
+                break;
+            }
+            case CallType::UploadDecal:
+            {
+                const RgDecalUploadInfo* info;
+                r.Object( info );
+                Mutable( info ).material = Material( info->material );
+                Timed( stats, [ & ] { return rgUploadDecal( instance, info ); } );
+                break;
+            }
+            case CallType::UploadPortal:
+            {
+                const RgPortalUploadInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUploadPortal( instance, info ); } );
+                break;
+            }
+            case CallType::BeginStaticGeometries:
+            {
+                Timed( stats, [ & ] { return rgBeginStaticGeometries( instance ); } );
+                break;
+            }
+            case CallType::SubmitStaticGeometries:
+            {
+                Timed( stats, [ & ] { return rgSubmitStaticGeometries( instance ); } );
+                break;
+            }
+            case CallType::UploadMesh:
+            {
+                const RgGeometryUploadInfo* info;
+                RgMesh                      captured;
+                r.Object( info );
+                r.Value( captured );
+                RemapGeometry( info, 1 );
+
+                RgMesh result = RG_NO_MESH;
+                Timed( stats, [ & ] { return rgUploadMesh( instance, info, &result ); } );
+                meshes[ captured ] = result;
+                break;
+            }
+            case CallType::UploadMeshInstances:
+            {
+                const RgMeshInstanceUploadInfo* instances;
+                uint32_t                        count = r.Array( instances, 0 );
+                for( uint32_t i = 0; i < count; i++ )
+                {
+                    Mutable( &instances[ i ] ).mesh = Find( meshes, instances[ i ].mesh, RG_NO_MESH );
+                }
+                Timed( stats, [ & ] { return rgUploadMeshInstances( instance, count, instances ); } );
+                break;
+            }
+            case CallType::UploadStaticChunk:
+            {
+                uint64_t                    chunkID;
+                const RgGeometryUploadInfo* infos;
+                r.Value( chunkID );
+                uint32_t count = r.Objects( infos, 0 );
+                RemapGeometry( infos, count );
+                Timed( stats, [ & ] { return rgUploadStaticChunk( instance, chunkID, count, infos ); } );
+                break;
+            }
+            case CallType::RemoveStaticChunk:
+            {
+                uint64_t chunkID;
+                r.Value( chunkID );
+                Timed( stats, [ & ] { return rgRemoveStaticChunk( instance, chunkID ); } );
+                break;
+            }
+            case CallType::UploadDirectionalLight:
+            {
+                const RgDirectionalLightUploadInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUploadDirectionalLight( instance, info ); } );
+                break;
+            }
+            case CallType::UploadSphericalLight:
+            {
+                const RgSphericalLightUploadInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUploadSphericalLight( instance, info ); } );
+                break;
+            }
+            case CallType::UploadSpotLight:
+            {
+                const RgSpotLightUploadInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUploadSpotLight( instance, info ); } );
+                break;
+            }
+            case CallType::UploadPolygonalLight:
+            {
+                const RgPolygonalLightUploadInfo* info;
+                r.Object( info );
+                Timed( stats, [ & ] { return rgUploadPolygonalLight( instance, info ); } );
+                break;
+            }
+            case CallType::CreateMaterial:
+            {
+                const RgMaterialCreateInfo* info;
+                RgMaterial                  captured;
+                r.Object( info );
+                r.Value( captured );
+
+                RgMaterial result = RG_NO_MATERIAL;
+                Timed( stats, [ & ] { return rgCreateMaterial( instance, info, &result ); } );
+                materials[ captured ] = result;
+                break;
+            }
+            case CallType::CreateAnimatedMaterial:
+            {
+                const RgAnimatedMaterialCreateInfo* info;
+                RgMaterial                          captured;
+                r.Object( info );
+                r.Value( captured );
+
+                RgMaterial result = RG_NO_MATERIAL;
+                Timed( stats, [ & ] { return rgCreateAnimatedMaterial( instance, info, &result ); } );
+                materials[ captured ] = result;
+                break;
+            }
+            case CallType::ChangeAnimatedMaterialFrame:
+            {
+                RgMaterial material;
+                uint32_t   frameIndex;
+                r.Value( material );
+                r.Value( frameIndex );
+                Timed( stats, [ & ] {
+                    return rgChangeAnimatedMaterialFrame( instance, Material( material ), frameIndex );
+                } );
+                break;
+            }
+            case CallType::UpdateMaterialContents:
+            {
+                const RTGL1::Capture::MaterialUpdate* update;
+                r.Object( update );
+
+                RgMaterialUpdateInfo info = update->info;
+                info.target               = Material( info.target );
+                Timed( stats, [ & ] { return rgUpdateMaterialContents( instance, &info ); } );
+                break;
+            }
+            case CallType::DestroyMaterial:
+            {
+                RgMaterial material;
+                r.Value( material );
+                Timed( stats, [ & ] { return rgDestroyMaterial( instance, Material( material ) ); } );
+                materials.erase( material );
+                break;
+            }
+            case CallType::CreateCubemap:
+            {
+                const RgCubemapCreateInfo* info;
+                RgCubemap                  captured;
+                r.Object( info );
+                r.Value( captured );
+
+                RgCubemap result = RG_EMPTY_CUBEMAP;
+                Timed( stats, [ & ] { return rgCreateCubemap( instance, info, &result ); } );
+                cubemaps[ captured ] = result;
+                break;
+            }
+            case CallType::DestroyCubemap:
+            {
+                RgCubemap cubemap;
+                r.Value( cubemap );
+                Timed( stats, [ & ] {
+                    return rgDestroyCubemap( instance, Find( cubemaps, cubemap, RG_EMPTY_CUBEMAP ) );
+                } );
+                cubemaps.erase( cubemap );
+                break;
+            }
+            case CallType::StartFrame:
+            {
+                const RgStartFrameInfo* info;
+                r.Object( info );
+
+                // replay as fast as possible
+                RgStartFrameInfo startInfo    = *info;
+                startInfo.requestVSync        = false;
+                startInfo.requestShaderReload = false;
+
+#ifndef RG_USE_NULL_DEVICE
+                glfwPollEvents();
+#endif
+
+                frameStart = Clock::now();
+                Timed( stats, [ & ] { return rgStartFrame( instance, &startInfo ); } );
+                break;
+            }
+            case CallType::DrawFrame:
+            {
+                const RgDrawFrameInfo* info;
+                r.Object( info );
+                if( info->pSkyParams != nullptr )
+                {
+                    Mutable( info->pSkyParams ).skyCubemap =
+                        Find( cubemaps, info->pSkyParams->skyCubemap, RG_EMPTY_CUBEMAP );
+                }
+                Timed( stats, [ & ] { return rgDrawFrame( instance, info ); } );
+                frameTimes.push_back( ToMs( Clock::now() - frameStart ) );
+                break;
+            }
+            default:
+            {
+                throw std::runtime_error( "Unknown call type in the capture" );
+            }
+        }
+    }
+
+    void PrintStats( double totalMs ) const
+    {
+        std::printf( "\n%-32s %10s %8s %12s %12s %12s %12s\n",
+                     "Call",
+                     "Count",
+                     "Failed",
+                     "Total (ms)",
+                     "Avg (us)",
+                     "Max (us)",
+                     "Data (KiB)" );
+
+        for( size_t i = 0; i < callStats.size(); i++ )
+        {
+            const CallStats& s = callStats[ i ];
+
+            if( s.count == 0 )
+            {
+                continue;
+            }
+
+            std::printf( "%-32s %10llu %8llu %12.3f %12.3f %12.3f %12.1f\n",
+                         GetCallName( static_cast< CallType >( i ) ),
+                         static_cast< unsigned long long >( s.count ),
+                         static_cast< unsigned long long >( s.failedCount ),
+                         s.totalMs,
+                         s.totalMs * 1000.0 / double( s.count ),
+                         s.maxMs * 1000.0,
+                         double( s.bytes ) / 1024.0 );
+        }
+
+        std::printf( "\nTotal replay time: %.3f ms\n", totalMs );
+
+        if( frameTimes.empty() )
+        {
+            return;
+        }
+
+        std::vector< double > sorted = frameTimes;
+        std::ranges::sort( sorted );
+
+        double sum = 0;
+        for( double t : sorted )
+        {
+            sum += t;
+        }
+
+        auto percentile = [ &sorted ]( double p ) {
+            return sorted[ std::min( sorted.size() - 1, size_t( p * double( sorted.size() ) ) ) ];
+        };
+
+        std::printf( "Frames: %zu, frame time (ms): avg %.3f, min %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f\n",
+                     sorted.size(),
+                     sum / double( sorted.size() ),
+                     sorted.front(),
+                     percentile( 0.50 ),
+                     percentile( 0.95 ),
+                     percentile( 0.99 ),
+                     sorted.back() );
+    }
+
+private:
+    void CreateInstance( Reader& r, CallStats& stats )
+    {
+        if( instance != nullptr )
+        {
+            throw std::runtime_error( "Capture contains more than one instance" );
+        }
+
+        const RgInstanceCreateInfo* captured;
+        r.Object( captured );
+
+        RgInstanceCreateInfo info = *captured;
+
+#if defined( RG_USE_NULL_DEVICE )
+        // headless surface is created by the library
+#elif defined( _WIN32 )
+        RgWin32SurfaceCreateInfo win32Info = {
+            .hinstance = GetModuleHandle( NULL ),
+            .hwnd      = glfwGetWin32Window( window ),
+        };
+        info.pWin32SurfaceInfo = &win32Info;
+#else
+        RgXlibSurfaceCreateInfo xlibInfo = {
+            .dpy    = glfwGetX11Display(),
+            .window = glfwGetX11Window( window ),
+        };
+        info.pXlibSurfaceCreateInfo = &xlibInfo;
+#endif
+
+        info.pfnPrint = []( const char* pMessage, void* pUserData ) {
+            std::cout << pMessage << std::endl;
+        };
+        // don't capture the replay
+        info.pCaptureFilePath = nullptr;
+
+        if( options.shaderFolder != nullptr )
+        {
+            info.pShaderFolderPath = options.shaderFolder;
+        }
+        if( options.blueNoise != nullptr )
+        {
+            info.pBlueNoiseFilePath = options.blueNoise;
+        }
+        if( options.textures != nullptr )
+        {
+            info.pOverridenTexturesFolderPath          = options.textures;
+            info.pOverridenTexturesFolderPathDeveloper = nullptr;
+        }
+
+        RgResult result = Timed( stats, [ & ] { return rgCreateInstance( &info, &instance ); } );
+
+        if( result != RG_SUCCESS )
+        {
+            throw std::runtime_error( std::string( "rgCreateInstance failed: " ) +
+                                      rgGetResultDescription( result ) );
+        }
+    }
+
+    template< typename Func >
+    RgResult Timed( CallStats& stats, Func&& call )
+    {
+        const auto     begin  = Clock::now();
+        const RgResult result = call();
+        const double   ms     = ToMs( Clock::now() - begin );
+
+        stats.count++;
+        stats.failedCount += result != RG_SUCCESS;
+        stats.totalMs += ms;
+        stats.maxMs = std::max( stats.maxMs, ms );
+
+        return result;
+    }
+
+    // Reader owns the memory of the read structs, so they can be patched
+    template< typename T >
+    static T& Mutable( const T* ptr )
+    {
+        return *const_cast< T* >( ptr );
+    }
+
+    template< typename Handle >
+    static Handle Find( const std::unordered_map< Handle, Handle >& map,
+                        Handle                                    captured,
+                        std::type_identity_t< Handle >            none )
+    {
+        auto it = map.find( captured );
+        return it != map.end() ? it->second : none;
+    }
+
+    RgMaterial Material( RgMaterial captured ) const
+    {
+        return Find( materials, captured, RG_NO_MATERIAL );
+    }
+
+    void RemapGeometry( const RgGeometryUploadInfo* infos, uint32_t count ) const
+    {
+        for( uint32_t i = 0; i < count; i++ )
+        {
+            for( RgMaterial& m : Mutable( &infos[ i ] ).geomMaterial.layerMaterials )
+            {
+                m = Material( m );
+            }
+        }
+    }
+
+private:
+    Options     options;
+    GLFWwindow* window;
+
+    RgInstance instance = nullptr;
+
+    // captured handle to the replayed one
+    std::unordered_map< RgMaterial, RgMaterial > materials;
+    std::unordered_map< RgCubemap, RgCubemap >   cubemaps;
+    std::unordered_map< RgMesh, RgMesh >         meshes;
+
+    std::array< CallStats, static_cast< size_t >( CallType::Count ) > callStats;
+
+    Clock::time_point     frameStart;
+    std::vector< double > frameTimes;
+};
+
+bool ParseOptions( int argc, char* argv[], Options& dst )
+{
+    for( int i = 1; i < argc; i++ )
+    {
+        auto isArg = [ & ]( const char* name, int valueCount ) {
+            return std::strcmp( argv[ i ], name ) == 0 && i + valueCount < argc;
+        };
+
+        if( isArg( "--shaders", 1 ) )
+        {
+            dst.shaderFolder = argv[ ++i ];
+        }
+        else if( isArg( "--bluenoise", 1 ) )
+        {
+            dst.blueNoise = argv[ ++i ];
+        }
+        else if( isArg( "--textures", 1 ) )
+        {
+            dst.textures = argv[ ++i ];
+        }
+        else if( isArg( "--window", 2 ) )
+        {
+            dst.width  = std::max( 1, std::atoi( argv[ ++i ] ) );
+            dst.height = std::max( 1, std::atoi( argv[ ++i ] ) );
+        }
+        else if( dst.capturePath == nullptr && argv[ i ][ 0 ] != '-' )
+        {
+            dst.capturePath = argv[ i ];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return dst.capturePath != nullptr;
+}
+
+bool ReadFile( const char* path, std::vector< uint8_t >& dst )
+{
+    std::ifstream file( path, std::ios::binary | std::ios::ate );
+
+    if( !file.is_open() )
+    {
+        return false;
+    }
+
+    dst.resize( static_cast< size_t >( file.tellg() ) );
+    file.seekg( 0 );
+
+    return bool( file.read( reinterpret_cast< char* >( dst.data() ), std::streamsize( dst.size() ) ) );
+}
+
+}
+
+
+int main( int argc, char* argv[] )
+{
+    Options options;
+
+    if( !ParseOptions( argc, argv, options ) )
+    {
+        std::cout << "Usage: RtglReplay <capture.rgcap> [--shaders <folder>] [--bluenoise <file>] "
+                     "[--textures <folder>] [--window <width> <height>]"
+                  << std::endl;
+        return 1;
+    }
+
+    std::vector< uint8_t > capture;
+
+    if( !ReadFile( options.capturePath, capture ) )
+    {
+        std::cout << "Can't read " << options.capturePath << std::endl;
+        return 1;
+    }
+
+    RTGL1::Capture::FileHeader header = {};
+
+    if( capture.size() < sizeof( header ) )
+    {
+        std::cout << "Capture is too small" << std::endl;
+        return 1;
+    }
+
+    std::memcpy( &header, capture.data(), sizeof( header ) );
+
+    if( !RTGL1::Capture::IsCompatible( header ) )
+    {
+        std::cout << "Capture was recorded by an incompatible version of the library" << std::endl;
+        return 1;
+    }
+
+
+#ifndef RG_USE_NULL_DEVICE
+    // window is only needed for a surface, it's not shown
+    if( !glfwInit() )
+    {
+        std::cout << "Can't initialize GLFW" << std::endl;
+        return 1;
+    }
+
+    glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( options.width, options.height, "RTGL1 Replay", nullptr, nullptr );
+
+    if( window == nullptr )
+    {
+        std::cout << "Can't create a window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+#else
+    GLFWwindow* window = nullptr;
+#endif
+
+    int exitCode = 0;
+    {
+        Replayer replayer( options, window );
+
+        const auto begin  = Clock::now();
+        size_t     offset = sizeof( header );
+
+        try
+        {
+            while( offset < capture.size() )
+            {
+                RTGL1::Capture::RecordHeader record = {};
+
+                if( capture.size() - offset < sizeof( record ) )
+                {
+                    throw std::runtime_error( "Capture is truncated" );
+                }
+                std::memcpy( &record, capture.data() + offset, sizeof( record ) );
+                offset += sizeof( record );
+
+                if( capture.size() - offset < record.size )
+                {
+                    throw std::runtime_error( "Capture is truncated" );
+                }
+
+                Reader reader( capture.data() + offset, record.size );
+                replayer.Execute( record.type, reader, record.size );
+
+                if( !reader.IsAtEnd() )
+                {
+                    throw std::runtime_error( "Capture record has unread data" );
+                }
+
+                offset += record.size;
+            }
+        }
+        catch( std::runtime_error& e )
+        {
+            // e.g. the application was closed without rgDestroyInstance, print what was replayed
+            std::cout << e.what() << " (at byte " << offset << ")" << std::endl;
+            exitCode = 1;
+        }
+
+        replayer.PrintStats( ToMs( Clock::now() - begin ) );
+    }
+
+#ifndef RG_USE_NULL_DEVICE
+    glfwDestroyWindow( window );
+    glfwTerminate();
+#endif
+
+    return exitCode;
+}